@@ -3,6 +3,44 @@
 
 typedef void *BENCHMARK_H;
 typedef void *BENCHMARK_DATA_PACKET_H;
+typedef void *BENCHMARK_CONFIG_H;
+typedef void *BENCHMARK_THREAD_CTX_H;
+typedef void *BENCHMARK_TICKET_H;
+
+/* Tables whose access method can be chosen. The rest of the
+ * tables need ordered scans and are always btrees. */
+#define BENCHMARK_TABLE_STOCKS    0x0001
+#define BENCHMARK_TABLE_PERSONAL  0x0002
+#define BENCHMARK_TABLE_QUOTES    0x0008
+
+/* Always a btree, but its datafile can be parsed on its own */
+#define BENCHMARK_TABLE_CURRENCIES 0x0004
+
+/* Always a btree, filled by benchmark_load_portfolio() */
+#define BENCHMARK_TABLE_PORTFOLIOS 0x0020
+
+#define BENCHMARK_ACCESS_BTREE    0
+#define BENCHMARK_ACCESS_HASH     1
+
+/* Returned when a transaction kept losing lock conflicts 
+ * after all the retries allowed by the configuration */
+#define BENCHMARK_RETRY_EXHAUSTED 2
+
+/* Transaction types, for benchmark_retry_stats_get() */
+#define BENCHMARK_XACT_VIEW_STOCK       0
+#define BENCHMARK_XACT_VIEW_PORTFOLIO   1
+#define BENCHMARK_XACT_PURCHASE         2
+#define BENCHMARK_XACT_SELL             3
+#define BENCHMARK_XACT_REFRESH_QUOTES   4
+#define BENCHMARK_XACT_LOAD             5   /* Batches of the initial load */
+
+/* Isolation of the calls that only read (view stock, view portfolio).
+ * DEFAULT leaves the choice to the handle, or to the configuration */
+#define BENCHMARK_ISOLATION_DEFAULT       0
+#define BENCHMARK_ISOLATION_UNCOMMITTED   1   /* Dirty reads, no read locks */
+#define BENCHMARK_ISOLATION_COMMITTED     2
+#define BENCHMARK_ISOLATION_SNAPSHOT      3   /* Needs benchmark_config_snapshot_set() */
+#define BENCHMARK_ISOLATION_SERIALIZABLE  4   /* Write locks held until commit */
 
 int 
 benchmark_handle_alloc(BENCHMARK_H *benchmark_handle,
@@ -11,6 +49,14 @@ benchmark_handle_alloc(BENCHMARK_H *benchmark_handle,
                        const char *homedir, 
                        const char *datafilesdir);
 
+int 
+benchmark_handle_alloc2(BENCHMARK_H *benchmark_handle,
+                        int create, 
+                        const char *program, 
+                        const char *homedir, 
+                        const char *datafilesdir,
+                        BENCHMARK_CONFIG_H config_handle);
+
 int 
 benchmark_handle_free(BENCHMARK_H benchmark_handle);
 
@@ -19,6 +65,201 @@ benchmark_initial_load(const char *program,
                        const char *homedir, 
                        const char *datafilesdir);
 
+void *
+benchmark_initial_load2(const char *program,
+                        const char *homedir, 
+                        const char *datafilesdir,
+                        BENCHMARK_CONFIG_H config_handle);
+
+/* Writes every table to a checksummed binary image at path. The
+ * image is consistent if snapshot reads are configured, or if
+ * nothing writes while it is saved. */
+int
+benchmark_image_save(BENCHMARK_H benchmark_handle, const char *path);
+
+/* Same as benchmark_initial_load2(), but the tables are restored
+ * from an image written by benchmark_image_save(). Returns NULL if
+ * the image is damaged or was written by a different build. */
+void *
+benchmark_image_load(const char *program,
+                     const char *homedir,
+                     const char *path,
+                     BENCHMARK_CONFIG_H config_handle);
+
+/* Parses the datafile of a table (BENCHMARK_TABLE_*) the way the
+ * initial load does, without loading it. Lines that cannot be
+ * parsed are counted in malformed. */
+int
+benchmark_datafile_parse(const char    *path,
+                         int            table,
+                         unsigned long *rows,
+                         unsigned long *malformed);
+
+int
+benchmark_config_alloc(BENCHMARK_CONFIG_H *config_handle);
+
+int
+benchmark_config_free(BENCHMARK_CONFIG_H config_handle);
+
+/* nelem is the expected number of keys of a hash table */
+int
+benchmark_config_access_method_set(BENCHMARK_CONFIG_H config_handle,
+                                   int                table,
+                                   int                access_method,
+                                   unsigned int       nelem);
+
+int
+benchmark_config_quote_cache_set(BENCHMARK_CONFIG_H config_handle,
+                                 int                enabled);
+
+/* Stocks, Currencies and Personal are read from a frozen copy */
+int
+benchmark_config_frozen_catalog_set(BENCHMARK_CONFIG_H config_handle,
+                                    int                enabled);
+
+/* Read only calls run on a snapshot of multiversion tables */
+int
+benchmark_config_snapshot_set(BENCHMARK_CONFIG_H config_handle,
+                              int                enabled);
+
+/* Transactions reuse one cursor per table (enabled by default) */
+int
+benchmark_config_cursor_cache_set(BENCHMARK_CONFIG_H config_handle,
+                                  int                enabled);
+
+/* Packets are applied sorted by (account, symbol), with the entries
+ * for the same holding merged into one */
+int
+benchmark_config_packet_order_set(BENCHMARK_CONFIG_H config_handle,
+                                  int                enabled);
+
+/* Each packet entry runs in a child transaction, so that a failed
+ * entry is rolled back alone instead of aborting its packet. See
+ * benchmark_data_packet_status_get() */
+int
+benchmark_config_packet_partial_set(BENCHMARK_CONFIG_H config_handle,
+                                    int                enabled);
+
+/* Worker threads started with the handle to apply submitted packets,
+ * and the most packets they apply in one transaction */
+int
+benchmark_config_order_queue_set(BENCHMARK_CONFIG_H config_handle,
+                                 int                num_workers,
+                                 int                group_max);
+
+/* Isolation of the read only calls of the handle. Defaults to
+ * SNAPSHOT with snapshot reads enabled, and to COMMITTED otherwise */
+int
+benchmark_config_read_isolation_set(BENCHMARK_CONFIG_H config_handle,
+                                    int                isolation);
+
+/* Concurrent single item calls (quote refreshes, one entry packets)
+ * are applied in one transaction: a batch waits up to window_usec
+ * for more calls, and takes up to max_batch. Each call still gets
+ * its own result. max_batch <= 1 disables it. */
+int
+benchmark_config_group_commit_set(BENCHMARK_CONFIG_H config_handle,
+                                  unsigned int       window_usec,
+                                  int                max_batch);
+
+/* Retries of a transaction that lost a lock conflict, with a
+ * jittered exponential backoff between backoff_usec and 
+ * max_backoff_usec. max_retries = 0 disables retrying. */
+int
+benchmark_config_retry_set(BENCHMARK_CONFIG_H config_handle,
+                           int                max_retries,
+                           unsigned int       backoff_usec,
+                           unsigned int       max_backoff_usec);
+
+/* The initial load puts batch_rows rows per transaction with bulk
+ * puts (default 1000). With not_durable set, the tables of a handle
+ * that loads them, from datafiles or from an image, do not write the
+ * log, for as long as the handle is open. */
+int
+benchmark_config_bulk_load_set(BENCHMARK_CONFIG_H config_handle,
+                               int                batch_rows,
+                               int                not_durable);
+
+/* With num_threads > 1, the initial load reads Personal and Currencies
+ * in threads of their own while Stocks and Quotes are loaded, and
+ * splits every datafile of a few MB or more in up to num_threads
+ * chunks loaded in parallel. Progress lines are not printed then. */
+int
+benchmark_config_parallel_load_set(BENCHMARK_CONFIG_H config_handle,
+                                   int                num_threads);
+
+/* The initial load generates num_accounts accounts and num_symbols
+ * stocks and quotes instead of reading the datafiles (currencies are
+ * still read), and benchmark_load_portfolio() generates
+ * num_portfolios holdings. Holdings per account and symbols held
+ * are Zipfian with the given skew in [0, 1), 0 being uniform.
+ * Accounts are numbered from 1. The same seed gives the same data. */
+int
+benchmark_config_generator_set(BENCHMARK_CONFIG_H config_handle,
+                               unsigned long      num_accounts,
+                               unsigned long      num_symbols,
+                               unsigned long      num_portfolios,
+                               double             skew,
+                               unsigned long      seed);
+
+/* benchmark_ingest_run() parses up to ring_size ticks ahead of the
+ * ones being applied, and applies up to batch_max of them in each
+ * transaction. */
+int
+benchmark_config_ingest_set(BENCHMARK_CONFIG_H config_handle,
+                            int                ring_size,
+                            int                batch_max);
+
+int
+benchmark_retry_stats_get(BENCHMARK_H    benchmark_handle,
+                          int            xact_type,
+                          unsigned long *attempts,
+                          unsigned long *deadlocks,
+                          unsigned long *retries,
+                          unsigned long *exhausted);
+
+/* Counts the records of a table (BENCHMARK_TABLE_*). Every record
+ * is visited, so this is meant for checks rather than for the
+ * workload. */
+int
+benchmark_table_rows_get(BENCHMARK_H    benchmark_handle,
+                         int            table,
+                         unsigned long *rows);
+
+int
+benchmark_lock_stats_get(BENCHMARK_H    benchmark_handle,
+                         unsigned long *nrequests,
+                         unsigned long *nwaits,
+                         unsigned long *ndeadlocks);
+
+/* Cursors opened for transactions, and opens saved by the cursor cache */
+int
+benchmark_cursor_stats_get(BENCHMARK_H    benchmark_handle,
+                           unsigned long *opened,
+                           unsigned long *reused);
+
+/* Snapshot transactions running (and the most ever running), every
+ * page in the cache, and old page versions frozen to disk and freed.
+ * cached_pages counts current pages and old versions alike; it is
+ * not the memory taken by the versions alone. */
+int
+benchmark_mvcc_stats_get(BENCHMARK_H    benchmark_handle,
+                         unsigned long *nsnapshots,
+                         unsigned long *maxnsnapshots,
+                         unsigned long *cached_pages,
+                         unsigned long *frozen,
+                         unsigned long *freed);
+
+/* Heap allocations since the process started, counting every thread:
+ * those of the library itself, and the memory Berkeley DB hands to the
+ * library through the allocation functions of the environment. The
+ * allocations Berkeley DB makes for its own use (locks, transaction
+ * handles, and the like) are not counted. Reads should leave it
+ * unchanged. */
+int
+benchmark_alloc_count_get(BENCHMARK_H    benchmark_handle,
+                          unsigned long *count);
+
 int
 benchmark_load_portfolio(BENCHMARK_H benchmark_handle);
 
@@ -40,6 +281,53 @@ benchmark_refresh_quotes_list(int            num_symbols,
                               const char   **symbols_list,
                               float         *prices_list,
                               void          *benchmark_handle);
+
+/* status_list[i] is 0 if symbols_list[i] was updated */
+int
+benchmark_refresh_quotes_batch(int            num_symbols,
+                               const char   **symbols_list,
+                               float         *prices_list,
+                               int           *status_list,
+                               void          *benchmark_handle);
+
+/*
+ * Quote ticks. A text stream has a tick per line:
+ *
+ *   symbol#price#bid#ask#volume#timestamp
+ *
+ * where the fields after the price may be empty, "None" or "n/a", or
+ * left out; a tick without a known price is rejected. A binary stream
+ * is a sequence of benchmark_tick_t in host byte order. bid, ask and
+ * volume are negative, and timestamp is 0, when not given. timestamp
+ * is in seconds since the epoch and sets the trade date of the quote,
+ * and the volume of a tick adds to the volume of the day.
+ */
+#define BENCHMARK_TICKS_TEXT    0
+#define BENCHMARK_TICKS_BINARY  1
+
+typedef struct benchmark_tick_t {
+  char       symbol[16];      /* NUL terminated */
+  float      price;
+  float      bid;
+  float      ask;
+  int        reserved;
+  long long  volume;
+  long long  timestamp;
+} benchmark_tick_t;
+
+/* Replays the ticks of path, which may be a file, a FIFO, or "-" for
+ * the standard input, until its end. A thread applies the ticks, in
+ * order, in batches of one transaction each while the caller parses
+ * the ones that follow. The ingest rate and the backlog of parsed
+ * ticks are printed every second. applied receives the ticks applied,
+ * and rejected the ones that were malformed or of unknown symbols. */
+int
+benchmark_ingest_run(BENCHMARK_H     benchmark_handle,
+                     const char     *path,
+                     int             format,
+                     unsigned long  *applied,
+                     unsigned long  *rejected);
+
 int
 benchmark_view_stock(BENCHMARK_H benchmark_handle, 
                      int *symbolP);
@@ -55,6 +343,13 @@ benchmark_view_portfolio(BENCHMARK_H  benchmark_handle);
 int
 benchmark_purchase2(BENCHMARK_DATA_PACKET_H data_packetH,
                     BENCHMARK_H           benchmark_handle);
+/* Portfolios holding symbol, and how many of them have pending orders */
+int
+benchmark_symbol_holders_get(BENCHMARK_H  benchmark_handle,
+                             int          symbol,
+                             int         *num_holders,
+                             int         *num_pending);
+
 int
 benchmark_view_portfolio2(int           num_accounts, 
                           const char    **account_list_P, 
@@ -99,6 +394,8 @@ benchmark_data_packet_alloc(size_t reqsz,
 int
 benchmark_data_packet_free(BENCHMARK_DATA_PACKET_H data_packetH);
 
+/* symbol may be NULL, in which case symbolId must be the position of 
+ * the symbol in the list returned by benchmark_stock_list_get() */
 int
 benchmark_data_packet_append(const char  *accountId,
                              int          symbolId,
@@ -107,4 +404,161 @@ benchmark_data_packet_append(const char  *accountId,
                              int          amount,
                              BENCHMARK_DATA_PACKET_H data_packetH);
 
+/* Outcome of each entry of a packet after benchmark_purchase2() or
+ * benchmark_sell2(). Unless the packet runs with partial commits, 
+ * all the entries share the outcome of the packet. */
+#define BENCHMARK_ITEM_PENDING    (-1)    /* Not run yet */
+#define BENCHMARK_ITEM_APPLIED    (0)
+#define BENCHMARK_ITEM_FAILED     (1)
+
+int
+benchmark_data_packet_status_get(BENCHMARK_DATA_PACKET_H  data_packetH,
+                                 int                      idx,
+                                 int                     *status);
+
+/*
+ * Asynchronous packets. The submit calls queue the packet and return;
+ * a worker of the handle applies it later, possibly in the same
+ * transaction as other packets. The packet belongs to the library
+ * until it completes. On completion done is called, from the worker
+ * thread, with the outcome of the packet; done may be NULL. If
+ * ticketP is not NULL, it receives a ticket that must be given to
+ * benchmark_ticket_wait(), which returns the outcome and frees it.
+ */
+typedef void (*benchmark_order_done_fn)(BENCHMARK_DATA_PACKET_H  data_packetH,
+                                        int                      status,
+                                        void                    *argP);
+
+int
+benchmark_purchase2_submit(BENCHMARK_DATA_PACKET_H   data_packetH,
+                           benchmark_order_done_fn   done,
+                           void                     *argP,
+                           BENCHMARK_TICKET_H       *ticketP,
+                           BENCHMARK_H               benchmark_handle);
+
+int
+benchmark_sell2_submit(BENCHMARK_DATA_PACKET_H   data_packetH,
+                       benchmark_order_done_fn   done,
+                       void                     *argP,
+                       BENCHMARK_TICKET_H       *ticketP,
+                       BENCHMARK_H               benchmark_handle);
+
+int
+benchmark_ticket_poll(BENCHMARK_TICKET_H  ticketH,
+                      int                *done);
+
+int
+benchmark_ticket_wait(BENCHMARK_TICKET_H  ticketH,
+                      int                *status);
+
+/* Packets submitted and completed, and transactions that applied
+ * more than one packet */
+int
+benchmark_order_queue_stats_get(BENCHMARK_H    benchmark_handle,
+                                unsigned long *submitted,
+                                unsigned long *completed,
+                                unsigned long *groups);
+
+/* Group commit batches applied, the calls in them, and the largest
+ * batch */
+int
+benchmark_group_commit_stats_get(BENCHMARK_H    benchmark_handle,
+                                 unsigned long *batches,
+                                 unsigned long *items,
+                                 unsigned long *largest);
+
+/*
+ * Per worker thread context. Each worker thread allocates its own
+ * context, and calls the _ctx variants of the API with it. These use
+ * the context's random number generator, buffers and counters, so
+ * they don't allocate memory or write to state shared between threads.
+ * seed makes the random choices of a thread repeatable.
+ */
+int
+benchmark_thread_ctx_alloc(BENCHMARK_H             benchmark_handle,
+                           unsigned int            seed,
+                           BENCHMARK_THREAD_CTX_H *thread_ctx_handle);
+
+int
+benchmark_thread_ctx_free(BENCHMARK_THREAD_CTX_H thread_ctx_handle);
+
+/* Isolation of the read only calls made with the context, so that a
+ * dashboard thread can read uncommitted quotes while the others don't.
+ * BENCHMARK_ISOLATION_DEFAULT goes back to the handle's */
+int
+benchmark_thread_ctx_isolation_set(BENCHMARK_THREAD_CTX_H thread_ctx_handle,
+                                   int                    isolation);
+
+int
+benchmark_view_stock_ctx(BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                         int                    *symbolP);
+
+int
+benchmark_view_stock2_ctx(int                      num_symbols,
+                          const char             **symbol_list_P,
+                          BENCHMARK_THREAD_CTX_H   thread_ctx_handle);
+
+int
+benchmark_view_portfolio_ctx(BENCHMARK_THREAD_CTX_H thread_ctx_handle);
+
+int
+benchmark_view_portfolio2_ctx(int                      num_accounts,
+                              const char             **account_list_P,
+                              BENCHMARK_THREAD_CTX_H   thread_ctx_handle);
+
+int
+benchmark_symbol_holders_get_ctx(BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                                 int                     symbol,
+                                 int                    *num_holders,
+                                 int                    *num_pending);
+
+int
+benchmark_purchase_ctx(int                     account,
+                       int                     symbol,
+                       float                   price,
+                       int                     amount,
+                       int                     force_apply,
+                       BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                       int                    *symbolP);
+
+int
+benchmark_purchase2_ctx(BENCHMARK_DATA_PACKET_H data_packetH,
+                        BENCHMARK_THREAD_CTX_H  thread_ctx_handle);
+
+int
+benchmark_sell_ctx(int                     account,
+                   int                     symbol,
+                   float                   price,
+                   int                     amount,
+                   int                     force_apply,
+                   BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                   int                    *symbol_ret);
+
+int
+benchmark_sell2_ctx(BENCHMARK_DATA_PACKET_H data_packetH,
+                    BENCHMARK_THREAD_CTX_H  thread_ctx_handle);
+
+int
+benchmark_refresh_quotes_ctx(BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                             int                    *symbolP,
+                             float                   newValue);
+
+int
+benchmark_refresh_quotes2_ctx(BENCHMARK_THREAD_CTX_H  thread_ctx_handle,
+                              const char             *symbolP,
+                              float                   newValue);
+
+int
+benchmark_refresh_quotes_list_ctx(int                      num_symbols,
+                                  const char             **symbols_list,
+                                  float                   *prices_list,
+                                  BENCHMARK_THREAD_CTX_H   thread_ctx_handle);
+
+int
+benchmark_refresh_quotes_batch_ctx(int                      num_symbols,
+                                   const char             **symbols_list,
+                                   float                   *prices_list,
+                                   int                     *status_list,
+                                   BENCHMARK_THREAD_CTX_H   thread_ctx_handle);
+
 #endif
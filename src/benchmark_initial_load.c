@@ -17,10 +17,117 @@
  */
 
 #include "common/benchmark_common.h"
+#include <pthread.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+
+/* Size of the buffer of a bulk put */
+#define LOAD_BULK_SIZE    (1024 * 1024)
+
+/* A file is only split in chunks of at least this many bytes */
+#define LOAD_CHUNK_MIN    (1024 * 1024)
+
+/* A generated table is only split in chunks of at least this many rows */
+#define LOAD_GENERATE_CHUNK_MIN    (100000)
+
+/* A row parsed from a datafile, and the key and data to put */
+typedef struct load_row_t {
+  void      *keyP;              /* NULL skips the row */
+  u_int32_t  key_size;
+  void      *dataP;
+  u_int32_t  data_size;
+  union {
+    PERSONAL  personal;
+    STOCK     stock;
+    CURRENCY  currency;
+    QUOTE     quote;
+  } u;
+} load_row_t;
+
+/* Returns BENCHMARK_FAIL for lines that cannot be parsed */
+typedef int (*load_parse_fn)(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP);
+
+/* Adds the generated rows [first, last) to the batch */
+typedef int (*load_generate_fn)(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP);
+
+/* How one datafile is loaded into its table. Generated tables have
+ * no file, and produce num_rows rows with generate instead */
+typedef struct load_table_t {
+  const char       *name;
+  const char       *file;
+  datafile_t        data;
+  DB               *dbP;
+  u_int32_t         put_flags;
+  load_parse_fn     parse;
+  load_generate_fn  generate;
+  u_int64_t         num_rows;
+} load_table_t;
+
+/* A byte range of a datafile, or a range of rows of a generated
+ * table. A line belongs to the chunk that holds its first byte */
+typedef struct load_chunk_t {
+  pthread_t       thread;
+  BENCHMARK_DBS  *benchmarkP;
+  load_table_t   *tableP;
+  size_t          start;
+  size_t          end;
+  long            rows;
+  long            truncated;    /* Fields cut to fit their record */
+  int             rc;
+} load_chunk_t;
+
+/* A table loaded by a thread of its own */
+typedef struct load_worker_t {
+  pthread_t       thread;
+  BENCHMARK_DBS  *benchmarkP;
+  const char     *file;
+  int           (*load_fn)(BENCHMARK_DBS *benchmarkP, const char *file);
+  int             rc;
+} load_worker_t;
 
 /*============================================================================
  *                          PROTOTYPES
  *============================================================================*/
+static int
+load_table(BENCHMARK_DBS *benchmarkP, load_table_t *tableP);
+
+static int
+load_chunk(load_chunk_t *chunkP);
+
+static void *
+load_chunk_main(void *argP);
+
+static int
+load_worker_start(load_worker_t *workerP, BENCHMARK_DBS *benchmarkP, const char *file,
+                  int (*load_fn)(BENCHMARK_DBS *benchmarkP, const char *file));
+
+static int
+load_worker_join(load_worker_t *workerP);
+
+static int
+parse_personal(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP);
+
+static int
+parse_stock(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP);
+
+static int
+parse_currency(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP);
+
+static int
+parse_quote(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP);
+
+static int
+generate_personal(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP);
+
+static int
+generate_stocks(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP);
+
+static int
+generate_quotes(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP);
+
+static int
+generate_holdings(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP);
+
 static int
 load_currencies_database(BENCHMARK_DBS *benchmarkP, const char *currencies_file);
 
@@ -33,19 +140,48 @@ load_personal_database(BENCHMARK_DBS *benchmarkP, const char *personal_file);
 static int
 load_quotes_database(BENCHMARK_DBS *benchmarkP, const char *quotes_file);
 
+BENCHMARK_DBS *
+benchmark_initial_load2(const char *program,
+                        const char *homedir, 
+                        const char *datafilesdir,
+                        void       *config_handle);
+
 BENCHMARK_DBS *
 benchmark_initial_load(const char *program,
                        const char *homedir, 
                        const char *datafilesdir) 
+{
+  return benchmark_initial_load2(program, homedir, datafilesdir, NULL);
+}
+
+/*
+ * Creates and loads the databases, opening the tables as described
+ * by config_handle (NULL means every table is a btree).
+ *
+ * With config.load_threads > 1, Personal and Currencies are loaded
+ * by threads of their own while this thread loads Stocks and then
+ * Quotes, and large files are split in chunks loaded in parallel.
+ */
+BENCHMARK_DBS *
+benchmark_initial_load2(const char *program,
+                        const char *homedir, 
+                        const char *datafilesdir,
+                        void       *config_handle) 
 {
   void *benchmarkP = NULL;
   char *personal_file = NULL;
   char *stocks_file = NULL;
   char *currencies_file = NULL;
   char *quotes_file = NULL;
+  load_worker_t personal_worker;
+  load_worker_t currencies_worker;
+  int parallel = 0;
   int size;
   int ret;
 
+  memset(&personal_worker, 0, sizeof(load_worker_t));
+  memset(&currencies_worker, 0, sizeof(load_worker_t));
+
   assert(homedir != NULL && homedir[0] != '\0');
   assert(datafilesdir != NULL && datafilesdir[0] != '\0');
   
@@ -82,35 +218,92 @@ benchmark_initial_load(const char *program,
   }
   snprintf(quotes_file, size, "%s/%s", datafilesdir, QUOTES_FILE);
  
-  if (benchmark_handle_alloc(&benchmarkP, 1, program, homedir, datafilesdir) != BENCHMARK_SUCCESS) {
+  if (benchmark_handle_alloc2(&benchmarkP, 1, program, homedir, datafilesdir, config_handle) != BENCHMARK_SUCCESS) {
     benchmark_error("Failed to allocate handle");
     goto failXit;
   }
 
-  ret = load_personal_database(benchmarkP, personal_file);
+  ret = generator_start(benchmarkP);
   if (ret) {
-    benchmark_error("Error loading personal database.");
+    benchmark_error("Error preparing the dataset generator.");
     goto failXit;
   }
 
+  parallel = (((BENCHMARK_DBS *)benchmarkP)->config.load_threads > 1);
+
+  if (parallel) {
+    ret = load_worker_start(&personal_worker, benchmarkP, personal_file, load_personal_database);
+    if (ret) {
+      goto failXit;
+    }
+
+    ret = load_worker_start(&currencies_worker, benchmarkP, currencies_file, load_currencies_database);
+    if (ret) {
+      goto failXit;
+    }
+  }
+  else {
+    ret = load_personal_database(benchmarkP, personal_file);
+    if (ret) {
+      benchmark_error("Error loading personal database.");
+      goto failXit;
+    }
+  }
+
   ret = load_stocks_database(benchmarkP, stocks_file);
   if (ret) {
     benchmark_error("Error loading stocks database.");
     goto failXit;
   }
 
-  ret = load_currencies_database(benchmarkP, currencies_file);
+  /* Quotes are keyed by symbol id, so the dictionary must be 
+   * built from the Stocks table before loading them */
+  ret = symbol_dict_load(benchmarkP);
   if (ret) {
-    benchmark_error("Error loading currencies database.");
+    benchmark_error("Error building symbol dictionary.");
     goto failXit;
   }
 
+  if (!parallel) {
+    ret = load_currencies_database(benchmarkP, currencies_file);
+    if (ret) {
+      benchmark_error("Error loading currencies database.");
+      goto failXit;
+    }
+  }
+
   ret = load_quotes_database(benchmarkP, quotes_file);
   if (ret) {
     benchmark_error("Error loading personal database.");
     goto failXit;
   }
- 
+
+  if (parallel) {
+    ret = load_worker_join(&personal_worker);
+    if (ret) {
+      benchmark_error("Error loading personal database.");
+      goto failXit;
+    }
+
+    ret = load_worker_join(&currencies_worker);
+    if (ret) {
+      benchmark_error("Error loading currencies database.");
+      goto failXit;
+    }
+  }
+
+  ret = quote_cache_load(benchmarkP);
+  if (ret) {
+    benchmark_error("Error loading quote cache.");
+    goto failXit;
+  }
+
+  ret = catalog_freeze(benchmarkP);
+  if (ret) {
+    benchmark_error("Error freezing catalog.");
+    goto failXit;
+  }
+
   BENCHMARK_CLEAR_CREATE_DB(benchmarkP);
 
 #if 0
@@ -125,6 +318,10 @@ benchmark_initial_load(const char *program,
   goto cleanup;
 
 failXit:
+  /* The loading threads use the handle */
+  load_worker_join(&personal_worker);
+  load_worker_join(&currencies_worker);
+
   if (benchmark_handle_free(benchmarkP) != BENCHMARK_SUCCESS) {
     benchmark_error("Failed to free handle");
   }
@@ -141,462 +338,764 @@ cleanup:
 }
 
 
+static int
+parse_personal(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP)
+{
+  PERSONAL *my_personal = &rowP->u.personal;
+
+  if (datafile_parse_personal(cursorP, my_personal) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  /*
+   * Note that given the way we built our struct, there's extra
+   * bytes in it. Essentially we're using fixed-width fields with
+   * the unused portion of some fields padded with zeros. This
+   * is the easiest thing to do, but it does result in a bloated
+   * database.
+   */
+  rowP->keyP = my_personal->account_id;
+  rowP->key_size = (u_int32_t)strlen(my_personal->account_id) + 1;
+  rowP->dataP = my_personal;
+  rowP->data_size = sizeof(PERSONAL);
+
+  benchmark_debug(4,"Inserting into Personal table: %s", my_personal->account_id);
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+parse_stock(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP)
+{
+  STOCK *my_stocks = &rowP->u.stock;
+
+  if (datafile_parse_stock(cursorP, my_stocks) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  rowP->keyP = my_stocks->stock_symbol;
+  rowP->key_size = (u_int32_t)strlen(my_stocks->stock_symbol) + 1;
+  rowP->dataP = my_stocks;
+  rowP->data_size = sizeof(STOCK);
+
+  benchmark_debug(4,"Inserting into Stocks table: %s", my_stocks->stock_symbol);
+  benchmark_debug(4, "\t(%s, %s)", my_stocks->stock_symbol, my_stocks->full_name);
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+parse_currency(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP)
+{
+  CURRENCY *my_currencies = &rowP->u.currency;
+
+  if (datafile_parse_currency(cursorP, my_currencies) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  rowP->keyP = my_currencies->currency_symbol;
+  rowP->key_size = (u_int32_t)strlen(my_currencies->currency_symbol) + 1;
+  rowP->dataP = my_currencies;
+  rowP->data_size = sizeof(CURRENCY);
+
+  benchmark_debug(4,"Inserting into Currencies table: %s", my_currencies->currency_symbol);
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+parse_quote(datafile_cursor_t *cursorP, load_row_t *rowP, BENCHMARK_DBS *benchmarkP)
+{
+  QUOTE *quote = &rowP->u.quote;
+
+  if (datafile_parse_quote(cursorP, quote) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  /* Set all quotes to 500 to start with */
+  quote->current_price = 500.0;
+
+  rowP->keyP = NULL;
+  if (symbol_dict_lookup(quote->symbol, &quote->symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_warning("Skipping quote for unlisted symbol: %s", quote->symbol);
+    return BENCHMARK_SUCCESS;
+  }
+
+  rowP->keyP = &quote->symbol_id;
+  rowP->key_size = sizeof(u_int32_t);
+  rowP->dataP = quote;
+  rowP->data_size = sizeof(QUOTE);
+
+  benchmark_debug(6,"Inserting into Quotes table: %s", quote->symbol);
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+generate_personal(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP)
+{
+  PERSONAL personal;
+  u_int64_t i;
+
+  for (i = first; i < last; i++) {
+    if (generator_personal(benchmarkP, i, &personal) != BENCHMARK_SUCCESS
+        || load_batch_add(batchP, personal.account_id, (u_int32_t)strlen(personal.account_id) + 1,
+                          &personal, sizeof(PERSONAL)) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+generate_stocks(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP)
+{
+  STOCK stock;
+  u_int64_t i;
+
+  for (i = first; i < last; i++) {
+    generator_stock(benchmarkP, i, &stock);
+    if (load_batch_add(batchP, stock.stock_symbol, (u_int32_t)strlen(stock.stock_symbol) + 1,
+                       &stock, sizeof(STOCK)) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+generate_quotes(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP)
+{
+  QUOTE quote;
+  u_int64_t i;
+
+  for (i = first; i < last; i++) {
+    if (generator_quote(benchmarkP, i, &quote) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+    if (load_batch_add(batchP, &quote.symbol_id, sizeof(u_int32_t),
+                       &quote, sizeof(QUOTE)) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+generate_holding(PORTFOLIOS *portfolioP, void *argP)
+{
+  load_batch_t *batchP = argP;
+  u_int32_t portfolio_id;
+
+  if (portfolio_id_next(batchP->benchmarkP, &portfolio_id) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  /* Big endian, so that the inserts go in key order */
+  portfolioP->portfolio_id = htonl(portfolio_id);
+
+  return load_batch_add(batchP, &portfolioP->portfolio_id, sizeof(u_int32_t),
+                        portfolioP, sizeof(PORTFOLIOS));
+}
+
+/* Rows are accounts here, each adding its holdings */
+static int
+generate_holdings(BENCHMARK_DBS *benchmarkP, u_int64_t first, u_int64_t last, load_batch_t *batchP)
+{
+  return generator_holdings(benchmarkP, first, last, generate_holding, batchP);
+}
+
 static int
 load_personal_database(BENCHMARK_DBS *benchmarkP, const char *personal_file)
 {
-  int     rc = 0;
-  int     cnt = 0;
-  DBT     key, data;
-  DB_TXN *txnP = NULL;
-  DB_ENV  *envP = NULL;
-  char buf[MAXLINE];
-  FILE *ifp;
-  PERSONAL my_personal;
+  load_table_t table;
+
+  memset(&table, 0, sizeof(load_table_t));
 
   if (benchmarkP == NULL) {
     goto failXit;
   }
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  envP = benchmarkP->envP;
-  if (envP == NULL || personal_file == NULL) {
+  if (benchmarkP->envP == NULL || benchmarkP->personal_dbp == NULL || personal_file == NULL) {
     benchmark_error("%s: Invalid arguments", __func__);
     goto failXit;
   }
 
-  benchmark_info("-- Loading Personal database from: %s... ", personal_file);
+  table.name = "Personal";
+  table.file = personal_file;
+  table.dbP = benchmarkP->personal_dbp;
+  table.put_flags = DB_NOOVERWRITE;
+  table.parse = parse_personal;
 
-  ifp = fopen(personal_file, "r");
-  if (ifp == NULL) {
-    benchmark_error("Error opening file '%s'", personal_file);
-    goto failXit;
+  if (GENERATOR_ENABLED(benchmarkP)) {
+    table.generate = generate_personal;
+    table.num_rows = benchmarkP->config.gen_accounts;
   }
 
-  fprintf(stderr,"Inserted: %3d rows", 0); 
-
-  /* Iterate over the vendor file */
-  while (fgets(buf, MAXLINE, ifp) != NULL) {
-
-    /* zero out the structure */
-    memset(&my_personal, 0, sizeof(PERSONAL));
-
-    /* Zero out the DBTs */
-    memset(&key, 0, sizeof(DBT));
-    memset(&data, 0, sizeof(DBT));
-
-    /*
-     * Scan the line into the structure.
-     * Convenient, but not particularly safe.
-     * In a real program, there would be a lot more
-     * defensive code here.
-     */
-    sscanf(buf,
-      "%10[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%16[^\n]",
-      my_personal.account_id, my_personal.last_name,
-      my_personal.first_name, my_personal.address,
-      my_personal.city,
-      my_personal.state, my_personal.country,
-      my_personal.phone);
-
-    /* Now that we have our structure we can load it into the database. */
-
-    /* Set up the database record's key */
-    key.data = my_personal.account_id;
-    key.size = (u_int32_t)strlen(my_personal.account_id) + 1;
-
-    /* Set up the database record's data */
-    data.data = &my_personal;
-    data.size = sizeof(PERSONAL);
-
-    /*
-     * Note that given the way we built our struct, there's extra
-     * bytes in it. Essentially we're using fixed-width fields with
-     * the unused portion of some fields padded with zeros. This
-     * is the easiest thing to do, but it does result in a bloated
-     * database. 
-     */
-
-    cnt ++;
-    /* Put the data into the database */
-    benchmark_debug(4,"Inserting into Personal table (%d): %s", cnt, (char *)key.data);
-
-    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction begin failed.", __LINE__, getpid());
-      goto failXit; 
-    }
+  return load_table(benchmarkP, &table);
 
-    assert(txnP != NULL);
-    assert(benchmarkP->personal_dbp != NULL);
+failXit:
+  return BENCHMARK_FAIL;
+}
 
-    rc = benchmarkP->personal_dbp->put(benchmarkP->personal_dbp, txnP, &key, &data, DB_NOOVERWRITE);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Database put failed.", __LINE__, getpid());
-      txnP->abort(txnP);
-      goto failXit; 
-    }
+static int
+load_stocks_database(BENCHMARK_DBS *benchmarkP, const char *stocks_file)
+{
+  load_table_t table;
 
-    rc = txnP->commit(txnP, 0);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction commit failed.", __LINE__, getpid());
-      goto failXit; 
-    }
-    fprintf(stderr,"\rInserted: %3d rows", cnt); 
-  }
-  fprintf(stderr, "\n");
+  memset(&table, 0, sizeof(load_table_t));
 
-  fclose(ifp);
+  if (benchmarkP == NULL) {
+    goto failXit;
+  }
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  return BENCHMARK_SUCCESS;
 
-failXit:
-  if (ifp != NULL) {
-    fclose(ifp);
+  if (benchmarkP->envP == NULL || benchmarkP->stocks_dbp == NULL || stocks_file == NULL) {
+    benchmark_error("%s: Invalid arguments", __func__);
+    goto failXit;
   }
 
+  table.name = "Stocks";
+  table.file = stocks_file;
+  table.dbP = benchmarkP->stocks_dbp;
+  table.put_flags = DB_NOOVERWRITE;
+  table.parse = parse_stock;
+
+  if (GENERATOR_ENABLED(benchmarkP)) {
+    table.generate = generate_stocks;
+    table.num_rows = benchmarkP->config.gen_symbols;
+  }
+
+  return load_table(benchmarkP, &table);
+
+failXit:
   return BENCHMARK_FAIL;
 }
 
 static int
-load_stocks_database(BENCHMARK_DBS *benchmarkP, const char *stocks_file)
+load_currencies_database(BENCHMARK_DBS *benchmarkP, const char *currencies_file)
 {
-  int     rc = 0;
-  int     cnt = 0;
-  DBT key, data;
-  DB_TXN *txnP = NULL;
-  DB_ENV  *envP = NULL;
-  char buf[MAXLINE];
-  char ignore_buf[500];
-  FILE *ifp;
-  STOCK my_stocks;
+  load_table_t table;
+
+  memset(&table, 0, sizeof(load_table_t));
 
   if (benchmarkP == NULL) {
     goto failXit;
   }
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  envP = benchmarkP->envP;
-  if (envP == NULL || stocks_file == NULL) {
+  if (benchmarkP->envP == NULL || benchmarkP->currencies_dbp == NULL || currencies_file == NULL) {
     benchmark_error("%s: Invalid arguments", __func__);
     goto failXit;
   }
 
-  benchmark_info("-- Loading Stocks database from: %s... ", stocks_file);
+  table.name = "Currencies";
+  table.file = currencies_file;
+  table.dbP = benchmarkP->currencies_dbp;
+  table.put_flags = 0; /* Same currency for multiple contries*/
+  table.parse = parse_currency;
+
+  return load_table(benchmarkP, &table);
 
-  ifp = fopen(stocks_file, "r");
-  if (ifp == NULL) {
-    benchmark_error("Error opening file '%s'", stocks_file);
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+static int
+load_quotes_database(BENCHMARK_DBS *benchmarkP, const char *quotes_file)
+{
+  load_table_t table;
+
+  memset(&table, 0, sizeof(load_table_t));
+
+  if (benchmarkP == NULL) {
     goto failXit;
   }
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  fprintf(stderr,"Inserted: %3d rows", 0); 
+  if (benchmarkP->envP == NULL || benchmarkP->quotes_dbp == NULL || quotes_file == NULL) {
+    benchmark_error( "%s: Invalid arguments", __func__);
+    goto failXit;
+  }
+
+  table.name = "Quotes";
+  table.file = quotes_file;
+  table.dbP = benchmarkP->quotes_dbp;
+  table.put_flags = DB_NOOVERWRITE;
+  table.parse = parse_quote;
+
+  if (GENERATOR_ENABLED(benchmarkP)) {
+    table.generate = generate_quotes;
+    table.num_rows = benchmarkP->config.gen_symbols;
+  }
+
+  return load_table(benchmarkP, &table);
+
+failXit:
+  return BENCHMARK_FAIL;
+}
 
-  /* Iterate over the vendor file */
-  while (fgets(buf, MAXLINE, ifp) != NULL) {
+/*
+ * Generates the holdings of the accounts of the generated dataset
+ * into the Portfolios table.
+ */
+int
+generate_portfolios(BENCHMARK_DBS *benchmarkP)
+{
+  load_table_t table;
+
+  if (benchmarkP == NULL) {
+    goto failXit;
+  }
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-    /* zero out the structure */
-    memset(&my_stocks, 0, sizeof(STOCK));
+  if (benchmarkP->envP == NULL || benchmarkP->portfolios_dbp == NULL || !GENERATOR_ENABLED(benchmarkP)) {
+    benchmark_error("%s: Invalid arguments", __func__);
+    goto failXit;
+  }
 
-    /* Zero out the DBTs */
-    memset(&key, 0, sizeof(DBT));
-    memset(&data, 0, sizeof(DBT));
+  memset(&table, 0, sizeof(load_table_t));
+  table.name = "Portfolios";
+  table.dbP = benchmarkP->portfolios_dbp;
+  table.put_flags = DB_NOOVERWRITE;
+  table.generate = generate_holdings;
+  table.num_rows = benchmarkP->config.gen_accounts;
 
-    /*
-     * Scan the line into the structure.
-     * Convenient, but not particularly safe.
-     * In a real program, there would be a lot more
-     * defensive code here.
-     */
-    sscanf(buf,
-      "%10[^#]#%128[^#]#%500[^\n]",
-      my_stocks.stock_symbol, my_stocks.full_name, ignore_buf);
+  return load_table(benchmarkP, &table);
 
-    /* Now that we have our structure we can load it into the database. */
+failXit:
+  return BENCHMARK_FAIL;
+}
 
-    /* Set up the database record's key */
-    key.data = my_stocks.stock_symbol;
-    key.size = (u_int32_t)strlen(my_stocks.stock_symbol) + 1;
+/*
+ * Loads a datafile into its table and reports the load rate. Files
+ * of several LOAD_CHUNK_MIN bytes are split in up to
+ * config.load_threads chunks, each loaded by a thread of its own.
+ * Generated tables are split the same way by rows.
+ */
+static int
+load_table(BENCHMARK_DBS *benchmarkP, load_table_t *tableP)
+{
+  load_chunk_t  *chunks = NULL;
+  load_chunk_t   whole;
+  struct timeval start, end;
+  double         secs;
+  long           rows = 0;
+  long           truncated = 0;
+  int            num_chunks = 1;
+  int            started = 0;
+  int            rc = BENCHMARK_SUCCESS;
+  size_t         size;
+  int            i;
+
+  memset(&tableP->data, 0, sizeof(datafile_t));
+  tableP->data.fd = -1;
+
+  if (tableP->generate != NULL) {
+    benchmark_info("-- Generating %s database... ", tableP->name);
+    size = tableP->num_rows;
+  }
+  else {
+    benchmark_info("-- Loading %s database from: %s... ", tableP->name, tableP->file);
 
-    /* Set up the database record's data */
-    data.data = &my_stocks;
-    data.size = sizeof(STOCK);
+    if (datafile_open(tableP->file, &tableP->data) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+    size = tableP->data.size;
+  }
 
-    /*
-     * Note that given the way we built our struct, there's extra
-     * bytes in it. Essentially we're using fixed-width fields with
-     * the unused portion of some fields padded with zeros. This
-     * is the easiest thing to do, but it does result in a bloated
-     * database.
-     */ 
+  if (benchmarkP->config.load_threads > 1) {
+    num_chunks = size / (tableP->generate != NULL ? LOAD_GENERATE_CHUNK_MIN : LOAD_CHUNK_MIN);
+    if (num_chunks > benchmarkP->config.load_threads) {
+      num_chunks = benchmarkP->config.load_threads;
+    }
+    if (num_chunks < 1) {
+      num_chunks = 1;
+    }
+  }
 
-    /* Put the data into the database */
-    cnt ++;
-    benchmark_debug(4,"Inserting into Stocks table (%d): %s", cnt, (char *)key.data);
-    benchmark_debug(4, "\t(%s, %s)", my_stocks.stock_symbol, my_stocks.full_name);
+  gettimeofday(&start, NULL);
 
-    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction begin failed.", __LINE__, getpid());
-      goto failXit; 
+  if (num_chunks == 1) {
+    memset(&whole, 0, sizeof(load_chunk_t));
+    whole.benchmarkP = benchmarkP;
+    whole.tableP = tableP;
+    whole.start = 0;
+    whole.end = size;
+    if (load_chunk(&whole) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+    rows = whole.rows;
+    truncated = whole.truncated;
+  }
+  else {
+    chunks = calloc(num_chunks, sizeof(load_chunk_t));
+    if (chunks == NULL) {
+      benchmark_error("Could not allocate chunks");
+      goto failXit;
     }
 
-    rc = benchmarkP->stocks_dbp->put(benchmarkP->stocks_dbp, txnP, &key, &data, DB_NOOVERWRITE);
+    for (i = 0; i < num_chunks; i++) {
+      chunks[i].benchmarkP = benchmarkP;
+      chunks[i].tableP = tableP;
+      chunks[i].start = size / num_chunks * i;
+      chunks[i].end = (i == num_chunks - 1) ? size : size / num_chunks * (i + 1);
+      if (pthread_create(&chunks[i].thread, NULL, load_chunk_main, &chunks[i]) != 0) {
+        benchmark_error("Could not start loading thread");
+        rc = BENCHMARK_FAIL;
+        break;
+      }
+      started ++;
+    }
 
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Database put failed.", __LINE__, getpid());
-      txnP->abort(txnP);
-      goto failXit; 
+    for (i = 0; i < started; i++) {
+      pthread_join(chunks[i].thread, NULL);
+      if (chunks[i].rc != BENCHMARK_SUCCESS) {
+        rc = BENCHMARK_FAIL;
+      }
+      rows += chunks[i].rows;
+      truncated += chunks[i].truncated;
     }
 
-    rc = txnP->commit(txnP, 0);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction commit failed.", __LINE__, getpid());
-      goto failXit; 
+    free(chunks);
+
+    if (rc != BENCHMARK_SUCCESS) {
+      goto failXit;
     }
-    fprintf(stderr,"\rInserted: %3d rows", cnt); 
   }
-  fprintf(stderr, "\n");
 
-  fclose(ifp);
+  gettimeofday(&end, NULL);
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+
+  datafile_close(&tableP->data);
+
+  if (truncated > 0) {
+    benchmark_warning("%ld fields of %s were cut to fit the %s table", truncated, tableP->file, tableP->name);
+  }
+
+  benchmark_info("Loaded %ld rows into %s in %.2f s (%.0f rows/s, %d chunks)",
+                 rows, tableP->name, secs, secs > 0 ? rows / secs : 0.0, num_chunks);
+
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   return BENCHMARK_SUCCESS;
 
 failXit:
-  if (ifp != NULL) {
-    fclose(ifp);
-  }
-
+  datafile_close(&tableP->data);
   return BENCHMARK_FAIL;
 }
 
+/*
+ * Loads the lines of a datafile that start in [start, end), or
+ * generates the rows [start, end) of a generated table.
+ */
 static int
-load_currencies_database(BENCHMARK_DBS *benchmarkP, const char *currencies_file)
+load_chunk(load_chunk_t *chunkP)
 {
-  int     rc = 0;
-  int     cnt = 0;
-  DBT key, data;
-  DB_TXN *txnP = NULL;
-  DB_ENV  *envP = NULL;
-  char buf[MAXLINE];
-  FILE *ifp;
-  CURRENCY my_currencies;
+  load_table_t *tableP = chunkP->tableP;
+  load_row_t *rowP = NULL;
+  load_batch_t batch;
+  datafile_cursor_t cursor;
 
-  if (benchmarkP == NULL) {
+  memset(&batch, 0, sizeof(load_batch_t));
+  memset(&cursor, 0, sizeof(datafile_cursor_t));
+
+  rowP = malloc(sizeof(load_row_t));
+  if (rowP == NULL) {
+    benchmark_error("Failed to allocate memory.");
     goto failXit;
   }
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  envP = benchmarkP->envP;
-  if (envP == NULL || currencies_file == NULL) {
-    benchmark_error("%s: Invalid arguments", __func__);
+  if (load_batch_init(&batch, chunkP->benchmarkP, tableP->dbP,
+                      tableP->name, tableP->put_flags) != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  benchmark_info("-- Loading Currencies database from: %s... ", currencies_file);
+  if (!batch.quiet) {
+    fprintf(stderr,"Inserted: %3d rows", 0);
+  }
+
+  if (tableP->generate != NULL) {
+    if (tableP->generate(chunkP->benchmarkP, chunkP->start, chunkP->end, &batch) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+  else {
+    /* Iterate over the vendor file */
+    datafile_cursor_init(&tableP->data, chunkP->start, chunkP->end, &cursor);
+    while (datafile_cursor_next(&cursor)) {
+
+      if (tableP->parse(&cursor, rowP, chunkP->benchmarkP) != BENCHMARK_SUCCESS) {
+        benchmark_warning("Skipping malformed line at offset %lu of %s",
+                          (unsigned long) cursor.offset, tableP->file);
+        continue;
+      }
+
+      if (rowP->keyP == NULL) {
+        continue;
+      }
+
+      /* Put the data into the database */
+      if (load_batch_add(&batch, rowP->keyP, rowP->key_size,
+                         rowP->dataP, rowP->data_size) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+  }
 
-  ifp = fopen(currencies_file, "r");
-  if (ifp == NULL) {
-    benchmark_error("Error opening file '%s'", currencies_file);
+  if (load_batch_finish(&batch) != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  fprintf(stderr,"Inserted: %3d rows", 0); 
+  chunkP->rows = batch.rows;
+  chunkP->truncated = cursor.truncated;
+
+  free(rowP);
+  return BENCHMARK_SUCCESS;
 
-  /* Iterate over the vendor file */
-  while (fgets(buf, MAXLINE, ifp) != NULL) {
+failXit:
+  free(batch.bulk.data);
+  free(rowP);
 
-    /* zero out the structure */
-    memset(&my_currencies, 0, sizeof(CURRENCY));
+  return BENCHMARK_FAIL;
+}
 
-    /* Zero out the DBTs */
-    memset(&key, 0, sizeof(DBT));
-    memset(&data, 0, sizeof(DBT));
+static void *
+load_chunk_main(void *argP)
+{
+  load_chunk_t *chunkP = argP;
 
-    /*
-     * Scan the line into the structure.
-     * Convenient, but not particularly safe.
-     * In a real program, there would be a lot more
-     * defensive code here.
-     */
-    sscanf(buf,
-      "%200[^#]#%200[^#]#%10[^\n]",
-      my_currencies.country, my_currencies.currency_name, my_currencies.currency_symbol);
+  chunkP->rc = load_chunk(chunkP);
 
-    /* Now that we have our structure we can load it into the database. */
+  return NULL;
+}
 
-    /* Set up the database record's key */
-    key.data = my_currencies.currency_symbol;
-    key.size = (u_int32_t)strlen(my_currencies.currency_symbol) + 1;
+static void *
+load_worker_main(void *argP)
+{
+  load_worker_t *workerP = argP;
 
-    /* Set up the database record's data */
-    data.data = &my_currencies;
-    data.size = sizeof(CURRENCY);
+  workerP->rc = workerP->load_fn(workerP->benchmarkP, workerP->file);
 
-    /*
-     * Note that given the way we built our struct, there's extra
-     * bytes in it. Essentially we're using fixed-width fields with
-     * the unused portion of some fields padded with zeros. This
-     * is the easiest thing to do, but it does result in a bloated
-     * database. 
-     */
+  return NULL;
+}
 
-    /* Put the data into the database */
-    cnt ++;
-    benchmark_debug(4,"Inserting into Currencies table (%d): %s", cnt, (char *)key.data);
+/*
+ * Loads a table in a thread of its own.
+ */
+static int
+load_worker_start(load_worker_t *workerP, BENCHMARK_DBS *benchmarkP, const char *file,
+                  int (*load_fn)(BENCHMARK_DBS *benchmarkP, const char *file))
+{
+  workerP->benchmarkP = benchmarkP;
+  workerP->file = file;
+  workerP->load_fn = load_fn;
+  workerP->rc = BENCHMARK_FAIL;
+
+  if (pthread_create(&workerP->thread, NULL, load_worker_main, workerP) != 0) {
+    benchmark_error("Could not start loading thread");
+    workerP->load_fn = NULL;
+    return BENCHMARK_FAIL;
+  }
 
-    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction begin failed.", __LINE__, getpid());
-      goto failXit; 
-    }
+  return BENCHMARK_SUCCESS;
+}
 
-    rc = benchmarkP->currencies_dbp->put(benchmarkP->currencies_dbp, txnP, &key, &data, 0 /* Same currency for multiple contries*/);
+/*
+ * Waits for a table loaded by load_worker_start(). Does nothing if
+ * the worker was not started or was already joined.
+ */
+static int
+load_worker_join(load_worker_t *workerP)
+{
+  if (workerP->load_fn == NULL) {
+    return BENCHMARK_SUCCESS;
+  }
 
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Database put failed.", __LINE__, getpid());
-      txnP->abort(txnP);
-      goto failXit; 
-    }
+  pthread_join(workerP->thread, NULL);
+  workerP->load_fn = NULL;
 
-    rc = txnP->commit(txnP, 0);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction commit failed.", __LINE__, getpid());
-      goto failXit; 
-    }
+  return workerP->rc;
+}
+
+/*
+ * Prepares a batch of rows for the given table. Rows are put with
+ * put_flags, in transactions of config.load_batch_rows rows.
+ */
+int
+load_batch_init(load_batch_t *batchP, BENCHMARK_DBS *benchmarkP, DB *dbP,
+                const char *table, u_int32_t put_flags)
+{
+  memset(batchP, 0, sizeof(load_batch_t));
+  batchP->benchmarkP = benchmarkP;
+  batchP->dbP = dbP;
+  batchP->table = table;
+  batchP->put_flags = put_flags;
+  batchP->batch_rows = benchmarkP->config.load_batch_rows;
+  if (batchP->batch_rows <= 0) {
+    batchP->batch_rows = 1;
+  }
+  batchP->quiet = (benchmarkP->config.load_threads > 1);
 
-    fprintf(stderr,"\rInserted: %3d rows", cnt); 
+  batchP->bulk.data = malloc(LOAD_BULK_SIZE);
+  if (batchP->bulk.data == NULL) {
+    benchmark_error("Could not allocate bulk buffer");
+    goto failXit;
   }
-  fprintf(stderr, "\n");
+  batchP->bulk.ulen = LOAD_BULK_SIZE;
+  batchP->bulk.flags = DB_DBT_USERMEM;
+  DB_MULTIPLE_WRITE_INIT(batchP->bulkP, &batchP->bulk);
+
+  gettimeofday(&batchP->last_report, NULL);
 
-  fclose(ifp);
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
   return BENCHMARK_SUCCESS;
 
 failXit:
-  if (ifp != NULL) {
-    fclose(ifp);
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Appends a row to the batch, putting the batch first if the row
+ * does not fit, and afterwards if it is full.
+ */
+int
+load_batch_add(load_batch_t *batchP, void *keyP, u_int32_t key_size,
+               void *dataP, u_int32_t data_size)
+{
+  DB_MULTIPLE_KEY_WRITE_NEXT(batchP->bulkP, &batchP->bulk,
+                             keyP, key_size, dataP, data_size);
+  if (batchP->bulkP == NULL) {
+    if (batchP->pending == 0) {
+      benchmark_error("Row does not fit in the bulk buffer of %s", batchP->table);
+      goto failXit;
+    }
+
+    if (load_batch_flush(batchP) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+
+    DB_MULTIPLE_KEY_WRITE_NEXT(batchP->bulkP, &batchP->bulk,
+                               keyP, key_size, dataP, data_size);
+    if (batchP->bulkP == NULL) {
+      benchmark_error("Row does not fit in the bulk buffer of %s", batchP->table);
+      goto failXit;
+    }
+  }
+
+  batchP->pending ++;
+  if (batchP->pending >= batchP->batch_rows) {
+    return load_batch_flush(batchP);
   }
 
+  return BENCHMARK_SUCCESS;
+
+failXit:
   return BENCHMARK_FAIL;
 }
 
+/* One bulk put of the pending rows, in a transaction of its own */
 static int
-load_quotes_database(BENCHMARK_DBS *benchmarkP, const char *quotes_file)
+load_batch_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
 {
-  int     rc = 0;
-  int     current_slot = 0;
-  int     cnt = 0;
-  FILE   *ifp;
+  load_batch_t *batchP = argP;
+  DB_ENV *envP = benchmarkP->envP;
   DB_TXN *txnP = NULL;
-  DB_ENV *envP = NULL;
-  DBT     key, data;
-  QUOTE   quote;
-  char    buf[MAXLINE];
+  DBT     data;
+  int     rc;
 
-  if (benchmarkP == NULL) {
+  rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  envP = benchmarkP->envP;
-  if (envP == NULL || benchmarkP->quotes_dbp == NULL || quotes_file == NULL) {
-    benchmark_error( "%s: Invalid arguments", __func__);
+  /* The key holds the pairs; the data argument is not used */
+  memset(&data, 0, sizeof(DBT));
+  rc = batchP->dbP->put(batchP->dbP, txnP, &batchP->bulk, &data,
+                        DB_MULTIPLE_KEY | batchP->put_flags);
+  xact_conflict_note(rc);
+  if (rc != 0) {
+    if (!xact_conflict_pending()) {
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to put %d rows into %s.",
+                __FILE__, __LINE__, getpid(), batchP->pending, batchP->table);
+    }
+    txnP->abort(txnP);
     goto failXit;
   }
 
-  benchmark_info("-- Loading Quotes database from: %s... ", quotes_file);
-
-  ifp = fopen(quotes_file, "r");
-  if (ifp == NULL) {
-    benchmark_error("Error opening file '%s'", quotes_file);
+  rc = txnP->commit(txnP, 0);
+  xact_conflict_note(rc);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
-  fprintf(stderr,"Inserted: %3d rows", 0); 
-
-  /* Iterate over the vendor file */
-  while (fgets(buf, MAXLINE, ifp) != NULL) {
-
-    /* zero out the structure */
-    memset(&quote, 0, sizeof(QUOTE));
-
-    /* Zero out the DBTs */
-    memset(&key, 0, sizeof(DBT));
-    memset(&data, 0, sizeof(DBT));
-
-    /*
-     * Scan the line into the structure.
-     * Convenient, but not particularly safe.
-     * In a real program, there would be a lot more
-     * defensive code here.
-     */
-    sscanf(buf,
-      "%10[^#]#%f#%10[^#]#%f#%f#%f#%f#%f#%ld#%10[^\n]",
-      quote.symbol, &quote.current_price,
-      quote.trade_time, &quote.low_price_day,
-      &quote.high_price_day, &quote.perc_price_change, &quote.bidding_price,
-      &quote.asking_price, &quote.trade_volume, quote.market_cap);
-
-    /* Set all quotes to 500 to start with */
-    quote.current_price = 500.0;
-
-    /* Now that we have our structure we can load it into the database. */
-
-    /* Set up the database record's key */
-    key.data = quote.symbol;
-    key.size = (u_int32_t)strlen(quote.symbol) + 1;
-
-    /* Set up the database record's data */
-    data.data = &quote;
-    data.size = sizeof(QUOTE);
-
-    /*
-     * Note that given the way we built our struct, there's extra
-     * bytes in it. Essentially we're using fixed-width fields with
-     * the unused portion of some fields padded with zeros. This
-     * is the easiest thing to do, but it does result in a bloated
-     * database. 
-     */
-
-    /* Put the data into the database */
-    cnt ++;
-    benchmark_debug(6,"Inserting into Quotes table (%d): %s", cnt, (char *)key.data);
-
-    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction begin failed.", __LINE__, getpid());
-      goto failXit; 
-    }
+  return BENCHMARK_SUCCESS;
 
-    rc = benchmarkP->quotes_dbp->put(benchmarkP->quotes_dbp, txnP, &key, &data, DB_NOOVERWRITE);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Database put failed.", __LINE__, getpid());
-      txnP->abort(txnP);
-      goto failXit; 
-    }
+failXit:
+  return BENCHMARK_FAIL;
+}
 
-    rc = txnP->commit(txnP, 0);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%d] [%d] Transaction commit failed.", __LINE__, getpid());
-      goto failXit; 
-    }
+/*
+ * Puts the pending rows with one bulk put in a transaction of their
+ * own. Progress is reported at most once per second.
+ */
+int
+load_batch_flush(load_batch_t *batchP)
+{
+  struct timeval now;
 
-    current_slot ++;
-    fprintf(stderr,"\rInserted: %3d rows", cnt); 
+  if (batchP->pending == 0) {
+    return BENCHMARK_SUCCESS;
   }
-  fprintf(stderr, "\n");
 
-  benchmarkP->number_stocks = current_slot;
+  /* Chunks of the same table split the same pages, so a bulk put
+   * that loses a deadlock is put again after a backoff */
+  if (xact_retry_run(BENCHMARK_XACT_LOAD, load_batch_attempt, batchP, batchP->benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("Gave up putting %d rows into %s", batchP->pending, batchP->table);
+    goto failXit;
+  }
 
-  fclose(ifp);
-  return BENCHMARK_SUCCESS;
+  batchP->rows += batchP->pending;
+  batchP->pending = 0;
+  DB_MULTIPLE_WRITE_INIT(batchP->bulkP, &batchP->bulk);
 
-failXit:
-  if (ifp != NULL) {
-    fclose(ifp);
+  gettimeofday(&now, NULL);
+  if (!batchP->quiet && now.tv_sec > batchP->last_report.tv_sec) {
+    fprintf(stderr, "\rInserted: %ld rows", batchP->rows);
+    batchP->last_report = now;
   }
 
+  return BENCHMARK_SUCCESS;
+
+failXit:
   return BENCHMARK_FAIL;
 }
 
+/*
+ * Puts the remaining rows. The buffer is released even if the put
+ * fails.
+ */
+int
+load_batch_finish(load_batch_t *batchP)
+{
+  int    rc;
+
+  rc = load_batch_flush(batchP);
+
+  free(batchP->bulk.data);
+  batchP->bulk.data = NULL;
+
+  if (rc != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  if (!batchP->quiet) {
+    fprintf(stderr, "\rInserted: %ld rows\n", batchP->rows);
+  }
 
+  return BENCHMARK_SUCCESS;
+}
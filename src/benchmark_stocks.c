@@ -37,7 +37,8 @@ cleanup:
 /*-------------------------------------------------------
  * Iterates over the stored stocks and obtains the 
  * names. The names are stored in a list of strings
- * in the BENCHMARK_DBS structure.
+ * in the BENCHMARK_DBS structure. The position of a
+ * symbol in this list is its symbol id.
  *-----------------------------------------------------*/
 int
 benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
@@ -45,11 +46,13 @@ benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
   DBC     *cursorP = NULL;
   DB_TXN  *txnP = NULL;
   DB_ENV  *envP = NULL;
-  DB_BTREE_STAT  *stocks_statsP = NULL;
   DBT      key, data;
+  char     symbol[ID_SZ];
+  char   **stocksP = NULL;
   int      ret;
   int      rc = BENCHMARK_SUCCESS;
   int      current_slot = 0;
+  int      num_slots = 0;
 
   if (benchmarkP == NULL) {
     benchmark_error("Invalid arguments");
@@ -64,11 +67,10 @@ benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
-  benchmark_debug(5, "PID: %d, Allocating space for %d stocks", 
-                  getpid(), benchmarkP->number_stocks);
-
-  memset(&key, 0, sizeof(DBT));
+  /* Only the keys are needed, so read none of the records */
+  dbt_usermem_set(&key, symbol, sizeof(symbol));
   memset(&data, 0, sizeof(DBT));
+  data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
 
   ret = envP->txn_begin(envP, 
                         NULL, 
@@ -81,31 +83,6 @@ benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
-  /* Get number of stocks in the database */
-  rc = benchmarkP->stocks_dbp->stat(benchmarkP->stocks_dbp, 
-                                    txnP, 
-                                    (void *)&stocks_statsP, 
-                                    0 /* no FAST_STAT */);
-  if (rc != 0) {
-    envP->err(envP, rc, 
-              "[%s:%d] [%d] Failed to obtain stats from Stocks table.", 
-              __FILE__, __LINE__, getpid());
-    goto failXit; 
-  }
-  
-  benchmarkP->number_stocks = stocks_statsP->bt_nkeys;
-  benchmark_debug(5, 
-                  "Number of keys in Stocks table is: %d", 
-                  benchmarkP->number_stocks);
-
-  /* Allocate an array of chars to hold the info 
-   * of the stocks */
-  benchmarkP->stocks = calloc(benchmarkP->number_stocks, sizeof (char *));
-  if (benchmarkP->stocks == NULL) {
-    benchmark_error("Could not allocate storage for stocks list");
-    goto failXit;
-  }
-
   ret = benchmarkP->stocks_dbp->cursor(benchmarkP->stocks_dbp, 
                                        txnP,
                                        &cursorP, 
@@ -117,25 +94,41 @@ benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
-  /* Iterate over the database, retrieving each record in turn. */
-  while ((ret = cursorP->get(cursorP, 
-                             &key, 
-                             &data, 
-                             DB_NEXT | DB_READ_COMMITTED)) == 0) 
+  /* Iterate over the database, retrieving each record in turn. 
+   * The list grows as needed, which saves us a full stat 
+   * traversal just to count the keys. */
+  while ((ret = cursor_get_usermem(cursorP, 
+                                  &key, 
+                                  NULL,
+                                  &data, 
+                                  DB_NEXT | DB_READ_COMMITTED)) == 0) 
   {
+    if (current_slot == num_slots) {
+      char **newP;
+      num_slots = num_slots ? 2 * num_slots : 1024;
+      newP = realloc(stocksP, num_slots * sizeof (char *));
+      if (newP == NULL) {
+        benchmark_error("Could not allocate storage for stocks list");
+        goto failXit;
+      }
+      stocksP = newP;
+    }
+
     benchmark_debug(5, "PID: %d, Copying stock number %d, %s", 
                     getpid(), current_slot, (char *)key.data);
 
-    assert(0 <= current_slot && current_slot < benchmarkP->number_stocks);
-
     /* Copy the key in the list */
-    benchmarkP->stocks[current_slot] = strdup((char *)key.data);
+    stocksP[current_slot] = strdup((char *)key.data);
+    if (stocksP[current_slot] == NULL) {
+      benchmark_error("Could not allocate storage for stocks list");
+      goto failXit;
+    }
     current_slot ++;
   }
 
   if (ret != DB_NOTFOUND) {
-    envP->err(envP, rc, 
-              "[%s:%d] [%d] Failed to find record in Quotes.", 
+    envP->err(envP, ret, 
+              "[%s:%d] [%d] Failed to iterate over Stocks.", 
               __FILE__, __LINE__, getpid());
     goto failXit;
   }
@@ -148,17 +141,24 @@ benchmark_stocks_symbols_get(BENCHMARK_DBS *benchmarkP)
   }
   cursorP = NULL;
 
-  benchmark_info("PID: %d, Committing transaction: %p", 
+  benchmark_debug(5, "PID: %d, Committing transaction: %p", 
                   getpid(), txnP);
   ret = txnP->commit(txnP, 0);
   if (ret != 0) {
-    envP->err(envP, rc, 
+    envP->err(envP, ret, 
               "[%s:%d] [%d] Transaction commit failed. txnP: %p", 
               __FILE__, __LINE__, getpid(), txnP);
+    txnP = NULL;
     goto failXit; 
   }
   txnP = NULL;
 
+  benchmarkP->stocks = stocksP;
+  benchmarkP->number_stocks = current_slot;
+  benchmark_debug(5, 
+                  "Number of keys in Stocks table is: %d", 
+                  benchmarkP->number_stocks);
+
   goto cleanup;
 
 failXit:
@@ -185,14 +185,12 @@ failXit:
     }
   }
 
-  if (benchmarkP->number_stocks > 0 && benchmarkP->stocks != NULL) {
+  if (stocksP != NULL) {
     int i;
-    for (i=0; i<benchmarkP->number_stocks; i++) {
-      if (benchmarkP->stocks[i] != NULL) {
-        free(benchmarkP->stocks[i]);
-        benchmarkP->stocks[i] = NULL;
-      }
+    for (i=0; i<current_slot; i++) {
+      free(stocksP[i]);
     }
+    free(stocksP);
   }
 
 cleanup:
@@ -205,8 +203,10 @@ benchmark_stocks_stats_get(BENCHMARK_DBS *benchmarkP)
 {
   int             rc = BENCHMARK_SUCCESS;
   DB             *quotes_dbp = NULL;
-  DB_BTREE_STAT  *quotes_statsP = NULL;
+  void           *quotes_statsP = NULL;
   DB_ENV         *envP = NULL;
+  DBTYPE          access_method;
+  u_int32_t       nkeys;
 
   if (benchmarkP == NULL) {
     goto failXit;
@@ -225,14 +225,28 @@ benchmark_stocks_stats_get(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
-  rc = quotes_dbp->stat(quotes_dbp, NULL, (void *)&quotes_statsP, 0 /* no FAST_STAT */);
+  rc = quotes_dbp->get_type(quotes_dbp, &access_method);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain type of Quotes table.", __FILE__, __LINE__, getpid());
+    goto failXit; 
+  }
+
+  rc = quotes_dbp->stat(quotes_dbp, NULL, &quotes_statsP, 0 /* no FAST_STAT */);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain stats from Quotes table.", __FILE__, __LINE__, getpid());
     goto failXit; 
   }
 
-  benchmarkP->number_stocks = quotes_statsP->bt_nkeys;
-  benchmark_debug(5, "Number of keys in Quotes table is: %d", benchmarkP->number_stocks);
+  /* The layout of the statistics depends on the access method */
+  if (access_method == DB_HASH) {
+    nkeys = ((DB_HASH_STAT *)quotes_statsP)->hash_nkeys;
+  }
+  else {
+    nkeys = ((DB_BTREE_STAT *)quotes_statsP)->bt_nkeys;
+  }
+
+  /* number_stocks is owned by the symbol dictionary, so only report */
+  benchmark_debug(5, "Number of keys in Quotes table is: %u", nkeys);
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   goto cleanup;
@@ -269,7 +283,7 @@ benchmark_stock_list_get(void   *benchmark_handle,
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   if (benchmarkP->number_stocks == 0 || benchmarkP->stocks == NULL) {
-    rc = benchmark_stocks_symbols_get(benchmarkP);
+    rc = symbol_dict_load(benchmarkP);
     if (rc != BENCHMARK_SUCCESS) {
       goto failXit;
     }
@@ -0,0 +1,251 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  catalog.c
+ *
+ *    Description:  Read only copy of the catalog tables (Stocks, Currencies
+ *                  and Personal). They are written once by the initial load
+ *                  and never modified, so after the load they can be frozen
+ *                  into sorted arrays. Lookups are then a binary search that
+ *                  takes no locks and allocates nothing. The Berkeley DB
+ *                  tables remain the durable copy.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+
+/* Every catalog record starts with its key: a zero padded string of
+ * at most ID_SZ bytes */
+static int
+compare_catalog_key(const void *a, const void *b)
+{
+  return strncmp((const char *)a, (const char *)b, ID_SZ);
+}
+
+/*
+ * Copies every record of dbP into a new array of record_size sized
+ * elements, sorted on the record key.
+ */
+static int
+catalog_table_load(BENCHMARK_DBS *benchmarkP,
+                   DB            *dbP,
+                   const char    *table_name,
+                   size_t         record_size,
+                   void         **arrayPP,
+                   u_int32_t     *countP)
+{
+  DBC     *cursorP = NULL;
+  DB_TXN  *txnP = NULL;
+  DB_ENV  *envP = NULL;
+  DBT      key, data;
+  char     key_buf[ID_SZ];
+  char    *arrayP = NULL;
+  char    *newP = NULL;
+  u_int32_t count = 0;
+  u_int32_t capacity = 0;
+  int      ret;
+
+  envP = benchmarkP->envP;
+  if (envP == NULL || dbP == NULL) {
+    benchmark_error("%s table is not open", table_name);
+    goto failXit;
+  }
+
+  ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  ret = dbP->cursor(dbP, txnP, &cursorP, DB_READ_COMMITTED);
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for %s.", __FILE__, __LINE__, getpid(), table_name);
+    goto failXit;
+  }
+
+  /* Records are read straight into their slot of the catalog */
+  for (;;) {
+    if (count == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      newP = realloc(arrayP, capacity * record_size);
+      if (newP == NULL) {
+        benchmark_error("Could not allocate %s catalog", table_name);
+        goto failXit;
+      }
+      arrayP = newP;
+    }
+
+    dbt_usermem_set(&key, key_buf, sizeof(key_buf));
+    dbt_usermem_set(&data, arrayP + count * record_size, (u_int32_t) record_size);
+
+    ret = cursor_get_usermem(cursorP, &key, NULL, &data, DB_NEXT | DB_READ_COMMITTED);
+    if (ret != 0) {
+      break;
+    }
+
+    if (data.size != record_size) {
+      benchmark_warning("Skipping %s record of %u bytes", table_name, data.size);
+      continue;
+    }
+
+    count ++;
+  }
+
+  if (ret != DB_NOTFOUND) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to iterate over %s.", __FILE__, __LINE__, getpid(), table_name);
+    goto failXit;
+  }
+
+  ret = cursorP->close(cursorP);
+  cursorP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  ret = txnP->commit(txnP, 0);
+  txnP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction commit failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  /* Hash tables come back in bucket order */
+  if (count > 1) {
+    qsort(arrayP, count, record_size, compare_catalog_key);
+  }
+
+  *arrayPP = arrayP;
+  *countP = count;
+
+  benchmark_debug(5, "Froze %u records of %s", count, table_name);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (cursorP != NULL) {
+    cursorP->close(cursorP);
+  }
+  if (txnP != NULL) {
+    txnP->abort(txnP);
+  }
+  free(arrayP);
+  return BENCHMARK_FAIL;
+}
+
+/*-------------------------------------------------------
+ * Freezes the catalog tables, when this is enabled in
+ * the configuration. Must be called once the tables
+ * have been loaded.
+ *-----------------------------------------------------*/
+int
+catalog_freeze(BENCHMARK_DBS *benchmarkP)
+{
+  benchmark_catalog_t *catalogP = NULL;
+  void *arrayP = NULL;
+  int   ret;
+
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  catalog_free(benchmarkP);
+
+  if (!benchmarkP->config.frozen_catalog) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  catalogP = calloc(1, sizeof(benchmark_catalog_t));
+  if (catalogP == NULL) {
+    benchmark_error("Could not allocate catalog");
+    goto failXit;
+  }
+
+  ret = catalog_table_load(benchmarkP, benchmarkP->stocks_dbp, STOCKSDB,
+                           sizeof(STOCK), &arrayP, &catalogP->num_stocks);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  catalogP->stocks = arrayP;
+
+  ret = catalog_table_load(benchmarkP, benchmarkP->currencies_dbp, CURRENCIESDB,
+                           sizeof(CURRENCY), &arrayP, &catalogP->num_currencies);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  catalogP->currencies = arrayP;
+
+  ret = catalog_table_load(benchmarkP, benchmarkP->personal_dbp, PERSONALDB,
+                           sizeof(PERSONAL), &arrayP, &catalogP->num_personal);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  catalogP->personal = arrayP;
+
+  benchmarkP->catalog = catalogP;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (catalogP != NULL) {
+    free(catalogP->stocks);
+    free(catalogP->currencies);
+    free(catalogP->personal);
+    free(catalogP);
+  }
+  return BENCHMARK_FAIL;
+}
+
+void
+catalog_free(BENCHMARK_DBS *benchmarkP)
+{
+  benchmark_catalog_t *catalogP;
+
+  if (benchmarkP == NULL || benchmarkP->catalog == NULL) {
+    return;
+  }
+
+  catalogP = benchmarkP->catalog;
+  benchmarkP->catalog = NULL;
+
+  free(catalogP->stocks);
+  free(catalogP->currencies);
+  free(catalogP->personal);
+  free(catalogP);
+}
+
+/* Returns the frozen Stocks record of symbol, or NULL if there is none */
+const STOCK *
+catalog_stock_get(const char *symbol, BENCHMARK_DBS *benchmarkP)
+{
+  if (!CATALOG_FROZEN(benchmarkP) || symbol == NULL) {
+    return NULL;
+  }
+
+  return bsearch(symbol, benchmarkP->catalog->stocks, benchmarkP->catalog->num_stocks,
+                 sizeof(STOCK), compare_catalog_key);
+}
+
+/* Returns the frozen Personal record of account_id, or NULL if there is none */
+const PERSONAL *
+catalog_personal_get(const char *account_id, BENCHMARK_DBS *benchmarkP)
+{
+  if (!CATALOG_FROZEN(benchmarkP) || account_id == NULL) {
+    return NULL;
+  }
+
+  return bsearch(account_id, benchmarkP->catalog->personal, benchmarkP->catalog->num_personal,
+                 sizeof(PERSONAL), compare_catalog_key);
+}
@@ -17,9 +17,9 @@
  */
 
 #include "benchmark_common.h"
-
-static int
-symbol_exists(const char *symbol, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP);
+#include <arpa/inet.h>
+#include <errno.h>
+#include <time.h>
 
 static int
 account_exists(const char *account_id, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP);
@@ -36,9 +36,27 @@ get_account_id(DB *sdbp,          /* secondary db handle */
               const DBT *pdata,  /* primary db record's data */
               DBT *skey);         /* secondary db record's key */
 
+static int
+get_holding_key(DB *sdbp,          /* secondary db handle */
+                const DBT *pkey,   /* primary db record's key */
+                const DBT *pdata,  /* primary db record's data */
+                DBT *skey);        /* secondary db record's key */
+
+static int
+get_symbol_id(DB *sdbp,          /* secondary db handle */
+              const DBT *pkey,   /* primary db record's key */
+              const DBT *pdata,  /* primary db record's data */
+              DBT *skey);        /* secondary db record's key */
+
+static void
+set_holding_key(char *holding_key, const char *account_id, u_int32_t symbol_id);
+
+static int
+compare_symbol_id(DB *dbp, const DBT *a, const DBT *b, size_t *locp);
+
 static int 
 create_portfolio(const char *account_id, 
-                 const char *symbol, 
+                 u_int32_t symbol_id, 
                  float price, 
                  int amount, 
                  int force_apply, 
@@ -47,7 +65,7 @@ create_portfolio(const char *account_id,
 
 int
 get_portfolio(const char *account_id, 
-              const char *symbol, 
+              u_int32_t symbol_id, 
               DB_TXN *txnP, 
               DBC **cursorPP, 
               DBT *key_ret, 
@@ -55,7 +73,7 @@ get_portfolio(const char *account_id,
               BENCHMARK_DBS *benchmarkP);
 
 int
-get_stock(const char *symbol, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *data_ret, int flags, BENCHMARK_DBS *benchmarkP);
+get_stock(u_int32_t symbol_id, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *data_ret, int flags, BENCHMARK_DBS *benchmarkP);
 
 /*=============== STATIC FUNCTIONS =======================*/
 static int
@@ -78,6 +96,66 @@ get_account_id(DB *sdbp,          /* secondary db handle */
     return (0);
 } 
 
+static int
+get_holding_key(DB *sdbp,          /* secondary db handle */
+                const DBT *pkey,   /* primary db record's key */
+                const DBT *pdata,  /* primary db record's data */
+                DBT *skey)         /* secondary db record's key */
+{
+    PORTFOLIOS *portfoliosP;
+
+    portfoliosP = pdata->data;
+
+    /* symbol_id and account_id are stored back to back and zero padded, 
+     * so the composite key is simply a slice of the record */
+    memset(skey, 0, sizeof(DBT));
+    skey->data = &portfoliosP->symbol_id;
+    skey->size = HOLDING_KEY_SZ;
+
+    return (0);
+} 
+
+static int
+get_symbol_id(DB *sdbp,          /* secondary db handle */
+              const DBT *pkey,   /* primary db record's key */
+              const DBT *pdata,  /* primary db record's data */
+              DBT *skey)         /* secondary db record's key */
+{
+    PORTFOLIOS *portfoliosP;
+
+    portfoliosP = pdata->data;
+
+    memset(skey, 0, sizeof(DBT));
+    skey->data = &portfoliosP->symbol_id;
+    skey->size = sizeof(u_int32_t);
+
+    return (0);
+} 
+
+/* Builds a PortfoliosHoldings key in the caller provided buffer, which 
+ * must be at least HOLDING_KEY_SZ bytes long. */
+static void
+set_holding_key(char *holding_key, const char *account_id, u_int32_t symbol_id)
+{
+  memset(holding_key, 0, HOLDING_KEY_SZ);
+  memcpy(holding_key, &symbol_id, sizeof(symbol_id));
+  strncpy(holding_key + sizeof(symbol_id), account_id, ID_SZ);
+}
+
+/* Quotes are keyed by a native u_int32_t symbol id. Compare them as
+ * integers so that the btree order matches the id order. */
+static int
+compare_symbol_id(DB *dbp, const DBT *a, const DBT *b, size_t *locp)
+{
+  u_int32_t id_a;
+  u_int32_t id_b;
+
+  memcpy(&id_a, a->data, sizeof(u_int32_t));
+  memcpy(&id_b, b->data, sizeof(u_int32_t));
+
+  return (id_a > id_b) - (id_a < id_b);
+}
+
 static int
 show_stock_item(void *vBuf)
 {
@@ -108,12 +186,19 @@ open_database(DB_ENV *envP,
               const char *program_name,  
               FILE *error_file_pointer,
               int is_secondary,
+              const benchmark_table_config_t *table_configP,
+              int (*bt_compare)(DB *, const DBT *, const DBT *, size_t *),
               int create)
 {
   DB *dbp;
+  DBTYPE access_method = DB_BTREE;
   u_int32_t open_flags;
   int ret;
 
+  if (table_configP != NULL) {
+    access_method = table_configP->access_method;
+  }
+
   /* Initialize the DB handle */
   ret = db_create(&dbp, envP, 0);
   if (ret != 0) {
@@ -129,9 +214,10 @@ open_database(DB_ENV *envP,
 
   /*
    * If this is a secondary database, then we want to allow
-   * sorted duplicates.
+   * sorted duplicates. Unique secondaries, such as the holdings
+   * index, must reject them instead.
    */
-  if (is_secondary) {
+  if (is_secondary == SECONDARY_DB) {
     ret = dbp->set_flags(dbp, DB_DUPSORT);
     if (ret != 0) {
       envP->err(envP, ret, "[%s:%d] [%d] Attempt to set DUPSORT flags failed.", __FILE__, __LINE__, getpid());
@@ -139,6 +225,24 @@ open_database(DB_ENV *envP,
     }
   }
 
+  if (access_method == DB_BTREE && bt_compare != NULL) {
+    ret = dbp->set_bt_compare(dbp, bt_compare);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Failed to set btree comparison function.", __FILE__, __LINE__, getpid());
+      return (ret);
+    }
+  }
+
+  /* Size the hash table up front, so that it doesn't need
+   * to split buckets while it is being loaded */
+  if (access_method == DB_HASH && table_configP->h_nelem > 0) {
+    ret = dbp->set_h_nelem(dbp, table_configP->h_nelem);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Failed to set number of hash elements.", __FILE__, __LINE__, getpid());
+      return (ret);
+    }
+  }
+
   /* 
    * Configure the cache file. This can be done
    * at any point in the application's life once the
@@ -153,7 +257,8 @@ open_database(DB_ENV *envP,
 
   /* Set the open flags */
   open_flags = DB_THREAD          /* multi-threaded application */
-              | DB_AUTO_COMMIT;   /* open is a transation */ 
+              | DB_AUTO_COMMIT    /* open is a transation */ 
+              | DB_READ_UNCOMMITTED; /* reads may ask for dirty data */
 
   if (create) {
     open_flags |= DB_CREATE; /*  Allow database creation */
@@ -165,7 +270,7 @@ open_database(DB_ENV *envP,
                   NULL,       /* Txn pointer */
                   NULL,       /* file_name,  File name */
                   NULL,       /* Logical db name */
-                  DB_BTREE,   /* Database type (using btree) */
+                  access_method, /* Database type (btree unless configured) */
                   open_flags, /* Open flags */
                   0);         /* File mode. Using defaults */
   if (ret != 0) {
@@ -253,9 +358,10 @@ int open_environment(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
  
+  /* Old page versions live in the cache, next to the current ones */
   rc = envP->set_cachesize(envP, 
                            0,    /* 0 gigabytes */
-                           10 * 1024 * 1024,    /* 10 megabytes */
+                           (benchmarkP->config.snapshot_reads ? 32 : 10) * 1024 * 1024,
                            1);    /* Create 1 cache. All memory will 
                                    * be allocated contiguously. */
   if (rc != 0) {
@@ -263,6 +369,35 @@ int open_environment(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
+  /* Count the memory Berkeley DB allocates for us */
+  rc = envP->set_alloc(envP, thread_db_malloc, thread_db_realloc, free);
+  if (rc != 0) {
+    benchmark_error("Error setting allocation functions: %s", db_strerror(rc));
+    goto failXit;
+  }
+
+  /* Every table is opened multiversion, so that readers can use
+   * snapshots instead of waiting on the writers' page locks */
+  if (benchmarkP->config.snapshot_reads) {
+    rc = envP->set_flags(envP, DB_MULTIVERSION, 1);
+    if (rc != 0) {
+      benchmark_error("Error setting multiversion: %s", db_strerror(rc));
+      goto failXit;
+    }
+  }
+
+  /* A table takes its durability from the environment when it is
+   * opened, so a load that skips the log must ask for it before the
+   * tables are created. They live in memory and are never reopened,
+   * so they skip it for as long as the handle is open. */
+  if (benchmarkP->createDBs == 1 && benchmarkP->config.load_not_durable) {
+    rc = envP->set_flags(envP, DB_TXN_NOT_DURABLE, 1);
+    if (rc != 0) {
+      benchmark_error("Error disabling logging: %s", db_strerror(rc));
+      goto failXit;
+    }
+  }
+
   env_flags = DB_INIT_TXN  |  /* Init transaction subsystem */
               DB_INIT_LOCK |  /* Init locking subsystem */
               DB_INIT_LOG  |  /* Init logging subsystem */
@@ -385,6 +520,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->stocks_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        benchmark_config_table_get(&benchmarkP->config, STOCKS_FLAG),
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -397,6 +534,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->quotes_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        benchmark_config_table_get(&benchmarkP->config, QUOTES_FLAG),
+                        compare_symbol_id,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -409,6 +548,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->quotes_hist_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        NULL,
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -421,6 +562,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->portfolios_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        NULL,
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -431,6 +574,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->portfolios_sdb_name,
                         program_name, error_fileP,
                         SECONDARY_DB,
+                        NULL,
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -448,6 +593,72 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
       return (ret);
     }
 
+    /* One holding per (account_id, symbol) pair, so that finding
+     * a portfolio is a point lookup */
+    ret = open_database(benchmarkP->envP,
+                        &(benchmarkP->portfolios_holdings_sdbp),
+                        benchmarkP->portfolios_holdings_sdb_name,
+                        program_name, error_fileP,
+                        SECONDARY_UNIQUE_DB,
+                        NULL,
+                        NULL,
+                        benchmarkP->createDBs);
+    if (ret != 0) {
+      return (ret);
+    }
+
+    ret = benchmarkP->portfolios_dbp->associate(benchmarkP->portfolios_dbp,
+                   NULL,
+                   benchmarkP->portfolios_holdings_sdbp,
+                   get_holding_key,
+                   0);
+
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Failed to associate holdings database.", __FILE__, __LINE__, getpid());
+      return (ret);
+    }
+
+    /* Holders of a symbol. Duplicates are sorted on the big endian 
+     * portfolio id, so they come out in id order */
+    ret = open_database(benchmarkP->envP,
+                        &(benchmarkP->portfolios_symbol_sdbp),
+                        benchmarkP->portfolios_symbol_sdb_name,
+                        program_name, error_fileP,
+                        SECONDARY_DB,
+                        NULL,
+                        compare_symbol_id,
+                        benchmarkP->createDBs);
+    if (ret != 0) {
+      return (ret);
+    }
+
+    ret = benchmarkP->portfolios_dbp->associate(benchmarkP->portfolios_dbp,
+                   NULL,
+                   benchmarkP->portfolios_symbol_sdbp,
+                   get_symbol_id,
+                   0);
+
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Failed to associate symbol database.", __FILE__, __LINE__, getpid());
+      return (ret);
+    }
+
+    ret = open_database(benchmarkP->envP,
+                        &(benchmarkP->sequences_dbp),
+                        benchmarkP->sequences_db_name,
+                        program_name, error_fileP,
+                        PRIMARY_DB,
+                        NULL,
+                        NULL,
+                        benchmarkP->createDBs);
+    if (ret != 0) {
+      return (ret);
+    }
+
+    ret = portfolio_seq_open(benchmarkP);
+    if (ret != 0) {
+      return (ret);
+    }
   }
 
   if (IS_ACCOUNTS(which_database)) {
@@ -456,6 +667,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->accounts_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        NULL,
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -468,6 +681,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->currencies_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        NULL,
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -480,6 +695,8 @@ databases_setup(BENCHMARK_DBS *benchmarkP,
                         benchmarkP->personal_db_name,
                         program_name, error_fileP,
                         PRIMARY_DB,
+                        benchmark_config_table_get(&benchmarkP->config, PERSONAL_FLAG),
+                        NULL,
                         benchmarkP->createDBs);
     if (ret != 0) {
       return (ret);
@@ -533,6 +750,39 @@ benchmark_end(BENCHMARK_DBS *benchmarkP,
   }
 
   if (IS_PORTFOLIOS(which_database)) {
+    rc = portfolio_seq_close(benchmarkP);
+    if (rc != 0) {
+      goto failXit;
+    }
+
+    rc = close_database(benchmarkP->envP,
+                        benchmarkP->sequences_dbp,
+                        program_name);
+    if (rc != 0) {
+      goto failXit;
+    }
+
+    rc = close_database(benchmarkP->envP,
+                        benchmarkP->portfolios_symbol_sdbp,
+                        program_name);
+    if (rc != 0) {
+      goto failXit;
+    }
+
+    rc = close_database(benchmarkP->envP,
+                        benchmarkP->portfolios_holdings_sdbp,
+                        program_name);
+    if (rc != 0) {
+      goto failXit;
+    }
+
+    rc = close_database(benchmarkP->envP,
+                        benchmarkP->portfolios_sdbp,
+                        program_name);
+    if (rc != 0) {
+      goto failXit;
+    }
+
     rc = close_database(benchmarkP->envP,
                         benchmarkP->portfolios_dbp,
                         program_name);
@@ -579,6 +829,7 @@ void
 initialize_benchmarkdbs(BENCHMARK_DBS *benchmarkP)
 {
   memset(benchmarkP, 0, sizeof(BENCHMARK_DBS));
+  benchmark_config_init(&benchmarkP->config);
 }
 
 /* Identify all the files that will hold our databases. */
@@ -607,6 +858,14 @@ set_db_filenames(BENCHMARK_DBS *benchmarkP)
   benchmarkP->portfolios_sdb_name = malloc(size);
   snprintf(benchmarkP->portfolios_sdb_name, size, "%s", PORTFOLIOSSECDB);
 
+  size = strlen(PORTFOLIOSHOLDDB) + 1;
+  benchmarkP->portfolios_holdings_sdb_name = malloc(size);
+  snprintf(benchmarkP->portfolios_holdings_sdb_name, size, "%s", PORTFOLIOSHOLDDB);
+
+  size = strlen(PORTFOLIOSSYMDB) + 1;
+  benchmarkP->portfolios_symbol_sdb_name = malloc(size);
+  snprintf(benchmarkP->portfolios_symbol_sdb_name, size, "%s", PORTFOLIOSSYMDB);
+
   size = strlen(ACCOUNTSDB) + 1;
   benchmarkP->accounts_db_name = malloc(size);
   snprintf(benchmarkP->accounts_db_name, size, "%s", ACCOUNTSDB);
@@ -618,6 +877,10 @@ set_db_filenames(BENCHMARK_DBS *benchmarkP)
   size = strlen(PERSONALDB) + 1;
   benchmarkP->personal_db_name = malloc(size);
   snprintf(benchmarkP->personal_db_name, size, "%s", PERSONALDB);
+
+  size = strlen(SEQUENCESDB) + 1;
+  benchmarkP->sequences_db_name = malloc(size);
+  snprintf(benchmarkP->sequences_db_name, size, "%s", SEQUENCESDB);
 }
 
 int
@@ -663,6 +926,44 @@ databases_close(BENCHMARK_DBS *benchmarkP)
     }
   }
 
+  /* The sequence is stored in Sequences, so it goes first */
+  if (portfolio_seq_close(benchmarkP) != 0) {
+    goto failXit;
+  }
+
+  if (benchmarkP->sequences_dbp != NULL) {
+    ret = benchmarkP->sequences_dbp->close(benchmarkP->sequences_dbp, 0);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Sequences database close failed.", __FILE__, __LINE__, getpid());
+      goto failXit;
+    }
+  }
+
+  /* Secondaries go before their primary */
+  if (benchmarkP->portfolios_symbol_sdbp != NULL) {
+    ret = benchmarkP->portfolios_symbol_sdbp->close(benchmarkP->portfolios_symbol_sdbp, 0);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Portfolios symbol database close failed.", __FILE__, __LINE__, getpid());
+      goto failXit;
+    }
+  }
+
+  if (benchmarkP->portfolios_holdings_sdbp != NULL) {
+    ret = benchmarkP->portfolios_holdings_sdbp->close(benchmarkP->portfolios_holdings_sdbp, 0);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Portfolios holdings database close failed.", __FILE__, __LINE__, getpid());
+      goto failXit;
+    }
+  }
+
+  if (benchmarkP->portfolios_sdbp != NULL) {
+    ret = benchmarkP->portfolios_sdbp->close(benchmarkP->portfolios_sdbp, 0);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Portfolios secondary database close failed.", __FILE__, __LINE__, getpid());
+      goto failXit;
+    }
+  }
+
   if (benchmarkP->portfolios_dbp != NULL) {
     ret = benchmarkP->portfolios_dbp->close(benchmarkP->portfolios_dbp, 0);
     if (ret != 0) {
@@ -709,7 +1010,9 @@ show_stocks_records(char *symbolId, BENCHMARK_DBS *benchmarkP)
   DBC *cursorP = NULL;
   DB_TXN  *txnP = NULL;
   DB_ENV  *envP = NULL;
+  STOCK   *stockP = &thread_read_buf()->stock;
   DBT key, data;
+  int isolation;
   int ret;
   int rc = BENCHMARK_SUCCESS;
 
@@ -727,29 +1030,40 @@ show_stocks_records(char *symbolId, BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
+  if (CATALOG_FROZEN(benchmarkP)) {
+    const STOCK *stockP = catalog_stock_get(symbolId, benchmarkP);
+    if (stockP == NULL) {
+      benchmark_error("Failed to find record in Stocks: %s", symbolId);
+      goto failXit;
+    }
+    (void) show_stock_item((void *)stockP);
+    goto cleanup;
+  }
+
   memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  dbt_usermem_set(&data, stockP, sizeof(STOCK));
 
   if (symbolId != NULL && symbolId[0] != '\0') {
     key.data = symbolId;
     key.size = (u_int32_t)strlen(symbolId) + 1;
   }
 
-  ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  isolation = read_isolation_get(benchmarkP);
+  ret = envP->txn_begin(envP, NULL, &txnP, read_xact_flags(isolation));
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
   ret = benchmarkP->stocks_dbp->cursor(benchmarkP->stocks_dbp, txnP,
-                                    &cursorP, DB_READ_COMMITTED);
+                                    &cursorP, read_cursor_flags(isolation));
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Stocks.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
   /* Position the cursor */
-  ret = cursorP->get(cursorP, &key, &data, DB_SET | DB_READ_COMMITTED | DB_RMW );
+  ret = cursor_get_usermem(cursorP, &key, NULL, &data, DB_SET | read_get_flags(isolation));
   if (ret != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to find record in Quotes.", __FILE__, __LINE__, getpid());
     goto failXit;
@@ -810,8 +1124,9 @@ show_all_portfolios(BENCHMARK_DBS *benchmarkP)
   DBC *cursorP = NULL;
   DB_TXN  *txnP = NULL;
   DB_ENV  *envP = NULL;
-  char *symbolIdP = NULL;
+  u_int32_t symbol_id;
   DBT key, data;
+  int isolation;
   int ret;
   int rc = BENCHMARK_SUCCESS;
   int curRc = 0;
@@ -829,10 +1144,11 @@ show_all_portfolios(BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
-  memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  dbt_usermem_set(&key, &thread_read_buf()->portfolio_key, sizeof(u_int32_t));
+  dbt_usermem_set(&data, &thread_read_buf()->portfolio, sizeof(PORTFOLIOS));
 
-  ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  isolation = read_isolation_get(benchmarkP);
+  ret = envP->txn_begin(envP, NULL, &txnP, read_xact_flags(isolation));
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
     goto failXit;
@@ -840,15 +1156,15 @@ show_all_portfolios(BENCHMARK_DBS *benchmarkP)
 
   /* First read the portfolios account */
   ret = benchmarkP->portfolios_dbp->cursor(benchmarkP->portfolios_dbp, txnP,
-                                    &cursorP, DB_READ_COMMITTED);
+                                    &cursorP, read_cursor_flags(isolation));
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Portfolio.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
-  while ((curRc=cursorP->get(cursorP, &key, &data, DB_READ_COMMITTED | DB_NEXT)) == 0)
+  while ((curRc=cursor_get_usermem(cursorP, &key, NULL, &data, read_get_flags(isolation) | DB_NEXT)) == 0)
   {
-    (void) show_portfolio_item(data.data, &symbolIdP);
+    (void) show_portfolio_item(data.data, &symbol_id);
   }
 
   ret = cursorP->close(cursorP);
@@ -903,6 +1219,8 @@ show_portfolios(char              *account_id,
   int rc = BENCHMARK_SUCCESS;
   int curRc = 0;
   int numClients = 0;
+  int isolation;
+  thread_read_buf_t *bufP = thread_read_buf();
 
   if (benchmarkP == NULL || benchmarkP->personal_dbp == NULL) {
     benchmark_error("Invalid argument");
@@ -918,10 +1236,11 @@ show_portfolios(char              *account_id,
   }
 
   memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  dbt_usermem_set(&data, &bufP->personal, sizeof(PERSONAL));
 
+  isolation = xact_isolation_get((DB_TXN *)xactH, benchmarkP);
   if (xactH == NULL) {
-    ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+    ret = envP->txn_begin(envP, NULL, &txnP, read_xact_flags(isolation));
     if (ret != 0) {
       envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
       goto failXit;
@@ -933,7 +1252,8 @@ show_portfolios(char              *account_id,
 
   /* First read the personall account */
   ret = benchmarkP->personal_dbp->cursor(benchmarkP->personal_dbp, txnP,
-                                    &personal_cursorP, DB_READ_COMMITTED);
+                                    &personal_cursorP, read_cursor_flags(isolation));
+  xact_conflict_note(ret);
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Personal.", __FILE__, __LINE__, getpid());
     goto failXit;
@@ -947,7 +1267,8 @@ show_portfolios(char              *account_id,
   if (account_id != NULL && account_id[0] != '\0') {
     key.data = account_id;
     key.size = (u_int32_t) strlen(account_id) + 1;
-    curRc=personal_cursorP->get(personal_cursorP, &key, &data, DB_SET | DB_READ_COMMITTED);
+    curRc=cursor_get_usermem(personal_cursorP, &key, NULL, &data, DB_SET | read_get_flags(isolation));
+    xact_conflict_note(curRc);
     if (curRc == 0) {
 
       /* Show user's information */
@@ -967,7 +1288,8 @@ show_portfolios(char              *account_id,
     }
   }
   else {
-    while ((curRc=personal_cursorP->get(personal_cursorP, &key, &data, DB_READ_COMMITTED | DB_NEXT)) == 0)
+    dbt_usermem_set(&key, bufP->account_id, sizeof(bufP->account_id));
+    while ((curRc=cursor_get_usermem(personal_cursorP, &key, NULL, &data, read_get_flags(isolation) | DB_NEXT)) == 0)
     {
       /* Show user's information */
       (void) show_personal_item(data.data);   
@@ -983,6 +1305,7 @@ show_portfolios(char              *account_id,
       numClients ++;
     }
 
+    xact_conflict_note(curRc);
     if (curRc != DB_NOTFOUND) {
       envP->err(envP, ret, "[%s:%d] [%d] Error retrieving portfolios.", __FILE__, __LINE__, getpid());
       goto failXit;
@@ -998,6 +1321,7 @@ show_portfolios(char              *account_id,
   if (xactH == NULL) {
     benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
     ret = txnP->commit(txnP, 0);
+    xact_conflict_note(ret);
     if (ret != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
       goto failXit; 
@@ -1043,16 +1367,17 @@ cleanup:
 int
 show_one_portfolio(char *account_id, DB_TXN  *txn_inP, BENCHMARK_DBS *benchmarkP)
 {
-  DBC *portfolio_cursorP = NULL;
+  PORTFOLIO_SCAN scan;
+  PORTFOLIOS *portfolioP = NULL;
   DB_TXN  *txnP = NULL;
   DB_ENV  *envP = NULL;
-  DBT key;
-  DBT pkey, pdata;
-  char *symbolIdP = NULL;
+  u_int32_t symbol_id;
   int rc = BENCHMARK_SUCCESS;
   int ret;
   int numPortfolios = 0;
 
+  memset(&scan, 0, sizeof(scan));
+
   if (benchmarkP == NULL || benchmarkP->portfolios_sdbp == NULL) {
     benchmark_error("Invalid argument");
     goto failXit;
@@ -1070,70 +1395,47 @@ show_one_portfolio(char *account_id, DB_TXN  *txn_inP, BENCHMARK_DBS *benchmarkP
     txnP = txn_inP;
   }
   else {
-    ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+    ret = envP->txn_begin(envP, NULL, &txnP, read_xact_flags(read_isolation_get(benchmarkP)));
     if (ret != 0) {
       envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
       goto failXit;
     }
   }
 
-  memset(&key, 0, sizeof(DBT));
-  memset(&pkey, 0, sizeof(DBT));
-  memset(&pdata, 0, sizeof(DBT));
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, %p : searching for account id: %s", getpid(), txnP, account_id);
 
-  key.data = account_id;
-  key.size = ID_SZ;
- 
-  /* Create a cursor to iterate over the portfolios given the 
-   * user id. */
-  ret = benchmarkP->portfolios_sdbp->cursor(benchmarkP->portfolios_sdbp, txnP, 
-                                   &portfolio_cursorP, DB_READ_COMMITTED);
-  if (ret != 0) {
-    envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Portfolios.", __FILE__, __LINE__, getpid());
+  ret = portfolio_scan_open(account_id, txnP, &scan, benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, %p : searching for account id: %s", getpid(), txnP, account_id);
-
-#if 1
-  /* Iterate over all portfolios in order to find those belonging to the user_id */
-  while ((ret = portfolio_cursorP->pget(portfolio_cursorP, &key, &pkey, &pdata, DB_NEXT)) == 0)
+  /* Only the portfolios of this account are visited */
+  while ((ret = portfolio_scan_next(&scan, &portfolioP)) == BENCHMARK_SUCCESS
+         && portfolioP != NULL)
   {
-    /* TODO: Is it necessary this comparison? */
-    if (strcmp(account_id, (char *)key.data) == 0) {
-      /* Finally, go ahead and display the information about this
-       * portfolio */
-      (void) show_portfolio_item(pdata.data, &symbolIdP);
-
-      numPortfolios ++;
-    }
+    (void) show_portfolio_item(portfolioP, &symbol_id);
+    numPortfolios ++;
   }
 
-#else 
-
-  /* Position the cursor */
-  rc = portfolio_cursorP->pget(portfolio_cursorP, &key, &pkey, &pdata, DB_SET | DB_READ_COMMITTED);
-  if (rc != 0) {
-    envP->err(envP, rc, "[%s:%d] [%d] Failed to find record (%s) in Portfolio.", __FILE__, __LINE__, getpid(), account_id);
+  if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  (void) show_portfolio_item(pdata.data, &symbolIdP);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, %p : account id: %s has %d portfolios", getpid(), txnP, account_id, numPortfolios);
 
-#endif
-  ret = portfolio_cursorP->close(portfolio_cursorP);
-  if (ret != 0) {
-    envP->err(envP, ret, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+  ret = portfolio_scan_close(&scan);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
   }
 
-  portfolio_cursorP = NULL;
-
   /* This means this function created its own txn */
   if (txn_inP == NULL) {
     benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
     ret = txnP->commit(txnP, 0);
+    xact_conflict_note(ret);
     if (ret != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
+      envP->err(envP, ret, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
+      txnP = NULL;
       goto failXit; 
     }
     txnP = NULL;
@@ -1143,22 +1445,14 @@ show_one_portfolio(char *account_id, DB_TXN  *txn_inP, BENCHMARK_DBS *benchmarkP
 
 failXit:
   rc = BENCHMARK_FAIL;
-  if (txnP != NULL) {
-    if (portfolio_cursorP != NULL) {
-      ret = portfolio_cursorP->close(portfolio_cursorP);
-      if (ret != 0) {
-        envP->err(envP, ret, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
-      }
-      portfolio_cursorP = NULL;
-    }
+  (void) portfolio_scan_close(&scan);
 
-    /* This means this function created its own txn */
-    if (txn_inP == NULL) {
-      benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
-      ret = txnP->abort(txnP);
-      if (ret != 0) {
-        envP->err(envP, ret, "[%s:%d] [%d] Transaction abort failed.", __FILE__, __LINE__, getpid());
-      }
+  /* This means this function created its own txn */
+  if (txn_inP == NULL && txnP != NULL) {
+    benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
+    ret = txnP->abort(txnP);
+    if (ret != 0) {
+      envP->err(envP, ret, "[%s:%d] [%d] Transaction abort failed.", __FILE__, __LINE__, getpid());
     }
   }
 
@@ -1166,53 +1460,301 @@ cleanup:
   return (rc);
 }
 
+/*
+ * Opens a bounded scan over the portfolios of account_id. The scan
+ * must be released with portfolio_scan_close(), which is safe to call
+ * on a scan that failed to open as long as it was zeroed first.
+ */
 int
-show_personal_item(void *vBuf)
+portfolio_scan_open(const char      *account_id,
+                    DB_TXN          *txnP,
+                    PORTFOLIO_SCAN  *scanP,
+                    BENCHMARK_DBS   *benchmarkP)
 {
-  char      *account_id;
-  char      *last_name;
-  char      *first_name;
-  char      *address;
-  char      *address_2;
-  char      *city;
-  char      *state;
-  char      *country;
-  char      *phone;
-  char      *email;
+  DB      *portfoliossdbP = NULL;
+  DB_ENV  *envP = NULL;
+  int      isolation;
+  int      rc;
 
-  size_t buf_pos = 0;
-  char *buf = (char *)vBuf;
+  if (account_id == NULL || account_id[0] == '\0' ||
+      txnP == NULL || scanP == NULL || benchmarkP == NULL)
+  {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
 
-  account_id = buf;
-  buf_pos += ID_SZ;
-  
-  last_name = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  first_name = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  envP = benchmarkP->envP;
+  portfoliossdbP = benchmarkP->portfolios_sdbp;
+  if (envP == NULL || portfoliossdbP == NULL) {
+    benchmark_error("Portfolios secondary database is not open");
+    goto failXit;
+  }
 
-  address = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  memset(scanP, 0, sizeof(PORTFOLIO_SCAN));
+  strncpy(scanP->account_id, account_id, ID_SZ);
 
-  address_2 = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  /* The key must match what get_account_id() stores */
+  scanP->key.data = scanP->account_id;
+  scanP->key.size = (u_int32_t) strlen(scanP->account_id) + 1;
+  scanP->key.ulen = sizeof(scanP->account_id);
+  scanP->key.flags = DB_DBT_USERMEM;
 
-  city = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  scanP->pkey.data = &scanP->portfolio_key;
+  scanP->pkey.ulen = sizeof(scanP->portfolio_key);
+  scanP->pkey.flags = DB_DBT_USERMEM;
 
-  state = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  scanP->data.data = &scanP->portfolio;
+  scanP->data.ulen = sizeof(PORTFOLIOS);
+  scanP->data.flags = DB_DBT_USERMEM;
 
-  country = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  scanP->op = DB_SET;
+  isolation = xact_isolation_get(txnP, benchmarkP);
+  scanP->read_flags = read_get_flags(isolation);
 
-  phone = buf + buf_pos;
-  buf_pos += NAME_SZ;
+  rc = portfoliossdbP->cursor(portfoliossdbP, txnP, &scanP->cursorP, read_cursor_flags(isolation));
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Portfolios.", __FILE__, __LINE__, getpid());
+    scanP->cursorP = NULL;
+    goto failXit;
+  }
 
-  email = buf + buf_pos;
- 
-  /* Display all this information */
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Opens a bounded scan over the portfolios that hold, or have pending
+ * orders on, symbol_id. Released with portfolio_scan_close().
+ */
+int
+holders_scan_open(u_int32_t        symbol_id,
+                  DB_TXN          *txnP,
+                  PORTFOLIO_SCAN  *scanP,
+                  BENCHMARK_DBS   *benchmarkP)
+{
+  DB      *symbolsdbP = NULL;
+  DB_ENV  *envP = NULL;
+  int      isolation;
+  int      rc;
+
+  if (txnP == NULL || scanP == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  envP = benchmarkP->envP;
+  symbolsdbP = benchmarkP->portfolios_symbol_sdbp;
+  if (envP == NULL || symbolsdbP == NULL) {
+    benchmark_error("Portfolios symbol database is not open");
+    goto failXit;
+  }
+
+  memset(scanP, 0, sizeof(PORTFOLIO_SCAN));
+  scanP->symbol_id = symbol_id;
+
+  /* The key must match what get_symbol_id() stores */
+  scanP->key.data = &scanP->symbol_id;
+  scanP->key.size = sizeof(scanP->symbol_id);
+  scanP->key.ulen = sizeof(scanP->symbol_id);
+  scanP->key.flags = DB_DBT_USERMEM;
+
+  scanP->pkey.data = &scanP->portfolio_key;
+  scanP->pkey.ulen = sizeof(scanP->portfolio_key);
+  scanP->pkey.flags = DB_DBT_USERMEM;
+
+  scanP->data.data = &scanP->portfolio;
+  scanP->data.ulen = sizeof(PORTFOLIOS);
+  scanP->data.flags = DB_DBT_USERMEM;
+
+  scanP->op = DB_SET;
+  isolation = xact_isolation_get(txnP, benchmarkP);
+  scanP->read_flags = read_get_flags(isolation);
+
+  rc = symbolsdbP->cursor(symbolsdbP, txnP, &scanP->cursorP, read_cursor_flags(isolation));
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Portfolios.", __FILE__, __LINE__, getpid());
+    scanP->cursorP = NULL;
+    goto failXit;
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Returns the next portfolio of the scan in *portfolioPP, or NULL once
+ * the last duplicate has been visited. The record is owned by the scan
+ * and is overwritten by the next call.
+ */
+int
+portfolio_scan_next(PORTFOLIO_SCAN *scanP, PORTFOLIOS **portfolioPP)
+{
+  int rc;
+
+  if (scanP == NULL || portfolioPP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  *portfolioPP = NULL;
+
+  /* Nothing left, or the scan was never opened */
+  if (scanP->cursorP == NULL || scanP->op == 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  rc = cursor_get_usermem(scanP->cursorP, &scanP->key, &scanP->pkey, &scanP->data, scanP->op | scanP->read_flags);
+  xact_conflict_note(rc);
+  if (rc == DB_NOTFOUND) {
+    scanP->op = 0;
+    return BENCHMARK_SUCCESS;
+  }
+  else if (rc != 0) {
+    if (scanP->account_id[0] != '\0') {
+      benchmark_error("Failed to scan portfolios of account %s: %s", scanP->account_id, db_strerror(rc));
+    }
+    else {
+      benchmark_error("Failed to scan holders of symbol %u: %s", scanP->symbol_id, db_strerror(rc));
+    }
+    goto failXit;
+  }
+
+  scanP->op = DB_NEXT_DUP;
+  *portfolioPP = &scanP->portfolio;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Batch variant of portfolio_scan_next(): copies up to max_portfolios
+ * records into the caller's array. *num_portfolios is less than 
+ * max_portfolios only when the account has no more portfolios.
+ *
+ * NOTE: Berkeley DB does not allow DB_MULTIPLE on secondary indices, 
+ *       so records are still fetched one duplicate at a time. What the
+ *       batch saves is the per-row call and copy overhead on the caller.
+ */
+int
+portfolio_scan_batch(PORTFOLIO_SCAN *scanP, 
+                     PORTFOLIOS     *portfolios, 
+                     int             max_portfolios, 
+                     int            *num_portfolios)
+{
+  PORTFOLIOS *portfolioP = NULL;
+  int n = 0;
+
+  if (scanP == NULL || portfolios == NULL || num_portfolios == NULL || max_portfolios <= 0) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  while (n < max_portfolios) {
+    if (portfolio_scan_next(scanP, &portfolioP) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+
+    if (portfolioP == NULL) {
+      break;
+    }
+
+    memcpy(&portfolios[n], portfolioP, sizeof(PORTFOLIOS));
+    n ++;
+  }
+
+  *num_portfolios = n;
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (num_portfolios != NULL) {
+    *num_portfolios = n;
+  }
+  return BENCHMARK_FAIL;
+}
+
+int
+portfolio_scan_close(PORTFOLIO_SCAN *scanP)
+{
+  int rc;
+
+  if (scanP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  if (scanP->cursorP != NULL) {
+    rc = scanP->cursorP->close(scanP->cursorP);
+    scanP->cursorP = NULL;
+    if (rc != 0) {
+      benchmark_error("Failed to close cursor for Portfolios: %s", db_strerror(rc));
+      goto failXit;
+    }
+  }
+
+  scanP->op = 0;
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+show_personal_item(void *vBuf)
+{
+  char      *account_id;
+  char      *last_name;
+  char      *first_name;
+  char      *address;
+  char      *address_2;
+  char      *city;
+  char      *state;
+  char      *country;
+  char      *phone;
+  char      *email;
+
+  size_t buf_pos = 0;
+  char *buf = (char *)vBuf;
+
+  account_id = buf;
+  buf_pos += ID_SZ;
+  
+  last_name = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  first_name = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  address = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  address_2 = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  city = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  state = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  country = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  phone = buf + buf_pos;
+  buf_pos += NAME_SZ;
+
+  email = buf + buf_pos;
+ 
+  /* Display all this information */
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "================= SHOWING PERSON ==============");
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "AccountId: %s", account_id);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tLast Name: %s", last_name);
@@ -1234,20 +1776,30 @@ int
 show_currencies_records(BENCHMARK_DBS *my_benchmarkP)
 {
   DBC *currencies_cursorp = NULL;
+  CURRENCY currency;
+  char currency_symbol[ID_SZ];
   DBT key, data;
   int exit_value, ret;
 
-  memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  dbt_usermem_set(&key, currency_symbol, sizeof(currency_symbol));
+  dbt_usermem_set(&data, &currency, sizeof(CURRENCY));
 
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "================= SHOWING CURRENCIES DATABASE ==============\n");
 
+  if (CATALOG_FROZEN(my_benchmarkP)) {
+    u_int32_t i;
+    for (i = 0; i < my_benchmarkP->catalog->num_currencies; i++) {
+      (void) show_currencies_item(&my_benchmarkP->catalog->currencies[i]);
+    }
+    return 0;
+  }
+
   my_benchmarkP->currencies_dbp->cursor(my_benchmarkP->currencies_dbp, NULL,
                                     &currencies_cursorp, 0);
 
   exit_value = 0;
   while ((ret =
-    currencies_cursorp->get(currencies_cursorp, &key, &data, DB_NEXT)) == 0)
+    cursor_get_usermem(currencies_cursorp, &key, NULL, &data, DB_NEXT)) == 0)
   {
     (void) show_currencies_item(data.data);
   }
@@ -1288,16 +1840,16 @@ show_currencies_item(void *vBuf)
 }
 
 int
-show_portfolio_item(void *vBuf, char **symbolIdPP)
+show_portfolio_item(void *vBuf, u_int32_t *symbolIdP)
 {
   PORTFOLIOS *portfolioP;
 
   portfolioP = (PORTFOLIOS *)vBuf;
   /* Display all this information */
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "================= SHOWING PORTFOLIO ==============");
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "Portfolio ID: %s", portfolioP->portfolio_id);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "Portfolio ID: %u", ntohl(portfolioP->portfolio_id));
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tAccount ID: %s", portfolioP->account_id);
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tSymbol ID: %s", portfolioP->symbol);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tSymbol ID: %u", portfolioP->symbol_id);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\t# Stocks Hold: %d", portfolioP->hold_stocks);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tSell?: %d", portfolioP->to_sell);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\t# Stocks to sell: %d", portfolioP->number_sell);
@@ -1307,15 +1859,15 @@ show_portfolio_item(void *vBuf, char **symbolIdPP)
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "\tPrice to buy: %d", portfolioP->price_buy);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_OP, "==================================================\n");
 
-  if (symbolIdPP) {
-    *symbolIdPP = portfolioP->symbol; 
+  if (symbolIdP) {
+    *symbolIdP = portfolioP->symbol_id; 
   }
 
   return 0;
 }
 
-int 
-start_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benchmarkP)
+static int 
+begin_xact(benchmark_xact_h *xact_ret, const char *txn_name, u_int32_t flags, BENCHMARK_DBS *benchmarkP)
 {
   int rc = BENCHMARK_SUCCESS;
   DB_TXN  *txnP = NULL;
@@ -1332,7 +1884,7 @@ start_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benc
     goto failXit;
   }
 
-  rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  rc = envP->txn_begin(envP, NULL, &txnP, flags);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
     goto failXit; 
@@ -1345,6 +1897,11 @@ start_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benc
     goto failXit; 
   }
 
+  rc = xact_ctx_attach(txnP);
+  if (rc != BENCHMARK_SUCCESS) {
+    goto failXit; 
+  }
+
   *xact_ret = txnP;
 
   goto cleanup;
@@ -1367,12 +1924,181 @@ cleanup:
   return rc;
 }
 
+int 
+start_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benchmarkP)
+{
+  return begin_xact(xact_ret, txn_name, DB_READ_COMMITTED | DB_TXN_WAIT, benchmarkP);
+}
+
+/* For transactions that don't write: they read at the isolation
+ * level of the calling thread, see read_isolation_get() */
+int 
+start_read_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benchmarkP)
+{
+  int isolation;
+  int rc;
+
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  isolation = read_isolation_get(benchmarkP);
+
+  rc = begin_xact(xact_ret, txn_name, read_xact_flags(isolation), benchmarkP);
+  if (rc == BENCHMARK_SUCCESS) {
+    XACT_CTX(*xact_ret)->isolation = isolation;
+  }
+
+  return rc;
+}
+
+/*
+ * Isolation of a read only call: the thread context's, else the
+ * handle's. Snapshots need multiversion tables; without them, a
+ * snapshot read reads committed data instead.
+ */
+int
+read_isolation_get(BENCHMARK_DBS *benchmarkP)
+{
+  benchmark_thread_ctx_t *thread_ctxP = thread_ctx_current();
+  int isolation = BENCHMARK_ISOLATION_DEFAULT;
+
+  if (thread_ctxP != NULL) {
+    isolation = thread_ctxP->isolation;
+  }
+
+  if (isolation == BENCHMARK_ISOLATION_DEFAULT) {
+    isolation = benchmarkP->config.read_isolation;
+  }
+
+  if (isolation == BENCHMARK_ISOLATION_DEFAULT) {
+    isolation = benchmarkP->config.snapshot_reads ? BENCHMARK_ISOLATION_SNAPSHOT
+                                                  : BENCHMARK_ISOLATION_COMMITTED;
+  }
+
+  if (isolation == BENCHMARK_ISOLATION_SNAPSHOT && !benchmarkP->config.snapshot_reads) {
+    isolation = BENCHMARK_ISOLATION_COMMITTED;
+  }
+
+  return isolation;
+}
+
+/* Read only transactions keep the level they were started with */
+int
+xact_isolation_get(DB_TXN *txnP, BENCHMARK_DBS *benchmarkP)
+{
+  if (txnP != NULL && XACT_CTX(txnP) != NULL
+      && XACT_CTX(txnP)->isolation != BENCHMARK_ISOLATION_DEFAULT) {
+    return XACT_CTX(txnP)->isolation;
+  }
+
+  return read_isolation_get(benchmarkP);
+}
+
+u_int32_t
+read_xact_flags(int isolation)
+{
+  switch (isolation) {
+    case BENCHMARK_ISOLATION_UNCOMMITTED:
+      return DB_READ_UNCOMMITTED | DB_TXN_WAIT;
+
+    case BENCHMARK_ISOLATION_SNAPSHOT:
+      return DB_TXN_SNAPSHOT | DB_TXN_WAIT;
+
+    case BENCHMARK_ISOLATION_SERIALIZABLE:
+      return DB_TXN_WAIT;
+
+    default:
+      return DB_READ_COMMITTED | DB_TXN_WAIT;
+  }
+}
+
+u_int32_t
+read_cursor_flags(int isolation)
+{
+  switch (isolation) {
+    case BENCHMARK_ISOLATION_UNCOMMITTED:
+      return DB_READ_UNCOMMITTED;
+
+    case BENCHMARK_ISOLATION_SNAPSHOT:
+    case BENCHMARK_ISOLATION_SERIALIZABLE:
+      return 0;
+
+    default:
+      return DB_READ_COMMITTED;
+  }
+}
+
+/* Serializable reads take write locks, so that what was read can't
+ * change, or be read for update by others, until the end */
+u_int32_t
+read_get_flags(int isolation)
+{
+  switch (isolation) {
+    case BENCHMARK_ISOLATION_UNCOMMITTED:
+      return DB_READ_UNCOMMITTED;
+
+    case BENCHMARK_ISOLATION_SNAPSHOT:
+      return 0;
+
+    case BENCHMARK_ISOLATION_SERIALIZABLE:
+      return DB_RMW;
+
+    default:
+      return DB_READ_COMMITTED;
+  }
+}
+
+/*
+ * Children let the work of one packet entry be undone without losing
+ * the rest of the packet. They have no context, so their operations
+ * open and close cursors of their own; the parent must not be used
+ * until the child is resolved.
+ */
+int
+start_child_xact(benchmark_xact_h parentH, benchmark_xact_h *xact_ret, BENCHMARK_DBS *benchmarkP)
+{
+  DB_TXN  *txnP = NULL;
+  DB_ENV  *envP = NULL;
+  int      rc;
+
+  if (benchmarkP == NULL || parentH == NULL || xact_ret == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  envP = benchmarkP->envP;
+  if (envP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  rc = envP->txn_begin(envP, (DB_TXN *)parentH, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  xact_conflict_note(rc);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Child transaction begin failed.", __FILE__, __LINE__, getpid());
+    goto failXit; 
+  }
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Starting child transaction: %p of %p", getpid(), txnP, parentH);
+
+  *xact_ret = txnP;
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (xact_ret != NULL) {
+    *xact_ret = NULL;
+  }
+  return BENCHMARK_FAIL;
+}
+
 int 
 commit_xact(benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 {
   int rc = BENCHMARK_SUCCESS;
   DB_TXN  *txnP = NULL;
   DB_ENV  *envP = NULL;
+  void    *pendingP = NULL;
 
   if (benchmarkP == NULL || xactH == NULL) {
     goto failXit;
@@ -1387,18 +2113,31 @@ commit_xact(benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 
   txnP = (DB_TXN *)xactH;
 
+  /* Resolving the transaction frees its handle, and its 
+   * cursors must be closed before that */
+  pendingP = quote_cache_deferred_take(txnP);
+
+  rc = xact_ctx_release(txnP, benchmarkP);
+  if (rc != BENCHMARK_SUCCESS) {
+    goto failXit; 
+  }
+
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
   rc = txnP->commit(txnP, 0);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
     goto failXit; 
   }
 
+  quote_cache_deferred_publish(pendingP, benchmarkP);
+
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   goto cleanup;
 
 failXit:
   BENCHMARK_CHECK_MAGIC(benchmarkP);
+  quote_cache_deferred_discard(pendingP);
   if (txnP != NULL) {
     benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
     rc = txnP->abort(txnP);
@@ -1433,6 +2172,10 @@ abort_xact(benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 
   txnP = (DB_TXN *)xactH;
 
+  /* Updates that didn't commit never reach the quote cache */
+  quote_cache_deferred_discard(quote_cache_deferred_take(txnP));
+  xact_ctx_release(txnP, benchmarkP);
+
   benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
   rc = txnP->abort(txnP);
   if (rc != 0) {
@@ -1452,6 +2195,24 @@ cleanup:
 
 int 
 show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t symbol_id;
+
+  if (symbolP == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  if (symbol_dict_lookup(symbolP, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("This symbol (%s) does not exist.", symbolP);
+    return BENCHMARK_FAIL;
+  }
+
+  return show_quote_by_id(symbol_id, xactH, benchmarkP);
+}
+
+int 
+show_quote_by_id(u_int32_t symbol_id, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 {
   int rc = BENCHMARK_SUCCESS;
   DB_TXN  *txnP = NULL;
@@ -1459,6 +2220,8 @@ show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
   DBT      key, data;
   DBC     *cursorp = NULL; /* To iterate over the porfolios */
   //QUOTE   *quoteP = NULL;
+  QUOTE    quote;
+  benchmark_xact_h ownH = NULL;
 
   if (benchmarkP == NULL) {
     goto failXit;
@@ -1471,21 +2234,32 @@ show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
+  /* Committed quotes can be read from the cache, unless the 
+   * transaction has quote updates of its own, or must lock them */
+  if ((xactH == NULL || XACT_CTX(xactH) == NULL || XACT_CTX(xactH)->quote_pendingP == NULL)
+      && xact_isolation_get((DB_TXN *)xactH, benchmarkP) != BENCHMARK_ISOLATION_SERIALIZABLE
+      && quote_cache_read(symbol_id, &quote, benchmarkP) == BENCHMARK_SUCCESS) {
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, cached: %u $%f", getpid(), symbol_id, quote.current_price);
+    return BENCHMARK_SUCCESS;
+  }
+
   memset(&key, 0, sizeof(DBT));
   memset(&data, 0, sizeof(DBT));
 
+  /* A transaction of our own reads at the level of the thread */
   if (xactH == NULL) {
-    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
+    rc = start_read_xact(&ownH, "SHOW_QUOTE_TXN", benchmarkP);
+    if (rc != BENCHMARK_SUCCESS) {
       goto failXit; 
     }
+    txnP = (DB_TXN *)ownH;
   }
   else {
     txnP = (DB_TXN *)xactH;
   }
 
-  rc = get_stock(symbolP, txnP, &cursorp, &key, &data, 0, benchmarkP);
+  rc = get_stock(symbol_id, txnP, &cursorp, &key, &data, 
+                 read_get_flags(xact_isolation_get(txnP, benchmarkP)), benchmarkP);
   if (rc != BENCHMARK_SUCCESS) {
     benchmark_error("Could not find record.");
     goto failXit; 
@@ -1496,7 +2270,7 @@ show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 
   /* Close the record */
   if (cursorp != NULL) {
-    rc = cursorp->close(cursorp);
+    rc = xact_cursor_release(txnP, cursorp, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for quote", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -1504,11 +2278,10 @@ show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
     cursorp = NULL;
   }
 
-  if (xactH == NULL) {
-    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
-    rc = txnP->commit(txnP, 0);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
+  if (ownH != NULL) {
+    rc = commit_xact(ownH, benchmarkP);
+    ownH = NULL;
+    if (rc != BENCHMARK_SUCCESS) {
       goto failXit; 
     }
   }
@@ -1518,20 +2291,16 @@ show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
 
 failXit:
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  if (xactH == NULL && txnP != NULL) {
+  if (ownH != NULL) {
     if (cursorp != NULL) {
-      rc = cursorp->close(cursorp);
+      rc = xact_cursor_release(txnP, cursorp, benchmarkP);
       if (rc != 0) {
         envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
       }
       cursorp = NULL;
     }
 
-    benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
-    rc = txnP->abort(txnP);
-    if (rc != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Transaction abort failed.", __FILE__, __LINE__, getpid());
-    }
+    abort_xact(ownH, benchmarkP);
   }
 
   rc = BENCHMARK_FAIL;
@@ -1553,6 +2322,27 @@ update_stock(char             *symbolP,
              float             newValue, 
              benchmark_xact_h  xactH,
              BENCHMARK_DBS    *benchmarkP)
+{
+  u_int32_t symbol_id;
+
+  if (symbolP == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  if (symbol_dict_lookup(symbolP, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("This symbol (%s) does not exist.", symbolP);
+    return BENCHMARK_FAIL;
+  }
+
+  return update_stock_by_id(symbol_id, newValue, xactH, benchmarkP);
+}
+
+int 
+update_stock_by_id(u_int32_t         symbol_id, 
+                   float             newValue, 
+                   benchmark_xact_h  xactH,
+                   BENCHMARK_DBS    *benchmarkP)
 {
   int rc = BENCHMARK_SUCCESS;
   DB_TXN  *txnP = NULL;
@@ -1560,6 +2350,8 @@ update_stock(char             *symbolP,
   DBT      key, data;
   DBC     *cursorp = NULL; /* To iterate over the porfolios */
   QUOTE   *quoteP = NULL;
+  QUOTE    published;
+  u_int32_t version = 0;
 
   if (benchmarkP == NULL) {
     goto failXit;
@@ -1572,8 +2364,276 @@ update_stock(char             *symbolP,
     goto failXit;
   }
 
-  memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  memset(&key, 0, sizeof(DBT));
+  memset(&data, 0, sizeof(DBT));
+
+  if (xactH == NULL) {
+    rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
+      goto failXit; 
+    }
+  }
+  else {
+    txnP = (DB_TXN *)xactH;
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT,"PID: %d, Starting transaction: %p", getpid(), txnP);
+  rc = get_stock(symbol_id, txnP, &cursorp, &key, &data, DB_RMW, benchmarkP);
+  if (rc != BENCHMARK_SUCCESS) {
+    benchmark_error("Could not find record.");
+    goto failXit; 
+  }
+  
+  /* Update whatever we need to update */
+  quoteP = data.data;
+  if (newValue >= 0) {
+    quoteP->current_price = newValue;
+  }
+  else {
+    int direction = thread_rand() % 2;
+    if (direction == 0 || quoteP->current_price <= 0) {
+      quoteP->current_price += 0.1;
+    }
+    else {
+      quoteP->current_price -= 0.1;
+    }
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, txnP: %p Updating %u to %f", getpid(), txnP, quoteP->symbol_id, quoteP->current_price);
+
+  /* Save the record */
+  rc = cursorp->put(cursorp, &key, &data, DB_CURRENT);
+  xact_conflict_note(rc);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] failed to update quote", __FILE__, __LINE__, getpid());
+    goto failXit; 
+  }
+
+  /* We still hold the write lock of the record, so the version 
+   * orders this update against any other update of the symbol */
+  if (QUOTE_CACHE_ENABLED(benchmarkP)) {
+    version = quote_cache_version_get(symbol_id, benchmarkP);
+    memcpy(&published, quoteP, sizeof(QUOTE));
+
+    if (xactH != NULL) {
+      rc = quote_cache_defer(txnP, symbol_id, version, &published);
+      if (rc != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+  }
+
+  /* Close the record */
+  if (cursorp != NULL) {
+    rc = xact_cursor_release(txnP, cursorp, benchmarkP);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for quote", __FILE__, __LINE__, getpid());
+      goto failXit; 
+    }
+    cursorp = NULL;
+  }
+
+  if (xactH == NULL) {
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
+    rc = txnP->commit(txnP, 0);
+    xact_conflict_note(rc);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
+      goto failXit; 
+    }
+
+    if (QUOTE_CACHE_ENABLED(benchmarkP)) {
+      quote_cache_publish(symbol_id, version, &published, benchmarkP);
+    }
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  goto cleanup;
+
+failXit:
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  if (xactH == NULL && txnP != NULL) {
+    if (cursorp != NULL) {
+      rc = cursorp->close(cursorp);
+      if (rc != 0) {
+        envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+      }
+      cursorp = NULL;
+    }
+
+    benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
+    rc = txnP->abort(txnP);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Transaction abort failed.", __FILE__, __LINE__, getpid());
+    }
+  }
+
+  rc = BENCHMARK_FAIL;
+
+cleanup:
+  return rc;
+}
+
+/* One entry of a batched quote refresh (see update_stocks_sorted) */
+typedef struct stock_update_t {
+  u_int32_t symbol_id;
+  float     price;
+  const quote_tick_t *tickP;  /* NULL if only the price changes */
+  int       position;       /* Index in the caller's arrays */
+  int       applied;
+  u_int32_t version;        /* Quote cache version */
+} stock_update_t;
+
+static int
+compare_stock_update(const void *a, const void *b)
+{
+  const stock_update_t *updA = a;
+  const stock_update_t *updB = b;
+
+  if (updA->symbol_id != updB->symbol_id) {
+    return updA->symbol_id < updB->symbol_id ? -1 : 1;
+  }
+
+  return updA->position - updB->position;
+}
+
+/* Writes the trade date of a quote as month/day/year, with a two
+ * digit year so that every date fits in trade_time. Quotes get their
+ * date this way whether they are loaded, generated or ticked; month
+ * and day must be valid already. */
+void
+quote_trade_date_set(QUOTE *quoteP, int year, int month, int day)
+{
+  snprintf(quoteP->trade_time, sizeof(quoteP->trade_time), "%u/%u/%02u",
+           (unsigned int) month % 100, (unsigned int) day % 100,
+           (unsigned int) year % 100);
+}
+
+/* Applies a tick to the quote read for its symbol. The volume of
+ * the tick adds to the volume of the day, and its timestamp gives
+ * the trade date. */
+static void
+quote_tick_apply(QUOTE *quoteP, const quote_tick_t *tickP)
+{
+  struct tm tm;
+
+  quoteP->current_price = tickP->price;
+  if (quoteP->low_price_day <= 0 || tickP->price < quoteP->low_price_day) {
+    quoteP->low_price_day = tickP->price;
+  }
+  if (tickP->price > quoteP->high_price_day) {
+    quoteP->high_price_day = tickP->price;
+  }
+
+  if (tickP->bid >= 0) {
+    quoteP->bidding_price = tickP->bid;
+  }
+  if (tickP->ask >= 0) {
+    quoteP->asking_price = tickP->ask;
+  }
+  if (tickP->volume >= 0) {
+    quoteP->trade_volume += tickP->volume;
+  }
+  if (tickP->timestamp > 0 && gmtime_r(&tickP->timestamp, &tm) != NULL) {
+    quote_trade_date_set(quoteP, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+  }
+}
+
+/*---------------------------------------------
+ * Updates a batch of quotes in a single 
+ * transaction.
+ *
+ * The updates are sorted on symbol id, which is 
+ * the key order of Quotes, and a single cursor 
+ * locks the records in that order. This lowers 
+ * the chance that two batches deadlock, but does
+ * not rule it out: a hash table does not lock 
+ * its pages in key order, and a caller's xactH 
+ * may already hold other locks. Callers must 
+ * still retry lost lock conflicts.
+ * The new records are written back with one 
+ * DB_MULTIPLE_KEY put.
+ *
+ * Either prices or ticks is given. The prices
+ * of a symbol that appears more than once are 
+ * replaced by the last one, while its ticks are
+ * all applied, in the order given.
+ *---------------------------------------------*/
+static int 
+update_stocks_batch(int                 num_symbols,
+                    const u_int32_t    *symbol_ids, 
+                    const float        *prices, 
+                    const quote_tick_t *ticks,
+                    int                *status_list,
+                    benchmark_xact_h    xactH,
+                    BENCHMARK_DBS      *benchmarkP)
+{
+  int rc = BENCHMARK_SUCCESS;
+  DB_TXN  *txnP = NULL;
+  DB_ENV  *envP = NULL;
+  DB      *quotesdbP = NULL;
+  DBC     *cursorp = NULL;
+  DBT      key, data, bulk;
+  stock_update_t *updates = NULL;
+  QUOTE   *quotes = NULL;
+  void    *bulk_buffer = NULL;
+  void    *bulkP = NULL;
+  u_int32_t bulk_size;
+  int      num_updates = 0;
+  int      num_found = 0;
+  int      run_start = 0;
+  int      i, j, k;
+
+  if (benchmarkP == NULL || (ticks == NULL && (symbol_ids == NULL || prices == NULL))
+      || status_list == NULL || num_symbols < 0) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  envP = benchmarkP->envP;
+  quotesdbP = benchmarkP->quotes_dbp;
+  if (envP == NULL || quotesdbP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  for (i = 0; i < num_symbols; i++) {
+    status_list[i] = BENCHMARK_FAIL;
+  }
+
+  if (num_symbols == 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  updates = thread_scratch_alloc(num_symbols * sizeof(stock_update_t));
+  quotes = thread_scratch_alloc(num_symbols * sizeof(QUOTE));
+  if (updates == NULL || quotes == NULL) {
+    benchmark_error("Could not allocate batch of %d updates", num_symbols);
+    goto failXit;
+  }
+  memset(updates, 0, num_symbols * sizeof(stock_update_t));
+
+  for (i = 0; i < num_symbols; i++) {
+    if (ticks != NULL) {
+      updates[num_updates].symbol_id = ticks[i].symbol_id;
+      updates[num_updates].price = ticks[i].price;
+      updates[num_updates].tickP = &ticks[i];
+    }
+    else {
+      updates[num_updates].symbol_id = symbol_ids[i];
+      updates[num_updates].price = prices[i];
+    }
+    if (updates[num_updates].symbol_id >= (u_int32_t) benchmarkP->number_stocks) {
+      benchmark_warning("This symbol id (%u) does not exist.", updates[num_updates].symbol_id);
+      continue;
+    }
+    updates[num_updates].position = i;
+    num_updates ++;
+  }
+
+  qsort(updates, num_updates, sizeof(stock_update_t), compare_stock_update);
 
   if (xactH == NULL) {
     rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
@@ -1586,70 +2646,176 @@ update_stock(char             *symbolP,
     txnP = (DB_TXN *)xactH;
   }
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT,"PID: %d, Starting transaction: %p", getpid(), txnP);
-  rc = get_stock(symbolP, txnP, &cursorp, &key, &data, DB_RMW, benchmarkP);
-  if (rc != BENCHMARK_SUCCESS) {
-    benchmark_error("Could not find record.");
-    goto failXit; 
-  }
-  
-  /* Update whatever we need to update */
-  quoteP = data.data;
-  if (newValue >= 0) {
-    quoteP->current_price = newValue;
+  rc = xact_cursor_get(txnP, XACT_CURSOR_QUOTES, &cursorp, benchmarkP);
+  xact_conflict_note(rc);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Quotes.", __FILE__, __LINE__, getpid());
+    goto failXit;
   }
-  else {
-    int direction = rand() % 2;
-    if (direction == 0 || quoteP->current_price <= 0) {
-      quoteP->current_price += 0.1;
+
+  /* Lock and read the records in key order. Duplicates of a symbol 
+   * are adjacent after the sort, and the record is written for the
+   * last one. */
+  for (i = 0; i < num_updates; i++) {
+    if (i == 0 || updates[i - 1].symbol_id != updates[i].symbol_id) {
+      run_start = i;
+    }
+    if (i + 1 < num_updates && updates[i + 1].symbol_id == updates[i].symbol_id) {
+      continue;
+    }
+
+    memset(&key, 0, sizeof(DBT));
+    memset(&data, 0, sizeof(DBT));
+
+    key.data = &updates[i].symbol_id;
+    key.size = sizeof(u_int32_t);
+
+    data.data = &quotes[i];
+    data.ulen = sizeof(QUOTE);
+    data.flags = DB_DBT_USERMEM;
+
+    rc = cursorp->get(cursorp, &key, &data, DB_SET | DB_RMW);
+    xact_conflict_note(rc);
+    if (rc == DB_NOTFOUND) {
+      benchmark_warning("No quote for symbol id %u", updates[i].symbol_id);
+      continue;
+    }
+    else if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to read quote %u.", __FILE__, __LINE__, getpid(), updates[i].symbol_id);
+      goto failXit;
+    }
+
+    if (updates[i].tickP != NULL) {
+      for (k = run_start; k <= i; k++) {
+        quote_tick_apply(&quotes[i], updates[k].tickP);
+      }
+    }
+    else if (updates[i].price >= 0) {
+      quotes[i].current_price = updates[i].price;
     }
     else {
-      quoteP->current_price -= 0.1;
+      int direction = thread_rand() % 2;
+      if (direction == 0 || quotes[i].current_price <= 0) {
+        quotes[i].current_price += 0.1;
+      }
+      else {
+        quotes[i].current_price -= 0.1;
+      }
     }
-  }
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, txnP: %p Updating %s to %f", getpid(), txnP, quoteP->symbol, quoteP->current_price);
+    updates[i].applied = 1;
+    num_found ++;
+  }
 
-  /* Save the record */
-  rc = cursorp->put(cursorp, &key, &data, DB_CURRENT);
+  rc = xact_cursor_release(txnP, cursorp, benchmarkP);
+  cursorp = NULL;
   if (rc != 0) {
-    envP->err(envP, rc, "[%s:%d] [%d] failed to update quote", __FILE__, __LINE__, getpid());
-    goto failXit; 
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for Quotes.", __FILE__, __LINE__, getpid());
+    goto failXit;
   }
 
-  /* Close the record */
-  if (cursorp != NULL) {
-    rc = cursorp->close(cursorp);
+  if (num_found > 0) {
+    /* Each pair takes its key and data plus four offsets, and the
+     * buffer ends with a terminator */
+    bulk_size = num_found * (sizeof(u_int32_t) + sizeof(QUOTE) + 4 * sizeof(u_int32_t))
+                + 2 * sizeof(u_int32_t);
+    bulk_size = (bulk_size + 1023) & ~1023;
+
+    bulk_buffer = thread_scratch_alloc(bulk_size);
+    if (bulk_buffer == NULL) {
+      benchmark_error("Could not allocate bulk buffer");
+      goto failXit;
+    }
+
+    memset(&bulk, 0, sizeof(DBT));
+    bulk.data = bulk_buffer;
+    bulk.ulen = bulk_size;
+    bulk.flags = DB_DBT_USERMEM;
+
+    DB_MULTIPLE_WRITE_INIT(bulkP, &bulk);
+    for (i = 0; i < num_updates; i++) {
+      if (!updates[i].applied) {
+        continue;
+      }
+      DB_MULTIPLE_KEY_WRITE_NEXT(bulkP, &bulk,
+                                 &updates[i].symbol_id, sizeof(u_int32_t),
+                                 &quotes[i], sizeof(QUOTE));
+      if (bulkP == NULL) {
+        benchmark_error("Bulk buffer is too small");
+        goto failXit;
+      }
+    }
+
+    /* The key holds the pairs; the data argument is not used */
+    memset(&data, 0, sizeof(DBT));
+    rc = quotesdbP->put(quotesdbP, txnP, &bulk, &data, DB_MULTIPLE_KEY);
+    xact_conflict_note(rc);
     if (rc != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for quote", __FILE__, __LINE__, getpid());
-      goto failXit; 
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to update %d quotes.", __FILE__, __LINE__, getpid(), num_found);
+      goto failXit;
+    }
+  }
+
+  /* We still hold the write locks, so the versions order these
+   * updates against any other update of the same symbols */
+  if (QUOTE_CACHE_ENABLED(benchmarkP)) {
+    for (i = 0; i < num_updates; i++) {
+      if (!updates[i].applied) {
+        continue;
+      }
+      updates[i].version = quote_cache_version_get(updates[i].symbol_id, benchmarkP);
+      if (xactH != NULL) {
+        rc = quote_cache_defer(txnP, updates[i].symbol_id, updates[i].version, &quotes[i]);
+        if (rc != BENCHMARK_SUCCESS) {
+          goto failXit;
+        }
+      }
     }
-    cursorp = NULL;
   }
 
   if (xactH == NULL) {
     benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
     rc = txnP->commit(txnP, 0);
+    xact_conflict_note(rc);
+    txnP = NULL;
     if (rc != 0) {
-      envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed. txnP: %p", __FILE__, __LINE__, getpid(), txnP);
+      envP->err(envP, rc, "[%s:%d] [%d] Transaction commit failed.", __FILE__, __LINE__, getpid());
       goto failXit; 
     }
+
+    if (QUOTE_CACHE_ENABLED(benchmarkP)) {
+      for (i = 0; i < num_updates; i++) {
+        if (updates[i].applied) {
+          quote_cache_publish(updates[i].symbol_id, updates[i].version, &quotes[i], benchmarkP);
+        }
+      }
+    }
   }
 
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  /* Every position that asked for an updated symbol succeeds. The
+   * update applied is the last one of each run of the same symbol. */
+  for (i = 0; i < num_updates; i = j) {
+    for (j = i; j < num_updates && updates[j].symbol_id == updates[i].symbol_id; j++)
+      ;
+    if (updates[j - 1].applied) {
+      for (k = i; k < j; k++) {
+        status_list[updates[k].position] = BENCHMARK_SUCCESS;
+      }
+    }
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Updated %d of %d quotes", num_found, num_symbols);
+
+  rc = BENCHMARK_SUCCESS;
   goto cleanup;
 
 failXit:
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-  if (xactH == NULL && txnP != NULL) {
-    if (cursorp != NULL) {
-      rc = cursorp->close(cursorp);
-      if (rc != 0) {
-        envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
-      }
-      cursorp = NULL;
-    }
+  if (cursorp != NULL) {
+    xact_cursor_release(txnP, cursorp, benchmarkP);
+    cursorp = NULL;
+  }
 
+  if (xactH == NULL && txnP != NULL) {
     benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
     rc = txnP->abort(txnP);
     if (rc != 0) {
@@ -1657,12 +2823,60 @@ failXit:
     }
   }
 
+  if (status_list != NULL) {
+    for (i = 0; i < num_symbols; i++) {
+      status_list[i] = BENCHMARK_FAIL;
+    }
+  }
+
   rc = BENCHMARK_FAIL;
 
 cleanup:
+  thread_scratch_free(bulk_buffer);
+  thread_scratch_free(quotes);
+  thread_scratch_free(updates);
   return rc;
 }
 
+/*---------------------------------------------
+ * Updates a batch of quotes in a single 
+ * transaction (see update_stocks_batch).
+ *
+ * status_list[i] tells whether symbol_ids[i] was
+ * updated. Unknown symbols are skipped and do 
+ * not fail the batch; when a symbol appears more
+ * than once, its last price wins.
+ *---------------------------------------------*/
+int 
+update_stocks_sorted(int               num_symbols,
+                     const u_int32_t  *symbol_ids, 
+                     const float      *prices, 
+                     int              *status_list,
+                     benchmark_xact_h  xactH,
+                     BENCHMARK_DBS    *benchmarkP)
+{
+  return update_stocks_batch(num_symbols, symbol_ids, prices, NULL,
+                             status_list, xactH, benchmarkP);
+}
+
+/* Same as update_stocks_sorted(), with the price, bid and ask, volume
+ * and time of each tick */
+int 
+update_stocks_ticks(int                 num_ticks,
+                    const quote_tick_t *ticks, 
+                    int                *status_list,
+                    benchmark_xact_h    xactH,
+                    BENCHMARK_DBS      *benchmarkP)
+{
+  if (ticks == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  return update_stocks_batch(num_ticks, NULL, NULL, ticks,
+                             status_list, xactH, benchmarkP);
+}
+
 
 int 
 sell_stocks(const char *account_id, 
@@ -1672,6 +2886,31 @@ sell_stocks(const char *account_id,
             int force_apply, 
             benchmark_xact_h  xactH,
             BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t symbol_id;
+
+  if (symbol == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  if (symbol_dict_lookup(symbol, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("This symbol (%s) does not exist.", symbol);
+    return BENCHMARK_FAIL;
+  }
+
+  return sell_stocks_by_id(account_id, symbol_id, price, amount, 
+                  force_apply, xactH, benchmarkP);
+}
+
+int 
+sell_stocks_by_id(const char *account_id, 
+                  u_int32_t symbol_id, 
+                  float price, 
+                  int amount, 
+                  int force_apply, 
+                  benchmark_xact_h  xactH,
+                  BENCHMARK_DBS *benchmarkP)
 {
   int rc = 0;
   DB_TXN  *txnP = NULL;
@@ -1721,38 +2960,38 @@ sell_stocks(const char *account_id,
   }
 
   /* 2) search the symbol */
-  exists = symbol_exists(symbol, txnP, benchmarkP);
-  if (!exists) {
-    benchmark_error("This symbol (%s) does not exist.", symbol);
+  if (symbol_id >= (u_int32_t) benchmarkP->number_stocks) {
+    benchmark_error("This symbol (%u) does not exist.", symbol_id);
     goto failXit; 
   }
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Looking up portfolio for account: %s and symbol: %s", account_id, symbol);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Looking up portfolio for account: %s and symbol: %u", account_id, symbol_id);
 
   /* get a cursor to the portfolio */
-  rc = get_portfolio(account_id, symbol, txnP, &cursor_portfolioP, &key_portfolio, &data_portfolio, benchmarkP);
+  rc = get_portfolio(account_id, symbol_id, txnP, &cursor_portfolioP, &key_portfolio, &data_portfolio, benchmarkP);
   if (rc != BENCHMARK_SUCCESS) {
-    benchmark_error("Failed to obtain portfolio for account: %s and symbol: %s.", account_id, symbol);
+    benchmark_error("Failed to obtain portfolio for account: %s and symbol: %u.", account_id, symbol_id);
     goto failXit; 
   }
 
   /* Update whatever we need to update */
   portfolioP = data_portfolio.data;
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Found portfolio for account: %s and symbol: %s -> %s", account_id, symbol, portfolioP->portfolio_id);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Found portfolio for account: %s and symbol: %u -> %u", account_id, symbol_id, ntohl(portfolioP->portfolio_id));
   if (portfolioP->hold_stocks < amount) {
     benchmark_error("Not enough stocks for this symbol. Have: %d, wanted: %d", portfolioP->hold_stocks, amount);
     goto failXit; 
   }
 
   /* Locate the porfolio in the primary database */
-  rc = benchmarkP->portfolios_dbp->cursor(benchmarkP->portfolios_dbp, txnP,
-                                    &cursor_primary_portfolioP, DB_READ_COMMITTED);
+  rc = xact_cursor_get(txnP, XACT_CURSOR_PORTFOLIOS, &cursor_primary_portfolioP, benchmarkP);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Portfolio.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
-  rc = cursor_primary_portfolioP->get(cursor_primary_portfolioP, &key_portfolio, &data_portfolio, DB_SET);
+  rc = cursor_get_usermem(cursor_primary_portfolioP, &key_portfolio, NULL, &data_portfolio, DB_SET);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to find record in Portfolio.", __FILE__, __LINE__, getpid());
     goto failXit;
@@ -1762,13 +3001,13 @@ sell_stocks(const char *account_id,
 
   /* Perform the sell right away */
   if (force_apply == 1) {
-    rc = get_stock(symbol, txnP, &cursor_quoteP, &key_quote, &data_quote, 0, benchmarkP);
+    rc = get_stock(symbol_id, txnP, &cursor_quoteP, &key_quote, &data_quote, DB_READ_COMMITTED, benchmarkP);
     if (rc != BENCHMARK_SUCCESS) {
       benchmark_error("Could not find record.");
       goto failXit; 
     }
     quoteP = data_quote.data;
-    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %s is %f, requested is: %f", symbol, quoteP->current_price, price);
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %u is %f, requested is: %f", symbol_id, quoteP->current_price, price);
     if (quoteP->current_price >= price) {
       benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Selling %d stocks", amount);
       portfolioP->hold_stocks -= amount;
@@ -1780,7 +3019,7 @@ sell_stocks(const char *account_id,
   }
   /* Save the request and let the system decide */
   else {
-    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Setting sell request for stock: %s for %d at %f", symbol, amount, price);
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Setting sell request for stock: %u for %d at %f", symbol_id, amount, price);
     portfolioP->to_sell = 1;
     portfolioP->number_sell = amount;
     portfolioP->price_sell = price;
@@ -1788,6 +3027,7 @@ sell_stocks(const char *account_id,
 
   /* Save the record */
   rc = cursor_primary_portfolioP->put(cursor_primary_portfolioP, &key_portfolio, &data_portfolio, DB_CURRENT);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Could not update record.", __FILE__, __LINE__, getpid());
     goto failXit; 
@@ -1795,7 +3035,7 @@ sell_stocks(const char *account_id,
 
   /* Close the record */
   if (cursor_portfolioP != NULL) {
-    rc = cursor_portfolioP->close(cursor_portfolioP);
+    rc = xact_cursor_release(txnP, cursor_portfolioP, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -1806,7 +3046,7 @@ sell_stocks(const char *account_id,
 
   /* Close the record */
   if (cursor_primary_portfolioP != NULL) {
-    rc = cursor_primary_portfolioP->close(cursor_primary_portfolioP);
+    rc = xact_cursor_release(txnP, cursor_primary_portfolioP, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -1815,9 +3055,20 @@ sell_stocks(const char *account_id,
     cursor_primary_portfolioP = NULL;
   }
 
+  if (cursor_quoteP != NULL) {
+    rc = xact_cursor_release(txnP, cursor_quoteP, benchmarkP);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
+      goto failXit; 
+    }
+
+    cursor_quoteP = NULL;
+  }
+
   if (xactH == NULL) {
     benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
     rc = txnP->commit(txnP, 0);
+    xact_conflict_note(rc);
     if (rc != 0) {
       envP->err(envP, rc, "%s:%d Transaction commit failed.", __func__, __LINE__);
       goto failXit; 
@@ -1830,9 +3081,11 @@ sell_stocks(const char *account_id,
 
 failXit:
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  if (xactH == NULL && txnP != NULL) {
+  /* The caller's transaction is aborted by the caller, which Berkeley
+   * DB refuses while cursors are open, so they are always closed */
+  if (txnP != NULL) {
     if (cursor_portfolioP != NULL) {
-      rc = cursor_portfolioP->close(cursor_portfolioP);
+      rc = xact_cursor_release(txnP, cursor_portfolioP, benchmarkP);
       if (rc != 0) {
         envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       }
@@ -1840,15 +3093,23 @@ failXit:
     }
 
     if (cursor_primary_portfolioP != NULL) {
-      rc = cursor_primary_portfolioP->close(cursor_primary_portfolioP);
+      rc = xact_cursor_release(txnP, cursor_primary_portfolioP, benchmarkP);
       if (rc != 0) {
         envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
-        goto failXit; 
       }
-
       cursor_primary_portfolioP = NULL;
     }
 
+    if (cursor_quoteP != NULL) {
+      rc = xact_cursor_release(txnP, cursor_quoteP, benchmarkP);
+      if (rc != 0) {
+        envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
+      }
+      cursor_quoteP = NULL;
+    }
+  }
+
+  if (xactH == NULL && txnP != NULL) {
     benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
     rc = txnP->abort(txnP);
     if (rc != 0) {
@@ -1872,6 +3133,31 @@ place_order(const char *account_id,
             int force_apply, 
             benchmark_xact_h  xactH,
             BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t symbol_id;
+
+  if (symbol == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  if (symbol_dict_lookup(symbol, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("This symbol (%s) does not exist.", symbol);
+    return BENCHMARK_FAIL;
+  }
+
+  return place_order_by_id(account_id, symbol_id, price, amount, 
+                  force_apply, xactH, benchmarkP);
+}
+
+int 
+place_order_by_id(const char *account_id, 
+                  u_int32_t symbol_id, 
+                  float price, 
+                  int amount, 
+                  int force_apply, 
+                  benchmark_xact_h  xactH,
+                  BENCHMARK_DBS *benchmarkP)
 {
   int rc = 0;
   int exists = 0;
@@ -1914,27 +3200,27 @@ place_order(const char *account_id,
   }
 
   /* 2) search the symbol */
-  exists = symbol_exists(symbol, txnP, benchmarkP);
-  if (!exists) {
-    benchmark_error("This symbol (%s) does not exist.", symbol);
+  if (symbol_id >= (u_int32_t) benchmarkP->number_stocks) {
+    benchmark_error("This symbol (%u) does not exist.", symbol_id);
     goto failXit; 
   }
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Looking up portfolio for account: %s and symbol: %s", account_id, symbol);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Looking up portfolio for account: %s and symbol: %u", account_id, symbol_id);
 
   /* 3) exists portfolio */
-  rc = get_portfolio(account_id, symbol, txnP, &cursor_portfolioP, &key_portfolio, &data_portfolio, benchmarkP);
+  rc = get_portfolio(account_id, symbol_id, txnP, &cursor_portfolioP, &key_portfolio, &data_portfolio, benchmarkP);
 
   /* 3.1) if so, update */
   if (rc == BENCHMARK_SUCCESS) {
-    rc = benchmarkP->portfolios_dbp->cursor(benchmarkP->portfolios_dbp, txnP,
-                                      &cursor_primary_portfolioP, DB_READ_COMMITTED);
+    rc = xact_cursor_get(txnP, XACT_CURSOR_PORTFOLIOS, &cursor_primary_portfolioP, benchmarkP);
+    xact_conflict_note(rc);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Portfolio.", __FILE__, __LINE__, getpid());
       goto failXit;
     }
 
-    rc = cursor_primary_portfolioP->get(cursor_primary_portfolioP, &key_portfolio, &data_portfolio, DB_SET);
+    rc = cursor_get_usermem(cursor_primary_portfolioP, &key_portfolio, NULL, &data_portfolio, DB_SET);
+    xact_conflict_note(rc);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Failed to find record in Portfolio.", __FILE__, __LINE__, getpid());
       goto failXit;
@@ -1944,13 +3230,13 @@ place_order(const char *account_id,
 
     /* Perform the sell right away */
     if (force_apply == 1) {
-      rc = get_stock(symbol, txnP, &cursor_quoteP, &key_quote, &data_quote, 0, benchmarkP);
+      rc = get_stock(symbol_id, txnP, &cursor_quoteP, &key_quote, &data_quote, DB_READ_COMMITTED, benchmarkP);
       if (rc != BENCHMARK_SUCCESS) {
         benchmark_error("Could not find record.");
         goto failXit; 
       }
       quoteP = data_quote.data;
-      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %s is %f, requested is: %f", symbol, quoteP->current_price, price);
+      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %u is %f, requested is: %f", symbol_id, quoteP->current_price, price);
       if (quoteP->current_price <= price) {
         benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Purchasing %d stocks", amount);
         portfolioP->hold_stocks += amount;
@@ -1962,7 +3248,7 @@ place_order(const char *account_id,
     }
     /* Save the request and let the system decide */
     else {
-      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Setting buy request for stock: %s for %d at %f", symbol, amount, price);
+      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Setting buy request for stock: %u for %d at %f", symbol_id, amount, price);
       portfolioP->to_buy = 1;
       portfolioP->number_buy = amount;
       portfolioP->price_buy = price;
@@ -1971,6 +3257,7 @@ place_order(const char *account_id,
     /* Save the record */
 
     rc = cursor_primary_portfolioP->put(cursor_primary_portfolioP, &key_portfolio, &data_portfolio, DB_CURRENT);
+    xact_conflict_note(rc);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Could not update record.", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -1980,26 +3267,26 @@ place_order(const char *account_id,
   /* 3.2) otherwise, create a new portfolio */
   else {
     if (force_apply == 1) {
-      rc = get_stock(symbol, txnP, &cursor_quoteP, &key_quote, &data_quote, 0, benchmarkP);
+      rc = get_stock(symbol_id, txnP, &cursor_quoteP, &key_quote, &data_quote, DB_READ_COMMITTED, benchmarkP);
       if (rc != BENCHMARK_SUCCESS) {
         benchmark_error("Could not find record.");
         goto failXit; 
       }
       quoteP = data_quote.data;
-      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %s is %f, requested is: %f", symbol, quoteP->current_price, price);
+      benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Current price for stock: %u is %f, requested is: %f", symbol_id, quoteP->current_price, price);
       if (quoteP->current_price <= price) {
-        benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Purchasing %d stocks of symbol: %s at %f USD since %s wanted a price <= %f USD", 
-                       amount, symbol, quoteP->current_price, account_id, price);
+        benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Purchasing %d stocks of symbol: %u at %f USD since %s wanted a price <= %f USD", 
+                       amount, symbol_id, quoteP->current_price, account_id, price);
       }
       else {
-        benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Price is to high to process request. Price is: %f USD for symbol: %s, but %s wanted a price <= %f USD ",
-                        quoteP->current_price, symbol, account_id, price);
+        benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Price is to high to process request. Price is: %f USD for symbol: %u, but %s wanted a price <= %f USD ",
+                        quoteP->current_price, symbol_id, account_id, price);
         goto failXit;
       }
     }
 
-    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "User: %s currently doesn't hold stocks of symbol: %s, so updating its portfolio....", account_id, symbol);
-    rc = create_portfolio(account_id, symbol, price, amount, force_apply, txnP, benchmarkP);
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "User: %s currently doesn't hold stocks of symbol: %u, so updating its portfolio....", account_id, symbol_id);
+    rc = create_portfolio(account_id, symbol_id, price, amount, force_apply, txnP, benchmarkP);
     if (rc != BENCHMARK_SUCCESS) {
       benchmark_error("Could not create new entry in portfolio");
       goto failXit; 
@@ -2008,7 +3295,7 @@ place_order(const char *account_id,
 
   /* Close the record */
   if (cursor_portfolioP != NULL) {
-    rc = cursor_portfolioP->close(cursor_portfolioP);
+    rc = xact_cursor_release(txnP, cursor_portfolioP, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -2019,7 +3306,7 @@ place_order(const char *account_id,
 
   /* Close the record */
   if (cursor_primary_portfolioP != NULL) {
-    rc = cursor_primary_portfolioP->close(cursor_primary_portfolioP);
+    rc = xact_cursor_release(txnP, cursor_primary_portfolioP, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       goto failXit; 
@@ -2028,9 +3315,20 @@ place_order(const char *account_id,
     cursor_primary_portfolioP = NULL;
   }
 
+  if (cursor_quoteP != NULL) {
+    rc = xact_cursor_release(txnP, cursor_quoteP, benchmarkP);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
+      goto failXit; 
+    }
+
+    cursor_quoteP = NULL;
+  }
+
   if (xactH == NULL) {
     benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Committing transaction: %p", getpid(), txnP);
     rc = txnP->commit(txnP, 0);
+    xact_conflict_note(rc);
     if (rc != 0) {
       envP->err(envP, rc, "%s:%d Transaction commit failed.", __func__, __LINE__);
       goto failXit; 
@@ -2042,9 +3340,11 @@ place_order(const char *account_id,
 
 failXit:
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  if (xactH == NULL && txnP != NULL) {
+  /* The caller's transaction is aborted by the caller, which Berkeley
+   * DB refuses while cursors are open, so they are always closed */
+  if (txnP != NULL) {
     if (cursor_portfolioP != NULL) {
-      rc = cursor_portfolioP->close(cursor_portfolioP);
+      rc = xact_cursor_release(txnP, cursor_portfolioP, benchmarkP);
       if (rc != 0) {
         envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
       }
@@ -2052,15 +3352,23 @@ failXit:
     }
 
     if (cursor_primary_portfolioP != NULL) {
-      rc = cursor_primary_portfolioP->close(cursor_primary_portfolioP);
+      rc = xact_cursor_release(txnP, cursor_primary_portfolioP, benchmarkP);
       if (rc != 0) {
         envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
-        goto failXit; 
       }
-
       cursor_primary_portfolioP = NULL;
     }
 
+    if (cursor_quoteP != NULL) {
+      rc = xact_cursor_release(txnP, cursor_quoteP, benchmarkP);
+      if (rc != 0) {
+        envP->err(envP, rc, "[%s:%d] [%d] Could not close cursor.", __FILE__, __LINE__, getpid());
+      }
+      cursor_quoteP = NULL;
+    }
+  }
+
+  if (xactH == NULL && txnP != NULL) {
     benchmark_warning("PID: %d About to abort transaction. txnP: %p", getpid(), txnP);
     rc = txnP->abort(txnP);
     if (rc != 0) {
@@ -2075,9 +3383,70 @@ cleanup:
   return rc;
 }
 
+void
+dbt_usermem_set(DBT *dbtP, void *bufferP, u_int32_t size)
+{
+  memset(dbtP, 0, sizeof(DBT));
+  dbtP->data = bufferP;
+  dbtP->ulen = size;
+  dbtP->flags = DB_DBT_USERMEM;
+}
+
+/*
+ * Reads through cursorP (with pget() when pkeyP is given) into the
+ * DB_DBT_USERMEM buffers of the DBTs. Berkeley DB leaves the cursor
+ * on a record that is larger than its buffer, so such a record is
+ * read again from there, into a spill buffer of the thread.
+ */
+int
+cursor_get_usermem(DBC *cursorP, DBT *keyP, DBT *pkeyP, DBT *dataP, u_int32_t flags)
+{
+  DBT *dbts[READ_SPILL_TYPES];
+  int  rc;
+  int  i;
+
+  rc = (pkeyP != NULL) ? cursorP->pget(cursorP, keyP, pkeyP, dataP, flags)
+                       : cursorP->get(cursorP, keyP, dataP, flags);
+  if (rc != DB_BUFFER_SMALL) {
+    return rc;
+  }
+
+  dbts[READ_SPILL_KEY] = keyP;
+  dbts[READ_SPILL_PKEY] = pkeyP;
+  dbts[READ_SPILL_DATA] = dataP;
+
+  for (i = 0; i < READ_SPILL_TYPES; i++) {
+    if (dbts[i] == NULL 
+        || !(dbts[i]->flags & DB_DBT_USERMEM) 
+        || dbts[i]->size <= dbts[i]->ulen) {
+      continue;
+    }
+
+    dbts[i]->data = thread_spill_get(i, dbts[i]->size);
+    if (dbts[i]->data == NULL) {
+      return ENOMEM;
+    }
+    dbts[i]->ulen = dbts[i]->size;
+  }
+
+  flags = DB_CURRENT | (flags & ~DB_OPFLAGS_MASK);
+
+  return (pkeyP != NULL) ? cursorP->pget(cursorP, keyP, pkeyP, dataP, flags)
+                         : cursorP->get(cursorP, keyP, dataP, flags);
+}
+
+/*
+ * Finds the portfolio that account_id holds for symbol. This is a single
+ * DB_SET on the PortfoliosHoldings secondary, so its cost does not depend
+ * on the number of portfolios in the system.
+ *
+ * On success the cursor is left positioned on the holding and key_ret and
+ * data_ret point to the primary key and data of the portfolio, in the
+ * read buffers of the thread. Both remain valid until the next lookup.
+ */
 int
 get_portfolio(const char *account_id, 
-              const char *symbol, 
+              u_int32_t symbol_id, 
               DB_TXN *txnP, 
               DBC **cursorPP, 
               DBT *key_ret, 
@@ -2086,14 +3455,14 @@ get_portfolio(const char *account_id,
 {
   DBC *cursorp = NULL;
   DB  *portfoliosdbP= NULL;
-  DB  *portfoliossdbP= NULL;
+  DB  *holdingsdbP= NULL;
   DB_ENV  *envP = NULL;
   DBT pkey, pdata;
   DBT key;
+  char holding_key[HOLDING_KEY_SZ];
   int rc = 0;
 
   if (account_id == NULL || account_id[0] == '\0' || 
-      symbol == NULL || symbol[0] == '\0' || 
       txnP == NULL || benchmarkP == NULL) 
   {
     benchmark_error("Invalid argument");
@@ -2114,46 +3483,48 @@ get_portfolio(const char *account_id,
     goto failXit;
   }
 
-  portfoliossdbP = benchmarkP->portfolios_sdbp;
-  if (portfoliossdbP == NULL) {
-    benchmark_error("Portfolios secondary database is not open");
+  holdingsdbP = benchmarkP->portfolios_holdings_sdbp;
+  if (holdingsdbP == NULL) {
+    benchmark_error("Portfolios holdings database is not open");
     goto failXit;
   }
 
   memset(&key, 0, sizeof(DBT));
-  memset(&pkey, 0, sizeof(DBT));
-  memset(&pdata, 0, sizeof(DBT));
+  dbt_usermem_set(&pkey, &thread_read_buf()->portfolio_key, sizeof(u_int32_t));
+  dbt_usermem_set(&pdata, &thread_read_buf()->portfolio, sizeof(PORTFOLIOS));
 
-  key.data = (char *)account_id;
-  key.size = ID_SZ;
+  set_holding_key(holding_key, account_id, symbol_id);
+  key.data = holding_key;
+  key.size = HOLDING_KEY_SZ;
 
-  rc = portfoliossdbP->cursor(portfoliossdbP, txnP,
-                         &cursorp, 0);
+  rc = xact_cursor_get(txnP, XACT_CURSOR_HOLDINGS, &cursorp, benchmarkP);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Portfolios.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
   
-  while ((rc=cursorp->pget(cursorp, &key, &pkey, &pdata, DB_NEXT)) == 0) {
-    /* TODO: Is this comparison needed? */
-    if (strcmp(account_id, (char *)key.data) == 0) {
-      if ( symbol != NULL && symbol[0] != '\0') {
-        if (strcmp(symbol, ((PORTFOLIOS *)pdata.data)->symbol) == 0) {
-          rc = BENCHMARK_SUCCESS;
-          goto cleanup;
-        }
-      }
-    }
+  rc = cursor_get_usermem(cursorp, &key, &pkey, &pdata, DB_SET);
+  xact_conflict_note(rc);
+  if (rc == 0) {
+    rc = BENCHMARK_SUCCESS;
+    goto cleanup;
+  }
+
+  if (rc != DB_NOTFOUND) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to look up holding.", __FILE__, __LINE__, getpid());
   }
 
 failXit:
-  benchmark_warning("Could not find symbol %s for account_id: %s", symbol, account_id);
+  benchmark_warning("Could not find symbol %u for account_id: %s", symbol_id, account_id);
 
-  rc = cursorp->close(cursorp);
-  if (rc != 0) {
-    envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for Portfolios.", __FILE__, __LINE__, getpid());
+  if (cursorp != NULL) {
+    rc = xact_cursor_release(txnP, cursorp, benchmarkP);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for Portfolios.", __FILE__, __LINE__, getpid());
+    }
+    cursorp = NULL;
   }
-  cursorp = NULL;
 
   rc = BENCHMARK_FAIL;
   return rc;
@@ -2172,7 +3543,7 @@ cleanup:
 }
 
 int
-get_stock(const char *symbol, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *data_ret, int flags, BENCHMARK_DBS *benchmarkP) 
+get_stock(u_int32_t symbol_id, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *data_ret, int flags, BENCHMARK_DBS *benchmarkP) 
 {
   DBC *cursorp = NULL;
   DB  *quotesdbP= NULL;
@@ -2181,7 +3552,7 @@ get_stock(const char *symbol, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *d
   DBT key, data;
   int rc = 0;
 
-  if (benchmarkP==NULL || txnP == NULL || cursorPP == NULL || symbol == NULL || symbol[0] == '\0')
+  if (benchmarkP==NULL || txnP == NULL || cursorPP == NULL)
   {
     benchmark_error("Invalid arguments");
     goto failXit;
@@ -2202,18 +3573,21 @@ get_stock(const char *symbol, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *d
   }
 
   memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
+  dbt_usermem_set(&data, &thread_read_buf()->quote, sizeof(QUOTE));
 
-  key.data = (char *)symbol;
-  key.size = (u_int32_t) strlen(symbol) + 1;
-  rc = quotesdbP->cursor(quotesdbP, txnP, &cursorp, DB_READ_COMMITTED);
+  key.data = &symbol_id;
+  key.size = sizeof(u_int32_t);
+
+  rc = xact_cursor_get(txnP, XACT_CURSOR_QUOTES, &cursorp, benchmarkP);
+  xact_conflict_note(rc);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to create cursor for Quotes.", __FILE__, __LINE__, getpid());
     goto failXit;
   }
 
   /* Position the cursor */
-  rc = cursorp->get(cursorp, &key, &data, DB_SET | DB_READ_COMMITTED | flags );
+  rc = cursor_get_usermem(cursorp, &key, NULL, &data, DB_SET | flags);
+  xact_conflict_note(rc);
   if (rc == 0) {
     goto done;
   }
@@ -2221,94 +3595,41 @@ get_stock(const char *symbol, DB_TXN *txnP, DBC **cursorPP, DBT *key_ret, DBT *d
 
 failXit:
   if (cursorp) {
-    rc = cursorp->close(cursorp);
+    rc = xact_cursor_release(txnP, cursorp, benchmarkP);
     if (rc != 0) {
       envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor for Quotes.", __FILE__, __LINE__, getpid());
-    }
-    cursorp = NULL;
-  }
-  if (cursorPP != NULL) {
-    *cursorPP = NULL;
-  }
-
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
-  return BENCHMARK_FAIL;
-
-done:
-  if (cursorPP != NULL) {
-    *cursorPP = cursorp;
-  }
-
-  if (key_ret != NULL) {
-    *key_ret = key;
-  }
-
-  quoteP = data.data;
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, retrieved: %s $%f", getpid(), quoteP->symbol, quoteP->current_price);
-  if (data_ret != NULL) {
-    *data_ret = data;
-  }
-
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-  return BENCHMARK_SUCCESS;
-}
-
-static int
-symbol_exists(const char *symbol, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP) 
-{
-  DBC *cursorp = NULL;
-  DB  *stocksdbP = NULL;
-  DB_ENV  *envP = NULL;
-  DBT key, data;
-  int exists = 0;
-  int ret = 0;
-
-  if (symbol == NULL || symbol[0] == '\0' || txnP == NULL || benchmarkP == NULL) {
-    benchmark_error("Invalid arguments");
-    goto failXit;
+    }
+    cursorp = NULL;
+  }
+  if (cursorPP != NULL) {
+    *cursorPP = NULL;
   }
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  envP = benchmarkP->envP;
-  if (envP == NULL) {
-    benchmark_error("Invalid arguments");
-    goto failXit;
-  }
+  return BENCHMARK_FAIL;
 
-  stocksdbP = benchmarkP->stocks_dbp;
-  if (stocksdbP == NULL) {
-    benchmark_error("Stocks database is not open");
-    goto failXit;
+done:
+  if (cursorPP != NULL) {
+    *cursorPP = cursorp;
   }
 
-  memset(&key, 0, sizeof(DBT));
-  memset(&data, 0, sizeof(DBT));
-
-  key.data = (char *)symbol;
-  key.size = (u_int32_t) strlen(symbol) + 1;
-  ret = stocksdbP->cursor(stocksdbP, txnP, &cursorp, DB_READ_COMMITTED);
-  if (ret != 0) {
-    envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Stocks.", __FILE__, __LINE__, getpid());
-    goto failXit;
-  }
+  quoteP = data.data;
 
-  /* Position the cursor */
-  ret = cursorp->get(cursorp, &key, &data, DB_SET);
-  if (ret == 0) {
-    exists = 1;
+  /* symbol_id lives in our stack frame, so hand out the copy 
+   * stored in the record instead */
+  if (key_ret != NULL) {
+    key.data = &quoteP->symbol_id;
+    *key_ret = key;
   }
 
-  goto cleanup;
-
-failXit:
-cleanup:
-  if (cursorp != NULL) {
-      cursorp->close(cursorp);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, retrieved: %u $%f", getpid(), quoteP->symbol_id, quoteP->current_price);
+  if (data_ret != NULL) {
+    *data_ret = data;
   }
 
-  return exists;
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  return BENCHMARK_SUCCESS;
 }
 
 static int
@@ -2334,6 +3655,11 @@ account_exists(const char *account_id, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP)
     goto failXit;
   }
 
+  /* Accounts never change after the load */
+  if (CATALOG_FROZEN(benchmarkP)) {
+    return catalog_personal_get(account_id, benchmarkP) != NULL;
+  }
+
   personaldbP = benchmarkP->personal_dbp;
   if (personaldbP == NULL) {
     benchmark_error("Personal database is not open");
@@ -2345,7 +3671,12 @@ account_exists(const char *account_id, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP)
 
   key.data = (char *)account_id;
   key.size = (u_int32_t) strlen(account_id) + 1;
+
+  /* Only the existence of the record matters, so read none of it */
+  data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+
   ret = personaldbP->cursor(personaldbP, txnP, &cursorp, DB_READ_COMMITTED);
+  xact_conflict_note(ret);
   if (ret != 0) {
     envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Personal.", __FILE__, __LINE__, getpid());
     goto failXit;
@@ -2353,6 +3684,7 @@ account_exists(const char *account_id, DB_TXN *txnP, BENCHMARK_DBS *benchmarkP)
 
   /* Position the cursor */
   ret = cursorp->get(cursorp, &key, &data, DB_SET);
+  xact_conflict_note(ret);
   if (ret == 0) {
     exists = 1;
   }
@@ -2370,7 +3702,7 @@ cleanup:
 
 static int 
 create_portfolio(const char *account_id, 
-                 const char *symbol, 
+                 u_int32_t symbol_id, 
                  float price, 
                  int amount, 
                  int force_apply, 
@@ -2381,7 +3713,7 @@ create_portfolio(const char *account_id,
   PORTFOLIOS portfolio;
   DB_ENV  *envP = NULL;
   DBT key, data;
-  int use_portfolio_id;
+  u_int32_t portfolio_id;
 
   envP = benchmarkP->envP;
   if (envP == NULL) {
@@ -2392,12 +3724,15 @@ create_portfolio(const char *account_id,
   memset(&key, 0, sizeof(DBT));
   memset(&data, 0, sizeof(DBT));
 
-  use_portfolio_id = __sync_fetch_and_add(&benchmarkP->number_portfolios, 1);
+  rc = portfolio_id_next(benchmarkP, &portfolio_id);
+  if (rc != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
 
   memset(&portfolio, 0, sizeof(PORTFOLIOS));
-  sprintf(portfolio.portfolio_id, "%d", use_portfolio_id);
+  portfolio.portfolio_id = htonl(portfolio_id);
   sprintf(portfolio.account_id, "%s", account_id);
-  sprintf(portfolio.symbol, "%s", symbol);
+  portfolio.symbol_id = symbol_id;
   portfolio.to_sell = 0;
   portfolio.number_sell = 0;
   portfolio.price_sell = 0;
@@ -2415,19 +3750,20 @@ create_portfolio(const char *account_id,
   }
 
   /* Set up the database record's key */
-  key.data = portfolio.portfolio_id;
-  key.size = (u_int32_t)strlen(portfolio.portfolio_id) + 1;
+  key.data = &portfolio.portfolio_id;
+  key.size = sizeof(portfolio.portfolio_id);
 
   /* Set up the database record's data */
   data.data = &portfolio;
   data.size = sizeof(PORTFOLIOS);
 
   /* Put the data into the database */
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Inserting: [portfolio_id = %s]", (char *)key.data);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Inserting: [portfolio_id = %u]", portfolio_id);
 
   rc = benchmarkP->portfolios_dbp->put(benchmarkP->portfolios_dbp, txnP, &key, &data, DB_NOOVERWRITE);
+  xact_conflict_note(rc);
   if (rc != 0) {
-    envP->err(envP, rc, "[%s:%d] [%d] Database put failed (id: %s).", __FILE__, __LINE__, getpid(), (char *)key.data);
+    envP->err(envP, rc, "[%s:%d] [%d] Database put failed (id: %u).", __FILE__, __LINE__, getpid(), portfolio_id);
     goto failXit; 
   }
 
@@ -2440,14 +3776,143 @@ cleanup:
   return rc;
 }
 
+/*
+ * The portfolio id sequence is stored in the Sequences table under
+ * PORTFOLIO_SEQ_KEY. Each handle reserves PORTFOLIO_SEQ_CACHE ids at a
+ * time, so most allocations do not touch the table at all.
+ */
+#define PORTFOLIO_SEQ_KEY   "portfolio_id"
+
+int
+portfolio_seq_open(BENCHMARK_DBS *benchmarkP)
+{
+  int rc = 0;
+  DB_SEQUENCE *seqP = NULL;
+  DB_ENV  *envP = NULL;
+  DBT key;
+
+  envP = benchmarkP->envP;
+
+  rc = db_sequence_create(&seqP, benchmarkP->sequences_dbp, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to create sequence.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  rc = seqP->set_range(seqP, 0, (db_seq_t) 0xFFFFFFFF);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to set sequence range.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  rc = seqP->set_cachesize(seqP, PORTFOLIO_SEQ_CACHE);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to set sequence cache size.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  memset(&key, 0, sizeof(DBT));
+  key.data = PORTFOLIO_SEQ_KEY;
+  key.size = (u_int32_t)strlen(PORTFOLIO_SEQ_KEY) + 1;
+
+  /* The record is created the first time the sequence is opened */
+  rc = seqP->open(seqP, NULL, &key, DB_CREATE | DB_THREAD);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to open portfolio id sequence.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  benchmarkP->portfolio_seqP = seqP;
+  return 0;
+
+failXit:
+  if (seqP != NULL) {
+    seqP->close(seqP, 0);
+  }
+  return rc ? rc : 1;
+}
+
+int
+portfolio_seq_close(BENCHMARK_DBS *benchmarkP)
+{
+  int rc = 0;
+  DB_SEQUENCE *seqP = benchmarkP->portfolio_seqP;
+
+  if (seqP == NULL) {
+    return 0;
+  }
+
+  benchmarkP->portfolio_seqP = NULL;
+  rc = seqP->close(seqP, 0);
+  if (rc != 0) {
+    benchmarkP->envP->err(benchmarkP->envP, rc, "[%s:%d] [%d] Sequence close failed.", __FILE__, __LINE__, getpid());
+  }
+
+  return rc;
+}
+
+/*
+ * Returns the next portfolio id in host byte order. Cached sequences
+ * cannot be used inside a transaction, so the id is drawn outside of
+ * the caller's; ids of aborted inserts are simply never reused.
+ */
+int
+portfolio_id_next(BENCHMARK_DBS *benchmarkP, u_int32_t *portfolio_idP)
+{
+  int rc = 0;
+  db_seq_t value;
+  DB_ENV  *envP = NULL;
+
+  if (benchmarkP == NULL || portfolio_idP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  envP = benchmarkP->envP;
+  if (envP == NULL || benchmarkP->portfolio_seqP == NULL) {
+    benchmark_error("Portfolio id sequence is not open");
+    goto failXit;
+  }
+
+  rc = benchmarkP->portfolio_seqP->get(benchmarkP->portfolio_seqP, NULL, 1, &value, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain a portfolio id.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  *portfolio_idP = (u_int32_t) value;
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
 int
 benchmark_handle_alloc(void **benchmark_handle,
                        int create,
                        const char *program,
                        const char *homedir,
                        const char *datafilesdir)
+{
+  return benchmark_handle_alloc2(benchmark_handle, create, program,
+                                 homedir, datafilesdir, NULL);
+}
+
+/*
+ * Same as benchmark_handle_alloc(), but the tables are opened as
+ * described by config_handle. A NULL configuration opens every
+ * table as a btree.
+ */
+int
+benchmark_handle_alloc2(void **benchmark_handle,
+                        int create,
+                        const char *program,
+                        const char *homedir,
+                        const char *datafilesdir,
+                        void *config_handle)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
+  benchmark_config_t *configP = config_handle;
   int ret = BENCHMARK_FAIL;
 
   set_benchmark_debug_level(BENCHMARK_DEBUG_LEVEL_MIN);
@@ -2459,6 +3924,10 @@ benchmark_handle_alloc(void **benchmark_handle,
 
   initialize_benchmarkdbs(benchmarkP);
   benchmarkP->magic = BENCHMARK_MAGIC_WORD;
+  if (configP != NULL) {
+    assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+    benchmarkP->config = *configP;
+  }
   if (create) benchmarkP->createDBs = 1;
   benchmarkP->db_home_dir = homedir;
   benchmarkP->datafilesdir = datafilesdir;
@@ -2474,12 +3943,31 @@ benchmark_handle_alloc(void **benchmark_handle,
 
   if (create) benchmarkP->createDBs = 0;
 
-#if 0
-  ret = benchmark_stocks_symbols_get(benchmarkP);
-  if (ret != 0) {
+  /* Symbols are referred to by id from here on */
+  ret = symbol_dict_load(benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = quote_cache_load(benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = catalog_freeze(benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = group_commit_start(benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = order_queue_start(benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
-#endif
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
@@ -2507,6 +3995,11 @@ benchmark_handle_free(void *benchmark_handle)
   }
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  /* Submitted orders are applied before the tables close */
+  order_queue_stop(benchmarkP);
+  group_commit_stop(benchmarkP);
+
   if (databases_close(benchmarkP) != BENCHMARK_SUCCESS) {
     return BENCHMARK_FAIL;
   }
@@ -2519,23 +4012,220 @@ benchmark_handle_free(void *benchmark_handle)
   free(benchmarkP->quotes_hist_db_name);
   free(benchmarkP->portfolios_db_name);
   free(benchmarkP->portfolios_sdb_name);
+  free(benchmarkP->portfolios_holdings_sdb_name);
+  free(benchmarkP->portfolios_symbol_sdb_name);
   free(benchmarkP->accounts_db_name);
   free(benchmarkP->currencies_db_name);
   free(benchmarkP->personal_db_name);
+  free(benchmarkP->sequences_db_name);
 
   /* Don't forget to free the list of stocks */
-  if (benchmarkP->number_stocks > 0 && benchmarkP->stocks != NULL) {
-    int i;
-    for (i=0; i<benchmarkP->number_stocks; i++) {
-      if (benchmarkP->stocks[i] != NULL) {
-        free(benchmarkP->stocks[i]);
-        benchmarkP->stocks[i] = NULL;
-      }
-    }
-  }
+  symbol_dict_free(benchmarkP);
+  quote_cache_free(benchmarkP);
+  generator_stop(benchmarkP);
+  catalog_free(benchmarkP);
 
   benchmarkP->magic = 0;
   free(benchmarkP);
 
   return BENCHMARK_SUCCESS;
 }
+
+/*
+ * Counts the records of a table from its statistics, which are
+ * gathered by walking the table since DB_FAST_STAT would not count
+ * the records of a btree.
+ */
+int
+benchmark_table_rows_get(void          *benchmark_handle,
+                         int            table,
+                         unsigned long *rows)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  DB_ENV        *envP = NULL;
+  DB            *dbP = NULL;
+  void          *statsP = NULL;
+  DBTYPE         access_method;
+  int            rc;
+
+  if (benchmarkP == NULL || rows == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  envP = benchmarkP->envP;
+  if (envP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  switch (table) {
+    case STOCKS_FLAG:
+      dbP = benchmarkP->stocks_dbp;
+      break;
+
+    case PERSONAL_FLAG:
+      dbP = benchmarkP->personal_dbp;
+      break;
+
+    case CURRENCIES_FLAG:
+      dbP = benchmarkP->currencies_dbp;
+      break;
+
+    case QUOTES_FLAG:
+      dbP = benchmarkP->quotes_dbp;
+      break;
+
+    case PORTFOLIOS_FLAG:
+      dbP = benchmarkP->portfolios_dbp;
+      break;
+
+    default:
+      benchmark_error("Invalid table: %d", table);
+      goto failXit;
+  }
+
+  if (dbP == NULL) {
+    benchmark_error("Table 0x%x is not open", table);
+    goto failXit;
+  }
+
+  rc = dbP->get_type(dbP, &access_method);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain type of table.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  rc = dbP->stat(dbP, NULL, &statsP, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain stats of table.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  /* The layout of the statistics depends on the access method */
+  if (access_method == DB_HASH) {
+    *rows = ((DB_HASH_STAT *)statsP)->hash_ndata;
+  }
+  else {
+    *rows = ((DB_BTREE_STAT *)statsP)->bt_ndata;
+  }
+
+  free(statsP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Reports the lock manager counters of the environment: how many
+ * locks were requested, how many of those requests had to wait
+ * and how many deadlocks were detected.
+ */
+int
+benchmark_lock_stats_get(void          *benchmark_handle,
+                         unsigned long *nrequests,
+                         unsigned long *nwaits,
+                         unsigned long *ndeadlocks)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  DB_LOCK_STAT  *lock_statsP = NULL;
+  DB_ENV        *envP = NULL;
+  int            rc;
+
+  if (benchmarkP == NULL || nrequests == NULL || nwaits == NULL || ndeadlocks == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  envP = benchmarkP->envP;
+  if (envP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  rc = envP->lock_stat(envP, &lock_statsP, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain lock statistics.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  *nrequests = lock_statsP->st_nrequests;
+  *nwaits = lock_statsP->st_lock_wait;
+  *ndeadlocks = lock_statsP->st_ndeadlocks;
+
+  free(lock_statsP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Old page versions are kept in the cache for as long as a snapshot
+ * may need them, so the pages in the cache grow with the number of
+ * snapshots running. Versions that don't fit are frozen to disk.
+ * cached_pages is st_pages, every page in the cache, whether it is a
+ * current page or an old version.
+ */
+int
+benchmark_mvcc_stats_get(void          *benchmark_handle,
+                         unsigned long *nsnapshots,
+                         unsigned long *maxnsnapshots,
+                         unsigned long *cached_pages,
+                         unsigned long *frozen,
+                         unsigned long *freed)
+{
+  BENCHMARK_DBS  *benchmarkP = benchmark_handle;
+  DB_MPOOL_STAT  *mpool_statsP = NULL;
+  DB_TXN_STAT    *txn_statsP = NULL;
+  DB_ENV         *envP = NULL;
+  int             rc;
+
+  if (benchmarkP == NULL || nsnapshots == NULL || maxnsnapshots == NULL
+      || cached_pages == NULL || frozen == NULL || freed == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  envP = benchmarkP->envP;
+  if (envP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  rc = envP->txn_stat(envP, &txn_statsP, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain transaction statistics.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  rc = envP->memp_stat(envP, &mpool_statsP, NULL, 0);
+  if (rc != 0) {
+    envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain cache statistics.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  *nsnapshots = txn_statsP->st_nsnapshot;
+  *maxnsnapshots = txn_statsP->st_maxnsnapshot;
+  *cached_pages = mpool_statsP->st_pages;
+  *frozen = mpool_statsP->st_mvcc_frozen;
+  *freed = mpool_statsP->st_mvcc_freed;
+
+  free(txn_statsP);
+  free(mpool_statsP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  free(txn_statsP);
+  return BENCHMARK_FAIL;
+}
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <db.h>
 
 #define BENCHMARK_NUM_SYMBOLS  (10)
@@ -32,6 +33,23 @@
 #define BENCHMARK_SUCCESS   (0)
 #define BENCHMARK_FAIL      (1)
 
+/* These must be defined exactly as in benchmark.h */
+#define BENCHMARK_RETRY_EXHAUSTED 2
+
+#define BENCHMARK_XACT_VIEW_STOCK       0
+#define BENCHMARK_XACT_VIEW_PORTFOLIO   1
+#define BENCHMARK_XACT_PURCHASE         2
+#define BENCHMARK_XACT_SELL             3
+#define BENCHMARK_XACT_REFRESH_QUOTES   4
+#define BENCHMARK_XACT_LOAD             5
+#define BENCHMARK_XACT_TYPES            6
+
+#define BENCHMARK_ISOLATION_DEFAULT       0
+#define BENCHMARK_ISOLATION_UNCOMMITTED   1
+#define BENCHMARK_ISOLATION_COMMITTED     2
+#define BENCHMARK_ISOLATION_SNAPSHOT      3
+#define BENCHMARK_ISOLATION_SERIALIZABLE  4
+
 #define BENCHMARK_MAGIC_WORD   (0xCAFE)
 #define CHRONOS_SHMKEY 35
 
@@ -50,6 +68,7 @@
 
 #define PRIMARY_DB	0
 #define SECONDARY_DB	1
+#define SECONDARY_UNIQUE_DB	2
 
 /*
  * This benchmark is based on Kyoung-Don Kang et al. 
@@ -62,9 +81,12 @@
 #define QUOTES_HISTDB     "Quotes_Hist"
 #define PORTFOLIOSDB      "Portfolios"
 #define PORTFOLIOSSECDB   "PortfoliosSec"
+#define PORTFOLIOSHOLDDB  "PortfoliosHoldings"
+#define PORTFOLIOSSYMDB   "PortfoliosSymbol"
 #define ACCOUNTSDB        "Accounts"
 #define CURRENCIESDB      "Currencies"
 #define PERSONALDB        "Personal"
+#define SEQUENCESDB       "Sequences"
 
 /* Some of the tables above are catalogs. We have static
  * files that we use to populate them */
@@ -97,6 +119,8 @@ typedef struct benchmark_xact_data_t {
   char      symbol[ID_SZ];
   float     price;
   int       amount;
+  int       status;           /* BENCHMARK_ITEM_* of the last run */
+  size_t    slot;             /* Entry of the canonical packet it went to */
 } benchmark_xact_data_t;
 
 typedef struct benchmark_data_packet_t {
@@ -107,6 +131,81 @@ typedef struct benchmark_data_packet_t {
 
 typedef void *benchmark_xact_h;
 
+/* How a single table is stored. Only tables that are accessed
+ * exclusively by exact key can be switched to DB_HASH. */
+typedef struct benchmark_table_config_t {
+  DBTYPE    access_method;
+  u_int32_t h_nelem;          /* Expected number of keys; 0 lets BDB grow */
+} benchmark_table_config_t;
+
+#define BENCHMARK_CONFIG_MAGIC_WORD   (0xC0F1)
+
+typedef struct benchmark_config_t {
+  int magic;
+  benchmark_table_config_t stocks;
+  benchmark_table_config_t quotes;
+  benchmark_table_config_t personal;
+  int quote_cache;            /* Serve quote reads from memory */
+  int frozen_catalog;         /* Serve catalog reads from memory */
+  int snapshot_reads;         /* Multiversion tables, snapshot reads */
+  int cursor_cache;           /* Transactions reuse their cursors */
+  int read_isolation;         /* Of read only calls, BENCHMARK_ISOLATION_* */
+  int packet_order;           /* Sort and merge packets before applying */
+  int packet_partial;         /* Failed entries don't abort their packet */
+  int order_workers;          /* Threads applying submitted packets */
+  int order_group_max;        /* Most orders applied in one transaction */
+  int       group_commit_max;         /* Most single item calls per transaction */
+  u_int32_t group_commit_window_usec; /* How long a batch waits for more calls */
+  int       retry_max;                /* Retries after a lock conflict */
+  u_int32_t retry_backoff_usec;       /* Backoff before the first retry */
+  u_int32_t retry_backoff_max_usec;   /* Upper bound of the backoff */
+  int       load_batch_rows;          /* Rows per transaction of the initial load */
+  int       load_not_durable;         /* Loaded tables skip the log */
+  int       load_threads;             /* Threads loading one datafile */
+  unsigned long gen_accounts;         /* Generated dataset; 0 loads the datafiles */
+  unsigned long gen_symbols;
+  unsigned long gen_portfolios;
+  double        gen_skew;             /* Zipfian skew of the holdings, 0 is uniform */
+  unsigned long gen_seed;
+  int       ingest_ring_size;         /* Ticks parsed ahead of the updates */
+  int       ingest_batch_max;         /* Most ticks applied per transaction */
+} benchmark_config_t;
+
+#define BENCHMARK_ORDER_GROUP_MAX_DEFAULT     (16)
+#define BENCHMARK_RETRY_MAX_DEFAULT           (5)
+#define BENCHMARK_RETRY_BACKOFF_DEFAULT       (100)
+#define BENCHMARK_RETRY_BACKOFF_MAX_DEFAULT   (20000)
+#define BENCHMARK_LOAD_BATCH_DEFAULT          (1000)
+#define BENCHMARK_INGEST_RING_DEFAULT         (65536)
+#define BENCHMARK_INGEST_BATCH_DEFAULT        (256)
+
+/* Generated account ids must fit in ID_SZ */
+#define BENCHMARK_GEN_ACCOUNTS_MAX            (999999999UL)
+
+/* Per transaction type retry counters (xact_retry.c) */
+typedef struct xact_retry_stats_t {
+  unsigned long attempts;
+  unsigned long conflicts;    /* Attempts that lost a lock conflict */
+  unsigned long retries;
+  unsigned long exhausted;    /* Transactions that ran out of retries */
+} xact_retry_stats_t;
+
+/* Tables with a cursor cached by each transaction (xact_cursor.c) */
+#define XACT_CURSOR_QUOTES        0
+#define XACT_CURSOR_PORTFOLIOS    1
+#define XACT_CURSOR_HOLDINGS      2
+#define XACT_CURSOR_TYPES         3
+
+/* State of a transaction started with start_xact(). It hangs from
+ * the app_private field of the DB_TXN */
+typedef struct xact_ctx_t {
+  DBC  *cursors[XACT_CURSOR_TYPES];   /* Opened on first use */
+  void *quote_pendingP;               /* Quote cache updates to publish */
+  int   isolation;                    /* Of a read only transaction, or 0 */
+} xact_ctx_t;
+
+#define XACT_CTX(_txnP)   ((xact_ctx_t *)((DB_TXN *)(_txnP))->app_private)
+
 /* Let's define our Benchmark DB, which translates to
  * multiple berkeley DBs*/
 typedef struct benchmark_dbs {
@@ -125,9 +224,12 @@ typedef struct benchmark_dbs {
   DB  *accounts_dbp;
   DB  *currencies_dbp;
   DB  *personal_dbp;
+  DB  *sequences_dbp;
 
   /* secondary databases */
   DB  *portfolios_sdbp;
+  DB  *portfolios_holdings_sdbp;
+  DB  *portfolios_symbol_sdbp;
 
   /* Some other useful information */
   const char *db_home_dir;
@@ -141,15 +243,52 @@ typedef struct benchmark_dbs {
   char *accounts_db_name;
   char *currencies_db_name;
   char *personal_db_name;
+  char *sequences_db_name;
 
   /* secondary databases */
   char *portfolios_sdb_name;
+  char *portfolios_holdings_sdb_name;
+  char *portfolios_symbol_sdb_name;
 
   /* How many stores do we have in the system */
   int    number_stocks;
   char **stocks;
 
-  int   number_portfolios;
+  /* Symbol dictionary. Symbol ids are dense and index stocks[]; 
+   * symbol_slots is an open addressing table mapping symbols back
+   * to their (id + 1), with 0 marking an empty slot. */
+  u_int32_t *symbol_slots;
+  u_int32_t  symbol_slots_mask;
+
+  /* Hands out portfolio ids. The sequence lives in the Sequences
+   * table and each handle caches a range of PORTFOLIO_SEQ_CACHE ids */
+  DB_SEQUENCE *portfolio_seqP;
+
+  /* Optional read only copy of the catalog tables */
+  struct benchmark_catalog_t *catalog;
+
+  /* Optional in memory copy of Quotes, indexed by symbol id */
+  struct quote_cache_entry_t *quote_cache;
+  u_int32_t                   quote_cache_size;
+
+  /* Optional queue of submitted packets, and its workers */
+  struct order_queue_t       *order_queue;
+
+  /* Optional batches of concurrent single item calls */
+  struct group_commit_t      *group_commit;
+
+  /* Optional synthetic dataset that replaces the datafiles */
+  struct generator_t         *generator;
+
+  /* How the tables are opened. Copied from the caller's 
+   * configuration when the handle is allocated. */
+  benchmark_config_t config;
+
+  xact_retry_stats_t retry_stats[BENCHMARK_XACT_TYPES];
+
+  /* Cursors opened for transactions, and cached cursors handed out again */
+  unsigned long cursor_opens;
+  unsigned long cursor_reuses;
 
 } BENCHMARK_DBS;
 
@@ -166,10 +305,12 @@ typedef struct stock {
   char              full_name[NAME_SZ];
 } STOCK;
 
+/* Quotes are keyed by symbol_id (see compare_symbol_id) */
 typedef struct quote {
+  u_int32_t symbol_id;
   char      symbol[ID_SZ];
   float     current_price;
-  char      trade_time[ID_SZ];
+  char      trade_time[ID_SZ];    /* Trade date, as "8/8/17" */
   float     low_price_day;
   float     high_price_day;
   float     perc_price_change;
@@ -179,6 +320,35 @@ typedef struct quote {
   char      market_cap[ID_SZ];
 } QUOTE;
 
+/* A quote tick resolved to its symbol id (see update_stocks_ticks).
+ * bid, ask and volume are negative, and timestamp is 0, when the
+ * tick doesn't give them. */
+typedef struct quote_tick_t {
+  u_int32_t symbol_id;
+  float     price;
+  float     bid;
+  float     ask;
+  long      volume;
+  time_t    timestamp;
+} quote_tick_t;
+
+/*
+ * One slot of the quote cache. Readers copy the quote and retry if
+ * sequence was odd or changed meanwhile, so they never block nor
+ * touch Berkeley DB locks. Writers make sequence odd while they copy.
+ *
+ * next_version is taken by update_stock while it holds the write lock
+ * of the record, so versions follow the commit order of the updates;
+ * an older update that publishes late is simply dropped.
+ */
+typedef struct quote_cache_entry_t {
+  volatile u_int32_t sequence;
+  u_int32_t          valid;
+  u_int32_t          version;
+  u_int32_t          next_version;
+  QUOTE              quote;
+} __attribute__((aligned(64))) quote_cache_entry_t;
+
 typedef struct quotes_hist {
   char      symbol[ID_SZ];
   int       current_price;
@@ -192,10 +362,18 @@ typedef struct quotes_hist {
   int       market_cap;
 } QUOTES_HIST;
 
+/* 
+ * Portfolios are keyed by portfolio_id stored big endian, so that the
+ * byte order of the keys is their numeric order and new portfolios are
+ * appended at the right edge of the btree.
+ *
+ * symbol_id and account_id must stay adjacent: together they form the key 
+ * of the PortfoliosHoldings secondary (see HOLDING_KEY_SZ).
+ */
 typedef struct portfolios {
-  char      portfolio_id[ID_SZ];
+  u_int32_t portfolio_id;
+  u_int32_t symbol_id;
   char      account_id[ID_SZ];
-  char      symbol[ID_SZ];
   int       hold_stocks;
   char      to_sell;
   int       number_sell;
@@ -205,6 +383,32 @@ typedef struct portfolios {
   int       price_buy;
 } PORTFOLIOS;
 
+#define HOLDING_KEY_SZ    (sizeof(u_int32_t) + ID_SZ)
+
+/* Portfolio ids cached by each sequence handle */
+#define PORTFOLIO_SEQ_CACHE   1000
+
+/*
+ * Bounded scan over the portfolios of a single account, or over the
+ * holders of a single symbol. The cursor is positioned with DB_SET on 
+ * the account (symbol) and then walks its duplicates with DB_NEXT_DUP,
+ * so the cost is proportional to the number of matching portfolios
+ * rather than to the size of the table.
+ * Records are copied into the scan's own memory (DB_DBT_USERMEM).
+ */
+typedef struct portfolio_scan {
+  DBC        *cursorP;
+  DBT         key;
+  DBT         pkey;
+  DBT         data;
+  u_int32_t   op;
+  u_int32_t   read_flags;   /* Isolation of the reads, see read_get_flags() */
+  char        account_id[ID_SZ + 1];
+  u_int32_t   symbol_id;
+  u_int32_t   portfolio_key;
+  PORTFOLIOS  portfolio;
+} PORTFOLIO_SCAN;
+
 typedef struct account {
   char      account_id[ID_SZ];
   char      user_name[USR_SZ];
@@ -231,6 +435,113 @@ typedef struct personal {
   char      email[LONG_NAME_SZ];
 } PERSONAL;
 
+/* Catalog tables frozen into arrays sorted on their key (catalog.c) */
+typedef struct benchmark_catalog_t {
+  STOCK     *stocks;
+  u_int32_t  num_stocks;
+  CURRENCY  *currencies;
+  u_int32_t  num_currencies;
+  PERSONAL  *personal;
+  u_int32_t  num_personal;
+} benchmark_catalog_t;
+
+/* A datafile mapped into memory (datafile.c) */
+typedef struct datafile_t {
+  const char *path;
+  int         fd;
+  char       *baseP;          /* NULL if the file is empty */
+  size_t      size;
+} datafile_t;
+
+#define DATAFILE_FIELDS_MAX   16
+
+/* A field of a line, pointing into the mapping */
+typedef struct datafile_field_t {
+  const char *startP;
+  size_t      len;
+} datafile_field_t;
+
+/* The lines that start in a byte range of a datafile */
+typedef struct datafile_cursor_t {
+  datafile_t       *fileP;
+  const char       *posP;       /* Start of the next line */
+  const char       *endP;       /* End of the range */
+  const char       *limitP;     /* End of the file */
+  size_t            offset;     /* Of the current line */
+  long              truncated;  /* Fields cut to fit their record */
+  int               num_fields;
+  datafile_field_t  fields[DATAFILE_FIELDS_MAX];
+} datafile_cursor_t;
+
+/* Rows of one table waiting for a bulk put. Each bulk put runs in
+ * its own transaction, instead of one transaction per row
+ * (benchmark_initial_load.c) */
+typedef struct load_batch_t {
+  BENCHMARK_DBS  *benchmarkP;
+  DB             *dbP;
+  const char     *table;
+  u_int32_t       put_flags;
+  DBT             bulk;
+  void           *bulkP;
+  int             pending;
+  int             batch_rows;
+  int             quiet;        /* Other loads run concurrently */
+  long            rows;
+  struct timeval  last_report;
+} load_batch_t;
+
+/* Which DBT of a read a spill buffer stands in for */
+#define READ_SPILL_KEY    0
+#define READ_SPILL_PKEY   1
+#define READ_SPILL_DATA   2
+#define READ_SPILL_TYPES  3
+
+/* Buffers that reads return their records in (thread_ctx.c). With
+ * DB_THREAD, Berkeley DB would otherwise allocate memory for every
+ * record it returns. A record that doesn't fit its buffer is read
+ * into a spill buffer instead, which only grows. */
+typedef struct thread_read_buf_t {
+  QUOTE       quote;
+  PORTFOLIOS  portfolio;
+  u_int32_t   portfolio_key;
+  PERSONAL    personal;
+  STOCK       stock;
+  char        account_id[ID_SZ];
+
+  void       *spillP[READ_SPILL_TYPES];
+  u_int32_t   spill_size[READ_SPILL_TYPES];
+} thread_read_buf_t;
+
+#define BENCHMARK_THREAD_CTX_MAGIC_WORD   (0x7C7C)
+#define BENCHMARK_THREAD_SCRATCH_SZ       (256 * 1024)
+
+/* State owned by one worker thread (thread_ctx.c). It is bound to the
+ * thread for the duration of each *_ctx API call, so that the calls
+ * neither allocate memory nor write to state shared with other threads */
+typedef struct benchmark_thread_ctx_t {
+  int            magic;
+  BENCHMARK_DBS *benchmarkP;
+  u_int64_t      rng_state;           /* xorshift64* */
+  int            isolation;           /* Of read only calls, or 0 */
+
+  /* Context of the thread's running transaction */
+  xact_ctx_t     xact;
+  int            xact_in_use;
+
+  /* Result buffers of the reads */
+  thread_read_buf_t read_buf;
+
+  /* Arena for the temporary buffers of a call; it is reset when
+   * the next call starts */
+  char          *scratchP;
+  size_t         scratch_size;
+  size_t         scratch_used;
+
+  /* Counters, added to the handle's when the context is freed */
+  xact_retry_stats_t retry_stats[BENCHMARK_XACT_TYPES];
+  unsigned long  cursor_opens;
+  unsigned long  cursor_reuses;
+} benchmark_thread_ctx_t;
 
 /* Function prototypes */
 int	databases_setup(BENCHMARK_DBS *, int, const char *, FILE *);
@@ -259,12 +570,45 @@ place_order(const char *account_id,
             benchmark_xact_h  xactH,
             BENCHMARK_DBS *benchmarkP);
 
+int 
+place_order_by_id(const char *account_id, 
+                  u_int32_t symbol_id, 
+                  float price, 
+                  int amount, 
+                  int force_apply, 
+                  benchmark_xact_h  xactH,
+                  BENCHMARK_DBS *benchmarkP);
+
 int 
 update_stock(char *symbolP, 
              float newValue, 
              benchmark_xact_h  xactH,
              BENCHMARK_DBS *benchmarkP);
 
+int 
+update_stock_by_id(u_int32_t symbol_id, 
+                   float newValue, 
+                   benchmark_xact_h  xactH,
+                   BENCHMARK_DBS *benchmarkP);
+
+int 
+update_stocks_sorted(int               num_symbols,
+                     const u_int32_t  *symbol_ids, 
+                     const float      *prices, 
+                     int              *status_list,
+                     benchmark_xact_h  xactH,
+                     BENCHMARK_DBS    *benchmarkP);
+
+int 
+update_stocks_ticks(int                 num_ticks,
+                    const quote_tick_t *ticks, 
+                    int                *status_list,
+                    benchmark_xact_h    xactH,
+                    BENCHMARK_DBS      *benchmarkP);
+
+void
+quote_trade_date_set(QUOTE *quoteP, int year, int month, int day);
+
 int 
 sell_stocks(const char *account_id, 
             const char *symbol, 
@@ -274,12 +618,24 @@ sell_stocks(const char *account_id,
             benchmark_xact_h  xactH,
             BENCHMARK_DBS *benchmarkP);
 
+int 
+sell_stocks_by_id(const char *account_id, 
+                  u_int32_t symbol_id, 
+                  float price, 
+                  int amount, 
+                  int force_apply, 
+                  benchmark_xact_h  xactH,
+                  BENCHMARK_DBS *benchmarkP);
+
 int 
 show_stocks_records(char *symbolId, BENCHMARK_DBS *benchmarkP);
 
 int
 show_quote(char *symbolP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP);
 
+int
+show_quote_by_id(u_int32_t symbol_id, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP);
+
 int 
 show_currencies_records(BENCHMARK_DBS *my_benchmarkP);
 
@@ -290,11 +646,52 @@ int
 show_personal_item(void *vBuf);
 
 int
-show_portfolio_item(void *vBuf, char **symbolIdPP);
+portfolio_scan_open(const char      *account_id,
+                    DB_TXN          *txnP,
+                    PORTFOLIO_SCAN  *scanP,
+                    BENCHMARK_DBS   *benchmarkP);
+
+int
+holders_scan_open(u_int32_t        symbol_id,
+                  DB_TXN          *txnP,
+                  PORTFOLIO_SCAN  *scanP,
+                  BENCHMARK_DBS   *benchmarkP);
+
+int
+portfolio_scan_next(PORTFOLIO_SCAN *scanP, PORTFOLIOS **portfolioPP);
+
+int
+portfolio_scan_batch(PORTFOLIO_SCAN *scanP, 
+                     PORTFOLIOS     *portfolios, 
+                     int             max_portfolios, 
+                     int            *num_portfolios);
+
+int
+portfolio_scan_close(PORTFOLIO_SCAN *scanP);
+
+int
+show_portfolio_item(void *vBuf, u_int32_t *symbolIdP);
+
+int
+portfolio_id_next(BENCHMARK_DBS *benchmarkP, u_int32_t *portfolio_idP);
+
+int
+portfolio_seq_open(BENCHMARK_DBS *benchmarkP);
+
+int
+portfolio_seq_close(BENCHMARK_DBS *benchmarkP);
 
 int 
 start_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benchmarkP);
 
+int 
+start_read_xact(benchmark_xact_h *xact_ret, const char *txn_name, BENCHMARK_DBS *benchmarkP);
+
+/* A child of a running transaction, resolved with commit_xact() or
+ * abort_xact() before its parent */
+int
+start_child_xact(benchmark_xact_h parentH, benchmark_xact_h *xact_ret, BENCHMARK_DBS *benchmarkP);
+
 int 
 abort_xact(benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP);
 
@@ -304,12 +701,304 @@ commit_xact(benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP);
 int
 benchmark_handle_free(void *benchmark_handle);
 
+/* Symbol dictionary (symbol_dict.c) */
+int
+symbol_dict_load(BENCHMARK_DBS *benchmarkP);
+
+int
+symbol_dict_lookup(const char *symbol, u_int32_t *symbol_id, BENCHMARK_DBS *benchmarkP);
+
+const char *
+symbol_dict_name(u_int32_t symbol_id, BENCHMARK_DBS *benchmarkP);
+
+void
+symbol_dict_free(BENCHMARK_DBS *benchmarkP);
+
+/* Lock conflict retries (xact_retry.c) */
+typedef int (*xact_attempt_fn)(void *argP, BENCHMARK_DBS *benchmarkP);
+
+/* Must be called with the return code of every Berkeley DB call made
+ * inside a transaction that may lose a lock conflict */
+void
+xact_conflict_note(int db_rc);
+
+/* Whether the running attempt has lost a lock conflict */
+int
+xact_conflict_pending(void);
+
+int
+xact_retry_run(int                xact_type,
+               xact_attempt_fn    attemptP,
+               void              *argP,
+               BENCHMARK_DBS     *benchmarkP);
+
+/* Per transaction cursors (xact_cursor.c). The cursor functions 
+ * return the Berkeley DB error code, like DB->cursor() */
+int
+xact_ctx_attach(DB_TXN *txnP);
+
+int
+xact_ctx_release(DB_TXN *txnP, BENCHMARK_DBS *benchmarkP);
+
+int
+xact_cursor_get(DB_TXN *txnP, int which, DBC **cursorPP, BENCHMARK_DBS *benchmarkP);
+
+int
+xact_cursor_release(DB_TXN *txnP, DBC *cursorP, BENCHMARK_DBS *benchmarkP);
+
+/* Per thread context (thread_ctx.c). Without a bound context these
+ * fall back to rand(), malloc() and the handle's counters */
+benchmark_thread_ctx_t *
+thread_ctx_current(void);
+
+BENCHMARK_DBS *
+thread_ctx_enter(void *ctx_handle);
+
+void
+thread_ctx_leave(void);
+
+int
+thread_rand(void);
+
+void *
+thread_scratch_alloc(size_t size);
+
+void
+thread_scratch_free(void *bufferP);
+
+thread_read_buf_t *
+thread_read_buf(void);
+
+void *
+thread_spill_get(int which, u_int32_t size);
+
+void
+thread_alloc_note(void);
+
+void *
+thread_db_malloc(size_t size);
+
+void *
+thread_db_realloc(void *bufferP, size_t size);
+
+/* Reads into DB_DBT_USERMEM buffers (benchmark_common.c) */
+void
+dbt_usermem_set(DBT *dbtP, void *bufferP, u_int32_t size);
+
+int
+cursor_get_usermem(DBC *cursorP, DBT *keyP, DBT *pkeyP, DBT *dataP, u_int32_t flags);
+
+/* Frozen catalog (catalog.c) */
+#define CATALOG_FROZEN(_benchmarkP)  ((_benchmarkP)->catalog != NULL)
+
+/* Isolation of the transactions that only read (benchmark_common.c).
+ * The level comes from the thread context, then from the handle */
+int
+read_isolation_get(BENCHMARK_DBS *benchmarkP);
+
+int
+xact_isolation_get(DB_TXN *txnP, BENCHMARK_DBS *benchmarkP);
+
+u_int32_t
+read_xact_flags(int isolation);
+
+u_int32_t
+read_cursor_flags(int isolation);
+
+u_int32_t
+read_get_flags(int isolation);
+
+int
+catalog_freeze(BENCHMARK_DBS *benchmarkP);
+
+void
+catalog_free(BENCHMARK_DBS *benchmarkP);
+
+const STOCK *
+catalog_stock_get(const char *symbol, BENCHMARK_DBS *benchmarkP);
+
+const PERSONAL *
+catalog_personal_get(const char *account_id, BENCHMARK_DBS *benchmarkP);
+
+/* Quote cache (quote_cache.c) */
+#define QUOTE_CACHE_ENABLED(_benchmarkP)  ((_benchmarkP)->quote_cache != NULL)
+
+int
+quote_cache_load(BENCHMARK_DBS *benchmarkP);
+
+void
+quote_cache_free(BENCHMARK_DBS *benchmarkP);
+
+int
+quote_cache_read(u_int32_t symbol_id, QUOTE *quoteP, BENCHMARK_DBS *benchmarkP);
+
+u_int32_t
+quote_cache_version_get(u_int32_t symbol_id, BENCHMARK_DBS *benchmarkP);
+
+void
+quote_cache_publish(u_int32_t symbol_id, u_int32_t version, const QUOTE *quoteP, BENCHMARK_DBS *benchmarkP);
+
+int
+quote_cache_defer(DB_TXN *txnP, u_int32_t symbol_id, u_int32_t version, const QUOTE *quoteP);
+
+void *
+quote_cache_deferred_take(DB_TXN *txnP);
+
+void
+quote_cache_deferred_publish(void *pending_listP, BENCHMARK_DBS *benchmarkP);
+
+void
+quote_cache_deferred_discard(void *pending_listP);
+
 int
 benchmark_handle_alloc(void **benchmark_handle,
                        int create,
                        const char *program,
                        const char *homedir,
                        const char *datafilesdir);
+
+int
+benchmark_handle_alloc2(void **benchmark_handle,
+                        int create,
+                        const char *program,
+                        const char *homedir,
+                        const char *datafilesdir,
+                        void *config_handle);
+
+/* Canonical packets (data_packet.c) */
+int
+data_packet_order(benchmark_data_packet_t *packetP,
+                  int                      is_sell,
+                  benchmark_data_packet_t *orderedP,
+                  BENCHMARK_DBS           *benchmarkP);
+
+void
+data_packet_order_free(benchmark_data_packet_t *orderedP);
+
+void
+data_packet_status_reset(benchmark_data_packet_t *packetP);
+
+void
+data_packet_status_set(benchmark_data_packet_t *packetP, int status);
+
+void
+data_packet_status_unorder(benchmark_data_packet_t       *packetP,
+                           const benchmark_data_packet_t *orderedP);
+
+/* Asynchronous orders (order_queue.c) */
+int
+order_queue_start(BENCHMARK_DBS *benchmarkP);
+
+void
+order_queue_stop(BENCHMARK_DBS *benchmarkP);
+
+/* Group commit of single item calls (group_commit.c) */
+#define GROUP_COMMIT_ENABLED(benchmarkP)  ((benchmarkP)->group_commit != NULL)
+
+int
+group_commit_start(BENCHMARK_DBS *benchmarkP);
+
+void
+group_commit_stop(BENCHMARK_DBS *benchmarkP);
+
+int
+group_commit_refresh(u_int32_t symbol_id, float price, BENCHMARK_DBS *benchmarkP);
+
+int
+group_commit_order(int is_sell, benchmark_xact_data_t *entryP, BENCHMARK_DBS *benchmarkP);
+
+/* Datafile tokenizer (datafile.c) */
+int
+datafile_open(const char *path, datafile_t *fileP);
+
+void
+datafile_close(datafile_t *fileP);
+
+void
+datafile_cursor_init(datafile_t *fileP, size_t start, size_t end, datafile_cursor_t *cursorP);
+
+int
+datafile_cursor_next(datafile_cursor_t *cursorP);
+
+void
+datafile_field_copy(datafile_cursor_t *cursorP, int field, char *dstP, size_t size);
+
+int
+datafile_field_known(datafile_cursor_t *cursorP, int field);
+
+int
+datafile_field_float(datafile_cursor_t *cursorP, int field, float *valueP);
+
+int
+datafile_field_long(datafile_cursor_t *cursorP, int field, long *valueP);
+
+int
+datafile_field_date(datafile_cursor_t *cursorP, int field, int *yearP, int *monthP, int *dayP);
+
+int
+datafile_parse_personal(datafile_cursor_t *cursorP, PERSONAL *personalP);
+
+int
+datafile_parse_stock(datafile_cursor_t *cursorP, STOCK *stockP);
+
+int
+datafile_parse_currency(datafile_cursor_t *cursorP, CURRENCY *currencyP);
+
+int
+datafile_parse_quote(datafile_cursor_t *cursorP, QUOTE *quoteP);
+
+/* Initial load (benchmark_initial_load.c) */
+int
+load_batch_init(load_batch_t *batchP, BENCHMARK_DBS *benchmarkP, DB *dbP,
+                const char *table, u_int32_t put_flags);
+
+int
+load_batch_add(load_batch_t *batchP, void *keyP, u_int32_t key_size,
+               void *dataP, u_int32_t data_size);
+
+int
+load_batch_flush(load_batch_t *batchP);
+
+int
+load_batch_finish(load_batch_t *batchP);
+
+int
+generate_portfolios(BENCHMARK_DBS *benchmarkP);
+
+/* Synthetic datasets (generator.c) */
+#define GENERATOR_ENABLED(benchmarkP)  ((benchmarkP)->generator != NULL)
+
+int
+generator_start(BENCHMARK_DBS *benchmarkP);
+
+void
+generator_stop(BENCHMARK_DBS *benchmarkP);
+
+void
+generator_symbol(u_int64_t index, char *symbol);
+
+int
+generator_personal(BENCHMARK_DBS *benchmarkP, u_int64_t index, PERSONAL *personalP);
+
+void
+generator_stock(BENCHMARK_DBS *benchmarkP, u_int64_t index, STOCK *stockP);
+
+int
+generator_quote(BENCHMARK_DBS *benchmarkP, u_int64_t index, QUOTE *quoteP);
+
+int
+generator_holdings(BENCHMARK_DBS  *benchmarkP,
+                   u_int64_t       first,
+                   u_int64_t       last,
+                   int           (*emit_fn)(PORTFOLIOS *portfolioP, void *argP),
+                   void           *argP);
+
+/* Table configuration (benchmark_config.c) */
+void
+benchmark_config_init(benchmark_config_t *configP);
+
+benchmark_table_config_t *
+benchmark_config_table_get(benchmark_config_t *configP, int which_database);
 /*---------------------------------
  * Debugging routines
  *-------------------------------*/
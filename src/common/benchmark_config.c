@@ -0,0 +1,560 @@
+/*
+ * benchmark_config.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Ricardo Zavaleta
+ *
+ *  Options that must be decided before the databases are opened,
+ *  such as the access method used by each table.
+ */
+
+#include "benchmark_common.h"
+
+/* Both headers define the isolation levels under the same names, so
+ * each header is checked against the same values as it is included */
+#if BENCHMARK_ISOLATION_DEFAULT != 0 \
+    || BENCHMARK_ISOLATION_UNCOMMITTED != 1 \
+    || BENCHMARK_ISOLATION_COMMITTED != 2 \
+    || BENCHMARK_ISOLATION_SNAPSHOT != 3 \
+    || BENCHMARK_ISOLATION_SERIALIZABLE != 4
+#error "Internal isolation levels changed; update benchmark.h too"
+#endif
+
+#include "../benchmark.h"
+
+#if BENCHMARK_ISOLATION_DEFAULT != 0 \
+    || BENCHMARK_ISOLATION_UNCOMMITTED != 1 \
+    || BENCHMARK_ISOLATION_COMMITTED != 2 \
+    || BENCHMARK_ISOLATION_SNAPSHOT != 3 \
+    || BENCHMARK_ISOLATION_SERIALIZABLE != 4
+#error "Public isolation levels must match the internal ones"
+#endif
+
+#if BENCHMARK_TABLE_STOCKS != STOCKS_FLAG \
+    || BENCHMARK_TABLE_QUOTES != QUOTES_FLAG \
+    || BENCHMARK_TABLE_PERSONAL != PERSONAL_FLAG \
+    || BENCHMARK_TABLE_PORTFOLIOS != PORTFOLIOS_FLAG
+#error "Public table identifiers must match the internal database flags"
+#endif
+
+/* Every table is a btree unless told otherwise, transactions
+ * keep their cursors, lock conflicts are retried a few times,
+ * and the initial load commits rows in batches */
+void
+benchmark_config_init(benchmark_config_t *configP)
+{
+  memset(configP, 0, sizeof(benchmark_config_t));
+  configP->magic = BENCHMARK_CONFIG_MAGIC_WORD;
+  configP->stocks.access_method = DB_BTREE;
+  configP->quotes.access_method = DB_BTREE;
+  configP->personal.access_method = DB_BTREE;
+  configP->cursor_cache = 1;
+  configP->order_group_max = BENCHMARK_ORDER_GROUP_MAX_DEFAULT;
+  configP->retry_max = BENCHMARK_RETRY_MAX_DEFAULT;
+  configP->retry_backoff_usec = BENCHMARK_RETRY_BACKOFF_DEFAULT;
+  configP->retry_backoff_max_usec = BENCHMARK_RETRY_BACKOFF_MAX_DEFAULT;
+  configP->load_batch_rows = BENCHMARK_LOAD_BATCH_DEFAULT;
+  configP->ingest_ring_size = BENCHMARK_INGEST_RING_DEFAULT;
+  configP->ingest_batch_max = BENCHMARK_INGEST_BATCH_DEFAULT;
+}
+
+/*
+ * Returns the configuration of the given table, or NULL for the
+ * tables that are always btrees (they rely on ordered scans or
+ * on sorted duplicates).
+ */
+benchmark_table_config_t *
+benchmark_config_table_get(benchmark_config_t *configP, int which_database)
+{
+  if (configP == NULL) {
+    return NULL;
+  }
+
+  switch (which_database) {
+    case STOCKS_FLAG:
+      return &configP->stocks;
+
+    case QUOTES_FLAG:
+      return &configP->quotes;
+
+    case PERSONAL_FLAG:
+      return &configP->personal;
+
+    default:
+      return NULL;
+  }
+}
+
+int
+benchmark_config_alloc(void **config_handle)
+{
+  benchmark_config_t *configP = NULL;
+
+  if (config_handle == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  *config_handle = NULL;
+
+  configP = malloc(sizeof(benchmark_config_t));
+  if (configP == NULL) {
+    benchmark_error("Could not allocate configuration");
+    goto failXit;
+  }
+
+  benchmark_config_init(configP);
+
+  *config_handle = configP;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_config_free(void *config_handle)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+  configP->magic = 0;
+  free(configP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Selects the access method of a table. nelem is only used by
+ * hash tables and is the number of keys the table is expected
+ * to hold, so that the buckets are allocated up front instead
+ * of splitting while the table is loaded.
+ */
+int
+benchmark_config_access_method_set(void         *config_handle,
+                                   int           table,
+                                   int           access_method,
+                                   unsigned int  nelem)
+{
+  benchmark_config_t       *configP = config_handle;
+  benchmark_table_config_t *tableP = NULL;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  tableP = benchmark_config_table_get(configP, table);
+  if (tableP == NULL) {
+    benchmark_error("The access method of table 0x%x cannot be changed", table);
+    goto failXit;
+  }
+
+  switch (access_method) {
+    case BENCHMARK_ACCESS_BTREE:
+      tableP->access_method = DB_BTREE;
+      tableP->h_nelem = 0;
+      break;
+
+    case BENCHMARK_ACCESS_HASH:
+      tableP->access_method = DB_HASH;
+      tableP->h_nelem = nelem;
+      break;
+
+    default:
+      benchmark_error("Unknown access method: %d", access_method);
+      goto failXit;
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Keeps a copy of every quote in memory. Quote reads are then served
+ * without a transaction, and updates are published once they commit.
+ */
+int
+benchmark_config_quote_cache_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->quote_cache = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Freezes Stocks, Currencies and Personal into sorted arrays once they
+ * are loaded. Catalog reads and account checks then take no locks.
+ */
+int
+benchmark_config_frozen_catalog_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->frozen_catalog = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Opens every table multiversion, and runs the transactions that only
+ * read on a snapshot. Readers then never wait for quote writers (and
+ * the other way around), at the cost of keeping old page versions in
+ * the cache.
+ */
+int
+benchmark_config_snapshot_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->snapshot_reads = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Transactions open a cursor per table the first time they need it
+ * and keep it until they commit or abort. Disabling this makes every
+ * operation open and close its own cursors.
+ */
+int
+benchmark_config_cursor_cache_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->cursor_cache = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Packets given to benchmark_purchase2() and benchmark_sell2() are
+ * applied in (account, symbol) order, with the entries for the same
+ * holding merged, so that concurrent packets lock the holdings they
+ * share in the same order.
+ */
+int
+benchmark_config_packet_order_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->packet_order = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Each entry of a packet runs in a child transaction. An entry that
+ * fails is rolled back alone and the packet commits the rest; the
+ * outcome of each entry is left in the packet. Lock conflicts still
+ * abort and retry the whole packet.
+ */
+int
+benchmark_config_packet_partial_set(void *config_handle, int enabled)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->packet_partial = enabled ? 1 : 0;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Starts num_workers threads with the handle, to apply the packets
+ * submitted with benchmark_purchase2_submit() and
+ * benchmark_sell2_submit(). Up to group_max orders are applied in
+ * one transaction. num_workers = 0 disables submission.
+ */
+int
+benchmark_config_order_queue_set(void *config_handle, int num_workers, int group_max)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || num_workers < 0 || group_max <= 0) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->order_workers = num_workers;
+  configP->order_group_max = group_max;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Sets the isolation of the read only calls of the handle, one of
+ * BENCHMARK_ISOLATION_*. Thread contexts may override it.
+ */
+int
+benchmark_config_read_isolation_set(void *config_handle, int isolation)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL
+      || isolation < BENCHMARK_ISOLATION_DEFAULT || isolation > BENCHMARK_ISOLATION_SERIALIZABLE) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->read_isolation = isolation;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Concurrent calls of benchmark_refresh_quotes(),
+ * benchmark_refresh_quotes2(), and of benchmark_purchase2() and
+ * benchmark_sell2() with one entry packets, are applied together in
+ * one transaction. A batch waits up to window_usec for more calls,
+ * and holds up to max_batch of them. max_batch <= 1 disables it.
+ */
+int
+benchmark_config_group_commit_set(void *config_handle, unsigned int window_usec, int max_batch)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->group_commit_window_usec = window_usec;
+  configP->group_commit_max = max_batch;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Sets how many times a transaction that lost a lock conflict is run
+ * again, and the bounds of the backoff that precedes each retry.
+ */
+int
+benchmark_config_retry_set(void         *config_handle,
+                           int           max_retries,
+                           unsigned int  backoff_usec,
+                           unsigned int  max_backoff_usec)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || max_retries < 0 || backoff_usec > max_backoff_usec) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->retry_max = max_retries;
+  configP->retry_backoff_usec = backoff_usec;
+  configP->retry_backoff_max_usec = max_backoff_usec;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Sets how many rows the initial load puts per transaction, and
+ * whether the tables it creates skip the log.
+ */
+int
+benchmark_config_bulk_load_set(void *config_handle, int batch_rows, int not_durable)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || batch_rows <= 0) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->load_batch_rows = batch_rows;
+  configP->load_not_durable = not_durable;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * With num_threads > 1 the initial load runs the tables in parallel
+ * and splits each large datafile in up to num_threads chunks.
+ */
+int
+benchmark_config_parallel_load_set(void *config_handle, int num_threads)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || num_threads < 0) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->load_threads = num_threads;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Generates a dataset of num_accounts accounts, num_symbols stocks
+ * with their quotes, and num_portfolios holdings instead of loading
+ * the datafiles. The same seed always gives the same dataset. skew
+ * is the Zipfian parameter of the holdings per account and of the
+ * symbols held, in [0, 1); 0 is uniform. num_accounts = 0 goes back
+ * to the datafiles.
+ */
+int
+benchmark_config_generator_set(void          *config_handle,
+                               unsigned long  num_accounts,
+                               unsigned long  num_symbols,
+                               unsigned long  num_portfolios,
+                               double         skew,
+                               unsigned long  seed)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || skew < 0 || skew >= 1
+      || num_accounts > BENCHMARK_GEN_ACCOUNTS_MAX
+      || (num_accounts > 0 && num_symbols == 0)
+      || num_portfolios > 0xFFFFFFFFUL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->gen_accounts = num_accounts;
+  configP->gen_symbols = num_symbols;
+  configP->gen_portfolios = num_portfolios;
+  configP->gen_skew = skew;
+  configP->gen_seed = seed;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * benchmark_ingest_run() parses up to ring_size ticks ahead of the
+ * ones being applied, and applies up to batch_max ticks per
+ * transaction. ring_size is rounded up to a power of two.
+ */
+int
+benchmark_config_ingest_set(void *config_handle, int ring_size, int batch_max)
+{
+  benchmark_config_t *configP = config_handle;
+
+  if (configP == NULL || ring_size <= 0 || ring_size > (1 << 24)
+      || batch_max <= 0 || batch_max > ring_size) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(configP->magic == BENCHMARK_CONFIG_MAGIC_WORD);
+
+  configP->ingest_ring_size = ring_size;
+  configP->ingest_batch_max = batch_max;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
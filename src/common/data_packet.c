@@ -6,6 +6,13 @@
  */
 
 #include "benchmark_common.h"
+#include "../benchmark.h"
+
+/* Entries take the return code of the call that applied them */
+#if BENCHMARK_ITEM_APPLIED != BENCHMARK_SUCCESS \
+    || BENCHMARK_ITEM_FAILED != BENCHMARK_FAIL
+#error "Packet entry outcomes must match the internal return codes"
+#endif
 
 int
 benchmark_data_packet_alloc(size_t reqsz, void **data_packetH)
@@ -108,9 +115,16 @@ benchmark_data_packet_append(const char  *accountId,
   idx = packetP->used;
   strncpy(packetP->data[idx].accountId, accountId, sizeof(packetP->data[idx].accountId));
   packetP->data[idx].symbolId = symbolId;
-  strncpy(packetP->data[idx].symbol, symbol, sizeof(packetP->data[idx].symbol));
+  /* Without a symbol the entry is resolved by symbolId alone */
+  if (symbol != NULL) {
+    strncpy(packetP->data[idx].symbol, symbol, sizeof(packetP->data[idx].symbol));
+  }
+  else {
+    packetP->data[idx].symbol[0] = '\0';
+  }
   packetP->data[idx].price = price;
   packetP->data[idx].amount = amount;
+  packetP->data[idx].status = BENCHMARK_ITEM_PENDING;
 
   packetP->used ++;
 
@@ -119,3 +133,214 @@ benchmark_data_packet_append(const char  *accountId,
   failXit:
     return BENCHMARK_FAIL;
 }
+
+/* Order of the entries of a canonical packet */
+static int
+data_packet_entry_cmp(const benchmark_xact_data_t *aP, const benchmark_xact_data_t *bP)
+{
+  int rc;
+
+  rc = strncmp(aP->accountId, bP->accountId, sizeof(aP->accountId));
+  if (rc != 0) {
+    return rc;
+  }
+
+  if (aP->symbolId != bP->symbolId) {
+    return (aP->symbolId < bP->symbolId) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+/* Bottom up merge sort, so that equal entries keep their order */
+static void
+data_packet_sort(benchmark_xact_data_t *entriesP,
+                 benchmark_xact_data_t *tmpP,
+                 size_t                 num_entries)
+{
+  benchmark_xact_data_t *srcP = entriesP;
+  benchmark_xact_data_t *dstP = tmpP;
+  benchmark_xact_data_t *swapP;
+  size_t width, lo, mid, hi, i, j, k;
+
+  for (width = 1; width < num_entries; width *= 2) {
+    for (lo = 0; lo < num_entries; lo += 2 * width) {
+      mid = (lo + width < num_entries) ? lo + width : num_entries;
+      hi = (lo + 2 * width < num_entries) ? lo + 2 * width : num_entries;
+
+      for (i = lo, j = mid, k = lo; k < hi; k++) {
+        if (i < mid && (j >= hi || data_packet_entry_cmp(&srcP[i], &srcP[j]) <= 0)) {
+          dstP[k] = srcP[i++];
+        }
+        else {
+          dstP[k] = srcP[j++];
+        }
+      }
+    }
+
+    swapP = srcP;
+    srcP = dstP;
+    dstP = swapP;
+  }
+
+  if (srcP != entriesP) {
+    memcpy(entriesP, srcP, num_entries * sizeof(benchmark_xact_data_t));
+  }
+}
+
+/*
+ * Builds in orderedP the canonical form of packetP: its symbols are
+ * resolved to ids, its entries are stably sorted by (account, symbol
+ * id), and the entries for the same holding are merged into one.
+ *
+ * A packet is applied all or nothing and quotes don't change while
+ * it runs, so a merged entry carries the total amount and the most
+ * restrictive price: the lowest bid of a purchase, the highest ask of
+ * a sell. Entries are not merged when they commit one by one, since
+ * each must succeed or fail on its own. Each entry of packetP records
+ * the slot of orderedP it went to. The entries live in scratch memory
+ * of the thread and must be given back with data_packet_order_free().
+ */
+int
+data_packet_order(benchmark_data_packet_t *packetP,
+                  int                      is_sell,
+                  benchmark_data_packet_t *orderedP,
+                  BENCHMARK_DBS           *benchmarkP)
+{
+  benchmark_xact_data_t *entriesP = NULL;
+  benchmark_xact_data_t *tmpP = NULL;
+  benchmark_xact_data_t *lastP;
+  u_int32_t symbol_id;
+  size_t i, used;
+
+  if (packetP == NULL || orderedP == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  memset(orderedP, 0, sizeof(benchmark_data_packet_t));
+
+  if (packetP->used == 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  entriesP = thread_scratch_alloc(packetP->used * sizeof(benchmark_xact_data_t));
+  tmpP = thread_scratch_alloc(packetP->used * sizeof(benchmark_xact_data_t));
+  if (entriesP == NULL || tmpP == NULL) {
+    benchmark_error("Could not allocate ordered packet");
+    goto failXit;
+  }
+
+  for (i = 0; i < packetP->used; i++) {
+    entriesP[i] = packetP->data[i];
+    entriesP[i].slot = i;
+    if (entriesP[i].symbol[0] == '\0') {
+      continue;
+    }
+
+    if (symbol_dict_lookup(entriesP[i].symbol, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+      benchmark_error("This symbol (%s) does not exist.", entriesP[i].symbol);
+      goto failXit;
+    }
+    entriesP[i].symbolId = symbol_id;
+    entriesP[i].symbol[0] = '\0';
+  }
+
+  data_packet_sort(entriesP, tmpP, packetP->used);
+
+  /* While merging, slot still holds the position in packetP */
+  packetP->data[entriesP[0].slot].slot = 0;
+  used = 1;
+  for (i = 1; i < packetP->used; i++) {
+    lastP = &entriesP[used - 1];
+    if (data_packet_entry_cmp(lastP, &entriesP[i]) != 0 || benchmarkP->config.packet_partial) {
+      packetP->data[entriesP[i].slot].slot = used;
+      entriesP[used ++] = entriesP[i];
+      continue;
+    }
+
+    packetP->data[entriesP[i].slot].slot = used - 1;
+
+    lastP->amount += entriesP[i].amount;
+    if (is_sell ? (entriesP[i].price > lastP->price)
+                : (entriesP[i].price < lastP->price)) {
+      lastP->price = entriesP[i].price;
+    }
+  }
+
+  thread_scratch_free(tmpP);
+
+  orderedP->data = entriesP;
+  orderedP->size = packetP->used;
+  orderedP->used = used;
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "Packet of %zu entries ordered into %zu",
+                  packetP->used, used);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  thread_scratch_free(tmpP);
+  thread_scratch_free(entriesP);
+  return BENCHMARK_FAIL;
+}
+
+void
+data_packet_order_free(benchmark_data_packet_t *orderedP)
+{
+  if (orderedP == NULL) {
+    return;
+  }
+
+  thread_scratch_free(orderedP->data);
+  memset(orderedP, 0, sizeof(benchmark_data_packet_t));
+}
+
+void
+data_packet_status_reset(benchmark_data_packet_t *packetP)
+{
+  data_packet_status_set(packetP, BENCHMARK_ITEM_PENDING);
+}
+
+void
+data_packet_status_set(benchmark_data_packet_t *packetP, int status)
+{
+  size_t i;
+
+  for (i = 0; i < packetP->used; i++) {
+    packetP->data[i].status = status;
+  }
+}
+
+/* Entries merged into one canonical entry share its outcome */
+void
+data_packet_status_unorder(benchmark_data_packet_t       *packetP,
+                           const benchmark_data_packet_t *orderedP)
+{
+  size_t i;
+
+  for (i = 0; i < packetP->used; i++) {
+    assert(packetP->data[i].slot < orderedP->used);
+    packetP->data[i].status = orderedP->data[packetP->data[i].slot].status;
+  }
+}
+
+int
+benchmark_data_packet_status_get(void *data_packetH,
+                                 int   idx,
+                                 int  *status)
+{
+  benchmark_data_packet_t *packetP = data_packetH;
+
+  if (packetP == NULL || status == NULL || idx < 0 || (size_t) idx >= packetP->used) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  *status = packetP->data[idx].status;
+
+  return BENCHMARK_SUCCESS;
+
+  failXit:
+    return BENCHMARK_FAIL;
+}
@@ -0,0 +1,539 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  datafile.c
+ *
+ *    Description:  Reads the '#' delimited datafiles. Files are mapped
+ *                  into memory and lines are split into fields that
+ *                  point into the mapping, so a field is only copied
+ *                  once: into the record it belongs to.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include "benchmark.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if BENCHMARK_TABLE_CURRENCIES != CURRENCIES_FLAG
+#error "Public table identifiers must match the internal database flags"
+#endif
+
+/*-------------------------------------------------------
+ * Maps a datafile into memory. An empty file is not
+ * mapped at all.
+ *-----------------------------------------------------*/
+int
+datafile_open(const char *path, datafile_t *fileP)
+{
+  struct stat st;
+
+  memset(fileP, 0, sizeof(datafile_t));
+  fileP->path = path;
+  fileP->fd = -1;
+
+  fileP->fd = open(path, O_RDONLY);
+  if (fileP->fd < 0) {
+    benchmark_error("Error opening file '%s'", path);
+    goto failXit;
+  }
+
+  if (fstat(fileP->fd, &st) != 0) {
+    benchmark_error("Error reading file '%s'", path);
+    goto failXit;
+  }
+
+  fileP->size = st.st_size;
+  if (fileP->size == 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  fileP->baseP = mmap(NULL, fileP->size, PROT_READ, MAP_PRIVATE, fileP->fd, 0);
+  if (fileP->baseP == MAP_FAILED) {
+    fileP->baseP = NULL;
+    benchmark_error("Error mapping file '%s'", path);
+    goto failXit;
+  }
+
+  /* Lines are read front to back */
+  madvise(fileP->baseP, fileP->size, MADV_SEQUENTIAL);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  datafile_close(fileP);
+  return BENCHMARK_FAIL;
+}
+
+void
+datafile_close(datafile_t *fileP)
+{
+  if (fileP->baseP != NULL) {
+    munmap(fileP->baseP, fileP->size);
+    fileP->baseP = NULL;
+  }
+
+  if (fileP->fd >= 0) {
+    close(fileP->fd);
+  }
+  fileP->fd = -1;
+}
+
+/*-------------------------------------------------------
+ * Prepares a cursor over the lines that start in the
+ * byte range [start, end) of the file. The line that
+ * crosses start belongs to the previous range.
+ *-----------------------------------------------------*/
+void
+datafile_cursor_init(datafile_t *fileP, size_t start, size_t end, datafile_cursor_t *cursorP)
+{
+  const char *nlP;
+
+  memset(cursorP, 0, sizeof(datafile_cursor_t));
+  cursorP->fileP = fileP;
+
+  if (fileP->baseP == NULL) {
+    return;
+  }
+
+  if (end > fileP->size) {
+    end = fileP->size;
+  }
+  if (start > end) {
+    start = end;
+  }
+
+  cursorP->posP = fileP->baseP + start;
+  cursorP->endP = fileP->baseP + end;
+  cursorP->limitP = fileP->baseP + fileP->size;
+
+  if (start > 0 && fileP->baseP[start - 1] != '\n') {
+    nlP = memchr(cursorP->posP, '\n', cursorP->limitP - cursorP->posP);
+    cursorP->posP = (nlP == NULL) ? cursorP->limitP : nlP + 1;
+  }
+}
+
+/*-------------------------------------------------------
+ * Splits the next line of the range into fields.
+ * Fields are trimmed of blanks, and a field between
+ * double quotes may hold '#'. Fields past the end of
+ * the line are empty. Returns 0 at the end of the range.
+ *-----------------------------------------------------*/
+int
+datafile_cursor_next(datafile_cursor_t *cursorP)
+{
+  const char *lineP;
+  const char *eolP;
+  const char *pP;
+  const char *startP;
+  const char *stopP;
+  int i;
+
+  for (;;) {
+    if (cursorP->posP == NULL || cursorP->posP >= cursorP->endP) {
+      return 0;
+    }
+
+    lineP = cursorP->posP;
+    eolP = memchr(lineP, '\n', cursorP->limitP - lineP);
+    if (eolP == NULL) {
+      eolP = cursorP->limitP;
+      cursorP->posP = cursorP->limitP;
+    }
+    else {
+      cursorP->posP = eolP + 1;
+    }
+
+    if (eolP > lineP && eolP[-1] == '\r') {
+      eolP --;
+    }
+
+    if (eolP > lineP) {
+      break;
+    }
+  }
+
+  cursorP->offset = lineP - cursorP->fileP->baseP;
+  cursorP->num_fields = 0;
+
+  pP = lineP;
+  while (cursorP->num_fields < DATAFILE_FIELDS_MAX) {
+    while (pP < eolP && (*pP == ' ' || *pP == '\t')) {
+      pP ++;
+    }
+
+    if (pP < eolP && *pP == '"') {
+      startP = pP + 1;
+      stopP = memchr(startP, '"', eolP - startP);
+      if (stopP == NULL) {
+        stopP = eolP;
+      }
+      pP = memchr(stopP, '#', eolP - stopP);
+    }
+    else {
+      startP = pP;
+      pP = memchr(startP, '#', eolP - startP);
+      stopP = (pP == NULL) ? eolP : pP;
+      while (stopP > startP && (stopP[-1] == ' ' || stopP[-1] == '\t')) {
+        stopP --;
+      }
+    }
+
+    cursorP->fields[cursorP->num_fields].startP = startP;
+    cursorP->fields[cursorP->num_fields].len = stopP - startP;
+    cursorP->num_fields ++;
+
+    if (pP == NULL) {
+      break;
+    }
+    pP ++;
+  }
+
+  for (i = cursorP->num_fields; i < DATAFILE_FIELDS_MAX; i++) {
+    cursorP->fields[i].startP = eolP;
+    cursorP->fields[i].len = 0;
+  }
+
+  return 1;
+}
+
+/*-------------------------------------------------------
+ * Copies a field as a NUL terminated string. A field
+ * that does not fit is cut and counted as truncated.
+ *-----------------------------------------------------*/
+void
+datafile_field_copy(datafile_cursor_t *cursorP, int field, char *dstP, size_t size)
+{
+  const datafile_field_t *fieldP = &cursorP->fields[field];
+  size_t len = fieldP->len;
+
+  if (len >= size) {
+    len = size - 1;
+    cursorP->truncated ++;
+  }
+
+  memcpy(dstP, fieldP->startP, len);
+  dstP[len] = '\0';
+}
+
+/* Empty fields, "None" and "n/a" stand for unknown values */
+static int
+datafile_field_unknown(const datafile_field_t *fieldP)
+{
+  return fieldP->len == 0
+         || (fieldP->len == 4 && memcmp(fieldP->startP, "None", 4) == 0)
+         || (fieldP->len == 3 && memcmp(fieldP->startP, "n/a", 3) == 0);
+}
+
+/* Whether the line has the field and its value is known */
+int
+datafile_field_known(datafile_cursor_t *cursorP, int field)
+{
+  return field < cursorP->num_fields && !datafile_field_unknown(&cursorP->fields[field]);
+}
+
+/*-------------------------------------------------------
+ * Parses a decimal such as "7.15", "-2.05%" or "+1.46%".
+ * Unknown values read as 0.
+ *-----------------------------------------------------*/
+int
+datafile_field_float(datafile_cursor_t *cursorP, int field, float *valueP)
+{
+  const datafile_field_t *fieldP = &cursorP->fields[field];
+  const char *pP = fieldP->startP;
+  const char *endP = fieldP->startP + fieldP->len;
+  double value = 0;
+  double scale = 1;
+  int negative = 0;
+  int digits = 0;
+
+  *valueP = 0;
+
+  if (datafile_field_unknown(fieldP)) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  if (*pP == '+' || *pP == '-') {
+    negative = (*pP == '-');
+    pP ++;
+  }
+
+  for (; pP < endP && *pP >= '0' && *pP <= '9'; pP++, digits++) {
+    value = value * 10 + (*pP - '0');
+  }
+
+  if (pP < endP && *pP == '.') {
+    for (pP++; pP < endP && *pP >= '0' && *pP <= '9'; pP++, digits++) {
+      scale *= 10;
+      value = value * 10 + (*pP - '0');
+    }
+  }
+
+  if (pP < endP && *pP == '%') {
+    pP ++;
+  }
+
+  if (digits == 0 || pP != endP) {
+    return BENCHMARK_FAIL;
+  }
+
+  value /= scale;
+  *valueP = (float) (negative ? -value : value);
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*-------------------------------------------------------
+ * Parses an integer. Unknown values read as 0.
+ *-----------------------------------------------------*/
+int
+datafile_field_long(datafile_cursor_t *cursorP, int field, long *valueP)
+{
+  const datafile_field_t *fieldP = &cursorP->fields[field];
+  const char *pP = fieldP->startP;
+  const char *endP = fieldP->startP + fieldP->len;
+  long value = 0;
+  int negative = 0;
+
+  *valueP = 0;
+
+  if (datafile_field_unknown(fieldP)) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  if (*pP == '+' || *pP == '-') {
+    negative = (*pP == '-');
+    pP ++;
+  }
+
+  if (pP == endP) {
+    return BENCHMARK_FAIL;
+  }
+
+  for (; pP < endP; pP++) {
+    if (*pP < '0' || *pP > '9') {
+      return BENCHMARK_FAIL;
+    }
+    value = value * 10 + (*pP - '0');
+  }
+
+  *valueP = negative ? -value : value;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*-------------------------------------------------------
+ * Parses a month/day/year date such as "8/8/2017".
+ * Unknown dates read as 0/0/0.
+ *-----------------------------------------------------*/
+int
+datafile_field_date(datafile_cursor_t *cursorP, int field, int *yearP, int *monthP, int *dayP)
+{
+  const datafile_field_t *fieldP = &cursorP->fields[field];
+  const char *pP = fieldP->startP;
+  const char *endP = fieldP->startP + fieldP->len;
+  int parts[3] = {0, 0, 0};
+  int i;
+
+  *monthP = *dayP = *yearP = 0;
+
+  if (datafile_field_unknown(fieldP)) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  for (i = 0; i < 3; i++) {
+    if (pP == endP || *pP < '0' || *pP > '9') {
+      return BENCHMARK_FAIL;
+    }
+    for (; pP < endP && *pP >= '0' && *pP <= '9'; pP++) {
+      parts[i] = parts[i] * 10 + (*pP - '0');
+    }
+    if (i < 2) {
+      if (pP == endP || *pP != '/') {
+        return BENCHMARK_FAIL;
+      }
+      pP ++;
+    }
+  }
+
+  if (pP != endP || parts[0] < 1 || parts[0] > 12 || parts[1] < 1 || parts[1] > 31) {
+    return BENCHMARK_FAIL;
+  }
+
+  *monthP = parts[0];
+  *dayP = parts[1];
+  *yearP = parts[2];
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* accounts.txt: id#last#first#address#city#state#country#phone */
+int
+datafile_parse_personal(datafile_cursor_t *cursorP, PERSONAL *personalP)
+{
+  memset(personalP, 0, sizeof(PERSONAL));
+
+  datafile_field_copy(cursorP, 0, personalP->account_id, sizeof(personalP->account_id));
+  datafile_field_copy(cursorP, 1, personalP->last_name, sizeof(personalP->last_name));
+  datafile_field_copy(cursorP, 2, personalP->first_name, sizeof(personalP->first_name));
+  datafile_field_copy(cursorP, 3, personalP->address, sizeof(personalP->address));
+  datafile_field_copy(cursorP, 4, personalP->city, sizeof(personalP->city));
+  datafile_field_copy(cursorP, 5, personalP->state, sizeof(personalP->state));
+  datafile_field_copy(cursorP, 6, personalP->country, sizeof(personalP->country));
+  datafile_field_copy(cursorP, 7, personalP->phone, sizeof(personalP->phone));
+
+  return (personalP->account_id[0] == '\0') ? BENCHMARK_FAIL : BENCHMARK_SUCCESS;
+}
+
+/* companylist.txt: symbol#name#... */
+int
+datafile_parse_stock(datafile_cursor_t *cursorP, STOCK *stockP)
+{
+  memset(stockP, 0, sizeof(STOCK));
+
+  datafile_field_copy(cursorP, 0, stockP->stock_symbol, sizeof(stockP->stock_symbol));
+  datafile_field_copy(cursorP, 1, stockP->full_name, sizeof(stockP->full_name));
+
+  return (stockP->stock_symbol[0] == '\0') ? BENCHMARK_FAIL : BENCHMARK_SUCCESS;
+}
+
+/* currencies.txt: country#currency name#currency symbol */
+int
+datafile_parse_currency(datafile_cursor_t *cursorP, CURRENCY *currencyP)
+{
+  memset(currencyP, 0, sizeof(CURRENCY));
+
+  datafile_field_copy(cursorP, 0, currencyP->country, sizeof(currencyP->country));
+  datafile_field_copy(cursorP, 1, currencyP->currency_name, sizeof(currencyP->currency_name));
+  datafile_field_copy(cursorP, 2, currencyP->currency_symbol, sizeof(currencyP->currency_symbol));
+
+  return (currencyP->currency_symbol[0] == '\0') ? BENCHMARK_FAIL : BENCHMARK_SUCCESS;
+}
+
+/* quotes.txt: symbol#price#date#low#high#change%#bid#ask#volume#market cap.
+ * The symbol id is left for the caller to look up. */
+int
+datafile_parse_quote(datafile_cursor_t *cursorP, QUOTE *quoteP)
+{
+  int year, month, day;
+
+  memset(quoteP, 0, sizeof(QUOTE));
+
+  datafile_field_copy(cursorP, 0, quoteP->symbol, sizeof(quoteP->symbol));
+  if (quoteP->symbol[0] == '\0') {
+    goto failXit;
+  }
+
+  if (datafile_field_float(cursorP, 1, &quoteP->current_price) != BENCHMARK_SUCCESS
+      || datafile_field_float(cursorP, 3, &quoteP->low_price_day) != BENCHMARK_SUCCESS
+      || datafile_field_float(cursorP, 4, &quoteP->high_price_day) != BENCHMARK_SUCCESS
+      || datafile_field_float(cursorP, 5, &quoteP->perc_price_change) != BENCHMARK_SUCCESS
+      || datafile_field_float(cursorP, 6, &quoteP->bidding_price) != BENCHMARK_SUCCESS
+      || datafile_field_float(cursorP, 7, &quoteP->asking_price) != BENCHMARK_SUCCESS
+      || datafile_field_long(cursorP, 8, &quoteP->trade_volume) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  /* The trade time is a date, kept as text. An unknown one is left
+   * empty */
+  if (datafile_field_date(cursorP, 2, &year, &month, &day) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  if (month > 0) {
+    quote_trade_date_set(quoteP, year, month, day);
+  }
+
+  /* Market caps such as "42.59M" are kept as text */
+  datafile_field_copy(cursorP, 9, quoteP->market_cap, sizeof(quoteP->market_cap));
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Parses a datafile into the records of the given table, without
+ * loading them. Used to measure the parser on its own.
+ */
+int
+benchmark_datafile_parse(const char    *path,
+                         int            table,
+                         unsigned long *rowsP,
+                         unsigned long *malformedP)
+{
+  datafile_t        file;
+  datafile_cursor_t cursor;
+  unsigned long     rows = 0;
+  unsigned long     malformed = 0;
+  int               rc;
+  union {
+    PERSONAL  personal;
+    STOCK     stock;
+    CURRENCY  currency;
+    QUOTE     quote;
+  } record;
+
+  if (path == NULL || rowsP == NULL || malformedP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  if (table != STOCKS_FLAG && table != PERSONAL_FLAG
+      && table != CURRENCIES_FLAG && table != QUOTES_FLAG) {
+    benchmark_error("Invalid table: %d", table);
+    goto failXit;
+  }
+
+  if (datafile_open(path, &file) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  datafile_cursor_init(&file, 0, file.size, &cursor);
+  while (datafile_cursor_next(&cursor)) {
+    switch (table) {
+      case STOCKS_FLAG:
+        rc = datafile_parse_stock(&cursor, &record.stock);
+        break;
+
+      case PERSONAL_FLAG:
+        rc = datafile_parse_personal(&cursor, &record.personal);
+        break;
+
+      case CURRENCIES_FLAG:
+        rc = datafile_parse_currency(&cursor, &record.currency);
+        break;
+
+      default:
+        rc = datafile_parse_quote(&cursor, &record.quote);
+        break;
+    }
+
+    if (rc == BENCHMARK_SUCCESS) {
+      rows ++;
+    }
+    else {
+      malformed ++;
+    }
+  }
+
+  datafile_close(&file);
+
+  *rowsP = rows;
+  *malformedP = malformed;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
@@ -0,0 +1,393 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  generator.c
+ *
+ *    Description:  Synthetic datasets of any scale, used by the initial
+ *                  load instead of the datafiles. Every row is derived
+ *                  from the seed and its own index only, so a dataset is
+ *                  the same whatever the number of loading threads.
+ *
+ *                  Accounts and symbols are ranked by popularity: with
+ *                  skew > 0, holdings follow a Zipfian distribution
+ *                  (skew = 0 is uniform), so account 1 holds the most
+ *                  symbols and the first symbols are the most held.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <math.h>
+
+/* Streams of the rows of each table */
+#define GEN_STREAM_PERSONAL   1
+#define GEN_STREAM_QUOTES     2
+#define GEN_STREAM_HOLDINGS   3
+
+/* Symbols are written in bijective base 26: A..Z, AA..ZZ, ... */
+#define GEN_SYMBOL_LETTERS    26
+
+typedef struct generator_t {
+  unsigned long seed;
+  unsigned long num_accounts;
+  unsigned long num_symbols;
+  unsigned long num_portfolios;
+  double        theta;
+
+  /* Zipfian constants of the symbols (Gray et al.) */
+  double        zeta_symbols;
+  double        zeta2;
+  double        alpha;
+  double        eta;
+
+  /* Sum of the weights of every account */
+  double        zeta_accounts;
+} generator_t;
+
+typedef struct generator_rng_t {
+  u_int64_t state;
+} generator_rng_t;
+
+static const char *first_names[] = {
+  "Dannette", "Elois", "Idella", "Marcus", "Ricardo", "Sonia", "Wen", "Yusuf",
+  "Amara", "Bruno", "Chloe", "Dmitri", "Esther", "Farid", "Greta", "Hiro"
+};
+
+static const char *last_names[] = {
+  "Chiarello", "Vazques", "Mease", "Zavaleta", "Okafor", "Lindqvist", "Tanaka",
+  "Moreau", "Nowak", "Oliveira", "Patel", "Quinn", "Rossi", "Schmidt", "Ueda", "Varga"
+};
+
+static const char *cities[] = {
+  "SACRAMENTO", "AUSTIN", "BOSTON", "DENVER", "SEATTLE", "CHICAGO", "MIAMI", "PHOENIX"
+};
+
+static const char *states[] = {
+  "CA", "TX", "MA", "CO", "WA", "IL", "FL", "AZ"
+};
+
+#define GEN_PICK(rngP, list)  ((list)[generator_next(rngP) % (sizeof(list) / sizeof((list)[0]))])
+
+/* SplitMix64 finalizer */
+static u_int64_t
+generator_mix(u_int64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+/* Random numbers of one row of one table */
+static void
+generator_rng_init(generator_rng_t *rngP, generator_t *genP, int stream, u_int64_t index)
+{
+  rngP->state = generator_mix(genP->seed + 0x9E3779B97F4A7C15ULL * (u_int64_t) stream)
+                ^ generator_mix(index + 1);
+}
+
+static u_int64_t
+generator_next(generator_rng_t *rngP)
+{
+  rngP->state += 0x9E3779B97F4A7C15ULL;
+  return generator_mix(rngP->state);
+}
+
+/* Uniform in [0, 1) */
+static double
+generator_uniform(generator_rng_t *rngP)
+{
+  return (generator_next(rngP) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Rank of a symbol, the most popular being 0 */
+static unsigned long
+generator_symbol_rank(generator_rng_t *rngP, generator_t *genP)
+{
+  double u = generator_uniform(rngP);
+  double uz = u * genP->zeta_symbols;
+  unsigned long rank;
+
+  if (genP->num_symbols == 1 || uz < 1.0) {
+    return 0;
+  }
+  if (uz < genP->zeta2) {
+    return 1;
+  }
+
+  rank = (unsigned long) (genP->num_symbols * pow(genP->eta * u - genP->eta + 1, genP->alpha));
+  return (rank < genP->num_symbols) ? rank : genP->num_symbols - 1;
+}
+
+/*-------------------------------------------------------
+ * Prepares the generator described by the configuration
+ * of the handle.
+ *-----------------------------------------------------*/
+int
+generator_start(BENCHMARK_DBS *benchmarkP)
+{
+  generator_t *genP = NULL;
+  unsigned long i;
+
+  if (benchmarkP->config.gen_accounts == 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  genP = calloc(1, sizeof(generator_t));
+  if (genP == NULL) {
+    benchmark_error("Could not allocate generator");
+    goto failXit;
+  }
+
+  genP->seed = benchmarkP->config.gen_seed;
+  genP->num_accounts = benchmarkP->config.gen_accounts;
+  genP->num_symbols = benchmarkP->config.gen_symbols;
+  genP->num_portfolios = benchmarkP->config.gen_portfolios;
+  genP->theta = benchmarkP->config.gen_skew;
+
+  for (i = 1; i <= genP->num_symbols; i++) {
+    genP->zeta_symbols += pow((double) i, -genP->theta);
+  }
+  for (i = 1; i <= genP->num_accounts; i++) {
+    genP->zeta_accounts += pow((double) i, -genP->theta);
+  }
+
+  genP->zeta2 = 1.0 + pow(0.5, genP->theta);
+  genP->alpha = 1.0 / (1.0 - genP->theta);
+  genP->eta = (1.0 - pow(2.0 / genP->num_symbols, 1.0 - genP->theta))
+              / (1.0 - genP->zeta2 / genP->zeta_symbols);
+
+  benchmarkP->generator = genP;
+
+  benchmark_info("Generating %lu accounts, %lu symbols and %lu holdings (skew %.2f, seed %lu)",
+                 genP->num_accounts, genP->num_symbols, genP->num_portfolios,
+                 genP->theta, genP->seed);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+void
+generator_stop(BENCHMARK_DBS *benchmarkP)
+{
+  free(benchmarkP->generator);
+  benchmarkP->generator = NULL;
+}
+
+/*-------------------------------------------------------
+ * Writes the symbol of the given index.
+ *-----------------------------------------------------*/
+void
+generator_symbol(u_int64_t index, char *symbol)
+{
+  char reversed[ID_SZ];
+  int len = 0;
+
+  index ++;
+  while (index > 0 && len < ID_SZ - 1) {
+    index --;
+    reversed[len++] = 'A' + (index % GEN_SYMBOL_LETTERS);
+    index /= GEN_SYMBOL_LETTERS;
+  }
+
+  while (len > 0) {
+    *symbol++ = reversed[--len];
+  }
+  *symbol = '\0';
+}
+
+/* Accounts are numbered from 1, as in accounts.txt. The configuration
+ * allows at most BENCHMARK_GEN_ACCOUNTS_MAX of them, whose ids fit in
+ * ID_SZ; an id that doesn't fit is an error, not a truncated key. */
+static int
+generator_account_id(u_int64_t index, char account_id[ID_SZ])
+{
+  int len;
+
+  len = snprintf(account_id, ID_SZ, "%llu", (unsigned long long) index + 1);
+  if (len < 0 || len >= ID_SZ) {
+    benchmark_error("Account %llu has an id longer than %d characters",
+                    (unsigned long long) index + 1, ID_SZ - 1);
+    return BENCHMARK_FAIL;
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+int
+generator_personal(BENCHMARK_DBS *benchmarkP, u_int64_t index, PERSONAL *personalP)
+{
+  generator_rng_t rng;
+
+  generator_rng_init(&rng, benchmarkP->generator, GEN_STREAM_PERSONAL, index);
+
+  memset(personalP, 0, sizeof(PERSONAL));
+  if (generator_account_id(index, personalP->account_id) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+  snprintf(personalP->last_name, sizeof(personalP->last_name), "%s", GEN_PICK(&rng, last_names));
+  snprintf(personalP->first_name, sizeof(personalP->first_name), "%s", GEN_PICK(&rng, first_names));
+  snprintf(personalP->address, sizeof(personalP->address), "%u HIGH ST",
+           (unsigned int) (generator_next(&rng) % 9999) + 1);
+  snprintf(personalP->city, sizeof(personalP->city), "%s", GEN_PICK(&rng, cities));
+  snprintf(personalP->state, sizeof(personalP->state), "%s", GEN_PICK(&rng, states));
+  snprintf(personalP->country, sizeof(personalP->country), "USA");
+  snprintf(personalP->phone, sizeof(personalP->phone), "%03u-%03u-%04u",
+           (unsigned int) (generator_next(&rng) % 800) + 200,
+           (unsigned int) (generator_next(&rng) % 1000),
+           (unsigned int) (generator_next(&rng) % 10000));
+
+  return BENCHMARK_SUCCESS;
+}
+
+void
+generator_stock(BENCHMARK_DBS *benchmarkP, u_int64_t index, STOCK *stockP)
+{
+  memset(stockP, 0, sizeof(STOCK));
+  generator_symbol(index, stockP->stock_symbol);
+  snprintf(stockP->full_name, sizeof(stockP->full_name), "%s Holdings Inc.", stockP->stock_symbol);
+}
+
+/*-------------------------------------------------------
+ * Quote of the symbol of the given index. The symbol
+ * dictionary must already hold the generated stocks.
+ *-----------------------------------------------------*/
+int
+generator_quote(BENCHMARK_DBS *benchmarkP, u_int64_t index, QUOTE *quoteP)
+{
+  generator_rng_t rng;
+  float spread;
+
+  generator_rng_init(&rng, benchmarkP->generator, GEN_STREAM_QUOTES, index);
+
+  memset(quoteP, 0, sizeof(QUOTE));
+  generator_symbol(index, quoteP->symbol);
+  if (symbol_dict_lookup(quoteP->symbol, &quoteP->symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("Generated symbol %s is not listed", quoteP->symbol);
+    return BENCHMARK_FAIL;
+  }
+
+  /* Same starting price as the loaded quotes */
+  quoteP->current_price = 500.0;
+  spread = (float) (generator_uniform(&rng) * 25.0);
+  quoteP->low_price_day = quoteP->current_price - spread;
+  quoteP->high_price_day = quoteP->current_price + spread;
+  quoteP->perc_price_change = (float) (generator_uniform(&rng) * 10.0 - 5.0);
+  quoteP->bidding_price = quoteP->current_price - spread / 10;
+  quoteP->asking_price = quoteP->current_price + spread / 10;
+  quoteP->trade_volume = (long) (generator_next(&rng) % 1000000);
+  quote_trade_date_set(quoteP, 2017, 8, 8);
+  snprintf(quoteP->market_cap, sizeof(quoteP->market_cap), "%.2fM", generator_uniform(&rng) * 1000);
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*-------------------------------------------------------
+ * Emits the holdings of the accounts [first, last). An
+ * account gets its Zipfian share of the holdings, and
+ * never holds the same symbol twice. portfolio_id is left
+ * for emit_fn to fill in.
+ *-----------------------------------------------------*/
+int
+generator_holdings(BENCHMARK_DBS  *benchmarkP,
+                   u_int64_t       first,
+                   u_int64_t       last,
+                   int           (*emit_fn)(PORTFOLIOS *portfolioP, void *argP),
+                   void           *argP)
+{
+  generator_t *genP = benchmarkP->generator;
+  generator_rng_t rng;
+  PORTFOLIOS portfolio;
+  char symbol[ID_SZ];
+  u_int32_t *setP = NULL;
+  u_int32_t set_size = 0;
+  u_int32_t slot;
+  unsigned long rank;
+  unsigned long count;
+  unsigned long done;
+  double before = 0;
+  double after;
+  u_int64_t account;
+  u_int64_t i;
+
+  /* Sum in the same order as a single range would, so the
+   * shares don't depend on how the accounts were split */
+  for (i = 1; i <= first; i++) {
+    before += pow((double) i, -genP->theta);
+  }
+
+  for (account = first; account < last; account++) {
+    after = before + pow((double) (account + 1), -genP->theta);
+    count = (unsigned long) (genP->num_portfolios * (after / genP->zeta_accounts))
+            - (unsigned long) (genP->num_portfolios * (before / genP->zeta_accounts));
+    before = after;
+
+    if (count > genP->num_symbols) {
+      count = genP->num_symbols;
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    /* Symbols already held, open addressing on symbol rank + 1 */
+    if (set_size < 2 * count) {
+      free(setP);
+      set_size = 2 * count;
+      setP = malloc(set_size * sizeof(u_int32_t));
+      if (setP == NULL) {
+        benchmark_error("Could not allocate holdings of account %lu", (unsigned long) account + 1);
+        goto failXit;
+      }
+    }
+    memset(setP, 0, set_size * sizeof(u_int32_t));
+
+    generator_rng_init(&rng, genP, GEN_STREAM_HOLDINGS, account);
+
+    for (done = 0; done < count; done++) {
+      /* A symbol already held is replaced by the next one */
+      rank = generator_symbol_rank(&rng, genP);
+      for (;;) {
+        slot = (u_int32_t) ((rank * 2654435761u) % set_size);
+        while (setP[slot] != 0 && setP[slot] != rank + 1) {
+          slot = (slot + 1) % set_size;
+        }
+        if (setP[slot] == 0) {
+          setP[slot] = rank + 1;
+          break;
+        }
+        rank = (rank + 1) % genP->num_symbols;
+      }
+
+      memset(&portfolio, 0, sizeof(PORTFOLIOS));
+      if (generator_account_id(account, portfolio.account_id) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+      generator_symbol(rank, symbol);
+      if (symbol_dict_lookup(symbol, &portfolio.symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+        benchmark_error("Generated symbol %s is not listed", symbol);
+        goto failXit;
+      }
+      portfolio.hold_stocks = (int) (generator_next(&rng) % 100) + 1;
+
+      if (emit_fn(&portfolio, argP) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+  }
+
+  free(setP);
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  free(setP);
+  return BENCHMARK_FAIL;
+}
@@ -0,0 +1,475 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  group_commit.c
+ *
+ *    Description:  Group commit of single item calls. Concurrent calls of
+ *                  benchmark_refresh_quotes(), benchmark_refresh_quotes2()
+ *                  and of benchmark_purchase2() and benchmark_sell2() with
+ *                  a one entry packet are coalesced into one transaction.
+ *
+ *                  The first caller of a kind opens a batch and leads it:
+ *                  it waits up to the configured window, or until the
+ *                  batch is full, closes the batch and applies every item
+ *                  in it. Callers that arrive meanwhile join the batch and
+ *                  sleep until the leader is done. Callers that arrive
+ *                  after the batch closed open the next one.
+ *
+ *                  Each caller gets the outcome of its own item. Quote
+ *                  updates have a status per item; if a batch of orders
+ *                  fails, its items are applied again one at a time, so
+ *                  one bad order doesn't fail the others.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#define GROUP_KIND_REFRESH    0
+#define GROUP_KIND_PURCHASE   1
+#define GROUP_KIND_SELL       2
+#define GROUP_KINDS           3
+
+typedef struct group_item_t {
+  struct group_item_t    *nextP;
+  u_int32_t               symbol_id;    /* Quote updates */
+  float                   price;
+  benchmark_xact_data_t  *entryP;       /* Orders */
+  int                     status;
+  int                     done;
+} group_item_t;
+
+typedef struct group_batch_t {
+  int            kind;
+  int            num_items;
+  group_item_t  *headP;
+  group_item_t **tailPP;
+} group_batch_t;
+
+typedef struct group_commit_t {
+  pthread_mutex_t  lock;
+  pthread_cond_t   full_cond;     /* Leaders wait for their batch to fill */
+  pthread_cond_t   done_cond;     /* Members wait for their item */
+  group_batch_t   *openP[GROUP_KINDS];
+
+  u_int32_t        window_usec;
+  int              max_batch;
+
+  unsigned long    batches;
+  unsigned long    items;
+  unsigned long    largest;
+} group_commit_t;
+
+static const int group_xact_types[GROUP_KINDS] = {
+  BENCHMARK_XACT_REFRESH_QUOTES,
+  BENCHMARK_XACT_PURCHASE,
+  BENCHMARK_XACT_SELL
+};
+
+/* Entries appended without a symbol skip the dictionary */
+static int
+group_order_apply(int kind, benchmark_xact_data_t *entryP, benchmark_xact_h xactH, BENCHMARK_DBS *benchmarkP)
+{
+  if (kind == GROUP_KIND_SELL) {
+    if (entryP->symbol[0] == '\0') {
+      return sell_stocks_by_id(entryP->accountId, entryP->symbolId, entryP->price,
+                               entryP->amount, 1, xactH, benchmarkP);
+    }
+    return sell_stocks(entryP->accountId, entryP->symbol, entryP->price,
+                       entryP->amount, 1, xactH, benchmarkP);
+  }
+
+  if (entryP->symbol[0] == '\0') {
+    return place_order_by_id(entryP->accountId, entryP->symbolId, entryP->price,
+                             entryP->amount, 1, xactH, benchmarkP);
+  }
+  return place_order(entryP->accountId, entryP->symbol, entryP->price,
+                     entryP->amount, 1, xactH, benchmarkP);
+}
+
+typedef struct group_refresh_args_t {
+  int        num_items;
+  u_int32_t *symbol_ids;
+  float     *prices;
+  int       *status_list;
+} group_refresh_args_t;
+
+/* The quotes are updated in key order, each with a status of its own */
+static int
+group_refresh_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  group_refresh_args_t *argsP = argP;
+  benchmark_xact_h xactH = NULL;
+  int ret;
+
+  ret = start_xact(&xactH, "GROUP_REFRESH_TXN", benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = update_stocks_sorted(argsP->num_items, argsP->symbol_ids, argsP->prices,
+                             argsP->status_list, xactH, benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  return ret;
+
+ failXit:
+  if (xactH != NULL) {
+    abort_xact(xactH, benchmarkP);
+  }
+
+  return BENCHMARK_FAIL;
+}
+
+/* All or nothing: fails if any of the orders fails */
+static int
+group_orders_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  group_batch_t *batchP = argP;
+  group_item_t  *itemP;
+  benchmark_xact_h xactH = NULL;
+  int ret;
+
+  ret = start_xact(&xactH, "GROUP_ORDER_TXN", benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  for (itemP = batchP->headP; itemP != NULL; itemP = itemP->nextP) {
+    ret = group_order_apply(batchP->kind, itemP->entryP, xactH, benchmarkP);
+    if (ret != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+
+  ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  return ret;
+
+ failXit:
+  if (xactH != NULL) {
+    abort_xact(xactH, benchmarkP);
+  }
+
+  return BENCHMARK_FAIL;
+}
+
+typedef struct group_single_args_t {
+  int           kind;
+  group_item_t *itemP;
+} group_single_args_t;
+
+static int
+group_single_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  group_single_args_t *argsP = argP;
+
+  if (argsP->kind == GROUP_KIND_REFRESH) {
+    return update_stock_by_id(argsP->itemP->symbol_id, argsP->itemP->price, NULL, benchmarkP);
+  }
+
+  return group_order_apply(argsP->kind, argsP->itemP->entryP, NULL, benchmarkP);
+}
+
+static void
+group_apply_one_by_one(group_batch_t *batchP, BENCHMARK_DBS *benchmarkP)
+{
+  group_single_args_t args;
+  group_item_t *itemP;
+
+  args.kind = batchP->kind;
+  for (itemP = batchP->headP; itemP != NULL; itemP = itemP->nextP) {
+    args.itemP = itemP;
+    itemP->status = xact_retry_run(group_xact_types[batchP->kind], group_single_attempt, &args, benchmarkP);
+  }
+}
+
+static void
+group_refresh_apply(group_batch_t *batchP, BENCHMARK_DBS *benchmarkP)
+{
+  group_refresh_args_t args;
+  group_item_t *itemP;
+  int i;
+
+  args.num_items = batchP->num_items;
+  args.symbol_ids = thread_scratch_alloc(batchP->num_items * sizeof(u_int32_t));
+  args.prices = thread_scratch_alloc(batchP->num_items * sizeof(float));
+  args.status_list = thread_scratch_alloc(batchP->num_items * sizeof(int));
+  if (args.symbol_ids == NULL || args.prices == NULL || args.status_list == NULL) {
+    benchmark_error("Could not allocate batch of %d quotes", batchP->num_items);
+    goto one_by_one;
+  }
+
+  for (i = 0, itemP = batchP->headP; itemP != NULL; i++, itemP = itemP->nextP) {
+    args.symbol_ids[i] = itemP->symbol_id;
+    args.prices[i] = itemP->price;
+  }
+
+  if (xact_retry_run(BENCHMARK_XACT_REFRESH_QUOTES, group_refresh_attempt, &args, benchmarkP) != BENCHMARK_SUCCESS) {
+    goto one_by_one;
+  }
+
+  for (i = 0, itemP = batchP->headP; itemP != NULL; i++, itemP = itemP->nextP) {
+    itemP->status = args.status_list[i];
+  }
+
+  thread_scratch_free(args.status_list);
+  thread_scratch_free(args.prices);
+  thread_scratch_free(args.symbol_ids);
+  return;
+
+one_by_one:
+  thread_scratch_free(args.status_list);
+  thread_scratch_free(args.prices);
+  thread_scratch_free(args.symbol_ids);
+  group_apply_one_by_one(batchP, benchmarkP);
+}
+
+static void
+group_batch_apply(group_batch_t *batchP, BENCHMARK_DBS *benchmarkP)
+{
+  group_item_t *itemP;
+
+  if (batchP->num_items == 1) {
+    group_apply_one_by_one(batchP, benchmarkP);
+    return;
+  }
+
+  if (batchP->kind == GROUP_KIND_REFRESH) {
+    group_refresh_apply(batchP, benchmarkP);
+    return;
+  }
+
+  if (xact_retry_run(group_xact_types[batchP->kind], group_orders_attempt, batchP, benchmarkP) == BENCHMARK_SUCCESS) {
+    for (itemP = batchP->headP; itemP != NULL; itemP = itemP->nextP) {
+      itemP->status = BENCHMARK_SUCCESS;
+    }
+    return;
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Batch of %d orders failed, applying them one by one", batchP->num_items);
+  group_apply_one_by_one(batchP, benchmarkP);
+}
+
+static void
+group_deadline_get(u_int32_t window_usec, struct timespec *deadlineP)
+{
+  struct timeval now;
+  long nsec;
+
+  gettimeofday(&now, NULL);
+  nsec = now.tv_usec * 1000L + (long) (window_usec % 1000000) * 1000L;
+  deadlineP->tv_sec = now.tv_sec + window_usec / 1000000 + nsec / 1000000000L;
+  deadlineP->tv_nsec = nsec % 1000000000L;
+}
+
+/* Joins itemP to the open batch of its kind, or leads a new one.
+ * Returns the outcome of the item */
+static int
+group_commit_run(int kind, group_item_t *itemP, BENCHMARK_DBS *benchmarkP)
+{
+  group_commit_t *groupP = benchmarkP->group_commit;
+  group_batch_t   batch;
+  group_item_t   *memberP;
+  struct timespec deadline;
+  int rc;
+
+  itemP->nextP = NULL;
+  itemP->status = BENCHMARK_FAIL;
+  itemP->done = 0;
+
+  pthread_mutex_lock(&groupP->lock);
+
+  if (groupP->openP[kind] != NULL) {
+    *groupP->openP[kind]->tailPP = itemP;
+    groupP->openP[kind]->tailPP = &itemP->nextP;
+    groupP->openP[kind]->num_items ++;
+    if (groupP->openP[kind]->num_items >= groupP->max_batch) {
+      groupP->openP[kind] = NULL;
+      pthread_cond_broadcast(&groupP->full_cond);
+    }
+
+    while (!itemP->done) {
+      pthread_cond_wait(&groupP->done_cond, &groupP->lock);
+    }
+    pthread_mutex_unlock(&groupP->lock);
+
+    return itemP->status;
+  }
+
+  batch.kind = kind;
+  batch.num_items = 1;
+  batch.headP = itemP;
+  batch.tailPP = &itemP->nextP;
+  groupP->openP[kind] = &batch;
+
+  /* A member that fills the batch closes it */
+  group_deadline_get(groupP->window_usec, &deadline);
+  while (groupP->openP[kind] == &batch) {
+    rc = pthread_cond_timedwait(&groupP->full_cond, &groupP->lock, &deadline);
+    if (rc == ETIMEDOUT) {
+      break;
+    }
+  }
+  if (groupP->openP[kind] == &batch) {
+    groupP->openP[kind] = NULL;
+  }
+
+  groupP->batches ++;
+  groupP->items += batch.num_items;
+  if ((unsigned long) batch.num_items > groupP->largest) {
+    groupP->largest = batch.num_items;
+  }
+
+  pthread_mutex_unlock(&groupP->lock);
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "PID: %d, Applying batch of %d items", getpid(), batch.num_items);
+  group_batch_apply(&batch, benchmarkP);
+
+  rc = itemP->status;
+
+  pthread_mutex_lock(&groupP->lock);
+  for (memberP = batch.headP; memberP != NULL; memberP = memberP->nextP) {
+    memberP->done = 1;
+  }
+  pthread_cond_broadcast(&groupP->done_cond);
+  pthread_mutex_unlock(&groupP->lock);
+
+  return rc;
+}
+
+int
+group_commit_refresh(u_int32_t symbol_id, float price, BENCHMARK_DBS *benchmarkP)
+{
+  group_item_t item;
+
+  memset(&item, 0, sizeof(group_item_t));
+  item.symbol_id = symbol_id;
+  item.price = price;
+
+  return group_commit_run(GROUP_KIND_REFRESH, &item, benchmarkP);
+}
+
+int
+group_commit_order(int is_sell, benchmark_xact_data_t *entryP, BENCHMARK_DBS *benchmarkP)
+{
+  group_item_t item;
+
+  memset(&item, 0, sizeof(group_item_t));
+  item.entryP = entryP;
+
+  return group_commit_run(is_sell ? GROUP_KIND_SELL : GROUP_KIND_PURCHASE, &item, benchmarkP);
+}
+
+/* Sets up group commit, if the configuration asks for it */
+int
+group_commit_start(BENCHMARK_DBS *benchmarkP)
+{
+  group_commit_t *groupP = NULL;
+
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  if (benchmarkP->config.group_commit_max <= 1) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  groupP = calloc(1, sizeof(group_commit_t));
+  if (groupP == NULL) {
+    benchmark_error("Could not allocate group commit");
+    goto failXit;
+  }
+
+  pthread_mutex_init(&groupP->lock, NULL);
+  pthread_cond_init(&groupP->full_cond, NULL);
+  pthread_cond_init(&groupP->done_cond, NULL);
+  groupP->window_usec = benchmarkP->config.group_commit_window_usec;
+  groupP->max_batch = benchmarkP->config.group_commit_max;
+
+  benchmarkP->group_commit = groupP;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/* No call may be in flight */
+void
+group_commit_stop(BENCHMARK_DBS *benchmarkP)
+{
+  group_commit_t *groupP = benchmarkP->group_commit;
+
+  if (groupP == NULL) {
+    return;
+  }
+
+  benchmarkP->group_commit = NULL;
+
+  pthread_cond_destroy(&groupP->done_cond);
+  pthread_cond_destroy(&groupP->full_cond);
+  pthread_mutex_destroy(&groupP->lock);
+  free(groupP);
+}
+
+/* Batches applied, items in them, and the largest batch. All zero
+ * when group commit is disabled */
+int
+benchmark_group_commit_stats_get(void          *benchmark_handle,
+                                 unsigned long *batches,
+                                 unsigned long *items,
+                                 unsigned long *largest)
+{
+  BENCHMARK_DBS  *benchmarkP = benchmark_handle;
+  group_commit_t *groupP;
+
+  if (benchmarkP == NULL || batches == NULL || items == NULL || largest == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  *batches = *items = *largest = 0;
+
+  groupP = benchmarkP->group_commit;
+  if (groupP != NULL) {
+    pthread_mutex_lock(&groupP->lock);
+    *batches = groupP->batches;
+    *items = groupP->items;
+    *largest = groupP->largest;
+    pthread_mutex_unlock(&groupP->lock);
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
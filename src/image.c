@@ -0,0 +1,894 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  image.c
+ *
+ *    Description:  Binary image of the tables. The environment lives in
+ *                  memory only, so every process used to parse all the
+ *                  datafiles again. An image is written by scanning each
+ *                  table with bulk reads, and restored with bulk puts in
+ *                  the order the records were read. Every section of the
+ *                  image carries a CRC32 of its records.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <stddef.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define IMAGE_MAGIC         "CHRNIMG"
+#define IMAGE_VERSION       (1)
+
+/* Buffer of a bulk read. Must be a multiple of 1024 */
+#define IMAGE_READ_SIZE     (1024 * 1024)
+
+/* Buffer of the image file */
+#define IMAGE_WRITE_SIZE    (4 * 1024 * 1024)
+
+/* The Sequences table has no *_FLAG of its own */
+#define IMAGE_SEQUENCES     (0x0100)
+
+/* Symbol ids follow the order of the Stocks table, which a hash table
+ * need not give back the same after a restore. This section records
+ * the ids the other tables refer to, so the restore can check them */
+#define IMAGE_SYMBOLS       (0x0200)
+
+/* Records are copied as they are, so an image can only be restored
+ * by a build with the same record layouts */
+#define IMAGE_LAYOUTS       (6)
+
+/* Start of the image */
+typedef struct image_header_t {
+  char      magic[8];
+  u_int32_t version;
+  u_int32_t num_sections;
+  u_int32_t layout[IMAGE_LAYOUTS];
+  u_int32_t crc;            /* Of the header, with crc set to 0 */
+} image_header_t;
+
+/* Start of a section. It is followed by its records, each one being
+ * the key and data sizes followed by the key and the data */
+typedef struct image_section_t {
+  u_int32_t table;
+  u_int32_t crc;            /* Of the records */
+  u_int64_t records;
+  u_int64_t bytes;
+} image_section_t;
+
+/* A table of the image. Secondaries are not saved; Berkeley DB
+ * fills them in as their primary is restored */
+typedef struct image_table_t {
+  u_int32_t   table;
+  const char *name;
+  size_t      db_offset;    /* Of its handle in BENCHMARK_DBS */
+  u_int32_t   put_flags;
+} image_table_t;
+
+/* In the order they are saved and restored */
+static const image_table_t image_tables[] = {
+  { STOCKS_FLAG,      "Stocks",      offsetof(BENCHMARK_DBS, stocks_dbp),      DB_NOOVERWRITE },
+  { QUOTES_FLAG,      "Quotes",      offsetof(BENCHMARK_DBS, quotes_dbp),      DB_NOOVERWRITE },
+  { QUOTES_HIST_FLAG, "Quotes_hist", offsetof(BENCHMARK_DBS, quotes_hist_dbp), DB_NOOVERWRITE },
+  { PERSONAL_FLAG,    "Personal",    offsetof(BENCHMARK_DBS, personal_dbp),    DB_NOOVERWRITE },
+  { CURRENCIES_FLAG,  "Currencies",  offsetof(BENCHMARK_DBS, currencies_dbp),  0 },
+  { ACCOUNTS_FLAG,    "Accounts",    offsetof(BENCHMARK_DBS, accounts_dbp),    DB_NOOVERWRITE },
+  { PORTFOLIOS_FLAG,  "Portfolios",  offsetof(BENCHMARK_DBS, portfolios_dbp),  DB_NOOVERWRITE },
+  { IMAGE_SEQUENCES,  "Sequences",   offsetof(BENCHMARK_DBS, sequences_dbp),   0 }
+};
+
+#define IMAGE_TABLES  ((int) (sizeof(image_tables) / sizeof(image_tables[0])))
+
+#define IMAGE_DB(_benchmarkP, _tableP) \
+  (*(DB **)((char *)(_benchmarkP) + (_tableP)->db_offset))
+
+/* The section being written is checksummed as it goes */
+typedef struct image_writer_t {
+  FILE            *fileP;
+  const char      *path;
+  off_t            start;       /* Of the section header */
+  image_section_t  section;
+  u_int64_t        bytes;       /* Of the whole image */
+} image_writer_t;
+
+static u_int32_t      image_crc_table[256];
+static pthread_once_t image_crc_once = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+ *                          PROTOTYPES
+ *============================================================================*/
+static void
+image_crc_init(void);
+
+static u_int32_t
+image_crc(u_int32_t crc, const void *bufP, size_t len);
+
+static void
+image_header_init(image_header_t *headerP);
+
+static int
+image_header_check(datafile_t *imageP);
+
+static int
+image_write(image_writer_t *writerP, const void *bufP, size_t len);
+
+static int
+image_section_begin(image_writer_t *writerP, u_int32_t table);
+
+static int
+image_record_write(image_writer_t *writerP,
+                   const void     *keyP,
+                   u_int32_t       key_size,
+                   const void     *dataP,
+                   u_int32_t       data_size);
+
+static int
+image_section_end(image_writer_t *writerP);
+
+static int
+image_table_save(BENCHMARK_DBS       *benchmarkP,
+                 DB_TXN              *txnP,
+                 u_int32_t            cursor_flags,
+                 const image_table_t *tableP,
+                 DBT                 *bulkP,
+                 image_writer_t      *writerP);
+
+static int
+image_symbols_save(BENCHMARK_DBS *benchmarkP, image_writer_t *writerP);
+
+static int
+image_section_read(datafile_t      *imageP,
+                   size_t          *offsetP,
+                   image_section_t *sectionP,
+                   char           **posPP);
+
+static int
+image_record_next(char      **posPP,
+                  char       *endP,
+                  char      **keyPP,
+                  u_int32_t  *key_sizeP,
+                  char      **dataPP,
+                  u_int32_t  *data_sizeP);
+
+static int
+image_table_restore(BENCHMARK_DBS *benchmarkP,
+                    datafile_t    *imageP,
+                    size_t        *offsetP,
+                    u_int64_t     *recordsP);
+
+static int
+image_symbols_check(BENCHMARK_DBS *benchmarkP,
+                    datafile_t    *imageP,
+                    size_t        *offsetP);
+
+/*============================================================================
+ *                          CHECKSUMS
+ *============================================================================*/
+static void
+image_crc_init(void)
+{
+  u_int32_t crc;
+  int i, j;
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    image_crc_table[i] = crc;
+  }
+}
+
+/* CRC32 of len bytes, continuing from crc (0 to start) */
+static u_int32_t
+image_crc(u_int32_t crc, const void *bufP, size_t len)
+{
+  const unsigned char *p = bufP;
+
+  pthread_once(&image_crc_once, image_crc_init);
+
+  crc = ~crc;
+  while (len-- > 0) {
+    crc = image_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+/*============================================================================
+ *                          HEADER
+ *============================================================================*/
+static void
+image_header_init(image_header_t *headerP)
+{
+  memset(headerP, 0, sizeof(image_header_t));
+  memcpy(headerP->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+  headerP->version = IMAGE_VERSION;
+  headerP->num_sections = IMAGE_TABLES + 1;
+  headerP->layout[0] = sizeof(STOCK);
+  headerP->layout[1] = sizeof(QUOTE);
+  headerP->layout[2] = sizeof(PERSONAL);
+  headerP->layout[3] = sizeof(CURRENCY);
+  headerP->layout[4] = sizeof(PORTFOLIOS);
+  headerP->layout[5] = sizeof(QUOTES_HIST);
+  headerP->crc = image_crc(0, headerP, sizeof(image_header_t));
+}
+
+/*
+ * Checks that the image was written by this build. The version is
+ * read back in host byte order, so an image of a machine of the
+ * other endianness is refused too.
+ */
+static int
+image_header_check(datafile_t *imageP)
+{
+  image_header_t expected;
+  image_header_t header;
+
+  image_header_init(&expected);
+
+  if (imageP->size < sizeof(image_header_t)) {
+    benchmark_error("%s is not an image", imageP->path);
+    goto failXit;
+  }
+  memcpy(&header, imageP->baseP, sizeof(image_header_t));
+
+  if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+    benchmark_error("%s is not an image", imageP->path);
+    goto failXit;
+  }
+
+  if (header.version != expected.version) {
+    benchmark_error("Image %s has version %u, expected %u",
+                    imageP->path, header.version, expected.version);
+    goto failXit;
+  }
+
+  /* Same magic and version, so any other difference is the layout */
+  if (header.crc != expected.crc) {
+    benchmark_error("Image %s was written with other record layouts, or is damaged",
+                    imageP->path);
+    goto failXit;
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*============================================================================
+ *                          SAVE
+ *============================================================================*/
+static int
+image_write(image_writer_t *writerP, const void *bufP, size_t len)
+{
+  if (len > 0 && fwrite(bufP, 1, len, writerP->fileP) != len) {
+    benchmark_error("Could not write %s: %s", writerP->path, strerror(errno));
+    return BENCHMARK_FAIL;
+  }
+
+  writerP->bytes += len;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*
+ * Starts a section. Its header goes out with zero sizes now, and
+ * again with the real ones from image_section_end().
+ */
+static int
+image_section_begin(image_writer_t *writerP, u_int32_t table)
+{
+  memset(&writerP->section, 0, sizeof(image_section_t));
+  writerP->section.table = table;
+
+  writerP->start = ftello(writerP->fileP);
+  if (writerP->start < 0) {
+    benchmark_error("Could not write %s: %s", writerP->path, strerror(errno));
+    return BENCHMARK_FAIL;
+  }
+
+  return image_write(writerP, &writerP->section, sizeof(image_section_t));
+}
+
+static int
+image_record_write(image_writer_t *writerP,
+                   const void     *keyP,
+                   u_int32_t       key_size,
+                   const void     *dataP,
+                   u_int32_t       data_size)
+{
+  image_section_t *sectionP = &writerP->section;
+  u_int32_t sizes[2];
+
+  sizes[0] = key_size;
+  sizes[1] = data_size;
+
+  if (image_write(writerP, sizes, sizeof(sizes)) != BENCHMARK_SUCCESS
+      || image_write(writerP, keyP, key_size) != BENCHMARK_SUCCESS
+      || image_write(writerP, dataP, data_size) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  sectionP->crc = image_crc(sectionP->crc, sizes, sizeof(sizes));
+  sectionP->crc = image_crc(sectionP->crc, keyP, key_size);
+  sectionP->crc = image_crc(sectionP->crc, dataP, data_size);
+  sectionP->bytes += sizeof(sizes) + key_size + data_size;
+  sectionP->records ++;
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+image_section_end(image_writer_t *writerP)
+{
+  if (fseeko(writerP->fileP, writerP->start, SEEK_SET) != 0
+      || fwrite(&writerP->section, sizeof(image_section_t), 1, writerP->fileP) != 1
+      || fseeko(writerP->fileP, 0, SEEK_END) != 0) {
+    benchmark_error("Could not write %s: %s", writerP->path, strerror(errno));
+    return BENCHMARK_FAIL;
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+image_table_save(BENCHMARK_DBS       *benchmarkP,
+                 DB_TXN              *txnP,
+                 u_int32_t            cursor_flags,
+                 const image_table_t *tableP,
+                 DBT                 *bulkP,
+                 image_writer_t      *writerP)
+{
+  DB_ENV  *envP = benchmarkP->envP;
+  DB      *dbP = IMAGE_DB(benchmarkP, tableP);
+  DBC     *cursorP = NULL;
+  DBT      key;
+  void    *pointerP;
+  void    *keyP;
+  void    *dataP;
+  void    *newP;
+  u_int32_t key_size;
+  u_int32_t data_size;
+  u_int32_t ulen;
+  int      ret;
+
+  if (dbP == NULL) {
+    benchmark_error("%s table is not open", tableP->name);
+    goto failXit;
+  }
+
+  if (image_section_begin(writerP, tableP->table) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = dbP->cursor(dbP, txnP, &cursorP, cursor_flags);
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for %s.", __FILE__, __LINE__, getpid(), tableP->name);
+    goto failXit;
+  }
+
+  for (;;) {
+    memset(&key, 0, sizeof(DBT));
+    ret = cursorP->get(cursorP, &key, bulkP, DB_MULTIPLE_KEY | DB_NEXT);
+    if (ret == DB_BUFFER_SMALL) {
+      /* A record larger than the whole buffer */
+      ulen = (bulkP->size + 1023) & ~1023;
+      newP = realloc(bulkP->data, ulen);
+      if (newP == NULL) {
+        benchmark_error("Could not allocate bulk buffer");
+        goto failXit;
+      }
+      bulkP->data = newP;
+      bulkP->ulen = ulen;
+      continue;
+    }
+    if (ret != 0) {
+      break;
+    }
+
+    DB_MULTIPLE_INIT(pointerP, bulkP);
+    for (;;) {
+      DB_MULTIPLE_KEY_NEXT(pointerP, bulkP, keyP, key_size, dataP, data_size);
+      if (pointerP == NULL) {
+        break;
+      }
+
+      if (image_record_write(writerP, keyP, key_size, dataP, data_size) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+  }
+
+  if (ret != DB_NOTFOUND) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to iterate over %s.", __FILE__, __LINE__, getpid(), tableP->name);
+    goto failXit;
+  }
+
+  ret = cursorP->close(cursorP);
+  cursorP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  if (image_section_end(writerP) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  benchmark_debug(1, "Saved %lu records of %s", (unsigned long) writerP->section.records, tableP->name);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (cursorP != NULL) {
+    cursorP->close(cursorP);
+  }
+  return BENCHMARK_FAIL;
+}
+
+/* The symbol of each symbol id, in id order */
+static int
+image_symbols_save(BENCHMARK_DBS *benchmarkP, image_writer_t *writerP)
+{
+  const char *symbolP;
+  u_int32_t symbol_id;
+
+  if (image_section_begin(writerP, IMAGE_SYMBOLS) != BENCHMARK_SUCCESS) {
+    return BENCHMARK_FAIL;
+  }
+
+  for (symbol_id = 0; symbol_id < (u_int32_t) benchmarkP->number_stocks; symbol_id++) {
+    symbolP = symbol_dict_name(symbol_id, benchmarkP);
+    if (image_record_write(writerP, &symbol_id, sizeof(u_int32_t),
+                           symbolP, (u_int32_t) strlen(symbolP) + 1) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return image_section_end(writerP);
+}
+
+/*
+ * Writes every table to an image at path. The tables are read in one
+ * transaction; with snapshot reads configured it sees a consistent
+ * state, otherwise the image is only consistent if nothing writes
+ * meanwhile. The image is written next to path and renamed over it
+ * once complete.
+ */
+int
+benchmark_image_save(void *benchmark_handle, const char *path)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  DB_ENV  *envP = NULL;
+  DB_TXN  *txnP = NULL;
+  DBT      bulk;
+  image_header_t header;
+  image_writer_t writer;
+  char    *tmp_path = NULL;
+  int      isolation;
+  int      size;
+  int      ret;
+  int      i;
+
+  memset(&bulk, 0, sizeof(DBT));
+  memset(&writer, 0, sizeof(image_writer_t));
+
+  if (benchmarkP == NULL || path == NULL || path[0] == '\0') {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  envP = benchmarkP->envP;
+  if (envP == NULL) {
+    benchmark_error("Environment is not open");
+    goto failXit;
+  }
+
+  size = strlen(path) + strlen(".tmp") + 1;
+  tmp_path = malloc(size);
+  if (tmp_path == NULL) {
+    benchmark_error("Failed to allocate memory.");
+    goto failXit;
+  }
+  snprintf(tmp_path, size, "%s.tmp", path);
+
+  bulk.data = malloc(IMAGE_READ_SIZE);
+  if (bulk.data == NULL) {
+    benchmark_error("Could not allocate bulk buffer");
+    goto failXit;
+  }
+  bulk.ulen = IMAGE_READ_SIZE;
+  bulk.flags = DB_DBT_USERMEM;
+
+  writer.path = tmp_path;
+  writer.fileP = fopen(tmp_path, "wb");
+  if (writer.fileP == NULL) {
+    benchmark_error("Could not create %s: %s", tmp_path, strerror(errno));
+    goto failXit;
+  }
+  setvbuf(writer.fileP, NULL, _IOFBF, IMAGE_WRITE_SIZE);
+
+  image_header_init(&header);
+  if (image_write(&writer, &header, sizeof(header)) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  isolation = benchmarkP->config.snapshot_reads ? BENCHMARK_ISOLATION_SNAPSHOT
+                                                : BENCHMARK_ISOLATION_COMMITTED;
+
+  ret = envP->txn_begin(envP, NULL, &txnP, read_xact_flags(isolation));
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  for (i = 0; i < IMAGE_TABLES; i++) {
+    if (image_table_save(benchmarkP, txnP, read_cursor_flags(isolation),
+                         &image_tables[i], &bulk, &writer) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+
+  ret = txnP->commit(txnP, 0);
+  txnP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction commit failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  if (image_symbols_save(benchmarkP, &writer) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  ret = fclose(writer.fileP);
+  writer.fileP = NULL;
+  if (ret != 0) {
+    benchmark_error("Could not write %s: %s", tmp_path, strerror(errno));
+    unlink(tmp_path);
+    goto failXit;
+  }
+
+  if (rename(tmp_path, path) != 0) {
+    benchmark_error("Could not rename %s to %s: %s", tmp_path, path, strerror(errno));
+    unlink(tmp_path);
+    goto failXit;
+  }
+
+  benchmark_info("Saved image of %.1f MB to %s", writer.bytes / (1024.0 * 1024.0), path);
+
+  free(bulk.data);
+  free(tmp_path);
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (txnP != NULL) {
+    txnP->abort(txnP);
+  }
+  if (writer.fileP != NULL) {
+    fclose(writer.fileP);
+    unlink(tmp_path);
+  }
+  free(bulk.data);
+  free(tmp_path);
+  return BENCHMARK_FAIL;
+}
+
+/*============================================================================
+ *                          RESTORE
+ *============================================================================*/
+
+/*
+ * Reads the section header at *offsetP and checks the checksum of its
+ * records, leaving *offsetP past the section and *posPP at its first
+ * record.
+ */
+static int
+image_section_read(datafile_t      *imageP,
+                   size_t          *offsetP,
+                   image_section_t *sectionP,
+                   char           **posPP)
+{
+  size_t offset = *offsetP;
+
+  if (imageP->size - offset < sizeof(image_section_t)) {
+    benchmark_error("Image %s is truncated", imageP->path);
+    return BENCHMARK_FAIL;
+  }
+  memcpy(sectionP, imageP->baseP + offset, sizeof(image_section_t));
+  offset += sizeof(image_section_t);
+
+  if (sectionP->bytes > imageP->size - offset) {
+    benchmark_error("Image %s is truncated", imageP->path);
+    return BENCHMARK_FAIL;
+  }
+
+  if (image_crc(0, imageP->baseP + offset, sectionP->bytes) != sectionP->crc) {
+    benchmark_error("Checksum of section %u of image %s does not match",
+                    sectionP->table, imageP->path);
+    return BENCHMARK_FAIL;
+  }
+
+  *posPP = imageP->baseP + offset;
+  *offsetP = offset + sectionP->bytes;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* Returns BENCHMARK_FAIL if the record does not fit before endP */
+static int
+image_record_next(char      **posPP,
+                  char       *endP,
+                  char      **keyPP,
+                  u_int32_t  *key_sizeP,
+                  char      **dataPP,
+                  u_int32_t  *data_sizeP)
+{
+  char *posP = *posPP;
+  u_int32_t sizes[2];
+
+  if ((size_t) (endP - posP) < sizeof(sizes)) {
+    return BENCHMARK_FAIL;
+  }
+  memcpy(sizes, posP, sizeof(sizes));
+  posP += sizeof(sizes);
+
+  if ((size_t) sizes[0] + sizes[1] > (size_t) (endP - posP)) {
+    return BENCHMARK_FAIL;
+  }
+
+  *keyPP = posP;
+  *key_sizeP = sizes[0];
+  *dataPP = posP + sizes[0];
+  *data_sizeP = sizes[1];
+  *posPP = posP + sizes[0] + sizes[1];
+
+  return BENCHMARK_SUCCESS;
+}
+
+static int
+image_table_restore(BENCHMARK_DBS *benchmarkP,
+                    datafile_t    *imageP,
+                    size_t        *offsetP,
+                    u_int64_t     *recordsP)
+{
+  const image_table_t *tableP = NULL;
+  image_section_t section;
+  load_batch_t batch;
+  char      *posP;
+  char      *endP;
+  char      *keyP;
+  char      *dataP;
+  u_int32_t  key_size;
+  u_int32_t  data_size;
+  u_int64_t  i;
+
+  memset(&batch, 0, sizeof(load_batch_t));
+
+  if (image_section_read(imageP, offsetP, &section, &posP) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  endP = posP + section.bytes;
+
+  for (i = 0; i < IMAGE_TABLES; i++) {
+    if (image_tables[i].table == section.table) {
+      tableP = &image_tables[i];
+      break;
+    }
+  }
+  if (tableP == NULL) {
+    benchmark_error("Image %s holds an unknown table %u", imageP->path, section.table);
+    goto failXit;
+  }
+
+  if (load_batch_init(&batch, benchmarkP, IMAGE_DB(benchmarkP, tableP),
+                      tableP->name, tableP->put_flags) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  batch.quiet = 1;
+
+  for (i = 0; i < section.records; i++) {
+    if (image_record_next(&posP, endP, &keyP, &key_size, &dataP, &data_size) != BENCHMARK_SUCCESS) {
+      break;
+    }
+
+    if (load_batch_add(&batch, keyP, key_size, dataP, data_size) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+
+  if (i < section.records || posP != endP) {
+    benchmark_error("Records of %s in image %s are malformed", tableP->name, imageP->path);
+    goto failXit;
+  }
+
+  if (load_batch_finish(&batch) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  *recordsP += section.records;
+
+  benchmark_debug(1, "Restored %lu records of %s", (unsigned long) section.records, tableP->name);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  free(batch.bulk.data);
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Checks that the symbol dictionary built from the restored Stocks
+ * table gives every symbol the id the restored tables use.
+ */
+static int
+image_symbols_check(BENCHMARK_DBS *benchmarkP,
+                    datafile_t    *imageP,
+                    size_t        *offsetP)
+{
+  image_section_t section;
+  const char *symbolP;
+  char      *posP;
+  char      *endP;
+  char      *keyP;
+  char      *dataP;
+  u_int32_t  key_size;
+  u_int32_t  data_size;
+  u_int32_t  symbol_id;
+  u_int64_t  i;
+
+  if (image_section_read(imageP, offsetP, &section, &posP) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+  endP = posP + section.bytes;
+
+  if (section.table != IMAGE_SYMBOLS || section.records != (u_int64_t) benchmarkP->number_stocks) {
+    benchmark_error("Image %s does not list the %d symbols of its Stocks table",
+                    imageP->path, benchmarkP->number_stocks);
+    goto failXit;
+  }
+
+  for (i = 0; i < section.records; i++) {
+    if (image_record_next(&posP, endP, &keyP, &key_size, &dataP, &data_size) != BENCHMARK_SUCCESS
+        || key_size != sizeof(u_int32_t) || data_size == 0 || dataP[data_size - 1] != '\0') {
+      benchmark_error("Symbols in image %s are malformed", imageP->path);
+      goto failXit;
+    }
+    memcpy(&symbol_id, keyP, sizeof(u_int32_t));
+
+    symbolP = symbol_dict_name(symbol_id, benchmarkP);
+    if (symbolP == NULL || strcmp(symbolP, dataP) != 0) {
+      benchmark_error("Symbol %s does not get id %u back; restore with the access method the image was saved with",
+                      dataP, symbol_id);
+      goto failXit;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/*
+ * Same as benchmark_initial_load2(), but the tables are restored from
+ * an image written by benchmark_image_save() instead of the datafiles.
+ * The portfolio id sequence is restored too, so new portfolios don't
+ * reuse the ids of the restored ones.
+ */
+void *
+benchmark_image_load(const char *program,
+                     const char *homedir,
+                     const char *path,
+                     void       *config_handle)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  datafile_t image;
+  struct timeval start, end;
+  u_int64_t records = 0;
+  size_t offset;
+  int ret;
+  int i;
+
+  memset(&image, 0, sizeof(datafile_t));
+  image.fd = -1;
+
+  assert(homedir != NULL && homedir[0] != '\0');
+
+  if (path == NULL || path[0] == '\0') {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  gettimeofday(&start, NULL);
+
+  if (datafile_open(path, &image) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  if (image_header_check(&image) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  if (benchmark_handle_alloc2((void **) &benchmarkP, 1, program, homedir, NULL, config_handle) != BENCHMARK_SUCCESS) {
+    benchmark_error("Failed to allocate handle");
+    goto failXit;
+  }
+
+  /* The sequence caches ids, so it is reopened on the restored record */
+  if (portfolio_seq_close(benchmarkP) != 0) {
+    goto failXit;
+  }
+
+  benchmark_info("-- Restoring databases from: %s... ", path);
+
+  offset = sizeof(image_header_t);
+  for (i = 0; i < IMAGE_TABLES; i++) {
+    if (image_table_restore(benchmarkP, &image, &offset, &records) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+
+  if (portfolio_seq_open(benchmarkP) != 0) {
+    goto failXit;
+  }
+
+  ret = symbol_dict_load(benchmarkP);
+  if (ret) {
+    benchmark_error("Error building symbol dictionary.");
+    goto failXit;
+  }
+
+  if (image_symbols_check(benchmarkP, &image, &offset) != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  if (offset != image.size) {
+    benchmark_error("Image %s has trailing data", path);
+    goto failXit;
+  }
+
+  datafile_close(&image);
+
+  /* The handle was built over empty tables. Group commit and the
+   * order workers it started don't depend on their contents */
+  ret = quote_cache_load(benchmarkP);
+  if (ret) {
+    benchmark_error("Error loading quote cache.");
+    goto failXit;
+  }
+
+  ret = catalog_freeze(benchmarkP);
+  if (ret) {
+    benchmark_error("Error freezing catalog.");
+    goto failXit;
+  }
+
+  BENCHMARK_CLEAR_CREATE_DB(benchmarkP);
+
+  gettimeofday(&end, NULL);
+  benchmark_info("Restored %lu records in %.2f s", (unsigned long) records,
+                 (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0);
+
+  return benchmarkP;
+
+failXit:
+  datafile_close(&image);
+
+  if (benchmarkP != NULL && benchmark_handle_free(benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("Failed to free handle");
+  }
+
+  return NULL;
+}
@@ -0,0 +1,586 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ingest.c
+ *
+ *    Description:  Replay of a stream of quote ticks. The calling thread
+ *                  reads the stream, parses the ticks and resolves their
+ *                  symbols, and hands them to an applier thread through a
+ *                  single producer, single consumer ring. The applier
+ *                  takes whatever is pending, up to batch_max ticks, and
+ *                  applies it as one sorted batch update of Quotes.
+ *
+ *                  There is a single applier, so the ticks of a symbol
+ *                  are applied in the order of the stream.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include "benchmark.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+/* Buffer of the reads. A text line must fit in it */
+#define INGEST_READ_SIZE    (1024 * 1024)
+
+/* Fields of a text tick */
+#define TICK_SYMBOL     0
+#define TICK_PRICE      1
+#define TICK_BID        2
+#define TICK_ASK        3
+#define TICK_VOLUME     4
+#define TICK_TIMESTAMP  5
+
+typedef struct ingest_t {
+  BENCHMARK_DBS    *benchmarkP;
+
+  /* The reader writes at head and the applier takes at tail. Each
+   * one only moves its own index */
+  quote_tick_t     *ringP;
+  unsigned long     ring_mask;
+  unsigned long     head;
+  unsigned long     tail;
+
+  /* A side that finds the ring full, or empty, sleeps on lock. The
+   * other side looks at its flag after it moves its index */
+  pthread_mutex_t   lock;
+  pthread_cond_t    not_full;
+  pthread_cond_t    not_empty;
+  int               reader_waiting;
+  int               applier_waiting;
+  int               eof;
+  int               failed;
+
+  /* Applier */
+  pthread_t         thread;
+  void             *ctxH;
+  int               batch_max;
+  quote_tick_t     *batchP;
+  int              *status_list;
+  unsigned long     applied;
+  unsigned long     batches;
+
+  /* Reader */
+  unsigned long     parsed;
+  unsigned long     malformed;
+  unsigned long     unknown;
+  struct timespec   start;
+  struct timespec   last_report;
+} ingest_t;
+
+typedef struct ingest_batch_args_t {
+  int                 num_ticks;
+  const quote_tick_t *ticks;
+  int                *status_list;
+} ingest_batch_args_t;
+
+static double
+ingest_elapsed(const struct timespec *startP, const struct timespec *endP)
+{
+  return (endP->tv_sec - startP->tv_sec) + (endP->tv_nsec - startP->tv_nsec) / 1e9;
+}
+
+/* Each batch runs in a transaction of its own */
+static int
+ingest_batch_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  ingest_batch_args_t *argsP = argP;
+
+  return update_stocks_ticks(argsP->num_ticks, argsP->ticks,
+                             argsP->status_list, NULL, benchmarkP);
+}
+
+/* Takes up to batch_max ticks, waiting for some unless the stream has
+ * ended. Returns 0 once the ring is empty and the stream has ended */
+static int
+ingest_take(ingest_t *ingestP)
+{
+  unsigned long head;
+  unsigned long tail = ingestP->tail;
+  unsigned long count;
+  unsigned long i;
+
+  head = __atomic_load_n(&ingestP->head, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    pthread_mutex_lock(&ingestP->lock);
+    __atomic_store_n(&ingestP->applier_waiting, 1, __ATOMIC_SEQ_CST);
+    while ((head = __atomic_load_n(&ingestP->head, __ATOMIC_SEQ_CST)) == tail
+           && !ingestP->eof) {
+      pthread_cond_wait(&ingestP->not_empty, &ingestP->lock);
+    }
+    __atomic_store_n(&ingestP->applier_waiting, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ingestP->lock);
+
+    if (head == tail) {
+      return 0;
+    }
+  }
+
+  count = head - tail;
+  if (count > (unsigned long) ingestP->batch_max) {
+    count = ingestP->batch_max;
+  }
+
+  for (i = 0; i < count; i++) {
+    ingestP->batchP[i] = ingestP->ringP[(tail + i) & ingestP->ring_mask];
+  }
+
+  /* The slots are free as soon as they are copied */
+  __atomic_store_n(&ingestP->tail, tail + count, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ingestP->reader_waiting, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&ingestP->lock);
+    pthread_cond_signal(&ingestP->not_full);
+    pthread_mutex_unlock(&ingestP->lock);
+  }
+
+  return (int) count;
+}
+
+static void *
+ingest_applier_main(void *argP)
+{
+  ingest_t *ingestP = argP;
+  BENCHMARK_DBS *benchmarkP;
+  ingest_batch_args_t args;
+  int num_ticks;
+  int rc;
+  int i;
+
+  while ((num_ticks = ingest_take(ingestP)) > 0) {
+    benchmarkP = thread_ctx_enter(ingestP->ctxH);
+
+    args.num_ticks = num_ticks;
+    args.ticks = ingestP->batchP;
+    args.status_list = ingestP->status_list;
+    rc = xact_retry_run(BENCHMARK_XACT_REFRESH_QUOTES, ingest_batch_attempt, &args, benchmarkP);
+
+    thread_ctx_leave();
+
+    if (rc != BENCHMARK_SUCCESS) {
+      benchmark_error("Could not apply a batch of %d ticks", num_ticks);
+      pthread_mutex_lock(&ingestP->lock);
+      __atomic_store_n(&ingestP->failed, 1, __ATOMIC_SEQ_CST);
+      pthread_cond_signal(&ingestP->not_full);
+      pthread_mutex_unlock(&ingestP->lock);
+      break;
+    }
+
+    for (i = 0; i < num_ticks; i++) {
+      if (ingestP->status_list[i] == BENCHMARK_SUCCESS) {
+        __atomic_add_fetch(&ingestP->applied, 1, __ATOMIC_RELAXED);
+      }
+    }
+    ingestP->batches ++;
+  }
+
+  return NULL;
+}
+
+/* Returns BENCHMARK_FAIL if the applier has stopped */
+static int
+ingest_push(ingest_t *ingestP, const quote_tick_t *tickP)
+{
+  unsigned long head = ingestP->head;
+  unsigned long size = ingestP->ring_mask + 1;
+
+  if (head - __atomic_load_n(&ingestP->tail, __ATOMIC_ACQUIRE) == size) {
+    pthread_mutex_lock(&ingestP->lock);
+    __atomic_store_n(&ingestP->reader_waiting, 1, __ATOMIC_SEQ_CST);
+    while (head - __atomic_load_n(&ingestP->tail, __ATOMIC_SEQ_CST) == size
+           && !ingestP->failed) {
+      pthread_cond_wait(&ingestP->not_full, &ingestP->lock);
+    }
+    __atomic_store_n(&ingestP->reader_waiting, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ingestP->lock);
+  }
+
+  if (__atomic_load_n(&ingestP->failed, __ATOMIC_SEQ_CST)) {
+    return BENCHMARK_FAIL;
+  }
+
+  ingestP->ringP[head & ingestP->ring_mask] = *tickP;
+  __atomic_store_n(&ingestP->head, head + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ingestP->applier_waiting, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&ingestP->lock);
+    pthread_cond_signal(&ingestP->not_empty);
+    pthread_mutex_unlock(&ingestP->lock);
+  }
+
+  ingestP->parsed ++;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* Prints the progress line, at most once a second unless final */
+static void
+ingest_report(ingest_t *ingestP, int final)
+{
+  struct timespec now;
+  unsigned long applied;
+  unsigned long backlog;
+  double seconds;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (!final && ingest_elapsed(&ingestP->last_report, &now) < 1.0) {
+    return;
+  }
+  ingestP->last_report = now;
+
+  applied = __atomic_load_n(&ingestP->applied, __ATOMIC_RELAXED);
+  backlog = ingestP->head - __atomic_load_n(&ingestP->tail, __ATOMIC_RELAXED);
+  seconds = ingest_elapsed(&ingestP->start, &now);
+
+  fprintf(stderr, "\rIngested: %lu ticks (%.0f ticks/s), backlog: %lu%s",
+          applied, seconds > 0 ? applied / seconds : 0.0, backlog,
+          final ? "\n" : "");
+}
+
+/* Resolves the symbol of a tick. Unknown symbols are counted and
+ * skipped */
+static int
+ingest_symbol(ingest_t *ingestP, const char *symbol, quote_tick_t *tickP)
+{
+  if (symbol_dict_lookup(symbol, &tickP->symbol_id, ingestP->benchmarkP) != BENCHMARK_SUCCESS) {
+    ingestP->unknown ++;
+    return BENCHMARK_FAIL;
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* Parses the complete lines of a buffer. Returns BENCHMARK_FAIL if
+ * the applier has stopped */
+static int
+ingest_text(ingest_t *ingestP, char *bufP, size_t len)
+{
+  datafile_t file;
+  datafile_cursor_t cursor;
+  quote_tick_t tick;
+  char symbol[sizeof(((benchmark_tick_t *)0)->symbol)];
+  long value;
+
+  memset(&file, 0, sizeof(datafile_t));
+  file.path = "ticks";
+  file.fd = -1;
+  file.baseP = bufP;
+  file.size = len;
+
+  datafile_cursor_init(&file, 0, len, &cursor);
+  while (datafile_cursor_next(&cursor)) {
+    memset(&tick, 0, sizeof(quote_tick_t));
+    tick.bid = -1;
+    tick.ask = -1;
+    tick.volume = -1;
+
+    cursor.truncated = 0;
+    datafile_field_copy(&cursor, TICK_SYMBOL, symbol, sizeof(symbol));
+    if (symbol[0] == '\0' || cursor.truncated > 0
+        || !datafile_field_known(&cursor, TICK_PRICE)
+        || datafile_field_float(&cursor, TICK_PRICE, &tick.price) != BENCHMARK_SUCCESS
+        || tick.price < 0
+        || (datafile_field_known(&cursor, TICK_BID)
+            && datafile_field_float(&cursor, TICK_BID, &tick.bid) != BENCHMARK_SUCCESS)
+        || (datafile_field_known(&cursor, TICK_ASK)
+            && datafile_field_float(&cursor, TICK_ASK, &tick.ask) != BENCHMARK_SUCCESS)
+        || (datafile_field_known(&cursor, TICK_VOLUME)
+            && datafile_field_long(&cursor, TICK_VOLUME, &tick.volume) != BENCHMARK_SUCCESS)) {
+      ingestP->malformed ++;
+      continue;
+    }
+
+    if (datafile_field_known(&cursor, TICK_TIMESTAMP)) {
+      if (datafile_field_long(&cursor, TICK_TIMESTAMP, &value) != BENCHMARK_SUCCESS) {
+        ingestP->malformed ++;
+        continue;
+      }
+      tick.timestamp = (time_t) value;
+    }
+
+    if (ingest_symbol(ingestP, symbol, &tick) != BENCHMARK_SUCCESS) {
+      continue;
+    }
+
+    if (ingest_push(ingestP, &tick) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* Parses the records of a buffer, which holds whole records only */
+static int
+ingest_binary(ingest_t *ingestP, const char *bufP, size_t len)
+{
+  benchmark_tick_t record;
+  quote_tick_t tick;
+  size_t offset;
+
+  for (offset = 0; offset + sizeof(benchmark_tick_t) <= len; offset += sizeof(benchmark_tick_t)) {
+    memcpy(&record, bufP + offset, sizeof(benchmark_tick_t));
+
+    if (memchr(record.symbol, '\0', sizeof(record.symbol)) == NULL
+        || record.symbol[0] == '\0' || !(record.price >= 0)) {
+      ingestP->malformed ++;
+      continue;
+    }
+
+    memset(&tick, 0, sizeof(quote_tick_t));
+    tick.price = record.price;
+    tick.bid = record.bid;
+    tick.ask = record.ask;
+    tick.volume = (long) record.volume;
+    tick.timestamp = record.timestamp > 0 ? (time_t) record.timestamp : 0;
+
+    if (ingest_symbol(ingestP, record.symbol, &tick) != BENCHMARK_SUCCESS) {
+      continue;
+    }
+
+    if (ingest_push(ingestP, &tick) != BENCHMARK_SUCCESS) {
+      return BENCHMARK_FAIL;
+    }
+  }
+
+  return BENCHMARK_SUCCESS;
+}
+
+/* Length of the complete lines at the start of the buffer */
+static size_t
+ingest_lines_len(const char *bufP, size_t used)
+{
+  size_t len;
+
+  for (len = used; len > 0 && bufP[len - 1] != '\n'; len--)
+    ;
+
+  return len;
+}
+
+/*
+ * Reads the stream until its end. The part of the buffer after the
+ * last complete line, or record, waits for the next read. A text
+ * line that does not fit in the buffer is dropped as malformed.
+ */
+static int
+ingest_read(ingest_t *ingestP, int fd, int format)
+{
+  char *bufP = NULL;
+  char *nlP;
+  size_t used = 0;
+  size_t complete;
+  ssize_t nread;
+  int skip_line = 0;
+  int eof = 0;
+
+  bufP = malloc(INGEST_READ_SIZE);
+  if (bufP == NULL) {
+    benchmark_error("Could not allocate read buffer");
+    goto failXit;
+  }
+
+  while (!eof) {
+    nread = read(fd, bufP + used, INGEST_READ_SIZE - used);
+    if (nread < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      benchmark_error("Could not read ticks: %s", strerror(errno));
+      goto failXit;
+    }
+
+    used += nread;
+    eof = (nread == 0);
+
+    if (format == BENCHMARK_TICKS_BINARY) {
+      complete = used - used % sizeof(benchmark_tick_t);
+      if (eof && complete < used) {
+        ingestP->malformed ++;
+        complete = used;
+      }
+      if (ingest_binary(ingestP, bufP, complete) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+    else {
+      /* Drop the rest of a line that did not fit */
+      if (skip_line) {
+        nlP = memchr(bufP, '\n', used);
+        complete = (nlP == NULL) ? used : (size_t) (nlP + 1 - bufP);
+        memmove(bufP, bufP + complete, used - complete);
+        used -= complete;
+        skip_line = (nlP == NULL);
+      }
+
+      /* Whatever is left is the last line once the stream ends */
+      complete = eof ? used : ingest_lines_len(bufP, used);
+      if (complete == 0 && used == INGEST_READ_SIZE) {
+        ingestP->malformed ++;
+        skip_line = 1;
+        complete = used;
+      }
+      else if (ingest_text(ingestP, bufP, complete) != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+
+    memmove(bufP, bufP + complete, used - complete);
+    used -= complete;
+
+    ingest_report(ingestP, 0);
+  }
+
+  free(bufP);
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  free(bufP);
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_ingest_run(void           *benchmark_handle,
+                     const char     *path,
+                     int             format,
+                     unsigned long  *applied,
+                     unsigned long  *rejected)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  ingest_t *ingestP = NULL;
+  unsigned long ring_size;
+  int started = 0;
+  int fd = -1;
+  int rc = BENCHMARK_FAIL;
+
+  if (benchmarkP == NULL || path == NULL
+      || (format != BENCHMARK_TICKS_TEXT && format != BENCHMARK_TICKS_BINARY)) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  if (strcmp(path, "-") == 0) {
+    fd = STDIN_FILENO;
+  }
+  else {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      benchmark_error("Could not open %s: %s", path, strerror(errno));
+      goto failXit;
+    }
+  }
+
+  ingestP = calloc(1, sizeof(ingest_t));
+  if (ingestP == NULL) {
+    benchmark_error("Could not allocate ingest state");
+    goto failXit;
+  }
+
+  ingestP->benchmarkP = benchmarkP;
+  ingestP->batch_max = benchmarkP->config.ingest_batch_max;
+  pthread_mutex_init(&ingestP->lock, NULL);
+  pthread_cond_init(&ingestP->not_full, NULL);
+  pthread_cond_init(&ingestP->not_empty, NULL);
+
+  for (ring_size = 1; ring_size < (unsigned long) benchmarkP->config.ingest_ring_size; ring_size <<= 1)
+    ;
+  ingestP->ring_mask = ring_size - 1;
+
+  ingestP->ringP = malloc(ring_size * sizeof(quote_tick_t));
+  ingestP->batchP = malloc(ingestP->batch_max * sizeof(quote_tick_t));
+  ingestP->status_list = malloc(ingestP->batch_max * sizeof(int));
+  if (ingestP->ringP == NULL || ingestP->batchP == NULL || ingestP->status_list == NULL
+      || benchmark_thread_ctx_alloc(benchmarkP, 0, &ingestP->ctxH) != BENCHMARK_SUCCESS) {
+    benchmark_error("Could not set up a ring of %lu ticks", ring_size);
+    goto failXit;
+  }
+
+  if (pthread_create(&ingestP->thread, NULL, ingest_applier_main, ingestP) != 0) {
+    benchmark_error("Could not start the tick applier");
+    goto failXit;
+  }
+  started = 1;
+
+  clock_gettime(CLOCK_MONOTONIC, &ingestP->start);
+  ingestP->last_report = ingestP->start;
+
+  rc = ingest_read(ingestP, fd, format);
+
+  /* The applier stops once it has taken every tick pushed */
+  pthread_mutex_lock(&ingestP->lock);
+  ingestP->eof = 1;
+  pthread_cond_signal(&ingestP->not_empty);
+  pthread_mutex_unlock(&ingestP->lock);
+  pthread_join(ingestP->thread, NULL);
+  started = 0;
+
+  ingest_report(ingestP, 1);
+
+  if (ingestP->failed) {
+    rc = BENCHMARK_FAIL;
+  }
+
+  if (ingestP->malformed > 0 || ingestP->unknown > 0) {
+    benchmark_warning("Skipped %lu malformed ticks and %lu ticks of unknown symbols",
+                      ingestP->malformed, ingestP->unknown);
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "Applied %lu of %lu ticks in %lu batches",
+                  ingestP->applied, ingestP->parsed, ingestP->batches);
+
+  if (applied != NULL) {
+    *applied = ingestP->applied;
+  }
+  if (rejected != NULL) {
+    *rejected = ingestP->malformed + ingestP->unknown;
+  }
+
+  if (rc != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  rc = BENCHMARK_SUCCESS;
+  goto cleanup;
+
+failXit:
+  if (started) {
+    pthread_mutex_lock(&ingestP->lock);
+    ingestP->eof = 1;
+    pthread_cond_signal(&ingestP->not_empty);
+    pthread_mutex_unlock(&ingestP->lock);
+    pthread_join(ingestP->thread, NULL);
+  }
+
+  rc = BENCHMARK_FAIL;
+
+cleanup:
+  if (ingestP != NULL) {
+    if (ingestP->ctxH != NULL) {
+      benchmark_thread_ctx_free(ingestP->ctxH);
+    }
+    free(ingestP->status_list);
+    free(ingestP->batchP);
+    free(ingestP->ringP);
+    pthread_cond_destroy(&ingestP->not_empty);
+    pthread_cond_destroy(&ingestP->not_full);
+    pthread_mutex_destroy(&ingestP->lock);
+    free(ingestP);
+  }
+
+  if (fd >= 0 && fd != STDIN_FILENO) {
+    close(fd);
+  }
+
+  return rc;
+}
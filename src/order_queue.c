@@ -0,0 +1,583 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  order_queue.c
+ *
+ *    Description:  Asynchronous purchase and sell packets. Callers submit
+ *                  a packet and return right away; a pool of worker
+ *                  threads owned by the handle applies it later.
+ *
+ *                  Submitted orders go to a lock free multiple producer,
+ *                  single consumer queue (an intrusive Vyukov queue).
+ *                  Workers take turns at being the consumer: each takes a
+ *                  group of up to group_max orders of the same kind and
+ *                  applies their entries in one transaction. If the group
+ *                  fails, its orders are applied again one at a time, so
+ *                  one bad order doesn't fail the others.
+ *
+ *                  Orders complete through a callback, a ticket, or both.
+ *                  Orders are not applied in submission order; callers
+ *                  that need an order applied first must wait for it.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include "benchmark.h"
+#include <pthread.h>
+
+typedef struct order_t {
+  struct order_t          *nextP;
+  struct order_queue_t    *queueP;
+  benchmark_data_packet_t *packetP;
+  int                      is_sell;
+  benchmark_order_done_fn  doneP;
+  void                    *argP;
+  int                      ticket;      /* Freed by benchmark_ticket_wait() */
+  volatile int             done;
+  int                      status;
+} order_t;
+
+typedef struct order_worker_t {
+  pthread_t                thread;
+  struct order_queue_t    *queueP;
+  void                    *ctxH;
+  benchmark_data_packet_t  group;       /* Entries of a group of orders */
+  order_t                **ordersP;
+} order_worker_t;
+
+typedef struct order_queue_t {
+  /* Producers push at the head, the consumer pops at the tail */
+  order_t          *headP;
+  order_t          *tailP;
+  order_t           stub;
+
+  /* Only the worker holding consumer_lock pops. carryP is an order it
+   * popped that didn't fit the group being built */
+  pthread_mutex_t   consumer_lock;
+  order_t          *carryP;
+
+  /* Idle workers and ticket holders sleep on wait_lock */
+  pthread_mutex_t   wait_lock;
+  pthread_cond_t    work_cond;
+  pthread_cond_t    done_cond;
+  int               sleepers;
+  int               stopping;
+
+  BENCHMARK_DBS    *benchmarkP;
+  int               num_workers;
+  int               group_max;
+  order_worker_t   *workersP;
+
+  unsigned long     submitted;
+  unsigned long     completed;
+  unsigned long     groups;
+} order_queue_t;
+
+static void
+order_queue_push(order_queue_t *queueP, order_t *orderP)
+{
+  order_t *prevP;
+
+  __atomic_store_n(&orderP->nextP, NULL, __ATOMIC_RELAXED);
+  prevP = __atomic_exchange_n(&queueP->headP, orderP, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&prevP->nextP, orderP, __ATOMIC_RELEASE);
+}
+
+/* Must hold consumer_lock. Returns NULL when the queue is empty, or
+ * when a producer is halfway through a push */
+static order_t *
+order_queue_pop(order_queue_t *queueP)
+{
+  order_t *tailP = queueP->tailP;
+  order_t *nextP = __atomic_load_n(&tailP->nextP, __ATOMIC_ACQUIRE);
+  order_t *headP;
+
+  if (tailP == &queueP->stub) {
+    if (nextP == NULL) {
+      return NULL;
+    }
+    queueP->tailP = nextP;
+    tailP = nextP;
+    nextP = __atomic_load_n(&nextP->nextP, __ATOMIC_ACQUIRE);
+  }
+
+  if (nextP != NULL) {
+    queueP->tailP = nextP;
+    return tailP;
+  }
+
+  headP = __atomic_load_n(&queueP->headP, __ATOMIC_SEQ_CST);
+  if (tailP != headP) {
+    return NULL;
+  }
+
+  order_queue_push(queueP, &queueP->stub);
+
+  nextP = __atomic_load_n(&tailP->nextP, __ATOMIC_ACQUIRE);
+  if (nextP != NULL) {
+    queueP->tailP = nextP;
+    return tailP;
+  }
+
+  return NULL;
+}
+
+/* The head is back on the stub once the last order was popped */
+static int
+order_queue_empty(order_queue_t *queueP)
+{
+  return __atomic_load_n(&queueP->headP, __ATOMIC_SEQ_CST) == &queueP->stub
+         && __atomic_load_n(&queueP->carryP, __ATOMIC_SEQ_CST) == NULL;
+}
+
+/* Takes up to group_max orders of the same kind */
+static int
+order_queue_take(order_queue_t *queueP, order_t **ordersP)
+{
+  order_t *orderP;
+  int      num_orders = 0;
+
+  pthread_mutex_lock(&queueP->consumer_lock);
+
+  orderP = queueP->carryP;
+  queueP->carryP = NULL;
+  if (orderP == NULL) {
+    orderP = order_queue_pop(queueP);
+  }
+
+  while (orderP != NULL) {
+    if (num_orders > 0 && orderP->is_sell != ordersP[0]->is_sell) {
+      queueP->carryP = orderP;
+      break;
+    }
+
+    ordersP[num_orders ++] = orderP;
+    if (num_orders == queueP->group_max) {
+      break;
+    }
+
+    orderP = order_queue_pop(queueP);
+  }
+
+  pthread_mutex_unlock(&queueP->consumer_lock);
+
+  return num_orders;
+}
+
+static void
+order_complete(order_t *orderP, int status)
+{
+  order_queue_t *queueP = orderP->queueP;
+
+  orderP->status = status;
+  __sync_fetch_and_add(&queueP->completed, 1);
+
+  if (orderP->doneP != NULL) {
+    orderP->doneP(orderP->packetP, status, orderP->argP);
+  }
+
+  if (!orderP->ticket) {
+    free(orderP);
+    return;
+  }
+
+  pthread_mutex_lock(&queueP->wait_lock);
+  orderP->done = 1;
+  pthread_cond_broadcast(&queueP->done_cond);
+  pthread_mutex_unlock(&queueP->wait_lock);
+}
+
+static int
+order_apply(int is_sell, benchmark_data_packet_t *packetP, void *ctxH)
+{
+  return is_sell ? benchmark_sell2_ctx(packetP, ctxH)
+                 : benchmark_purchase2_ctx(packetP, ctxH);
+}
+
+/* Applies the orders in one transaction, or one at a time if the
+ * group doesn't go through */
+static void
+order_group_apply(order_worker_t *workerP, int num_orders)
+{
+  benchmark_data_packet_t *groupP = &workerP->group;
+  order_t **ordersP = workerP->ordersP;
+  benchmark_xact_data_t *newP;
+  size_t used = 0;
+  int    is_sell = ordersP[0]->is_sell;
+  int    status;
+  int    i;
+
+  if (num_orders == 1) {
+    order_complete(ordersP[0], order_apply(is_sell, ordersP[0]->packetP, workerP->ctxH));
+    return;
+  }
+
+  for (i = 0; i < num_orders; i++) {
+    used += ordersP[i]->packetP->used;
+  }
+
+  if (used > groupP->size) {
+    newP = realloc(groupP->data, used * sizeof(benchmark_xact_data_t));
+    if (newP == NULL) {
+      benchmark_error("Could not allocate group of orders");
+      goto one_by_one;
+    }
+    groupP->data = newP;
+    groupP->size = used;
+  }
+
+  groupP->used = 0;
+  for (i = 0; i < num_orders; i++) {
+    memcpy(groupP->data + groupP->used, ordersP[i]->packetP->data,
+           ordersP[i]->packetP->used * sizeof(benchmark_xact_data_t));
+    groupP->used += ordersP[i]->packetP->used;
+  }
+
+  __sync_fetch_and_add(&workerP->queueP->groups, 1);
+
+  status = order_apply(is_sell, groupP, workerP->ctxH);
+  if (status == BENCHMARK_SUCCESS) {
+    used = 0;
+    for (i = 0; i < num_orders; i++) {
+      memcpy(ordersP[i]->packetP->data, groupP->data + used,
+             ordersP[i]->packetP->used * sizeof(benchmark_xact_data_t));
+      used += ordersP[i]->packetP->used;
+      order_complete(ordersP[i], BENCHMARK_SUCCESS);
+    }
+    return;
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Group of %d orders failed, applying them one by one", num_orders);
+
+one_by_one:
+  for (i = 0; i < num_orders; i++) {
+    order_complete(ordersP[i], order_apply(is_sell, ordersP[i]->packetP, workerP->ctxH));
+  }
+}
+
+static void *
+order_worker_main(void *argP)
+{
+  order_worker_t *workerP = argP;
+  order_queue_t  *queueP = workerP->queueP;
+  int num_orders;
+
+  for (;;) {
+    num_orders = order_queue_take(queueP, workerP->ordersP);
+    if (num_orders > 0) {
+      order_group_apply(workerP, num_orders);
+      continue;
+    }
+
+    /* Producers look at sleepers after they push, so either they see
+     * this worker or this worker sees their order */
+    pthread_mutex_lock(&queueP->wait_lock);
+    __sync_fetch_and_add(&queueP->sleepers, 1);
+    while (!queueP->stopping && order_queue_empty(queueP)) {
+      pthread_cond_wait(&queueP->work_cond, &queueP->wait_lock);
+    }
+    __sync_fetch_and_sub(&queueP->sleepers, 1);
+
+    /* Stop only once everything submitted has been applied */
+    if (queueP->stopping && order_queue_empty(queueP)) {
+      pthread_mutex_unlock(&queueP->wait_lock);
+      break;
+    }
+    pthread_mutex_unlock(&queueP->wait_lock);
+  }
+
+  return NULL;
+}
+
+static void
+order_queue_destroy(order_queue_t *queueP)
+{
+  int i;
+
+  for (i = 0; i < queueP->num_workers; i++) {
+    if (queueP->workersP[i].ctxH != NULL) {
+      benchmark_thread_ctx_free(queueP->workersP[i].ctxH);
+    }
+    free(queueP->workersP[i].group.data);
+    free(queueP->workersP[i].ordersP);
+  }
+  free(queueP->workersP);
+
+  pthread_cond_destroy(&queueP->done_cond);
+  pthread_cond_destroy(&queueP->work_cond);
+  pthread_mutex_destroy(&queueP->wait_lock);
+  pthread_mutex_destroy(&queueP->consumer_lock);
+  free(queueP);
+}
+
+/* Starts the workers, if the configuration asks for any */
+int
+order_queue_start(BENCHMARK_DBS *benchmarkP)
+{
+  order_queue_t *queueP = NULL;
+  int started = 0;
+  int i;
+
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  if (benchmarkP->config.order_workers <= 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  queueP = calloc(1, sizeof(order_queue_t));
+  if (queueP == NULL) {
+    benchmark_error("Could not allocate order queue");
+    goto failXit;
+  }
+
+  queueP->headP = &queueP->stub;
+  queueP->tailP = &queueP->stub;
+  queueP->benchmarkP = benchmarkP;
+  queueP->group_max = benchmarkP->config.order_group_max;
+  pthread_mutex_init(&queueP->consumer_lock, NULL);
+  pthread_mutex_init(&queueP->wait_lock, NULL);
+  pthread_cond_init(&queueP->work_cond, NULL);
+  pthread_cond_init(&queueP->done_cond, NULL);
+
+  queueP->workersP = calloc(benchmarkP->config.order_workers, sizeof(order_worker_t));
+  if (queueP->workersP == NULL) {
+    benchmark_error("Could not allocate order workers");
+    goto failXit;
+  }
+  queueP->num_workers = benchmarkP->config.order_workers;
+
+  for (i = 0; i < queueP->num_workers; i++) {
+    queueP->workersP[i].queueP = queueP;
+    queueP->workersP[i].ordersP = calloc(queueP->group_max, sizeof(order_t *));
+    if (queueP->workersP[i].ordersP == NULL
+        || benchmark_thread_ctx_alloc(benchmarkP, i, &queueP->workersP[i].ctxH) != BENCHMARK_SUCCESS) {
+      benchmark_error("Could not set up order worker %d", i);
+      goto failXit;
+    }
+  }
+
+  for (i = 0; i < queueP->num_workers; i++) {
+    if (pthread_create(&queueP->workersP[i].thread, NULL, order_worker_main, &queueP->workersP[i]) != 0) {
+      benchmark_error("Could not start order worker %d", i);
+      goto failXit;
+    }
+    started ++;
+  }
+
+  benchmarkP->order_queue = queueP;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (queueP != NULL) {
+    pthread_mutex_lock(&queueP->wait_lock);
+    queueP->stopping = 1;
+    pthread_cond_broadcast(&queueP->work_cond);
+    pthread_mutex_unlock(&queueP->wait_lock);
+
+    for (i = 0; i < started; i++) {
+      pthread_join(queueP->workersP[i].thread, NULL);
+    }
+
+    order_queue_destroy(queueP);
+  }
+  return BENCHMARK_FAIL;
+}
+
+/* Applies every order submitted so far, then stops the workers */
+void
+order_queue_stop(BENCHMARK_DBS *benchmarkP)
+{
+  order_queue_t *queueP = benchmarkP->order_queue;
+  int i;
+
+  if (queueP == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&queueP->wait_lock);
+  queueP->stopping = 1;
+  pthread_cond_broadcast(&queueP->work_cond);
+  pthread_mutex_unlock(&queueP->wait_lock);
+
+  for (i = 0; i < queueP->num_workers; i++) {
+    pthread_join(queueP->workersP[i].thread, NULL);
+  }
+
+  benchmarkP->order_queue = NULL;
+  order_queue_destroy(queueP);
+}
+
+static int
+order_submit(int                       is_sell,
+             void                     *data_packetH,
+             benchmark_order_done_fn   doneP,
+             void                     *argP,
+             void                    **ticketP,
+             void                     *benchmark_handle)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  order_queue_t *queueP;
+  order_t       *orderP = NULL;
+
+  if (ticketP != NULL) {
+    *ticketP = NULL;
+  }
+
+  if (benchmarkP == NULL || data_packetH == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  queueP = benchmarkP->order_queue;
+  if (queueP == NULL || queueP->stopping) {
+    benchmark_error("The order queue is not running");
+    goto failXit;
+  }
+
+  orderP = calloc(1, sizeof(order_t));
+  if (orderP == NULL) {
+    benchmark_error("Could not allocate order");
+    goto failXit;
+  }
+
+  orderP->queueP = queueP;
+  orderP->packetP = data_packetH;
+  orderP->is_sell = is_sell;
+  orderP->doneP = doneP;
+  orderP->argP = argP;
+  orderP->ticket = (ticketP != NULL);
+  orderP->status = BENCHMARK_FAIL;
+
+  if (ticketP != NULL) {
+    *ticketP = orderP;
+  }
+
+  __sync_fetch_and_add(&queueP->submitted, 1);
+  order_queue_push(queueP, orderP);
+
+  if (__atomic_load_n(&queueP->sleepers, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock(&queueP->wait_lock);
+    pthread_cond_signal(&queueP->work_cond);
+    pthread_mutex_unlock(&queueP->wait_lock);
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_purchase2_submit(void                     *data_packetH,
+                           benchmark_order_done_fn   doneP,
+                           void                     *argP,
+                           void                    **ticketP,
+                           void                     *benchmark_handle)
+{
+  return order_submit(0, data_packetH, doneP, argP, ticketP, benchmark_handle);
+}
+
+int
+benchmark_sell2_submit(void                     *data_packetH,
+                       benchmark_order_done_fn   doneP,
+                       void                     *argP,
+                       void                    **ticketP,
+                       void                     *benchmark_handle)
+{
+  return order_submit(1, data_packetH, doneP, argP, ticketP, benchmark_handle);
+}
+
+int
+benchmark_ticket_poll(void *ticketH, int *done)
+{
+  order_t *orderP = ticketH;
+
+  if (orderP == NULL || done == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  *done = __atomic_load_n(&orderP->done, __ATOMIC_ACQUIRE);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_ticket_wait(void *ticketH, int *status)
+{
+  order_t       *orderP = ticketH;
+  order_queue_t *queueP;
+
+  if (orderP == NULL || status == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  queueP = orderP->queueP;
+
+  pthread_mutex_lock(&queueP->wait_lock);
+  while (!orderP->done) {
+    pthread_cond_wait(&queueP->done_cond, &queueP->wait_lock);
+  }
+  pthread_mutex_unlock(&queueP->wait_lock);
+
+  *status = orderP->status;
+  free(orderP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_order_queue_stats_get(void          *benchmark_handle,
+                                unsigned long *submitted,
+                                unsigned long *completed,
+                                unsigned long *groups)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  order_queue_t *queueP;
+
+  if (benchmarkP == NULL || submitted == NULL || completed == NULL || groups == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  queueP = benchmarkP->order_queue;
+  if (queueP == NULL) {
+    *submitted = *completed = *groups = 0;
+    return BENCHMARK_SUCCESS;
+  }
+
+  *submitted = __sync_fetch_and_add(&queueP->submitted, 0);
+  *completed = __sync_fetch_and_add(&queueP->completed, 0);
+  *groups = __sync_fetch_and_add(&queueP->groups, 0);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
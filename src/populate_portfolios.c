@@ -18,6 +18,7 @@
 
 #include "common/benchmark_common.h"
 #include <time.h>
+#include <arpa/inet.h>
 
 /*============================================================================
  *                          PROTOTYPES
@@ -38,7 +39,12 @@ benchmark_load_portfolio(void *benchmark_handle)
   }
   
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  ret = load_portfolio_database(benchmarkP);
+  if (GENERATOR_ENABLED(benchmarkP)) {
+    ret = generate_portfolios(benchmarkP);
+  }
+  else {
+    ret = load_portfolio_database(benchmarkP);
+  }
   if (ret) {
     benchmark_error("%s:%d Error loading personal database.", __FILE__, __LINE__);
     goto failXit;
@@ -62,6 +68,8 @@ load_portfolio_database(BENCHMARK_DBS *benchmarkP)
   DB_ENV  *envP = NULL;
 #define CHRONOS_PORTFOLIOS_NUM	100
   PORTFOLIOS portfolio;
+  u_int32_t portfolio_id;
+  int collisions = 0;
   int i;
 
   envP = benchmarkP->envP;
@@ -82,9 +90,14 @@ load_portfolio_database(BENCHMARK_DBS *benchmarkP)
     memset(&key, 0, sizeof(DBT));
     memset(&data, 0, sizeof(DBT));
 
-    sprintf(portfolio.portfolio_id, "%d", i);
+    if (portfolio_id_next(benchmarkP, &portfolio_id) != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+
+    /* Big endian, so that the inserts go in key order */
+    portfolio.portfolio_id = htonl(portfolio_id);
     sprintf(portfolio.account_id, "%d", (rand() % 50)+1);
-    sprintf(portfolio.symbol, "%s", benchmarkP->stocks[rand() % benchmarkP->number_stocks]);
+    portfolio.symbol_id = rand() % benchmarkP->number_stocks;
     portfolio.hold_stocks = (rand() % 100) + 1;
 
 #if 0
@@ -107,8 +120,8 @@ load_portfolio_database(BENCHMARK_DBS *benchmarkP)
     /* Now that we have our structure we can load it into the database. */
 
     /* Set up the database record's key */
-    key.data = portfolio.portfolio_id;
-    key.size = (u_int32_t)strlen(portfolio.portfolio_id) + 1;
+    key.data = &portfolio.portfolio_id;
+    key.size = sizeof(portfolio.portfolio_id);
 
     /* Set up the database record's data */
     data.data = &portfolio;
@@ -123,7 +136,7 @@ load_portfolio_database(BENCHMARK_DBS *benchmarkP)
      */
 
     /* Put the data into the database */
-    benchmark_debug(4,"Inserting: %s for symbol: %s", portfolio.portfolio_id, portfolio.symbol);
+    benchmark_debug(4,"Inserting: %u for symbol: %u", portfolio_id, portfolio.symbol_id);
     show_portfolio_item(data.data, NULL);
 
     rc = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
@@ -133,7 +146,20 @@ load_portfolio_database(BENCHMARK_DBS *benchmarkP)
     }
 
     rc = benchmarkP->portfolios_dbp->put(benchmarkP->portfolios_dbp, txnP, &key, &data, DB_NOOVERWRITE);
-    if (rc != 0) {
+    if (rc == DB_KEYEXIST && collisions < CHRONOS_PORTFOLIOS_NUM) {
+      /* This account already holds the random symbol. Holdings are
+       * unique per (account, symbol), so draw again. */
+      collisions ++;
+      benchmark_debug(4, "Account %s already holds %u, retrying", portfolio.account_id, portfolio.symbol_id);
+      rc = txnP->abort(txnP);
+      if (rc != 0) {
+        envP->err(envP, rc, "[%s:%d] [%d] Transaction abort failed.", __FILE__, __LINE__, getpid());
+        goto failXit; 
+      }
+      i --;
+      continue;
+    }
+    else if (rc != 0) {
       envP->err(envP, rc, "Database put failed.");
       rc = txnP->abort(txnP);
       if (rc != 0) {
@@ -18,6 +18,23 @@
 
 #include "common/benchmark_common.h"
 
+typedef struct purchase_args_t {
+  const char *account_id;
+  u_int32_t   symbol_id;
+  float       price;
+  int         amount;
+  int         force_apply;
+} purchase_args_t;
+
+static int
+purchase_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  purchase_args_t *argsP = argP;
+
+  return place_order_by_id(argsP->account_id, argsP->symbol_id, argsP->price,
+                           argsP->amount, argsP->force_apply, NULL, benchmarkP);
+}
+
 int
 benchmark_purchase(int account, 
                    int symbol, 
@@ -28,9 +45,9 @@ benchmark_purchase(int account,
                    int *symbolP)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
-  int ret;
+  purchase_args_t args;
+  int ret = BENCHMARK_FAIL;
   int symbol_idx;
-  char *random_symbol;
   float random_price;
   int random_amount;
 
@@ -42,29 +59,33 @@ benchmark_purchase(int account,
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
   if (symbol < 0) {
-    symbol_idx = rand() % benchmarkP->number_stocks;
-    random_symbol = benchmarkP->stocks[symbol_idx];
+    symbol_idx = thread_rand() % benchmarkP->number_stocks;
   }
   else {
-    random_symbol = benchmarkP->stocks[symbol];
+    symbol_idx = symbol;
   }
 
   if (price < 0) {
-    random_price = rand() % 100 + 1;
+    random_price = thread_rand() % 100 + 1;
   }
   else {
     random_price = price;
   }
 
   if (amount < 0) {
-    random_amount = rand() % 20 + 1;
+    random_amount = thread_rand() % 20 + 1;
   }
   else {
     random_amount = amount;
   }
  
   assert("Need to set account id" == NULL);
-  ret = place_order(NULL, random_symbol, random_price, random_amount, force_apply, NULL, benchmarkP);
+  args.account_id = NULL;
+  args.symbol_id = symbol_idx;
+  args.price = random_price;
+  args.amount = random_amount;
+  args.force_apply = force_apply;
+  ret = xact_retry_run(BENCHMARK_XACT_PURCHASE, purchase_attempt, &args, benchmarkP);
   if (ret != 0) {
     fprintf(stderr, "Could not place order\n");
     goto failXit;
@@ -81,30 +102,20 @@ benchmark_purchase(int account,
   if (symbolP != NULL) {
     *symbolP = -1;
   }
-  return BENCHMARK_FAIL;
+  return ret;
 }
 
 
-int
-benchmark_purchase2(void  *data_packetH,
-                    void  *benchmark_handle)
+static int
+purchase2_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
 {
-  BENCHMARK_DBS *benchmarkP = NULL;
-  benchmark_data_packet_t *packetP = NULL;
+  benchmark_data_packet_t *packetP = argP;
   benchmark_xact_h xactH = NULL;
+  benchmark_xact_h entryH = NULL;
+  int partial = benchmarkP->config.packet_partial;
   int i;
   int ret;
 
-  benchmarkP = benchmark_handle;
-  if (benchmarkP == NULL || data_packetH == NULL) {
-    benchmark_error("Invalid arguments");
-    goto failXit;
-  }
-
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
-  packetP = data_packetH;
-
   ret = start_xact(&xactH, "PURCHASE_TXN", benchmarkP);
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
@@ -114,23 +125,60 @@ benchmark_purchase2(void  *data_packetH,
 
   for (i=0; i<packetP->used; i++) {
     benchmark_debug(2, "Placing order for user: %s", packetP->data[i].accountId);
-    ret = place_order(packetP->data[i].accountId,
-                      packetP->data[i].symbol,
-                      packetP->data[i].price,
-                      packetP->data[i].amount,
-                      1, xactH, benchmarkP);
+
+    /* With partial commits, each entry runs in a child of the packet */
+    entryH = xactH;
+    if (partial) {
+      ret = start_child_xact(xactH, &entryH, benchmarkP);
+      if (ret != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+
+    /* Entries appended without a symbol skip the dictionary */
+    if (packetP->data[i].symbol[0] == '\0') {
+      ret = place_order_by_id(packetP->data[i].accountId,
+                              packetP->data[i].symbolId,
+                              packetP->data[i].price,
+                              packetP->data[i].amount,
+                              1, entryH, benchmarkP);
+    }
+    else {
+      ret = place_order(packetP->data[i].accountId,
+                        packetP->data[i].symbol,
+                        packetP->data[i].price,
+                        packetP->data[i].amount,
+                        1, entryH, benchmarkP);
+    }
+
+    if (partial) {
+      if (ret == BENCHMARK_SUCCESS) {
+        ret = commit_xact(entryH, benchmarkP);
+      }
+      else {
+        abort_xact(entryH, benchmarkP);
+      }
+      entryH = NULL;
+
+      /* A lost lock conflict must still retry the whole packet */
+      if (ret != BENCHMARK_SUCCESS && xact_conflict_pending()) {
+        goto failXit;
+      }
+      packetP->data[i].status = ret;
+      continue;
+    }
+
     if (ret != BENCHMARK_SUCCESS) {
       goto failXit;
     }
   }
 
   ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
   return ret;
 
  failXit:
@@ -140,3 +188,99 @@ benchmark_purchase2(void  *data_packetH,
 
   return BENCHMARK_FAIL;
 }
+
+int
+benchmark_purchase2(void  *data_packetH,
+                    void  *benchmark_handle)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  benchmark_data_packet_t *packetP = data_packetH;
+  benchmark_data_packet_t ordered;
+  int ret;
+
+  benchmarkP = benchmark_handle;
+  if (benchmarkP == NULL || data_packetH == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  data_packet_status_reset(data_packetH);
+
+  /* A single order can share a transaction with concurrent ones */
+  if (GROUP_COMMIT_ENABLED(benchmarkP) && packetP->used == 1) {
+    ret = group_commit_order(0, packetP->data, benchmarkP);
+    data_packet_status_set(data_packetH, ret);
+    return ret;
+  }
+
+  /* Every attempt applies the packet in the same canonical order */
+  if (benchmarkP->config.packet_order) {
+    if (data_packet_order(data_packetH, 0, &ordered, benchmarkP) != BENCHMARK_SUCCESS) {
+      data_packet_status_set(data_packetH, BENCHMARK_FAIL);
+      return BENCHMARK_FAIL;
+    }
+    ret = xact_retry_run(BENCHMARK_XACT_PURCHASE, purchase2_attempt, &ordered, benchmarkP);
+    data_packet_status_unorder(data_packetH, &ordered);
+    data_packet_order_free(&ordered);
+  }
+  else {
+    ret = xact_retry_run(BENCHMARK_XACT_PURCHASE, purchase2_attempt, data_packetH, benchmarkP);
+  }
+
+  /* Entries share the outcome of the packet, unless they were
+   * committed one by one into a packet that committed */
+  if (!benchmarkP->config.packet_partial || ret != BENCHMARK_SUCCESS) {
+    data_packet_status_set(data_packetH, ret);
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Variants that run on a thread context, see thread_ctx.c
+ *----------------------------------------------------------*/
+
+int
+benchmark_purchase_ctx(int    account,
+                       int    symbol,
+                       float  price,
+                       int    amount,
+                       int    force_apply,
+                       void  *thread_ctx_handle,
+                       int   *symbolP)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_purchase(account, symbol, price, amount, force_apply, benchmarkP, symbolP);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_purchase2_ctx(void *data_packetH,
+                        void *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_purchase2(data_packetH, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
@@ -0,0 +1,310 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  quote_cache.c
+ *
+ *    Description:  In memory copy of the Quotes table, indexed by symbol id.
+ *                  Each slot is protected by a sequence lock, so quote reads
+ *                  neither start a transaction nor take Berkeley DB locks.
+ *                  Updates reach the cache only after they commit.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+
+/* Quotes updated by a transaction that has not committed yet. The
+ * list hangs from the context of the transaction. */
+typedef struct quote_cache_pending_t {
+  u_int32_t                     symbol_id;
+  u_int32_t                     version;
+  QUOTE                         quote;
+  struct quote_cache_pending_t *nextP;
+} quote_cache_pending_t;
+
+/*-------------------------------------------------------
+ * Allocates the cache (when it is enabled in the
+ * configuration) and fills it from the Quotes table.
+ * The symbol dictionary must be loaded already.
+ *-----------------------------------------------------*/
+int
+quote_cache_load(BENCHMARK_DBS *benchmarkP)
+{
+  quote_cache_entry_t *cacheP = NULL;
+  DBC     *cursorP = NULL;
+  DB_TXN  *txnP = NULL;
+  DB_ENV  *envP = NULL;
+  DBT      key, data;
+  QUOTE    quote;
+  u_int32_t symbol_id;
+  int      loaded = 0;
+  int      ret;
+
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  quote_cache_free(benchmarkP);
+
+  if (!benchmarkP->config.quote_cache || benchmarkP->number_stocks <= 0) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  envP = benchmarkP->envP;
+  if (envP == NULL || benchmarkP->quotes_dbp == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  ret = posix_memalign((void **)&cacheP, sizeof(quote_cache_entry_t),
+                       benchmarkP->number_stocks * sizeof(quote_cache_entry_t));
+  if (ret != 0) {
+    benchmark_error("Could not allocate quote cache");
+    cacheP = NULL;
+    goto failXit;
+  }
+  memset(cacheP, 0, benchmarkP->number_stocks * sizeof(quote_cache_entry_t));
+
+  dbt_usermem_set(&key, &symbol_id, sizeof(u_int32_t));
+  dbt_usermem_set(&data, &quote, sizeof(QUOTE));
+
+  ret = envP->txn_begin(envP, NULL, &txnP, DB_READ_COMMITTED | DB_TXN_WAIT);
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction begin failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  ret = benchmarkP->quotes_dbp->cursor(benchmarkP->quotes_dbp, txnP, &cursorP, DB_READ_COMMITTED);
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to create cursor for Quotes.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  while ((ret = cursor_get_usermem(cursorP, &key, NULL, &data, DB_NEXT | DB_READ_COMMITTED)) == 0) {
+    memcpy(&symbol_id, key.data, sizeof(u_int32_t));
+    if (symbol_id >= (u_int32_t) benchmarkP->number_stocks) {
+      benchmark_warning("Quote for unknown symbol id: %u", symbol_id);
+      continue;
+    }
+
+    memcpy(&cacheP[symbol_id].quote, data.data, sizeof(QUOTE));
+    cacheP[symbol_id].valid = 1;
+    loaded ++;
+  }
+
+  if (ret != DB_NOTFOUND) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to iterate over Quotes.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  ret = cursorP->close(cursorP);
+  cursorP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  ret = txnP->commit(txnP, 0);
+  txnP = NULL;
+  if (ret != 0) {
+    envP->err(envP, ret, "[%s:%d] [%d] Transaction commit failed.", __FILE__, __LINE__, getpid());
+    goto failXit;
+  }
+
+  benchmarkP->quote_cache = cacheP;
+  benchmarkP->quote_cache_size = benchmarkP->number_stocks;
+
+  benchmark_debug(5, "Quote cache holds %d of %d symbols",
+                  loaded, benchmarkP->number_stocks);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (cursorP != NULL) {
+    cursorP->close(cursorP);
+  }
+  if (txnP != NULL) {
+    txnP->abort(txnP);
+  }
+  free(cacheP);
+  return BENCHMARK_FAIL;
+}
+
+void
+quote_cache_free(BENCHMARK_DBS *benchmarkP)
+{
+  if (benchmarkP == NULL) {
+    return;
+  }
+
+  free(benchmarkP->quote_cache);
+  benchmarkP->quote_cache = NULL;
+  benchmarkP->quote_cache_size = 0;
+}
+
+/*
+ * Copies the cached quote of symbol_id into quoteP. Fails if there
+ * is no cache or the symbol has no quote, in which case the caller
+ * should go to the Quotes table.
+ */
+int
+quote_cache_read(u_int32_t symbol_id, QUOTE *quoteP, BENCHMARK_DBS *benchmarkP)
+{
+  quote_cache_entry_t *entryP;
+  u_int32_t sequence;
+  u_int32_t valid;
+
+  if (!QUOTE_CACHE_ENABLED(benchmarkP) || symbol_id >= benchmarkP->quote_cache_size) {
+    return BENCHMARK_FAIL;
+  }
+
+  entryP = &benchmarkP->quote_cache[symbol_id];
+
+  for (;;) {
+    sequence = __atomic_load_n(&entryP->sequence, __ATOMIC_ACQUIRE);
+    if (sequence & 1) {
+      /* A writer is copying the quote */
+      continue;
+    }
+
+    valid = entryP->valid;
+    memcpy(quoteP, &entryP->quote, sizeof(QUOTE));
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&entryP->sequence, __ATOMIC_RELAXED) == sequence) {
+      break;
+    }
+  }
+
+  return valid ? BENCHMARK_SUCCESS : BENCHMARK_FAIL;
+}
+
+/*
+ * Hands out the version of a new update of symbol_id. Must be called
+ * while holding the write lock of the Quotes record.
+ */
+u_int32_t
+quote_cache_version_get(u_int32_t symbol_id, BENCHMARK_DBS *benchmarkP)
+{
+  if (!QUOTE_CACHE_ENABLED(benchmarkP) || symbol_id >= benchmarkP->quote_cache_size) {
+    return 0;
+  }
+
+  return __atomic_add_fetch(&benchmarkP->quote_cache[symbol_id].next_version, 1, __ATOMIC_RELAXED);
+}
+
+/* Makes a committed quote visible to readers */
+void
+quote_cache_publish(u_int32_t symbol_id, u_int32_t version, const QUOTE *quoteP, BENCHMARK_DBS *benchmarkP)
+{
+  quote_cache_entry_t *entryP;
+  u_int32_t sequence;
+
+  if (!QUOTE_CACHE_ENABLED(benchmarkP) || symbol_id >= benchmarkP->quote_cache_size) {
+    return;
+  }
+
+  entryP = &benchmarkP->quote_cache[symbol_id];
+
+  /* Writers exclude each other by making the sequence odd */
+  for (;;) {
+    sequence = __atomic_load_n(&entryP->sequence, __ATOMIC_RELAXED);
+    if ((sequence & 1) == 0
+        && __atomic_compare_exchange_n(&entryP->sequence, &sequence, sequence + 1,
+                                       0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      break;
+    }
+  }
+
+  if (!entryP->valid || (int32_t)(version - entryP->version) > 0) {
+    memcpy(&entryP->quote, quoteP, sizeof(QUOTE));
+    entryP->version = version;
+    entryP->valid = 1;
+  }
+
+  __atomic_store_n(&entryP->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/* Remembers an update made by txnP, to be published once it commits */
+int
+quote_cache_defer(DB_TXN *txnP, u_int32_t symbol_id, u_int32_t version, const QUOTE *quoteP)
+{
+  quote_cache_pending_t *pendingP;
+  xact_ctx_t *ctxP = XACT_CTX(txnP);
+
+  if (ctxP == NULL) {
+    benchmark_error("Transaction has no context");
+    return BENCHMARK_FAIL;
+  }
+
+  pendingP = thread_scratch_alloc(sizeof(quote_cache_pending_t));
+  if (pendingP == NULL) {
+    benchmark_error("Could not allocate pending quote");
+    return BENCHMARK_FAIL;
+  }
+
+  pendingP->symbol_id = symbol_id;
+  pendingP->version = version;
+  memcpy(&pendingP->quote, quoteP, sizeof(QUOTE));
+  pendingP->nextP = ctxP->quote_pendingP;
+  ctxP->quote_pendingP = pendingP;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*
+ * Detaches the pending updates of txnP. This must happen before the
+ * transaction is resolved, since commit and abort free the handle.
+ */
+void *
+quote_cache_deferred_take(DB_TXN *txnP)
+{
+  xact_ctx_t *ctxP = XACT_CTX(txnP);
+  void *pendingP;
+
+  if (ctxP == NULL) {
+    return NULL;
+  }
+
+  pendingP = ctxP->quote_pendingP;
+  ctxP->quote_pendingP = NULL;
+  return pendingP;
+}
+
+void
+quote_cache_deferred_publish(void *pending_listP, BENCHMARK_DBS *benchmarkP)
+{
+  quote_cache_pending_t *pendingP = pending_listP;
+  quote_cache_pending_t *nextP;
+
+  while (pendingP != NULL) {
+    nextP = pendingP->nextP;
+    quote_cache_publish(pendingP->symbol_id, pendingP->version, &pendingP->quote, benchmarkP);
+    thread_scratch_free(pendingP);
+    pendingP = nextP;
+  }
+}
+
+void
+quote_cache_deferred_discard(void *pending_listP)
+{
+  quote_cache_pending_t *pendingP = pending_listP;
+  quote_cache_pending_t *nextP;
+
+  while (pendingP != NULL) {
+    nextP = pendingP->nextP;
+    thread_scratch_free(pendingP);
+    pendingP = nextP;
+  }
+}
@@ -18,13 +18,55 @@
 
 #include "common/benchmark_common.h"
 
+typedef struct refresh_args_t {
+  int               num_symbols;
+  const char      **symbols_list;
+  const u_int32_t  *symbol_ids;
+  const float      *prices_list;
+  int              *status_list;
+} refresh_args_t;
+
+static int
+refresh_quote_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  refresh_args_t *argsP = argP;
+
+  return update_stock_by_id(argsP->symbol_ids[0], argsP->prices_list[0], NULL, benchmarkP);
+}
+
+/* Concurrent callers share a transaction under group commit */
+static int
+refresh_quote_run(u_int32_t symbol_id, float newValue, BENCHMARK_DBS *benchmarkP)
+{
+  refresh_args_t args;
+
+  if (GROUP_COMMIT_ENABLED(benchmarkP)) {
+    return group_commit_refresh(symbol_id, newValue, benchmarkP);
+  }
+
+  memset(&args, 0, sizeof(refresh_args_t));
+  args.num_symbols = 1;
+  args.symbol_ids = &symbol_id;
+  args.prices_list = &newValue;
+  return xact_retry_run(BENCHMARK_XACT_REFRESH_QUOTES, refresh_quote_attempt, &args, benchmarkP);
+}
+
+/* Runs the sorted batch update in a transaction of its own */
+static int
+refresh_batch_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  refresh_args_t *argsP = argP;
+
+  return update_stocks_sorted(argsP->num_symbols, argsP->symbol_ids, argsP->prices_list,
+                              argsP->status_list, NULL, benchmarkP);
+}
+
 int
 benchmark_refresh_quotes(void *benchmark_handle, int *symbolP, float newValue)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
   int symbol;
-  char *random_symbol;
-  int ret = BENCHMARK_SUCCESS;
+  int ret = BENCHMARK_FAIL;
 
   benchmarkP = benchmark_handle;
   if (benchmarkP == NULL) {
@@ -37,12 +79,11 @@ benchmark_refresh_quotes(void *benchmark_handle, int *symbolP, float newValue)
     symbol = *symbolP;
   }
   else {
-    symbol = rand() % benchmarkP->number_stocks;
+    symbol = thread_rand() % benchmarkP->number_stocks;
   }
-  random_symbol = benchmarkP->stocks[symbol];
 
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "PID: %d, Attempting to update %s to %f", getpid(), random_symbol, newValue);
-  ret = update_stock(random_symbol, newValue, NULL, benchmarkP);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "PID: %d, Attempting to update %d to %f", getpid(), symbol, newValue);
+  ret = refresh_quote_run(symbol, newValue, benchmarkP);
   if (ret != 0) {
     benchmark_error("Could not update quote");
     goto failXit;
@@ -53,7 +94,7 @@ benchmark_refresh_quotes(void *benchmark_handle, int *symbolP, float newValue)
   }
     
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "Done refreshing price for %s.", random_symbol);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, "Done refreshing price for %d.", symbol);
   return ret;
   
  failXit:
@@ -61,14 +102,15 @@ benchmark_refresh_quotes(void *benchmark_handle, int *symbolP, float newValue)
     *symbolP = -1;
   }
   
-  return BENCHMARK_FAIL;
+  return ret;
 }
 
 int
 benchmark_refresh_quotes2(void *benchmark_handle, const char *symbolP, float newValue)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
-  int ret = BENCHMARK_SUCCESS;
+  u_int32_t symbol_id;
+  int ret = BENCHMARK_FAIL;
 
   benchmarkP = benchmark_handle;
   if (benchmarkP == NULL) {
@@ -82,7 +124,12 @@ benchmark_refresh_quotes2(void *benchmark_handle, const char *symbolP, float new
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_API,"PID: %d, Attempting to update %s to %f", getpid(), symbolP, newValue);
-  ret = update_stock((char *)symbolP, newValue, NULL, benchmarkP);
+  if (symbol_dict_lookup(symbolP, &symbol_id, benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("This symbol (%s) does not exist.", symbolP);
+    goto failXit;
+  }
+
+  ret = refresh_quote_run(symbol_id, newValue, benchmarkP);
   if (ret != 0) {
     benchmark_error("Could not update quote");
     goto failXit;
@@ -94,13 +141,93 @@ benchmark_refresh_quotes2(void *benchmark_handle, const char *symbolP, float new
   
  failXit:
   
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Resolves the symbols of a refresh batch into ids. Unknown
+ * symbols get an id past the last stock, which the batch
+ * update reports as failed.
+ *----------------------------------------------------------*/
+static u_int32_t *
+refresh_symbol_ids_get(int            num_symbols,
+                       const char   **symbols_list,
+                       BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t *symbol_ids = NULL;
+  int i;
+
+  symbol_ids = thread_scratch_alloc((num_symbols > 0 ? num_symbols : 1) * sizeof(u_int32_t));
+  if (symbol_ids == NULL) {
+    benchmark_error("Could not allocate symbol ids");
+    return NULL;
+  }
+
+  for (i=0; i<num_symbols; i++) {
+    if (symbols_list[i] == NULL
+        || symbol_dict_lookup(symbols_list[i], &symbol_ids[i], benchmarkP) != BENCHMARK_SUCCESS) {
+      benchmark_warning("This symbol (%s) does not exist.", symbols_list[i] ? symbols_list[i] : "");
+      symbol_ids[i] = (u_int32_t) benchmarkP->number_stocks;
+    }
+  }
+
+  return symbol_ids;
+}
+
+/* All or nothing: fails if any of the symbols fails */
+static int
+refresh_list_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  refresh_args_t *argsP = argP;
+  int num_symbols = argsP->num_symbols;
+  int *status_list = argsP->status_list;
+  benchmark_xact_h xactH = NULL;
+  int i;
+  int ret;
+
+  ret = start_xact(&xactH, "REFRESH_STOCK_TXN", benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API,
+                  "PID: %d, Attempting to update %d symbols", 
+                  getpid(), num_symbols);
+
+  ret = update_stocks_sorted(num_symbols, argsP->symbol_ids, argsP->prices_list, 
+                             status_list, xactH, benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    benchmark_error("Could not update quotes");
+    goto failXit;
+  }
+
+  for (i=0; i<num_symbols; i++) {
+    if (status_list[i] != BENCHMARK_SUCCESS) {
+      benchmark_error("Could not update quote of %s", argsP->symbols_list[i]);
+      goto failXit;
+    }
+  }
+
+  ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  return ret;
+  
+ failXit:
+  if (xactH != NULL) {
+    abort_xact(xactH, benchmarkP);
+  }
+  
   return BENCHMARK_FAIL;
 }
 
 /*------------------------------------------------------------
  * Updates the quotes of the provided symbols with the
  * provided prices. All the updates happen in the 
- * same transaction.
+ * same transaction, and fail if any symbol fails.
  *----------------------------------------------------------*/
 int
 benchmark_refresh_quotes_list(int           num_symbols,
@@ -109,9 +236,10 @@ benchmark_refresh_quotes_list(int           num_symbols,
                               void         *benchmark_handle)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
-  benchmark_xact_h xactH = NULL;
-  int i;
-  int ret = BENCHMARK_SUCCESS;
+  refresh_args_t args;
+  u_int32_t *symbol_ids = NULL;
+  int *status_list = NULL;
+  int ret = BENCHMARK_FAIL;
 
   benchmarkP = benchmark_handle;
   if (benchmarkP == NULL) {
@@ -119,44 +247,185 @@ benchmark_refresh_quotes_list(int           num_symbols,
     goto failXit;
   }
 
-  if (symbols_list == NULL || prices_list == NULL) {
+  if (symbols_list == NULL || prices_list == NULL || num_symbols < 0) {
     benchmark_error("Invalid arguments");
     goto failXit;
   }
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  ret = start_xact(&xactH, "REFRESH_STOCK_TXN", benchmarkP);
+  symbol_ids = refresh_symbol_ids_get(num_symbols, symbols_list, benchmarkP);
+  status_list = thread_scratch_alloc((num_symbols > 0 ? num_symbols : 1) * sizeof(int));
+  if (symbol_ids == NULL || status_list == NULL) {
+    goto failXit;
+  }
+
+  args.num_symbols = num_symbols;
+  args.symbols_list = symbols_list;
+  args.symbol_ids = symbol_ids;
+  args.prices_list = prices_list;
+  args.status_list = status_list;
+  ret = xact_retry_run(BENCHMARK_XACT_REFRESH_QUOTES, refresh_list_attempt, &args, benchmarkP);
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  for (i=0; i<num_symbols; i++) {
-    benchmark_debug(BENCHMARK_DEBUG_LEVEL_API,
-                    "PID: %d, Attempting to update %s to %f", 
-                    getpid(), symbols_list[i], prices_list[i]);
+  thread_scratch_free(status_list);
+  thread_scratch_free(symbol_ids);
 
-    ret = update_stock((char *)symbols_list[i], prices_list[i], xactH, benchmarkP);
-    if (ret != BENCHMARK_SUCCESS) {
-      benchmark_error("Could not update quote");
-      goto failXit;
-    }
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, 
+                  "Done refreshing price for %d symbols.", num_symbols);
+  return ret;
+  
+ failXit:
+  thread_scratch_free(status_list);
+  thread_scratch_free(symbol_ids);
+  
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Like benchmark_refresh_quotes_list(), but a symbol that 
+ * cannot be updated does not abort the others. 
+ * status_list[i] is set to 0 when symbols_list[i] was 
+ * updated. The updates are applied in key order, which 
+ * makes deadlocks between concurrent batches less likely;
+ * the ones that still happen are retried.
+ *----------------------------------------------------------*/
+int
+benchmark_refresh_quotes_batch(int           num_symbols,
+                               const char  **symbols_list,
+                               float        *prices_list,
+                               int          *status_list,
+                               void         *benchmark_handle)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  refresh_args_t args;
+  u_int32_t *symbol_ids = NULL;
+  int ret = BENCHMARK_FAIL;
+
+  benchmarkP = benchmark_handle;
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
   }
 
-  ret = commit_xact(xactH, benchmarkP);
+  if (symbols_list == NULL || prices_list == NULL || status_list == NULL || num_symbols < 0) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  symbol_ids = refresh_symbol_ids_get(num_symbols, symbols_list, benchmarkP);
+  if (symbol_ids == NULL) {
+    goto failXit;
+  }
+
+  args.num_symbols = num_symbols;
+  args.symbols_list = symbols_list;
+  args.symbol_ids = symbol_ids;
+  args.prices_list = prices_list;
+  args.status_list = status_list;
+  ret = xact_retry_run(BENCHMARK_XACT_REFRESH_QUOTES, refresh_batch_attempt, &args, benchmarkP);
   if (ret != BENCHMARK_SUCCESS) {
+    benchmark_error("Could not update quotes");
     goto failXit;
   }
 
+  thread_scratch_free(symbol_ids);
+
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   benchmark_debug(BENCHMARK_DEBUG_LEVEL_API, 
                   "Done refreshing price for %d symbols.", num_symbols);
   return ret;
-  
+
  failXit:
-  if (xactH != NULL) {
-    abort_xact(xactH, benchmarkP);
+  thread_scratch_free(symbol_ids);
+
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Variants that run on a thread context, see thread_ctx.c
+ *----------------------------------------------------------*/
+
+int
+benchmark_refresh_quotes_ctx(void  *thread_ctx_handle,
+                             int   *symbolP,
+                             float  newValue)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
   }
-  
-  return BENCHMARK_FAIL;
+
+  ret = benchmark_refresh_quotes(benchmarkP, symbolP, newValue);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_refresh_quotes2_ctx(void       *thread_ctx_handle,
+                              const char *symbolP,
+                              float       newValue)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_refresh_quotes2(benchmarkP, symbolP, newValue);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_refresh_quotes_list_ctx(int          num_symbols,
+                                  const char **symbols_list,
+                                  float       *prices_list,
+                                  void        *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_refresh_quotes_list(num_symbols, symbols_list, prices_list, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_refresh_quotes_batch_ctx(int          num_symbols,
+                                   const char **symbols_list,
+                                   float       *prices_list,
+                                   int         *status_list,
+                                   void        *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_refresh_quotes_batch(num_symbols, symbols_list, prices_list, status_list, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
 }
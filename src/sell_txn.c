@@ -18,13 +18,30 @@
 
 #include "common/benchmark_common.h"
 
+typedef struct sell_args_t {
+  const char *account_id;
+  u_int32_t   symbol_id;
+  float       price;
+  int         amount;
+  int         force_apply;
+} sell_args_t;
+
+static int
+sell_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  sell_args_t *argsP = argP;
+
+  return sell_stocks_by_id(argsP->account_id, argsP->symbol_id, argsP->price,
+                           argsP->amount, argsP->force_apply, NULL, benchmarkP);
+}
+
 int
 benchmark_sell(int account, int symbol, float price, int amount, int force_apply, void *benchmark_handle, int *symbol_ret)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
-  int ret;
+  sell_args_t args;
+  int ret = BENCHMARK_FAIL;
   int symbol_idx;
-  char *random_symbol;
   float random_price;
   int random_amount;
 
@@ -36,29 +53,33 @@ benchmark_sell(int account, int symbol, float price, int amount, int force_apply
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
   if (symbol < 0) {
-    symbol_idx = rand() % benchmarkP->number_stocks;
-    random_symbol = benchmarkP->stocks[symbol_idx];
+    symbol_idx = thread_rand() % benchmarkP->number_stocks;
   }
   else {
-    random_symbol = benchmarkP->stocks[symbol];
+    symbol_idx = symbol;
   }
 
   if (price < 0) {
-    random_price = rand() % 100 + 1;
+    random_price = thread_rand() % 100 + 1;
   }
   else {
     random_price = price;
   }
 
   if (amount < 0) {
-    random_amount = rand() % 20 + 1;
+    random_amount = thread_rand() % 20 + 1;
   }
   else {
     random_amount = amount;
   }
  
   assert("Need to pass a valid account" == NULL);
-  ret = sell_stocks(NULL, random_symbol, random_price, random_amount, force_apply, NULL, benchmarkP);
+  args.account_id = NULL;
+  args.symbol_id = symbol_idx;
+  args.price = random_price;
+  args.amount = random_amount;
+  args.force_apply = force_apply;
+  ret = xact_retry_run(BENCHMARK_XACT_SELL, sell_attempt, &args, benchmarkP);
   if (ret != 0) {
     benchmark_error("Could not place order");
     goto failXit;
@@ -76,29 +97,19 @@ benchmark_sell(int account, int symbol, float price, int amount, int force_apply
     *symbol_ret = -1;
   }
       
-  return BENCHMARK_FAIL;
+  return ret;
 }
 
-int
-benchmark_sell2(void *data_packetH,
-                void *benchmark_handle)
+static int
+sell2_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
 {
-  BENCHMARK_DBS *benchmarkP = NULL;
-  benchmark_data_packet_t *packetP = NULL;
+  benchmark_data_packet_t *packetP = argP;
   benchmark_xact_h xactH = NULL;
+  benchmark_xact_h entryH = NULL;
+  int partial = benchmarkP->config.packet_partial;
   int i;
   int ret;
 
-  benchmarkP = benchmark_handle;
-  if (benchmarkP == NULL || data_packetH == NULL) {
-    benchmark_error("Invalid arguments");
-    goto failXit;
-  }
-
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
-  packetP = data_packetH;
-
   ret = start_xact(&xactH, "SELL_TXN", benchmarkP);
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
@@ -108,23 +119,61 @@ benchmark_sell2(void *data_packetH,
 
   for (i=0; i<packetP->used; i++) {
     benchmark_debug(2, "Placing order for user: %s", packetP->data[i].accountId);
-    ret = sell_stocks(packetP->data[i].accountId,
-                      packetP->data[i].symbol,
-                      packetP->data[i].price,
-                      packetP->data[i].amount,
-                      1, xactH, benchmarkP);
+
+    /* With partial commits, each entry runs in a child of the packet */
+    entryH = xactH;
+    if (partial) {
+      ret = start_child_xact(xactH, &entryH, benchmarkP);
+      if (ret != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+
+    /* Entries appended without a symbol skip the dictionary */
+    if (packetP->data[i].symbol[0] == '\0') {
+      ret = sell_stocks_by_id(packetP->data[i].accountId,
+                              packetP->data[i].symbolId,
+                              packetP->data[i].price,
+                              packetP->data[i].amount,
+                              1, entryH, benchmarkP);
+    }
+    else {
+      ret = sell_stocks(packetP->data[i].accountId,
+                        packetP->data[i].symbol,
+                        packetP->data[i].price,
+                        packetP->data[i].amount,
+                        1, entryH, benchmarkP);
+    }
+
+    if (partial) {
+      if (ret == BENCHMARK_SUCCESS) {
+        ret = commit_xact(entryH, benchmarkP);
+      }
+      else {
+        abort_xact(entryH, benchmarkP);
+      }
+      entryH = NULL;
+
+      /* A lost lock conflict must still retry the whole packet */
+      if (ret != BENCHMARK_SUCCESS && xact_conflict_pending()) {
+        goto failXit;
+      }
+      packetP->data[i].status = ret;
+      continue;
+    }
+
     if (ret != BENCHMARK_SUCCESS) {
-      benchmark_error("Could not place order for user: %s and symbol: %s", packetP->data[i].accountId, packetP->data[i].symbol);
+      benchmark_error("Could not place order for user: %s and symbol: %s (%d)", packetP->data[i].accountId, packetP->data[i].symbol, packetP->data[i].symbolId);
       goto failXit;
     }
   }
 
   ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
   return ret;
   
  failXit:
@@ -134,3 +183,99 @@ benchmark_sell2(void *data_packetH,
 
   return BENCHMARK_FAIL;
 }
+
+int
+benchmark_sell2(void *data_packetH,
+                void *benchmark_handle)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  benchmark_data_packet_t *packetP = data_packetH;
+  benchmark_data_packet_t ordered;
+  int ret;
+
+  benchmarkP = benchmark_handle;
+  if (benchmarkP == NULL || data_packetH == NULL) {
+    benchmark_error("Invalid arguments");
+    return BENCHMARK_FAIL;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  data_packet_status_reset(data_packetH);
+
+  /* A single order can share a transaction with concurrent ones */
+  if (GROUP_COMMIT_ENABLED(benchmarkP) && packetP->used == 1) {
+    ret = group_commit_order(1, packetP->data, benchmarkP);
+    data_packet_status_set(data_packetH, ret);
+    return ret;
+  }
+
+  /* Every attempt applies the packet in the same canonical order */
+  if (benchmarkP->config.packet_order) {
+    if (data_packet_order(data_packetH, 1, &ordered, benchmarkP) != BENCHMARK_SUCCESS) {
+      data_packet_status_set(data_packetH, BENCHMARK_FAIL);
+      return BENCHMARK_FAIL;
+    }
+    ret = xact_retry_run(BENCHMARK_XACT_SELL, sell2_attempt, &ordered, benchmarkP);
+    data_packet_status_unorder(data_packetH, &ordered);
+    data_packet_order_free(&ordered);
+  }
+  else {
+    ret = xact_retry_run(BENCHMARK_XACT_SELL, sell2_attempt, data_packetH, benchmarkP);
+  }
+
+  /* Entries share the outcome of the packet, unless they were
+   * committed one by one into a packet that committed */
+  if (!benchmarkP->config.packet_partial || ret != BENCHMARK_SUCCESS) {
+    data_packet_status_set(data_packetH, ret);
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Variants that run on a thread context, see thread_ctx.c
+ *----------------------------------------------------------*/
+
+int
+benchmark_sell_ctx(int    account,
+                   int    symbol,
+                   float  price,
+                   int    amount,
+                   int    force_apply,
+                   void  *thread_ctx_handle,
+                   int   *symbol_ret)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_sell(account, symbol, price, amount, force_apply, benchmarkP, symbol_ret);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_sell2_ctx(void *data_packetH,
+                    void *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_sell2(data_packetH, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
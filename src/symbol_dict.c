@@ -0,0 +1,161 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  symbol_dict.c
+ *
+ *    Description:  Maps stock symbols to dense integer ids. Ids are the
+ *                  position of the symbol in the Stocks table, so they can
+ *                  be rebuilt by any handle opened on the same databases.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include "benchmark_stocks.h"
+
+/* FNV-1a over the NUL terminated symbol */
+static u_int32_t
+symbol_hash(const char *symbol)
+{
+  u_int32_t hash = 2166136261u;
+
+  while (*symbol != '\0') {
+    hash ^= (unsigned char) *symbol++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/*-------------------------------------------------------
+ * Builds the symbol dictionary from the Stocks table.
+ * It is fine for the table to be empty, e.g. right 
+ * after the databases are created; in that case the
+ * dictionary is simply empty.
+ *-----------------------------------------------------*/
+int
+symbol_dict_load(BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t num_slots;
+  u_int32_t slot;
+  int       i;
+
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  symbol_dict_free(benchmarkP);
+
+  if (benchmark_stocks_symbols_get(benchmarkP) != BENCHMARK_SUCCESS) {
+    benchmark_error("Failed to retrieve list of symbols");
+    goto failXit;
+  }
+
+  /* Keep the table at most half full */
+  num_slots = 16;
+  while (num_slots < 2 * (u_int32_t) benchmarkP->number_stocks) {
+    num_slots <<= 1;
+  }
+
+  benchmarkP->symbol_slots = calloc(num_slots, sizeof(u_int32_t));
+  if (benchmarkP->symbol_slots == NULL) {
+    benchmark_error("Could not allocate symbol dictionary");
+    goto failXit;
+  }
+  benchmarkP->symbol_slots_mask = num_slots - 1;
+
+  for (i = 0; i < benchmarkP->number_stocks; i++) {
+    slot = symbol_hash(benchmarkP->stocks[i]) & benchmarkP->symbol_slots_mask;
+    while (benchmarkP->symbol_slots[slot] != 0) {
+      slot = (slot + 1) & benchmarkP->symbol_slots_mask;
+    }
+    benchmarkP->symbol_slots[slot] = i + 1;
+  }
+
+  benchmark_debug(5, "Symbol dictionary has %d symbols in %u slots", 
+                  benchmarkP->number_stocks, num_slots);
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (benchmarkP != NULL) {
+    symbol_dict_free(benchmarkP);
+  }
+  return BENCHMARK_FAIL;
+}
+
+int
+symbol_dict_lookup(const char *symbol, u_int32_t *symbol_id, BENCHMARK_DBS *benchmarkP)
+{
+  u_int32_t slot;
+  u_int32_t entry;
+
+  if (symbol == NULL || symbol_id == NULL || benchmarkP == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  if (benchmarkP->symbol_slots == NULL) {
+    goto failXit;
+  }
+
+  slot = symbol_hash(symbol) & benchmarkP->symbol_slots_mask;
+  while ((entry = benchmarkP->symbol_slots[slot]) != 0) {
+    if (strcmp(benchmarkP->stocks[entry - 1], symbol) == 0) {
+      *symbol_id = entry - 1;
+      return BENCHMARK_SUCCESS;
+    }
+    slot = (slot + 1) & benchmarkP->symbol_slots_mask;
+  }
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+/* Returns the symbol for symbol_id, or NULL if the id is unknown */
+const char *
+symbol_dict_name(u_int32_t symbol_id, BENCHMARK_DBS *benchmarkP)
+{
+  if (benchmarkP == NULL || benchmarkP->stocks == NULL
+      || symbol_id >= (u_int32_t) benchmarkP->number_stocks) {
+    return NULL;
+  }
+
+  return benchmarkP->stocks[symbol_id];
+}
+
+void
+symbol_dict_free(BENCHMARK_DBS *benchmarkP)
+{
+  int i;
+
+  if (benchmarkP == NULL) {
+    return;
+  }
+
+  if (benchmarkP->stocks != NULL) {
+    for (i=0; i<benchmarkP->number_stocks; i++) {
+      free(benchmarkP->stocks[i]);
+      benchmarkP->stocks[i] = NULL;
+    }
+    free(benchmarkP->stocks);
+    benchmarkP->stocks = NULL;
+  }
+  benchmarkP->number_stocks = 0;
+
+  free(benchmarkP->symbol_slots);
+  benchmarkP->symbol_slots = NULL;
+  benchmarkP->symbol_slots_mask = 0;
+}
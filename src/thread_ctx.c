@@ -0,0 +1,373 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  thread_ctx.c
+ *
+ *    Description:  Per worker thread context. Each worker allocates one
+ *                  context up front and passes it to the *_ctx variants of
+ *                  the API. While a call runs, the context is bound to the
+ *                  thread and supplies the random numbers, the result
+ *                  buffers, the transaction context and the scratch memory
+ *                  of the call, and collects its counters.
+ *
+ *                  Threads without a context read into buffers of their
+ *                  own, so no read needs Berkeley DB to allocate memory.
+ *                  The memory that is still allocated on behalf of the
+ *                  application is counted, so tests can check that
+ *                  reads don't allocate.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <pthread.h>
+
+#define SCRATCH_ALIGN   16
+
+/* Context bound to the calling thread, if any */
+static __thread benchmark_thread_ctx_t *thread_ctx = NULL;
+
+/* Read buffers of a thread without a bound context. The key frees
+ * their spill buffers when the thread exits. */
+static __thread thread_read_buf_t thread_buf;
+static __thread int               thread_buf_registered = 0;
+static pthread_key_t              thread_buf_key;
+static pthread_once_t             thread_buf_once = PTHREAD_ONCE_INIT;
+
+/* Allocations made for the application since the process started */
+static unsigned long              alloc_count = 0;
+
+benchmark_thread_ctx_t *
+thread_ctx_current(void)
+{
+  return thread_ctx;
+}
+
+/*
+ * Binds the context to the calling thread for the duration of an
+ * API call, and returns its benchmark handle.
+ */
+BENCHMARK_DBS *
+thread_ctx_enter(void *ctx_handle)
+{
+  benchmark_thread_ctx_t *ctxP = ctx_handle;
+
+  if (ctxP == NULL) {
+    benchmark_error("Invalid thread context");
+    return NULL;
+  }
+
+  assert(ctxP->magic == BENCHMARK_THREAD_CTX_MAGIC_WORD);
+  assert(thread_ctx == NULL);
+
+  ctxP->scratch_used = 0;
+  thread_ctx = ctxP;
+
+  return ctxP->benchmarkP;
+}
+
+void
+thread_ctx_leave(void)
+{
+  thread_ctx = NULL;
+}
+
+/* Uniform in [0, 2^31) */
+int
+thread_rand(void)
+{
+  u_int64_t x;
+
+  if (thread_ctx == NULL) {
+    return rand();
+  }
+
+  x = thread_ctx->rng_state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  thread_ctx->rng_state = x;
+
+  return (int)((x * 0x2545F4914F6CDD1DULL) >> 33);
+}
+
+/*
+ * Returns a temporary buffer that lives until the end of the API
+ * call. It comes from the arena of the bound context when it fits,
+ * and from malloc() otherwise; either way it must be given back with
+ * thread_scratch_free().
+ */
+void *
+thread_scratch_alloc(size_t size)
+{
+  benchmark_thread_ctx_t *ctxP = thread_ctx;
+  size_t offset;
+
+  if (ctxP != NULL) {
+    offset = (ctxP->scratch_used + SCRATCH_ALIGN - 1) & ~((size_t) SCRATCH_ALIGN - 1);
+    if (offset + size <= ctxP->scratch_size) {
+      ctxP->scratch_used = offset + size;
+      return ctxP->scratchP + offset;
+    }
+  }
+
+  thread_alloc_note();
+  return malloc(size);
+}
+
+void
+thread_scratch_free(void *bufferP)
+{
+  benchmark_thread_ctx_t *ctxP = thread_ctx;
+
+  if (bufferP == NULL) {
+    return;
+  }
+
+  /* Arena memory is reclaimed as a whole by the next call */
+  if (ctxP != NULL
+      && (char *)bufferP >= ctxP->scratchP
+      && (char *)bufferP < ctxP->scratchP + ctxP->scratch_size) {
+    return;
+  }
+
+  free(bufferP);
+}
+
+static void
+read_buf_spill_free(thread_read_buf_t *bufP)
+{
+  int i;
+
+  for (i = 0; i < READ_SPILL_TYPES; i++) {
+    free(bufP->spillP[i]);
+    bufP->spillP[i] = NULL;
+    bufP->spill_size[i] = 0;
+  }
+}
+
+static void
+thread_buf_destroy(void *argP)
+{
+  read_buf_spill_free(argP);
+}
+
+static void
+thread_buf_key_create(void)
+{
+  (void) pthread_key_create(&thread_buf_key, thread_buf_destroy);
+}
+
+thread_read_buf_t *
+thread_read_buf(void)
+{
+  if (thread_ctx != NULL) {
+    return &thread_ctx->read_buf;
+  }
+
+  return &thread_buf;
+}
+
+/*
+ * Returns a buffer of at least size bytes for a record that doesn't
+ * fit the read buffer meant for it. The buffer is valid until the
+ * next spill of the same kind.
+ */
+void *
+thread_spill_get(int which, u_int32_t size)
+{
+  thread_read_buf_t *bufP = thread_read_buf();
+  void *newP;
+
+  assert(which >= 0 && which < READ_SPILL_TYPES);
+
+  if (size <= bufP->spill_size[which]) {
+    return bufP->spillP[which];
+  }
+
+  if (bufP == &thread_buf && !thread_buf_registered) {
+    (void) pthread_once(&thread_buf_once, thread_buf_key_create);
+    (void) pthread_setspecific(thread_buf_key, bufP);
+    thread_buf_registered = 1;
+  }
+
+  newP = realloc(bufP->spillP[which], size);
+  if (newP == NULL) {
+    benchmark_error("Could not allocate spill buffer");
+    return NULL;
+  }
+  thread_alloc_note();
+
+  bufP->spillP[which] = newP;
+  bufP->spill_size[which] = size;
+
+  return newP;
+}
+
+void
+thread_alloc_note(void)
+{
+  __sync_fetch_and_add(&alloc_count, 1);
+}
+
+/* Allocation functions of the environment: Berkeley DB uses them for
+ * the memory it hands to the application (DB_DBT_MALLOC and
+ * DB_DBT_REALLOC records, statistics) */
+void *
+thread_db_malloc(size_t size)
+{
+  thread_alloc_note();
+  return malloc(size);
+}
+
+void *
+thread_db_realloc(void *bufferP, size_t size)
+{
+  thread_alloc_note();
+  return realloc(bufferP, size);
+}
+
+int
+benchmark_alloc_count_get(void          *benchmark_handle,
+                          unsigned long *count)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+
+  if (benchmarkP == NULL || count == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  *count = __sync_fetch_and_add(&alloc_count, 0);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_thread_ctx_alloc(void          *benchmark_handle,
+                           unsigned int   seed,
+                           void         **ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  benchmark_thread_ctx_t *ctxP = NULL;
+
+  if (benchmarkP == NULL || ctx_handle == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  *ctx_handle = NULL;
+
+  ctxP = calloc(1, sizeof(benchmark_thread_ctx_t));
+  if (ctxP == NULL) {
+    benchmark_error("Could not allocate thread context");
+    goto failXit;
+  }
+
+  ctxP->scratchP = malloc(BENCHMARK_THREAD_SCRATCH_SZ);
+  if (ctxP->scratchP == NULL) {
+    benchmark_error("Could not allocate scratch space");
+    goto failXit;
+  }
+
+  ctxP->magic = BENCHMARK_THREAD_CTX_MAGIC_WORD;
+  ctxP->benchmarkP = benchmarkP;
+  ctxP->scratch_size = BENCHMARK_THREAD_SCRATCH_SZ;
+
+  /* The generator must never be seeded with 0 */
+  ctxP->rng_state = ((u_int64_t) seed + 1) * 0x9E3779B97F4A7C15ULL;
+  if (ctxP->rng_state == 0) {
+    ctxP->rng_state = 1;
+  }
+
+  *ctx_handle = ctxP;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  if (ctxP != NULL) {
+    free(ctxP->scratchP);
+    free(ctxP);
+  }
+  return BENCHMARK_FAIL;
+}
+
+/* Snapshots are only possible when the handle has multiversion tables */
+int
+benchmark_thread_ctx_isolation_set(void *ctx_handle, int isolation)
+{
+  benchmark_thread_ctx_t *ctxP = ctx_handle;
+
+  if (ctxP == NULL
+      || isolation < BENCHMARK_ISOLATION_DEFAULT || isolation > BENCHMARK_ISOLATION_SERIALIZABLE) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  assert(ctxP->magic == BENCHMARK_THREAD_CTX_MAGIC_WORD);
+
+  if (isolation == BENCHMARK_ISOLATION_SNAPSHOT && !ctxP->benchmarkP->config.snapshot_reads) {
+    benchmark_error("Snapshot reads are not enabled");
+    goto failXit;
+  }
+
+  ctxP->isolation = isolation;
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
+
+int
+benchmark_thread_ctx_free(void *ctx_handle)
+{
+  benchmark_thread_ctx_t *ctxP = ctx_handle;
+  BENCHMARK_DBS *benchmarkP;
+  int i;
+
+  if (ctxP == NULL) {
+    benchmark_error("Invalid argument");
+    goto failXit;
+  }
+
+  assert(ctxP->magic == BENCHMARK_THREAD_CTX_MAGIC_WORD);
+  assert(thread_ctx != ctxP);
+
+  benchmarkP = ctxP->benchmarkP;
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  for (i = 0; i < BENCHMARK_XACT_TYPES; i++) {
+    __sync_fetch_and_add(&benchmarkP->retry_stats[i].attempts, ctxP->retry_stats[i].attempts);
+    __sync_fetch_and_add(&benchmarkP->retry_stats[i].conflicts, ctxP->retry_stats[i].conflicts);
+    __sync_fetch_and_add(&benchmarkP->retry_stats[i].retries, ctxP->retry_stats[i].retries);
+    __sync_fetch_and_add(&benchmarkP->retry_stats[i].exhausted, ctxP->retry_stats[i].exhausted);
+  }
+  __sync_fetch_and_add(&benchmarkP->cursor_opens, ctxP->cursor_opens);
+  __sync_fetch_and_add(&benchmarkP->cursor_reuses, ctxP->cursor_reuses);
+
+  ctxP->magic = 0;
+  read_buf_spill_free(&ctxP->read_buf);
+  free(ctxP->scratchP);
+  free(ctxP);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
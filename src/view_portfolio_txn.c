@@ -18,6 +18,17 @@
 
 #include "common/benchmark_common.h"
 
+typedef struct view_portfolio_args_t {
+  int           num_accounts;
+  const char  **account_list_P;
+} view_portfolio_args_t;
+
+typedef struct symbol_holders_args_t {
+  u_int32_t     symbol_id;
+  int           holders;
+  int           pending;
+} symbol_holders_args_t;
+
 int
 benchmark_portfolios_stats_get(void *benchmark_handle)
 {
@@ -46,14 +57,16 @@ benchmark_portfolios_stats_get(void *benchmark_handle)
     goto failXit;
   }
 
-  rc = portfolios_dbp->stat(portfolios_dbp, NULL, (void *)&portfolios_statsP, 0 /* no FAST_STAT */);
+  /* Portfolio ids come from a sequence, so there is no need to count
+   * the keys; the fast stat is enough for reporting */
+  rc = portfolios_dbp->stat(portfolios_dbp, NULL, (void *)&portfolios_statsP, DB_FAST_STAT);
   if (rc != 0) {
     envP->err(envP, rc, "[%s:%d] [%d] Failed to obtain stats from Portfolios table.", __FILE__, __LINE__, getpid());
     goto failXit; 
   }
 
-  benchmarkP->number_portfolios = portfolios_statsP->bt_nkeys;
-  benchmark_debug(5, "Number of keys in Portfolios table is: %d", benchmarkP->number_portfolios);
+  benchmark_debug(5, "Portfolios table has %u leaf pages, %u levels",
+                  portfolios_statsP->bt_leaf_pg, portfolios_statsP->bt_levels);
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
   goto cleanup;
@@ -70,6 +83,12 @@ cleanup:
   return rc;
 }
 
+static int
+view_portfolio_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  return show_portfolios(NULL, 0, NULL, benchmarkP);
+}
+
 int
 benchmark_view_portfolio(void *benchmark_handle)
 {
@@ -82,7 +101,7 @@ benchmark_view_portfolio(void *benchmark_handle)
   }
 
   BENCHMARK_CHECK_MAGIC(benchmarkP);
-  ret = show_portfolios(NULL, 0, NULL, benchmarkP);
+  ret = xact_retry_run(BENCHMARK_XACT_VIEW_PORTFOLIO, view_portfolio_attempt, NULL, benchmarkP);
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
   return (ret);
@@ -91,51 +110,235 @@ benchmark_view_portfolio(void *benchmark_handle)
   return BENCHMARK_FAIL;
 }
 
+static int
+view_portfolio2_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  view_portfolio_args_t *argsP = argP;
+  int num_accounts = argsP->num_accounts;
+  const char **account_list_P = argsP->account_list_P;
+  benchmark_xact_h xactH = NULL;
+  int i;
+  int ret;
+
+  ret = start_read_xact(&xactH, "VIEW_PORTFOLIO_TXN", benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  benchmark_debug(2, "Showing portfolio for: %d users", num_accounts);
+
+  for (i=0; i<num_accounts; i++) {
+    benchmark_debug(2, "Showing quote for user: %s", account_list_P[i]);
+    ret = show_portfolios((char *)account_list_P[i], 0, xactH, benchmarkP);
+    if (ret != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
+  }
+
+  ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
+
+  return ret;
+
+ failXit:
+  if (xactH != NULL) {
+    abort_xact(xactH, benchmarkP);
+  }
+
+  return BENCHMARK_FAIL;
+}
+
 int
 benchmark_view_portfolio2(int           num_accounts, 
                           const char    **account_list_P, 
                           void          *benchmark_handle)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
-  benchmark_xact_h xactH = NULL;
-  int i;
+  view_portfolio_args_t args;
   int ret;
 
   benchmarkP = benchmark_handle;
   if (benchmarkP == NULL) {
-    goto failXit;
+    return BENCHMARK_FAIL;
   }
   
   BENCHMARK_CHECK_MAGIC(benchmarkP);
 
-  ret = start_xact(&xactH, "VIEW_PORTFOLIO_TXN", benchmarkP);
+  args.num_accounts = num_accounts;
+  args.account_list_P = account_list_P;
+  ret = xact_retry_run(BENCHMARK_XACT_VIEW_PORTFOLIO, view_portfolio2_attempt, &args, benchmarkP);
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  return ret;
+}
+
+static int
+symbol_holders_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  symbol_holders_args_t *argsP = argP;
+  benchmark_xact_h xactH = NULL;
+  PORTFOLIO_SCAN scan;
+  PORTFOLIOS *portfolioP = NULL;
+  int holders = 0;
+  int pending = 0;
+  int ret;
+
+  memset(&scan, 0, sizeof(PORTFOLIO_SCAN));
+
+  ret = start_read_xact(&xactH, "SYMBOL_HOLDERS_TXN", benchmarkP);
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  benchmark_debug(2, "Showing portfolio for: %d users", num_accounts);
+  ret = holders_scan_open(argsP->symbol_id, xactH, &scan, benchmarkP);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
+  }
 
-  for (i=0; i<num_accounts; i++) {
-    benchmark_debug(2, "Showing quote for user: %s", account_list_P[i]);
-    ret = show_portfolios((char *)account_list_P[i], 0, xactH, benchmarkP);
+  for (;;) {
+    ret = portfolio_scan_next(&scan, &portfolioP);
     if (ret != BENCHMARK_SUCCESS) {
       goto failXit;
     }
+
+    if (portfolioP == NULL) {
+      break;
+    }
+
+    holders ++;
+    if (portfolioP->to_buy || portfolioP->to_sell) {
+      pending ++;
+    }
+  }
+
+  ret = portfolio_scan_close(&scan);
+  if (ret != BENCHMARK_SUCCESS) {
+    goto failXit;
   }
 
   ret = commit_xact(xactH, benchmarkP);
+  xactH = NULL;
   if (ret != BENCHMARK_SUCCESS) {
     goto failXit;
   }
 
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
+  benchmark_debug(4, "Symbol %u has %d holders, %d with pending orders", argsP->symbol_id, holders, pending);
 
-  return ret;
+  argsP->holders = holders;
+  argsP->pending = pending;
+
+  return BENCHMARK_SUCCESS;
 
  failXit:
+  portfolio_scan_close(&scan);
   if (xactH != NULL) {
     abort_xact(xactH, benchmarkP);
   }
 
   return BENCHMARK_FAIL;
 }
+
+/*
+ * Counts the portfolios that hold symbol, and how many of them have a
+ * pending buy or sell order. This is the fan-out that a price change
+ * on symbol has to re-evaluate; it only visits the holders of symbol.
+ */
+int
+benchmark_symbol_holders_get(void *benchmark_handle,
+                             int   symbol,
+                             int  *num_holders,
+                             int  *num_pending)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  symbol_holders_args_t args;
+  int ret;
+
+  benchmarkP = benchmark_handle;
+  if (benchmarkP == NULL || num_holders == NULL || num_pending == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  if (symbol < 0 || symbol >= benchmarkP->number_stocks) {
+    benchmark_error("Invalid symbol id: %d", symbol);
+    return BENCHMARK_FAIL;
+  }
+
+  memset(&args, 0, sizeof(symbol_holders_args_t));
+  args.symbol_id = (u_int32_t) symbol;
+
+  ret = xact_retry_run(BENCHMARK_XACT_VIEW_PORTFOLIO, symbol_holders_attempt, &args, benchmarkP);
+  if (ret == BENCHMARK_SUCCESS) {
+    *num_holders = args.holders;
+    *num_pending = args.pending;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Variants that run on a thread context, see thread_ctx.c
+ *----------------------------------------------------------*/
+
+int
+benchmark_view_portfolio_ctx(void *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_view_portfolio(benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_view_portfolio2_ctx(int          num_accounts,
+                              const char **account_list_P,
+                              void        *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_view_portfolio2(num_accounts, account_list_P, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_symbol_holders_get_ctx(void *thread_ctx_handle,
+                                 int   symbol,
+                                 int  *num_holders,
+                                 int  *num_pending)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_symbol_holders_get(benchmarkP, symbol, num_holders, num_pending);
+
+  thread_ctx_leave();
+  return ret;
+}
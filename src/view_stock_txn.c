@@ -19,15 +19,24 @@
 #include "common/benchmark_common.h"
 #include "benchmark_stocks.h"
 
+typedef struct view_stock_args_t {
+  int           num_symbols;
+  const char  **symbol_list_P;
+} view_stock_args_t;
 
+static int
+view_stock_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
+{
+  return show_quote_by_id(*(u_int32_t *)argP, NULL, benchmarkP);
+}
 
 int
 benchmark_view_stock(void *benchmark_handle, int *symbolP)
 {
   BENCHMARK_DBS *benchmarkP = NULL;
+  u_int32_t symbol_id;
   int ret;
   int symbol;
-  char *random_symbol;
 
   benchmarkP = benchmark_handle;
   if (benchmarkP == NULL) {
@@ -46,14 +55,15 @@ benchmark_view_stock(void *benchmark_handle, int *symbolP)
     symbol = *symbolP;
   }
   else {
-    symbol = rand() % benchmarkP->number_stocks;
+    symbol = thread_rand() % benchmarkP->number_stocks;
   } 
 
-  random_symbol = benchmarkP->stocks[symbol];
 #if 0
+  random_symbol = benchmarkP->stocks[symbol];
   ret = show_stocks_records(random_symbol, benchmarkP);
 #endif
-  ret = show_quote(random_symbol, NULL, benchmarkP);
+  symbol_id = symbol;
+  ret = xact_retry_run(BENCHMARK_XACT_VIEW_STOCK, view_stock_attempt, &symbol_id, benchmarkP);
 
   if (symbolP != NULL) {
     *symbolP = symbol;
@@ -71,44 +81,54 @@ benchmark_view_stock(void *benchmark_handle, int *symbolP)
   return BENCHMARK_FAIL;
 }
 
-int
-benchmark_view_stock2(int num_symbols, const char **symbol_list_P, void *benchmark_handle)
+static int
+view_stock2_attempt(void *argP, BENCHMARK_DBS *benchmarkP)
 {
-  BENCHMARK_DBS *benchmarkP = NULL;
+  view_stock_args_t *argsP = argP;
+  int num_symbols = argsP->num_symbols;
+  const char **symbol_list_P = argsP->symbol_list_P;
   benchmark_xact_h xactH = NULL;
+  u_int32_t symbol_id;
+  QUOTE quote;
   int i;
   int ret;
 
-  benchmarkP = benchmark_handle;
-  if (benchmarkP == NULL) {
-    benchmark_error("Invalid benchmark handle");
-    goto failXit;
-  }
-  
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
-  ret = start_xact(&xactH, "VIEW_STOCK_TXN", benchmarkP);
-  if (ret != BENCHMARK_SUCCESS) {
-    goto failXit;
-  }
-
   benchmark_debug(2, "Showing quotes for: %d symbols", num_symbols);
 
   for (i=0; i<num_symbols; i++) {
     benchmark_debug(2, "Showing quote for symbol: %s", symbol_list_P[i]);
+
+    /* Quotes served by the cache don't need a transaction, so 
+     * only start one if we actually have to go to the database */
+    if (QUOTE_CACHE_ENABLED(benchmarkP)
+        && read_isolation_get(benchmarkP) != BENCHMARK_ISOLATION_SERIALIZABLE
+        && symbol_dict_lookup(symbol_list_P[i], &symbol_id, benchmarkP) == BENCHMARK_SUCCESS
+        && quote_cache_read(symbol_id, &quote, benchmarkP) == BENCHMARK_SUCCESS) {
+      continue;
+    }
+
+    if (xactH == NULL) {
+      ret = start_read_xact(&xactH, "VIEW_STOCK_TXN", benchmarkP);
+      if (ret != BENCHMARK_SUCCESS) {
+        goto failXit;
+      }
+    }
+
     ret = show_quote((char *)symbol_list_P[i], xactH, benchmarkP);
     if (ret != BENCHMARK_SUCCESS) {
       goto failXit;
     }
   }
 
-  ret = commit_xact(xactH, benchmarkP);
-  if (ret != BENCHMARK_SUCCESS) {
-    goto failXit;
+  ret = BENCHMARK_SUCCESS;
+  if (xactH != NULL) {
+    ret = commit_xact(xactH, benchmarkP);
+    xactH = NULL;
+    if (ret != BENCHMARK_SUCCESS) {
+      goto failXit;
+    }
   }
 
-  BENCHMARK_CHECK_MAGIC(benchmarkP);
-
   return ret;
 
  failXit:
@@ -118,3 +138,68 @@ benchmark_view_stock2(int num_symbols, const char **symbol_list_P, void *benchma
 
   return BENCHMARK_FAIL;
 }
+
+int
+benchmark_view_stock2(int num_symbols, const char **symbol_list_P, void *benchmark_handle)
+{
+  BENCHMARK_DBS *benchmarkP = NULL;
+  view_stock_args_t args;
+  int ret;
+
+  benchmarkP = benchmark_handle;
+  if (benchmarkP == NULL) {
+    benchmark_error("Invalid benchmark handle");
+    return BENCHMARK_FAIL;
+  }
+  
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  args.num_symbols = num_symbols;
+  args.symbol_list_P = symbol_list_P;
+  ret = xact_retry_run(BENCHMARK_XACT_VIEW_STOCK, view_stock2_attempt, &args, benchmarkP);
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  return ret;
+}
+
+/*------------------------------------------------------------
+ * Variants that run on a thread context, see thread_ctx.c
+ *----------------------------------------------------------*/
+
+int
+benchmark_view_stock_ctx(void *thread_ctx_handle,
+                         int  *symbolP)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_view_stock(benchmarkP, symbolP);
+
+  thread_ctx_leave();
+  return ret;
+}
+
+int
+benchmark_view_stock2_ctx(int          num_symbols,
+                          const char **symbol_list_P,
+                          void        *thread_ctx_handle)
+{
+  BENCHMARK_DBS *benchmarkP;
+  int ret;
+
+  benchmarkP = thread_ctx_enter(thread_ctx_handle);
+  if (benchmarkP == NULL) {
+    return BENCHMARK_FAIL;
+  }
+
+  ret = benchmark_view_stock2(num_symbols, symbol_list_P, benchmarkP);
+
+  thread_ctx_leave();
+  return ret;
+}
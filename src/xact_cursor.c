@@ -0,0 +1,245 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  xact_cursor.c
+ *
+ *    Description:  Cursors owned by a transaction. A transaction started
+ *                  with start_xact() opens one cursor per table the first
+ *                  time an operation needs it, and hands the same cursor to
+ *                  every later operation. The cursors are closed right
+ *                  before the transaction commits or aborts.
+ *
+ *                  Transactions begun internally (without start_xact())
+ *                  have no context, so their operations still open and
+ *                  close cursors of their own.
+ *
+ *                  A thread with a bound thread context reuses the
+ *                  transaction context embedded in it; other threads
+ *                  reuse one of their own, so starting a transaction
+ *                  doesn't allocate memory. Only a thread running two
+ *                  transactions at once allocates a context.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <errno.h>
+
+/* Context of the running transaction of a thread without a bound
+ * thread context */
+static __thread xact_ctx_t thread_xact;
+static __thread int        thread_xact_in_use = 0;
+
+/* Returns the table behind a cursor type, and the flags its cursors
+ * are opened with */
+static DB *
+xact_cursor_db(int which, u_int32_t *flagsP, BENCHMARK_DBS *benchmarkP)
+{
+  switch (which) {
+    case XACT_CURSOR_QUOTES:
+      *flagsP = DB_READ_COMMITTED;
+      return benchmarkP->quotes_dbp;
+
+    case XACT_CURSOR_PORTFOLIOS:
+      *flagsP = DB_READ_COMMITTED;
+      return benchmarkP->portfolios_dbp;
+
+    case XACT_CURSOR_HOLDINGS:
+      *flagsP = 0;
+      return benchmarkP->portfolios_holdings_sdbp;
+
+    default:
+      return NULL;
+  }
+}
+
+int
+xact_ctx_attach(DB_TXN *txnP)
+{
+  benchmark_thread_ctx_t *thread_ctxP = thread_ctx_current();
+  xact_ctx_t *ctxP;
+
+  if (thread_ctxP != NULL && !thread_ctxP->xact_in_use) {
+    ctxP = &thread_ctxP->xact;
+    memset(ctxP, 0, sizeof(xact_ctx_t));
+    thread_ctxP->xact_in_use = 1;
+    txnP->app_private = ctxP;
+    return BENCHMARK_SUCCESS;
+  }
+
+  if (thread_ctxP == NULL && !thread_xact_in_use) {
+    ctxP = &thread_xact;
+    memset(ctxP, 0, sizeof(xact_ctx_t));
+    thread_xact_in_use = 1;
+    txnP->app_private = ctxP;
+    return BENCHMARK_SUCCESS;
+  }
+
+  ctxP = calloc(1, sizeof(xact_ctx_t));
+  if (ctxP == NULL) {
+    benchmark_error("Could not allocate transaction context");
+    return BENCHMARK_FAIL;
+  }
+  thread_alloc_note();
+
+  txnP->app_private = ctxP;
+
+  return BENCHMARK_SUCCESS;
+}
+
+/*
+ * Closes the cursors of txnP and frees its context. Must be called
+ * before txnP is resolved; pending quote updates must have been
+ * taken already.
+ */
+int
+xact_ctx_release(DB_TXN *txnP, BENCHMARK_DBS *benchmarkP)
+{
+  xact_ctx_t *ctxP = XACT_CTX(txnP);
+  DB_ENV     *envP = benchmarkP->envP;
+  int         ret = BENCHMARK_SUCCESS;
+  int         rc;
+  int         i;
+
+  if (ctxP == NULL) {
+    return BENCHMARK_SUCCESS;
+  }
+
+  for (i = 0; i < XACT_CURSOR_TYPES; i++) {
+    if (ctxP->cursors[i] == NULL) {
+      continue;
+    }
+
+    rc = ctxP->cursors[i]->close(ctxP->cursors[i]);
+    if (rc != 0) {
+      envP->err(envP, rc, "[%s:%d] [%d] Failed to close cursor.", __FILE__, __LINE__, getpid());
+      ret = BENCHMARK_FAIL;
+    }
+    ctxP->cursors[i] = NULL;
+  }
+
+  assert(ctxP->quote_pendingP == NULL);
+
+  txnP->app_private = NULL;
+  if (thread_ctx_current() != NULL && ctxP == &thread_ctx_current()->xact) {
+    thread_ctx_current()->xact_in_use = 0;
+  }
+  else if (ctxP == &thread_xact) {
+    thread_xact_in_use = 0;
+  }
+  else {
+    free(ctxP);
+  }
+
+  return ret;
+}
+
+/*
+ * Returns in cursorPP a cursor of txnP over the given table. The
+ * cursor may have been used by an earlier operation, so it must be
+ * positioned before use, and given back with xact_cursor_release().
+ */
+int
+xact_cursor_get(DB_TXN *txnP, int which, DBC **cursorPP, BENCHMARK_DBS *benchmarkP)
+{
+  benchmark_thread_ctx_t *thread_ctxP = thread_ctx_current();
+  xact_ctx_t *ctxP = XACT_CTX(txnP);
+  DB         *dbP;
+  u_int32_t   flags = 0;
+  int         rc;
+
+  dbP = xact_cursor_db(which, &flags, benchmarkP);
+  if (dbP == NULL) {
+    benchmark_error("No table for cursor type %d", which);
+    return EINVAL;
+  }
+
+  /* Read only transactions read at their own level */
+  if (ctxP != NULL && ctxP->isolation != BENCHMARK_ISOLATION_DEFAULT) {
+    flags = read_cursor_flags(ctxP->isolation);
+  }
+
+  if (ctxP != NULL && ctxP->cursors[which] != NULL) {
+    if (thread_ctxP != NULL) {
+      thread_ctxP->cursor_reuses ++;
+    }
+    else {
+      __sync_fetch_and_add(&benchmarkP->cursor_reuses, 1);
+    }
+    *cursorPP = ctxP->cursors[which];
+    return 0;
+  }
+
+  rc = dbP->cursor(dbP, txnP, cursorPP, flags);
+  if (rc != 0) {
+    *cursorPP = NULL;
+    return rc;
+  }
+
+  if (thread_ctxP != NULL) {
+    thread_ctxP->cursor_opens ++;
+  }
+  else {
+    __sync_fetch_and_add(&benchmarkP->cursor_opens, 1);
+  }
+
+  if (ctxP != NULL && benchmarkP->config.cursor_cache) {
+    ctxP->cursors[which] = *cursorPP;
+  }
+
+  return 0;
+}
+
+/* Closes cursorP, unless it is cached by txnP */
+int
+xact_cursor_release(DB_TXN *txnP, DBC *cursorP, BENCHMARK_DBS *benchmarkP)
+{
+  xact_ctx_t *ctxP = XACT_CTX(txnP);
+  int         i;
+
+  if (cursorP == NULL) {
+    return 0;
+  }
+
+  if (ctxP != NULL) {
+    for (i = 0; i < XACT_CURSOR_TYPES; i++) {
+      if (ctxP->cursors[i] == cursorP) {
+        return 0;
+      }
+    }
+  }
+
+  return cursorP->close(cursorP);
+}
+
+/* Counts of live thread contexts are added when they are freed */
+int
+benchmark_cursor_stats_get(void          *benchmark_handle,
+                           unsigned long *opened,
+                           unsigned long *reused)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+
+  if (benchmarkP == NULL || opened == NULL || reused == NULL) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  *opened = __sync_fetch_and_add(&benchmarkP->cursor_opens, 0);
+  *reused = __sync_fetch_and_add(&benchmarkP->cursor_reuses, 0);
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
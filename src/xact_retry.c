@@ -0,0 +1,173 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  xact_retry.c
+ *
+ *    Description:  Retries transactions that lose a lock conflict. Failures
+ *                  caused by DB_LOCK_DEADLOCK or DB_LOCK_NOTGRANTED are noted
+ *                  in a per thread flag where the Berkeley DB call fails; the
+ *                  transaction is then run again after a jittered exponential
+ *                  backoff, until the retry budget runs out.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Ricardo Zavaleta (rj.zavaleta@gmail.com)
+ *   Organization:  Cinvestav
+ *
+ * =====================================================================================
+ */
+
+#include "common/benchmark_common.h"
+#include <stdint.h>
+#include <time.h>
+
+/* Set when a Berkeley DB call of the running attempt lost a lock conflict */
+static __thread int xact_conflict = 0;
+
+/* Backoff jitter; seeded the first time a thread backs off */
+static __thread unsigned int xact_backoff_seed = 0;
+
+void
+xact_conflict_note(int db_rc)
+{
+  if (db_rc == DB_LOCK_DEADLOCK || db_rc == DB_LOCK_NOTGRANTED) {
+    xact_conflict = 1;
+  }
+}
+
+int
+xact_conflict_pending(void)
+{
+  return xact_conflict;
+}
+
+static void
+xact_backoff(int retry, const benchmark_config_t *configP)
+{
+  struct timespec delay;
+  u_int32_t usec;
+
+  if (configP->retry_backoff_usec == 0) {
+    return;
+  }
+
+  if (xact_backoff_seed == 0) {
+    xact_backoff_seed = (unsigned int) time(NULL) ^ (unsigned int)(uintptr_t) &xact_backoff_seed;
+  }
+
+  /* Double the window on every retry, up to the maximum, and
+   * sleep for a random time within it */
+  usec = configP->retry_backoff_usec;
+  while (retry-- > 0 && usec < configP->retry_backoff_max_usec) {
+    usec <<= 1;
+  }
+  if (usec > configP->retry_backoff_max_usec) {
+    usec = configP->retry_backoff_max_usec;
+  }
+
+  usec = usec / 2 + rand_r(&xact_backoff_seed) % (usec / 2 + 1);
+
+  delay.tv_sec = usec / 1000000;
+  delay.tv_nsec = (usec % 1000000) * 1000;
+  nanosleep(&delay, NULL);
+}
+
+/*
+ * Runs attemptP until it succeeds, fails for a reason other than a lock
+ * conflict, or the retry budget runs out. Each attempt must run and
+ * resolve a whole transaction of its own.
+ *
+ * Returns BENCHMARK_SUCCESS, BENCHMARK_FAIL, or BENCHMARK_RETRY_EXHAUSTED
+ * if the last attempt still lost a lock conflict.
+ */
+int
+xact_retry_run(int                xact_type,
+               xact_attempt_fn    attemptP,
+               void              *argP,
+               BENCHMARK_DBS     *benchmarkP)
+{
+  xact_retry_stats_t *statsP;
+  int retry = 0;
+  int rc;
+
+  assert(xact_type >= 0 && xact_type < BENCHMARK_XACT_TYPES);
+
+  /* A bound thread context keeps counters of its own */
+  if (thread_ctx_current() != NULL) {
+    statsP = &thread_ctx_current()->retry_stats[xact_type];
+  }
+  else {
+    statsP = &benchmarkP->retry_stats[xact_type];
+  }
+
+  for (;;) {
+    xact_conflict = 0;
+    __sync_fetch_and_add(&statsP->attempts, 1);
+
+    rc = attemptP(argP, benchmarkP);
+    if (rc == BENCHMARK_SUCCESS) {
+      return BENCHMARK_SUCCESS;
+    }
+
+    if (!xact_conflict) {
+      return BENCHMARK_FAIL;
+    }
+
+    __sync_fetch_and_add(&statsP->conflicts, 1);
+
+    if (retry >= benchmarkP->config.retry_max) {
+      __sync_fetch_and_add(&statsP->exhausted, 1);
+      benchmark_warning("Transaction type %d gave up after %d retries", xact_type, retry);
+      return BENCHMARK_RETRY_EXHAUSTED;
+    }
+
+    xact_backoff(retry, &benchmarkP->config);
+
+    retry ++;
+    __sync_fetch_and_add(&statsP->retries, 1);
+    benchmark_debug(BENCHMARK_DEBUG_LEVEL_XACT, "Retrying transaction type %d (%d)", xact_type, retry);
+  }
+}
+
+/* Counts of live thread contexts are added when they are freed */
+int
+benchmark_retry_stats_get(void          *benchmark_handle,
+                          int            xact_type,
+                          unsigned long *attempts,
+                          unsigned long *deadlocks,
+                          unsigned long *retries,
+                          unsigned long *exhausted)
+{
+  BENCHMARK_DBS *benchmarkP = benchmark_handle;
+  xact_retry_stats_t *statsP;
+
+  if (benchmarkP == NULL || xact_type < 0 || xact_type >= BENCHMARK_XACT_TYPES) {
+    benchmark_error("Invalid arguments");
+    goto failXit;
+  }
+
+  BENCHMARK_CHECK_MAGIC(benchmarkP);
+
+  statsP = &benchmarkP->retry_stats[xact_type];
+
+  if (attempts != NULL) {
+    *attempts = __sync_fetch_and_add(&statsP->attempts, 0);
+  }
+  if (deadlocks != NULL) {
+    *deadlocks = __sync_fetch_and_add(&statsP->conflicts, 0);
+  }
+  if (retries != NULL) {
+    *retries = __sync_fetch_and_add(&statsP->retries, 0);
+  }
+  if (exhausted != NULL) {
+    *exhausted = __sync_fetch_and_add(&statsP->exhausted, 0);
+  }
+
+  return BENCHMARK_SUCCESS;
+
+failXit:
+  return BENCHMARK_FAIL;
+}
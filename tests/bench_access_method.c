@@ -0,0 +1,225 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_access_method.c
+ *
+ *    Description:  Compare point lookup throughput and lock contention on the
+ *                  Quotes table when the catalogs are opened as btrees and
+ *                  as hash tables.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+
+/* A bit above the number of rows in the catalog files */
+#define QUOTES_NELEM    4096
+#define STOCKS_NELEM    4096
+#define PERSONAL_NELEM  64
+
+typedef struct worker_t {
+  pthread_t     thread;
+  BENCHMARK_H   benchmarkH;
+  int           num_stocks;
+  int           update_pct;
+  unsigned int  seed;
+  volatile int *stopP;
+  long          lookups;
+  long          updates;
+  long          failures;
+} worker_t;
+
+static void *
+worker_main(void *argP)
+{
+  worker_t *workerP = argP;
+  int symbol;
+
+  while (!*workerP->stopP) {
+    symbol = rand_r(&workerP->seed) % workerP->num_stocks;
+
+    if ((int)(rand_r(&workerP->seed) % 100) < workerP->update_pct) {
+      float price = (rand_r(&workerP->seed) % 1000) + 1;
+      if (benchmark_refresh_quotes(workerP->benchmarkH, &symbol, price) == SUCCESS) {
+        workerP->updates ++;
+      }
+      else {
+        workerP->failures ++;
+      }
+    }
+    else {
+      if (benchmark_view_stock(workerP->benchmarkH, &symbol) == SUCCESS) {
+        workerP->lookups ++;
+      }
+      else {
+        workerP->failures ++;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static int
+run(const char *label, int access_method, int num_threads, int seconds, int update_pct)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  worker_t      workers[MAX_THREADS];
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  volatile int  stop = 0;
+  unsigned long nrequests_start, nwaits_start, ndeadlocks_start;
+  unsigned long nrequests, nwaits, ndeadlocks;
+  long          lookups = 0;
+  long          updates = 0;
+  long          failures = 0;
+  int           i;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to allocate configuration\n");
+    goto failXit;
+  }
+
+  if (benchmark_config_access_method_set(configH, BENCHMARK_TABLE_QUOTES, access_method, QUOTES_NELEM) != SUCCESS
+      || benchmark_config_access_method_set(configH, BENCHMARK_TABLE_STOCKS, access_method, STOCKS_NELEM) != SUCCESS
+      || benchmark_config_access_method_set(configH, BENCHMARK_TABLE_PERSONAL, access_method, PERSONAL_NELEM) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set access method\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  if (benchmark_lock_stats_get(benchmarkH, &nrequests_start, &nwaits_start, &ndeadlocks_start) != SUCCESS) {
+    goto failXit;
+  }
+
+  for (i = 0; i < num_threads; i++) {
+    memset(&workers[i], 0, sizeof(worker_t));
+    workers[i].benchmarkH = benchmarkH;
+    workers[i].num_stocks = num_stocks;
+    workers[i].update_pct = update_pct;
+    workers[i].seed = i + 1;
+    workers[i].stopP = &stop;
+    if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start worker\n");
+      stop = 1;
+      num_threads = i;
+      break;
+    }
+  }
+
+  sleep(seconds);
+  stop = 1;
+
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+    lookups += workers[i].lookups;
+    updates += workers[i].updates;
+    failures += workers[i].failures;
+  }
+
+  if (benchmark_lock_stats_get(benchmarkH, &nrequests, &nwaits, &ndeadlocks) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "%8s %14.0f %14.0f %10ld %12lu %10lu %10lu\n",
+          label,
+          (double) lookups / seconds,
+          (double) updates / seconds,
+          failures,
+          nrequests - nrequests_start,
+          nwaits - nwaits_start,
+          ndeadlocks - ndeadlocks_start);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_threads = 4;
+  int seconds = 5;
+  int update_pct = 20;
+
+  if (argc > 1) {
+    num_threads = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    seconds = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    update_pct = atoi(argv[3]);
+  }
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS || seconds <= 0) {
+    fprintf(stderr, "Usage: %s [threads (1-%d)] [seconds] [update %%]\n", argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "threads: %d, seconds: %d, updates: %d%%\n\n", num_threads, seconds, update_pct);
+  fprintf(stdout, "%8s %14s %14s %10s %12s %10s %10s\n",
+          "method", "lookups/s", "updates/s", "failed", "lock reqs", "lock waits", "deadlocks");
+
+  if (run("btree", BENCHMARK_ACCESS_BTREE, num_threads, seconds, update_pct) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("hash", BENCHMARK_ACCESS_HASH, num_threads, seconds, update_pct) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
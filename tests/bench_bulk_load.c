@@ -0,0 +1,127 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_bulk_load.c
+ *
+ *    Description:  Measure how long the initial load takes when each row
+ *                  is put in a transaction of its own, when rows are put
+ *                  in batches, when the batches skip the log, and when
+ *                  the tables are loaded by several threads.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+static int
+run(const char *label, int batch_rows, int not_durable, int num_threads)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  struct timespec start, end;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_bulk_load_set(configH, batch_rows, not_durable) != SUCCESS
+      || benchmark_config_parallel_load_set(configH, num_threads) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "%12s %10d %10d %12.1f\n", label, batch_rows, num_threads,
+          elapsed_usec(&start, &end) / 1000.0);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int batch_rows = 1000;
+  int num_threads = 4;
+
+  if (argc > 1) {
+    batch_rows = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_threads = atoi(argv[2]);
+  }
+
+  if (batch_rows <= 0 || num_threads <= 1) {
+    fprintf(stderr, "Usage: %s [rows per transaction] [threads (> 1)]\n", argv[0]);
+    goto failXit;
+  }
+
+  fprintf(stdout, "%12s %10s %10s %12s\n", "mode", "batch", "threads", "load (ms)");
+
+  if (run("row", 1, 0, 1) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("batch", batch_rows, 0, 1) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("not durable", batch_rows, 1, 1) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("parallel", batch_rows, 0, num_threads) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
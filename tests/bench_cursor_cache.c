@@ -0,0 +1,203 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_cursor_cache.c
+ *
+ *    Description:  Measure the cost per item of large purchase and sell
+ *                  packets, with and without the per transaction cursor
+ *                  cache.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define NUM_ACCOUNTS    50
+#define PACKET_SZ       100
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/*
+ * Sends num_packets packets of PACKET_SZ items, walking the (account,
+ * symbol) pairs in order. Returns the time spent in the packets that
+ * succeeded and the number of items they carried.
+ */
+static int
+run_packets(int is_sell, int num_packets, char **stocks_list, int num_stocks,
+            double *usec, long *items, BENCHMARK_H benchmarkH)
+{
+  BENCHMARK_DATA_PACKET_H packetH = NULL;
+  struct timespec start, end;
+  char account[16];
+  int  pair = 0;
+  int  rc;
+  int  i, p;
+
+  *usec = 0;
+  *items = 0;
+
+  for (p = 0; p < num_packets; p++) {
+    if (benchmark_data_packet_alloc(PACKET_SZ, &packetH) != SUCCESS) {
+      goto failXit;
+    }
+
+    for (i = 0; i < PACKET_SZ; i++, pair++) {
+      int symbol = (pair / NUM_ACCOUNTS) % num_stocks;
+      snprintf(account, sizeof(account), "%d", (pair % NUM_ACCOUNTS) + 1);
+      benchmark_data_packet_append(account, symbol, stocks_list[symbol],
+                                   is_sell ? 1.0 : 1000.0, 1, packetH);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (is_sell) {
+      rc = benchmark_sell2(packetH, benchmarkH);
+    }
+    else {
+      rc = benchmark_purchase2(packetH, benchmarkH);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* Some listed symbols have no quote; just skip those packets */
+    if (rc == SUCCESS) {
+      *usec += elapsed_usec(&start, &end);
+      *items += PACKET_SZ;
+    }
+
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
+
+static int
+run(const char *label, int use_cache, int num_packets)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  double        purchase_usec, sell_usec;
+  long          purchase_items, sell_items;
+  unsigned long opened_before, opened, reused;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_cursor_cache_set(configH, use_cache) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  /* The first round creates the holdings; the timed rounds update them */
+  if (run_packets(0, num_packets, stocks_list, num_stocks,
+                  &purchase_usec, &purchase_items, benchmarkH) != SUCCESS
+      || benchmark_cursor_stats_get(benchmarkH, &opened_before, &reused) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to create holdings\n");
+    goto failXit;
+  }
+
+  if (run_packets(0, num_packets, stocks_list, num_stocks,
+                  &purchase_usec, &purchase_items, benchmarkH) != SUCCESS
+      || run_packets(1, num_packets, stocks_list, num_stocks,
+                     &sell_usec, &sell_items, benchmarkH) != SUCCESS
+      || benchmark_cursor_stats_get(benchmarkH, &opened, &reused) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to run packets\n");
+    goto failXit;
+  }
+
+  if (purchase_items == 0 || sell_items == 0) {
+    fprintf(stderr, "ERROR: No packet succeeded\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "%8s %16.2f %16.2f %16.2f\n", label,
+          purchase_usec / purchase_items, sell_usec / sell_items,
+          (double)(opened - opened_before) / (purchase_items + sell_items));
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_packets = 200;
+
+  if (argc > 1) {
+    num_packets = atoi(argv[1]);
+  }
+
+  if (num_packets <= 0) {
+    fprintf(stderr, "Usage: %s [packets of %d items]\n", argv[0], PACKET_SZ);
+    goto failXit;
+  }
+
+  fprintf(stdout, "packets: %d, items per packet: %d\n\n", num_packets, PACKET_SZ);
+  fprintf(stdout, "%8s %16s %16s %16s\n", "cache", "purchase (us)", "sell (us)", "cursors/item");
+
+  if (run("off", 0, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("on", 1, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
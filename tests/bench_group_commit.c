@@ -0,0 +1,212 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_group_commit.c
+ *
+ *    Description:  Measure the quote refreshes per second of concurrent
+ *                  threads, each refreshing one quote per call, with every
+ *                  call in a transaction of its own and with group commit.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+
+typedef struct worker_t {
+  pthread_t     thread;
+  BENCHMARK_H   benchmarkH;
+  char        **stocks_list;
+  int           num_stocks;
+  int           num_calls;
+  unsigned int  seed;
+  long          refreshed;
+  long          failed;
+} worker_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+static void *
+worker_main(void *argP)
+{
+  worker_t *workerP = argP;
+  BENCHMARK_THREAD_CTX_H ctxH = NULL;
+  int symbol;
+  int c;
+
+  if (benchmark_thread_ctx_alloc(workerP->benchmarkH, workerP->seed, &ctxH) != SUCCESS) {
+    workerP->failed = workerP->num_calls;
+    return NULL;
+  }
+
+  for (c = 0; c < workerP->num_calls; c++) {
+    symbol = rand_r(&workerP->seed) % workerP->num_stocks;
+    if (benchmark_refresh_quotes2_ctx(ctxH, workerP->stocks_list[symbol],
+                                      (rand_r(&workerP->seed) % 100) + 1) == SUCCESS) {
+      workerP->refreshed ++;
+    }
+    else {
+      workerP->failed ++;
+    }
+  }
+
+  benchmark_thread_ctx_free(ctxH);
+  return NULL;
+}
+
+static int
+run(const char *label, unsigned int window_usec, int max_batch, int num_threads, int num_calls)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  worker_t      workers[MAX_THREADS];
+  struct timespec start, end;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  long          refreshed = 0;
+  long          failed = 0;
+  unsigned long batches, items, largest;
+  double        usec;
+  int           i;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_group_commit_set(configH, window_usec, max_batch) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < num_threads; i++) {
+    memset(&workers[i], 0, sizeof(worker_t));
+    workers[i].benchmarkH = benchmarkH;
+    workers[i].stocks_list = stocks_list;
+    workers[i].num_stocks = num_stocks;
+    workers[i].num_calls = num_calls;
+    workers[i].seed = i + 100;
+    if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start worker\n");
+      num_threads = i;
+      break;
+    }
+  }
+
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+    refreshed += workers[i].refreshed;
+    failed += workers[i].failed;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  usec = elapsed_usec(&start, &end);
+
+  if (benchmark_group_commit_stats_get(benchmarkH, &batches, &items, &largest) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "%8s %14.1f %10lu %10.2f %10lu %10ld\n", label,
+          refreshed * 1000000.0 / usec, batches,
+          batches ? (double) items / batches : 1.0, largest, failed);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_threads = 16;
+  int num_calls = 2000;
+  int window_usec = 200;
+  int max_batch = 32;
+
+  if (argc > 1) {
+    num_threads = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_calls = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    window_usec = atoi(argv[3]);
+  }
+  if (argc > 4) {
+    max_batch = atoi(argv[4]);
+  }
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS || num_calls <= 0
+      || window_usec < 0 || max_batch <= 1) {
+    fprintf(stderr, "Usage: %s [threads (1-%d)] [calls per thread] [window (us)] [max batch (> 1)]\n",
+            argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "threads: %d, calls per thread: %d, window: %d us, max batch: %d\n\n",
+          num_threads, num_calls, window_usec, max_batch);
+  fprintf(stdout, "%8s %14s %10s %10s %10s %10s\n", "group",
+          "calls/s", "batches", "avg batch", "largest", "failed");
+
+  if (run("off", 0, 0, num_threads, num_calls) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("on", window_usec, max_batch, num_threads, num_calls) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,237 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_holdings.c
+ *
+ *    Description:  Measure purchase/sell latency as the number of portfolios
+ *                  grows. Since holdings are found with a point lookup, the
+ *                  latency should stay flat.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define NUM_ACCOUNTS    50
+#define PACKET_SZ       100
+#define NUM_SAMPLES     500
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/*
+ * Adds new holdings until there are at least target_holdings of them.
+ * Holdings are created walking the (account, symbol) pairs in order,
+ * so that every purchase creates a new portfolio.
+ */
+static int
+grow_holdings(int target_holdings, int *num_holdings, int *next_pair,
+              char **stocks_list, int num_stocks, BENCHMARK_H benchmarkH)
+{
+  BENCHMARK_DATA_PACKET_H packetH = NULL;
+  char account[16];
+  int i;
+
+  while (*num_holdings < target_holdings && *next_pair < NUM_ACCOUNTS * num_stocks) {
+    if (benchmark_data_packet_alloc(PACKET_SZ, &packetH) != SUCCESS) {
+      goto failXit;
+    }
+
+    for (i = 0; i < PACKET_SZ && *next_pair < NUM_ACCOUNTS * num_stocks; i++) {
+      int symbol = *next_pair / NUM_ACCOUNTS;
+      snprintf(account, sizeof(account), "%d", (*next_pair % NUM_ACCOUNTS) + 1);
+      benchmark_data_packet_append(account, symbol, stocks_list[symbol],
+                                   1000.0, 10, packetH);
+      (*next_pair) ++;
+    }
+
+    /* Some listed symbols have no quote; just skip those packets */
+    if (benchmark_purchase2(packetH, benchmarkH) == SUCCESS) {
+      *num_holdings += i;
+    }
+
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
+
+/* Times single-item purchases and sells against existing holdings */
+static int
+sample_latency(int next_pair, char **stocks_list,
+               double *purchase_usec, double *sell_usec,
+               BENCHMARK_H benchmarkH)
+{
+  BENCHMARK_DATA_PACKET_H packetH = NULL;
+  struct timespec start, end;
+  char account[16];
+  int samples = 0;
+  int i;
+
+  *purchase_usec = 0;
+  *sell_usec = 0;
+
+  for (i = 0; i < NUM_SAMPLES; i++) {
+    int pair = rand() % next_pair;
+    int symbol = pair / NUM_ACCOUNTS;
+    snprintf(account, sizeof(account), "%d", (pair % NUM_ACCOUNTS) + 1);
+
+    if (benchmark_data_packet_alloc(1, &packetH) != SUCCESS) {
+      goto failXit;
+    }
+    benchmark_data_packet_append(account, symbol, stocks_list[symbol],
+                                 1000.0, 1, packetH);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (benchmark_purchase2(packetH, benchmarkH) != SUCCESS) {
+      benchmark_data_packet_free(packetH);
+      continue;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *purchase_usec += elapsed_usec(&start, &end);
+    benchmark_data_packet_free(packetH);
+
+    if (benchmark_data_packet_alloc(1, &packetH) != SUCCESS) {
+      goto failXit;
+    }
+    benchmark_data_packet_append(account, symbol, stocks_list[symbol],
+                                 1.0, 1, packetH);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (benchmark_sell2(packetH, benchmarkH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to sell %s for account %s\n", stocks_list[symbol], account);
+      benchmark_data_packet_free(packetH);
+      goto failXit;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *sell_usec += elapsed_usec(&start, &end);
+    benchmark_data_packet_free(packetH);
+
+    samples ++;
+  }
+
+  if (samples == 0) {
+    goto failXit;
+  }
+
+  *purchase_usec /= samples;
+  *sell_usec /= samples;
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
+
+int test(int max_holdings)
+{
+  BENCHMARK_H   benchmarkH = NULL;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  int           num_holdings = 0;
+  int           next_pair = 0;
+  int           target;
+  double        purchase_usec;
+  double        sell_usec;
+
+  fprintf(stdout, "Performing initial load\n");
+  benchmarkH = benchmark_initial_load("MyBench",
+                                      CHRONOS_SERVER_HOME_DIR,
+                                      CHRONOS_SERVER_DATAFILES_DIR);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "%12s %16s %16s\n", "holdings", "purchase (us)", "sell (us)");
+
+  for (target = 1000; target <= max_holdings; target *= 2) {
+    if (grow_holdings(target, &num_holdings, &next_pair,
+                      stocks_list, num_stocks, benchmarkH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to add holdings\n");
+      goto failXit;
+    }
+
+    if (sample_latency(next_pair, stocks_list,
+                       &purchase_usec, &sell_usec, benchmarkH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to sample latencies\n");
+      goto failXit;
+    }
+
+    fprintf(stdout, "%12d %16.2f %16.2f\n", num_holdings, purchase_usec, sell_usec);
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Freeing benchmark handle\n");
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test PASSED\n");
+  return SUCCESS;
+
+failXit:
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test FAILED\n");
+
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+    benchmarkH = NULL;
+  }
+
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int max_holdings = 32000;
+
+  if (argc > 1) {
+    max_holdings = atoi(argv[1]);
+  }
+
+  srand(1);
+
+  if (test(max_holdings) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failure in test");
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
@@ -0,0 +1,142 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_image.c
+ *
+ *    Description:  Measure how long it takes to get the tables back by
+ *                  running the initial load, and by restoring an image
+ *                  of them saved with benchmark_image_save().
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define CHRONOS_SERVER_IMAGE          "/tmp/chronos/tables.img"
+#define SUCCESS 0
+#define FAIL    1
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  struct timespec start, end;
+  struct stat st;
+  unsigned long num_accounts = 0;
+  unsigned long num_symbols = 0;
+  unsigned long num_portfolios = 0;
+  double load_usec;
+  double save_usec;
+  double restore_usec;
+
+  /* Optionally, a generated dataset of the given scale */
+  if (argc > 3) {
+    num_accounts = strtoul(argv[1], NULL, 10);
+    num_symbols = strtoul(argv[2], NULL, 10);
+    num_portfolios = strtoul(argv[3], NULL, 10);
+  }
+  else if (argc > 1) {
+    fprintf(stderr, "Usage: %s [accounts symbols holdings]\n", argv[0]);
+    goto failXit;
+  }
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_generator_set(configH, num_accounts, num_symbols,
+                                        num_portfolios, 0.99, 1) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+  if (benchmark_load_portfolio(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to load portfolios\n");
+    goto failXit;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  load_usec = elapsed_usec(&start, &end);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (benchmark_image_save(benchmarkH, CHRONOS_SERVER_IMAGE) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to save image\n");
+    goto failXit;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  save_usec = elapsed_usec(&start, &end);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+
+  /* The image replaces the datafiles, so no generator this time */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  benchmarkH = benchmark_image_load("MyBench",
+                                    CHRONOS_SERVER_HOME_DIR,
+                                    CHRONOS_SERVER_IMAGE,
+                                    NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to restore image\n");
+    goto failXit;
+  }
+  restore_usec = elapsed_usec(&start, &end);
+
+  if (stat(CHRONOS_SERVER_IMAGE, &st) != 0) {
+    fprintf(stderr, "ERROR: Cannot find %s\n", CHRONOS_SERVER_IMAGE);
+    goto failXit;
+  }
+
+  fprintf(stdout, "%12s %12s %12s %12s %8s\n", "image (MB)", "load (ms)", "save (ms)", "restore (ms)", "speedup");
+  fprintf(stdout, "%12.1f %12.1f %12.1f %12.1f %8.2f\n", st.st_size / (1024.0 * 1024.0),
+          load_usec / 1000.0, save_usec / 1000.0, restore_usec / 1000.0,
+          load_usec / restore_usec);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,203 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_ingest.c
+ *
+ *    Description:  Measure how fast a recorded stream of quote ticks is
+ *                  replayed with benchmark_ingest_run(), from a text file
+ *                  and from a binary one holding the same ticks.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define CHRONOS_SERVER_TICKS_TEXT     "/tmp/chronos/ticks.txt"
+#define CHRONOS_SERVER_TICKS_BINARY   "/tmp/chronos/ticks.bin"
+#define SUCCESS 0
+#define FAIL    1
+
+/* Start of the recorded day */
+#define TICKS_START_TIME  (1502197200LL)
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/* A random walk of every symbol, ten ticks a second */
+static int
+write_ticks(char **stocks_list, int num_stocks, unsigned long num_ticks)
+{
+  FILE *textfp = NULL;
+  FILE *binfp = NULL;
+  benchmark_tick_t tick;
+  float *prices = NULL;
+  unsigned long i;
+  int symbol;
+
+  prices = malloc(num_stocks * sizeof(float));
+  textfp = fopen(CHRONOS_SERVER_TICKS_TEXT, "w");
+  binfp = fopen(CHRONOS_SERVER_TICKS_BINARY, "w");
+  if (prices == NULL || textfp == NULL || binfp == NULL) {
+    fprintf(stderr, "ERROR: Failed to create the tick files\n");
+    goto failXit;
+  }
+
+  for (symbol = 0; symbol < num_stocks; symbol++) {
+    prices[symbol] = 10 + rand() % 90;
+  }
+
+  for (i = 0; i < num_ticks; i++) {
+    symbol = rand() % num_stocks;
+    prices[symbol] += (rand() % 2 == 0 || prices[symbol] < 1) ? 0.01 : -0.01;
+
+    memset(&tick, 0, sizeof(benchmark_tick_t));
+    snprintf(tick.symbol, sizeof(tick.symbol), "%s", stocks_list[symbol]);
+    tick.price = prices[symbol];
+    tick.bid = prices[symbol] - 0.01;
+    tick.ask = prices[symbol] + 0.01;
+    tick.volume = 100 * (1 + rand() % 10);
+    tick.timestamp = TICKS_START_TIME + i / 10;
+
+    fprintf(textfp, "%s#%.2f#%.2f#%.2f#%lld#%lld\n", tick.symbol, tick.price,
+            tick.bid, tick.ask, tick.volume, tick.timestamp);
+    if (fwrite(&tick, sizeof(benchmark_tick_t), 1, binfp) != 1) {
+      fprintf(stderr, "ERROR: Failed to write the tick files\n");
+      goto failXit;
+    }
+  }
+
+  if (fclose(textfp) != 0 || fclose(binfp) != 0) {
+    textfp = binfp = NULL;
+    fprintf(stderr, "ERROR: Failed to write the tick files\n");
+    goto failXit;
+  }
+
+  free(prices);
+  return SUCCESS;
+
+failXit:
+  if (textfp) {
+    fclose(textfp);
+  }
+  if (binfp) {
+    fclose(binfp);
+  }
+  free(prices);
+  return FAIL;
+}
+
+static int
+replay(BENCHMARK_H benchmarkH, const char *path, int format, const char *name)
+{
+  struct timespec start, end;
+  unsigned long applied = 0;
+  unsigned long rejected = 0;
+  double usec;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (benchmark_ingest_run(benchmarkH, path, format, &applied, &rejected) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to replay %s\n", path);
+    return FAIL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  usec = elapsed_usec(&start, &end);
+
+  fprintf(stdout, "%8s %10lu %10lu %12.1f %12.0f\n", name, applied, rejected,
+          usec / 1000.0, applied * 1000000.0 / usec);
+
+  return SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  unsigned long num_ticks = 1000000;
+  int           batch_max = 256;
+
+  if (argc > 1) {
+    num_ticks = strtoul(argv[1], NULL, 10);
+  }
+  if (argc > 2) {
+    batch_max = atoi(argv[2]);
+  }
+
+  if (num_ticks == 0 || batch_max <= 0) {
+    fprintf(stderr, "Usage: %s [ticks] [batch_max]\n", argv[0]);
+    goto failXit;
+  }
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_ingest_set(configH, 65536, batch_max) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS
+      || num_stocks <= 0) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  srand(1);
+  if (write_ticks(stocks_list, num_stocks, num_ticks) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "ticks: %lu, batch_max: %d\n\n", num_ticks, batch_max);
+  fprintf(stdout, "%8s %10s %10s %12s %12s\n", "format", "applied", "rejected",
+          "time (ms)", "ticks/s");
+
+  if (replay(benchmarkH, CHRONOS_SERVER_TICKS_TEXT, BENCHMARK_TICKS_TEXT, "text") != SUCCESS
+      || replay(benchmarkH, CHRONOS_SERVER_TICKS_BINARY, BENCHMARK_TICKS_BINARY, "binary") != SUCCESS) {
+    goto failXit;
+  }
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,288 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_order_queue.c
+ *
+ *    Description:  Measure how long front-end threads are blocked per
+ *                  purchase packet, and the packets applied per second,
+ *                  when packets are applied in the caller's thread and
+ *                  when they are submitted to the order queue.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+#define NUM_ACCOUNTS    50
+#define PACKET_SZ       4
+
+typedef struct producer_t {
+  pthread_t                 thread;
+  BENCHMARK_H               benchmarkH;
+  int                       use_queue;
+  char                    **stocks_list;
+  int                       num_stocks;
+  int                       num_packets;
+  unsigned int              seed;
+  BENCHMARK_DATA_PACKET_H  *packetsP;
+  BENCHMARK_TICKET_H       *ticketsP;
+  double                    blocked_usec;
+  long                      applied;
+} producer_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+static void *
+producer_main(void *argP)
+{
+  producer_t *producerP = argP;
+  BENCHMARK_THREAD_CTX_H ctxH = NULL;
+  struct timespec start, end;
+  int status;
+  int p;
+
+  if (benchmark_thread_ctx_alloc(producerP->benchmarkH, producerP->seed, &ctxH) != SUCCESS) {
+    return NULL;
+  }
+
+  for (p = 0; p < producerP->num_packets; p++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (producerP->use_queue) {
+      if (benchmark_purchase2_submit(producerP->packetsP[p], NULL, NULL,
+                                     &producerP->ticketsP[p], producerP->benchmarkH) != SUCCESS) {
+        producerP->ticketsP[p] = NULL;
+      }
+    }
+    else if (benchmark_purchase2_ctx(producerP->packetsP[p], ctxH) == SUCCESS) {
+      producerP->applied ++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    producerP->blocked_usec += elapsed_usec(&start, &end);
+  }
+
+  /* Packets must outlive their orders */
+  if (producerP->use_queue) {
+    for (p = 0; p < producerP->num_packets; p++) {
+      if (producerP->ticketsP[p] != NULL
+          && benchmark_ticket_wait(producerP->ticketsP[p], &status) == SUCCESS
+          && status == SUCCESS) {
+        producerP->applied ++;
+      }
+    }
+  }
+
+  benchmark_thread_ctx_free(ctxH);
+  return NULL;
+}
+
+static int
+producer_setup(producer_t *producerP)
+{
+  char account[16];
+  int  symbol;
+  int  p, i;
+
+  producerP->packetsP = calloc(producerP->num_packets, sizeof(BENCHMARK_DATA_PACKET_H));
+  producerP->ticketsP = calloc(producerP->num_packets, sizeof(BENCHMARK_TICKET_H));
+  if (producerP->packetsP == NULL || producerP->ticketsP == NULL) {
+    return FAIL;
+  }
+
+  for (p = 0; p < producerP->num_packets; p++) {
+    if (benchmark_data_packet_alloc(PACKET_SZ, &producerP->packetsP[p]) != SUCCESS) {
+      return FAIL;
+    }
+
+    for (i = 0; i < PACKET_SZ; i++) {
+      symbol = rand_r(&producerP->seed) % producerP->num_stocks;
+      snprintf(account, sizeof(account), "%d", (rand_r(&producerP->seed) % NUM_ACCOUNTS) + 1);
+      benchmark_data_packet_append(account, symbol, producerP->stocks_list[symbol],
+                                   1000.0, 1, producerP->packetsP[p]);
+    }
+  }
+
+  return SUCCESS;
+}
+
+static void
+producer_cleanup(producer_t *producerP)
+{
+  int p;
+
+  if (producerP->packetsP != NULL) {
+    for (p = 0; p < producerP->num_packets; p++) {
+      if (producerP->packetsP[p] != NULL) {
+        benchmark_data_packet_free(producerP->packetsP[p]);
+      }
+    }
+  }
+  free(producerP->packetsP);
+  free(producerP->ticketsP);
+}
+
+static int
+run(const char *label, int num_workers, int num_producers, int num_packets)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  producer_t    producers[MAX_THREADS];
+  struct timespec start, end;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  double        blocked_usec = 0;
+  double        usec;
+  long          applied = 0;
+  unsigned long submitted, completed, groups;
+  int           i;
+
+  memset(producers, 0, sizeof(producers));
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_order_queue_set(configH, num_workers, 16) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  for (i = 0; i < num_producers; i++) {
+    producers[i].benchmarkH = benchmarkH;
+    producers[i].use_queue = (num_workers > 0);
+    producers[i].stocks_list = stocks_list;
+    producers[i].num_stocks = num_stocks;
+    producers[i].num_packets = num_packets;
+    producers[i].seed = i + 100;
+    if (producer_setup(&producers[i]) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to build packets\n");
+      goto failXit;
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < num_producers; i++) {
+    if (pthread_create(&producers[i].thread, NULL, producer_main, &producers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start producer\n");
+      num_producers = i;
+      break;
+    }
+  }
+
+  for (i = 0; i < num_producers; i++) {
+    pthread_join(producers[i].thread, NULL);
+    blocked_usec += producers[i].blocked_usec;
+    applied += producers[i].applied;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  usec = elapsed_usec(&start, &end);
+
+  if (benchmark_order_queue_stats_get(benchmarkH, &submitted, &completed, &groups) != SUCCESS) {
+    submitted = completed = groups = 0;
+  }
+
+  fprintf(stdout, "%8s %16.2f %14.1f %10ld %10lu\n", label,
+          blocked_usec / (num_producers * num_packets),
+          applied * 1000000.0 / usec, applied, groups);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  for (i = 0; i < MAX_THREADS; i++) {
+    producer_cleanup(&producers[i]);
+  }
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  for (i = 0; i < MAX_THREADS; i++) {
+    producer_cleanup(&producers[i]);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_producers = 8;
+  int num_workers = 4;
+  int num_packets = 1000;
+
+  if (argc > 1) {
+    num_producers = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_workers = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    num_packets = atoi(argv[3]);
+  }
+
+  if (num_producers <= 0 || num_producers > MAX_THREADS || num_workers <= 0 || num_packets <= 0) {
+    fprintf(stderr, "Usage: %s [producers (1-%d)] [workers] [packets per producer]\n", argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "producers: %d, workers: %d, packets per producer: %d, items per packet: %d\n\n",
+          num_producers, num_workers, num_packets, PACKET_SZ);
+  fprintf(stdout, "%8s %16s %14s %10s %10s\n", "mode",
+          "blocked (us)", "packets/s", "applied", "groups");
+
+  if (run("sync", 0, num_producers, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("queue", num_workers, num_producers, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,306 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_packet_order.c
+ *
+ *    Description:  Measure deadlocks and throughput of concurrent purchase
+ *                  and sell packets over a small set of holdings, applied
+ *                  in arrival order and in canonical order.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+#define HOT_ACCOUNTS    8
+#define HOT_SYMBOLS     8
+#define PACKET_SZ       16
+
+typedef struct worker_t {
+  pthread_t     thread;
+  BENCHMARK_H   benchmarkH;
+  int          *symbols;
+  char        **stocks_list;
+  int           num_packets;
+  unsigned int  seed;
+  long          packets;
+  long          failed;
+} worker_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/* Random pairs, in random order, with repeats */
+static int
+packet_fill(BENCHMARK_DATA_PACKET_H packetH, float price, unsigned int *seedP,
+            int *symbols, char **stocks_list)
+{
+  char account[16];
+  int  symbol;
+  int  i;
+
+  for (i = 0; i < PACKET_SZ; i++) {
+    symbol = symbols[rand_r(seedP) % HOT_SYMBOLS];
+    snprintf(account, sizeof(account), "%d", (rand_r(seedP) % HOT_ACCOUNTS) + 1);
+    if (benchmark_data_packet_append(account, symbol, stocks_list[symbol],
+                                     price, 1, packetH) != SUCCESS) {
+      return FAIL;
+    }
+  }
+
+  return SUCCESS;
+}
+
+/* Each purchase is followed by a sell of the same entries, so the
+ * holdings never run out */
+static void *
+worker_main(void *argP)
+{
+  worker_t *workerP = argP;
+  BENCHMARK_THREAD_CTX_H ctxH = NULL;
+  BENCHMARK_DATA_PACKET_H buyH = NULL;
+  BENCHMARK_DATA_PACKET_H sellH = NULL;
+  unsigned int sell_seed;
+  int p;
+
+  if (benchmark_thread_ctx_alloc(workerP->benchmarkH, workerP->seed, &ctxH) != SUCCESS) {
+    workerP->failed = workerP->num_packets;
+    return NULL;
+  }
+
+  for (p = 0; p < workerP->num_packets; p++) {
+    sell_seed = workerP->seed;
+    if (benchmark_data_packet_alloc(PACKET_SZ, &buyH) != SUCCESS
+        || benchmark_data_packet_alloc(PACKET_SZ, &sellH) != SUCCESS
+        || packet_fill(buyH, 1000.0, &workerP->seed, workerP->symbols, workerP->stocks_list) != SUCCESS
+        || packet_fill(sellH, 1.0, &sell_seed, workerP->symbols, workerP->stocks_list) != SUCCESS) {
+      workerP->failed ++;
+    }
+    else if (benchmark_purchase2_ctx(buyH, ctxH) != SUCCESS) {
+      workerP->failed ++;
+    }
+    else {
+      workerP->packets ++;
+      if (benchmark_sell2_ctx(sellH, ctxH) == SUCCESS) {
+        workerP->packets ++;
+      }
+      else {
+        workerP->failed ++;
+      }
+    }
+
+    if (buyH != NULL) {
+      benchmark_data_packet_free(buyH);
+      buyH = NULL;
+    }
+    if (sellH != NULL) {
+      benchmark_data_packet_free(sellH);
+      sellH = NULL;
+    }
+  }
+
+  benchmark_thread_ctx_free(ctxH);
+  return NULL;
+}
+
+/* Picks symbols that have a quote, and creates every hot holding */
+static int
+holdings_setup(BENCHMARK_H benchmarkH, char **stocks_list, int num_stocks, int *symbols)
+{
+  BENCHMARK_DATA_PACKET_H packetH = NULL;
+  char account[16];
+  int  found = 0;
+  int  symbol;
+  int  a;
+
+  for (symbol = 0; symbol < num_stocks && found < HOT_SYMBOLS; symbol++) {
+    if (benchmark_data_packet_alloc(HOT_ACCOUNTS, &packetH) != SUCCESS) {
+      return FAIL;
+    }
+
+    for (a = 0; a < HOT_ACCOUNTS; a++) {
+      snprintf(account, sizeof(account), "%d", a + 1);
+      benchmark_data_packet_append(account, symbol, stocks_list[symbol], 1000.0, 1, packetH);
+    }
+
+    if (benchmark_purchase2(packetH, benchmarkH) == SUCCESS) {
+      symbols[found ++] = symbol;
+    }
+
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+  }
+
+  return (found == HOT_SYMBOLS) ? SUCCESS : FAIL;
+}
+
+static int
+run(const char *label, int ordered, int num_threads, int num_packets)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  worker_t      workers[MAX_THREADS];
+  struct timespec start, end;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  int           symbols[HOT_SYMBOLS];
+  long          packets = 0;
+  long          failed = 0;
+  unsigned long attempts, conflicts, retries, exhausted;
+  unsigned long total_attempts = 0, total_conflicts = 0;
+  double        usec;
+  int           types[2] = { BENCHMARK_XACT_PURCHASE, BENCHMARK_XACT_SELL };
+  int           i;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_packet_order_set(configH, ordered) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  if (holdings_setup(benchmarkH, stocks_list, num_stocks, symbols) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to create holdings\n");
+    goto failXit;
+  }
+
+  /* Only count what the workers do. Conflicts are the attempts that
+   * Berkeley DB chose as deadlock victims. */
+  for (i = 0; i < 2; i++) {
+    if (benchmark_retry_stats_get(benchmarkH, types[i], &attempts, &conflicts,
+                                  &retries, &exhausted) != SUCCESS) {
+      goto failXit;
+    }
+    total_attempts -= attempts;
+    total_conflicts -= conflicts;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < num_threads; i++) {
+    memset(&workers[i], 0, sizeof(worker_t));
+    workers[i].benchmarkH = benchmarkH;
+    workers[i].symbols = symbols;
+    workers[i].stocks_list = stocks_list;
+    workers[i].num_packets = num_packets;
+    workers[i].seed = i + 100;
+    if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start worker\n");
+      num_threads = i;
+      break;
+    }
+  }
+
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+    packets += workers[i].packets;
+    failed += workers[i].failed;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  usec = elapsed_usec(&start, &end);
+
+  for (i = 0; i < 2; i++) {
+    if (benchmark_retry_stats_get(benchmarkH, types[i], &attempts, &conflicts,
+                                  &retries, &exhausted) != SUCCESS) {
+      goto failXit;
+    }
+    total_attempts += attempts;
+    total_conflicts += conflicts;
+  }
+
+  fprintf(stdout, "%8s %14.1f %10lu %14.4f %10ld\n", label,
+          packets * 1000000.0 / usec, total_conflicts,
+          total_attempts ? (double) total_conflicts / total_attempts : 0.0,
+          failed);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_threads = 8;
+  int num_packets = 500;
+
+  if (argc > 1) {
+    num_threads = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_packets = atoi(argv[2]);
+  }
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS || num_packets <= 0) {
+    fprintf(stderr, "Usage: %s [threads (1-%d)] [packets per thread]\n", argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "threads: %d, packets per thread: %d, items per packet: %d, holdings: %d\n\n",
+          num_threads, num_packets, PACKET_SZ, HOT_ACCOUNTS * HOT_SYMBOLS);
+  fprintf(stdout, "%8s %14s %10s %14s %10s\n", "ordered",
+          "packets/s", "deadlocks", "per attempt", "failed");
+
+  if (run("off", 0, num_threads, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("on", 1, num_threads, num_packets) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,171 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_parse.c
+ *
+ *    Description:  Measure how fast the datafiles are parsed with fgets()
+ *                  and sscanf(), as the initial load used to, and with
+ *                  the datafile tokenizer of the library.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAXLINE   1024
+
+/* Fields are one byte larger than the widths scanned into them */
+typedef struct scan_buf_t {
+  char  text[8][512];
+  float numbers[6];
+  long  volume;
+} scan_buf_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/* The scan patterns of the old loaders */
+static unsigned long
+parse_sscanf(const char *path, int table)
+{
+  char buf[MAXLINE];
+  FILE *ifp;
+  scan_buf_t s;
+  unsigned long rows = 0;
+
+  ifp = fopen(path, "r");
+  if (ifp == NULL) {
+    return 0;
+  }
+
+  while (fgets(buf, MAXLINE, ifp) != NULL) {
+    switch (table) {
+      case BENCHMARK_TABLE_PERSONAL:
+        sscanf(buf,
+          "%10[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%128[^#]#%16[^\n]",
+          s.text[0], s.text[1], s.text[2], s.text[3],
+          s.text[4], s.text[5], s.text[6], s.text[7]);
+        break;
+
+      case BENCHMARK_TABLE_STOCKS:
+        sscanf(buf,
+          "%10[^#]#%128[^#]#%500[^\n]",
+          s.text[0], s.text[1], s.text[2]);
+        break;
+
+      case BENCHMARK_TABLE_CURRENCIES:
+        sscanf(buf,
+          "%200[^#]#%200[^#]#%10[^\n]",
+          s.text[0], s.text[1], s.text[2]);
+        break;
+
+      default:
+        sscanf(buf,
+          "%10[^#]#%f#%10[^#]#%f#%f#%f#%f#%f#%ld#%10[^\n]",
+          s.text[0], &s.numbers[0], s.text[1], &s.numbers[1],
+          &s.numbers[2], &s.numbers[3], &s.numbers[4],
+          &s.numbers[5], &s.volume, s.text[2]);
+        break;
+    }
+    rows ++;
+  }
+
+  fclose(ifp);
+  return rows;
+}
+
+static int
+run(const char *file, int table, int iterations)
+{
+  char path[512];
+  struct stat st;
+  struct timespec start, end;
+  unsigned long rows = 0;
+  unsigned long malformed = 0;
+  double scan_usec;
+  double tok_usec;
+  double mb;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/%s", CHRONOS_SERVER_DATAFILES_DIR, file);
+  if (stat(path, &st) != 0) {
+    fprintf(stderr, "ERROR: Cannot find %s\n", path);
+    return FAIL;
+  }
+  mb = (double) st.st_size * iterations / (1024 * 1024);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < iterations; i++) {
+    rows = parse_sscanf(path, table);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  scan_usec = elapsed_usec(&start, &end);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < iterations; i++) {
+    if (benchmark_datafile_parse(path, table, &rows, &malformed) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to parse %s\n", path);
+      return FAIL;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  tok_usec = elapsed_usec(&start, &end);
+
+  fprintf(stdout, "%16s %8lu %10lu %12.1f %12.1f %8.2f\n", file, rows, malformed,
+          mb * 1000000.0 / scan_usec, mb * 1000000.0 / tok_usec,
+          scan_usec / tok_usec);
+
+  return SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+  int iterations = 100;
+
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  if (iterations <= 0) {
+    fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    goto failXit;
+  }
+
+  fprintf(stdout, "iterations: %d\n\n", iterations);
+  fprintf(stdout, "%16s %8s %10s %12s %12s %8s\n", "file", "rows",
+          "malformed", "sscanf MB/s", "mmap MB/s", "speedup");
+
+  if (run("accounts.txt", BENCHMARK_TABLE_PERSONAL, iterations) != SUCCESS
+      || run("companylist.txt", BENCHMARK_TABLE_STOCKS, iterations) != SUCCESS
+      || run("currencies.txt", BENCHMARK_TABLE_CURRENCIES, iterations) != SUCCESS
+      || run("quotes.txt", BENCHMARK_TABLE_QUOTES, iterations) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,197 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_quote_cache.c
+ *
+ *    Description:  Measure view stock latency while other threads keep
+ *                  refreshing quotes, with and without the quote cache.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+
+typedef struct refresher_t {
+  pthread_t     thread;
+  BENCHMARK_H   benchmarkH;
+  int           num_stocks;
+  unsigned int  seed;
+  volatile int *stopP;
+  long          updates;
+} refresher_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+static void *
+refresher_main(void *argP)
+{
+  refresher_t *refresherP = argP;
+  int symbol;
+  float price;
+
+  while (!*refresherP->stopP) {
+    symbol = rand_r(&refresherP->seed) % refresherP->num_stocks;
+    price = (rand_r(&refresherP->seed) % 1000) + 1;
+    if (benchmark_refresh_quotes(refresherP->benchmarkH, &symbol, price) == SUCCESS) {
+      refresherP->updates ++;
+    }
+  }
+
+  return NULL;
+}
+
+static int
+run(const char *label, int use_cache, int num_refreshers, int num_views)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  refresher_t   refreshers[MAX_THREADS];
+  struct timespec start, end;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  volatile int  stop = 0;
+  double        total_usec = 0;
+  double        max_usec = 0;
+  double        usec;
+  long          updates = 0;
+  unsigned int  seed = 1;
+  int           symbol;
+  int           i;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_quote_cache_set(configH, use_cache) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  for (i = 0; i < num_refreshers; i++) {
+    memset(&refreshers[i], 0, sizeof(refresher_t));
+    refreshers[i].benchmarkH = benchmarkH;
+    refreshers[i].num_stocks = num_stocks;
+    refreshers[i].seed = i + 100;
+    refreshers[i].stopP = &stop;
+    if (pthread_create(&refreshers[i].thread, NULL, refresher_main, &refreshers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start refresher\n");
+      num_refreshers = i;
+      break;
+    }
+  }
+
+  for (i = 0; i < num_views; i++) {
+    symbol = rand_r(&seed) % num_stocks;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (benchmark_view_stock(benchmarkH, &symbol) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to view stock %d\n", symbol);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    usec = elapsed_usec(&start, &end);
+    total_usec += usec;
+    if (usec > max_usec) {
+      max_usec = usec;
+    }
+  }
+
+  stop = 1;
+  for (i = 0; i < num_refreshers; i++) {
+    pthread_join(refreshers[i].thread, NULL);
+    updates += refreshers[i].updates;
+  }
+
+  fprintf(stdout, "%8s %14.2f %14.2f %12ld\n",
+          label, total_usec / num_views, max_usec, updates);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_refreshers = 4;
+  int num_views = 100000;
+
+  if (argc > 1) {
+    num_refreshers = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_views = atoi(argv[2]);
+  }
+
+  if (num_refreshers < 0 || num_refreshers > MAX_THREADS || num_views <= 0) {
+    fprintf(stderr, "Usage: %s [refresher threads (0-%d)] [views]\n", argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "refreshers: %d, views: %d\n\n", num_refreshers, num_views);
+  fprintf(stdout, "%8s %14s %14s %12s\n", "cache", "avg view (us)", "max view (us)", "updates");
+
+  if (run("off", 0, num_refreshers, num_views) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("on", 1, num_refreshers, num_views) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
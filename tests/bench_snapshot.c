@@ -0,0 +1,211 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench_snapshot.c
+ *
+ *    Description:  Measure quote refresh latency while other threads keep
+ *                  reading quotes, with and without snapshot reads.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define MAX_THREADS     64
+#define READ_BATCH      50
+
+typedef struct reader_t {
+  pthread_t     thread;
+  BENCHMARK_H   benchmarkH;
+  char        **stocks_list;
+  int           num_stocks;
+  unsigned int  seed;
+  volatile int *stopP;
+  long          reads;
+} reader_t;
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+/* Each read holds its transaction across a batch of quotes */
+static void *
+reader_main(void *argP)
+{
+  reader_t *readerP = argP;
+  const char *batch[READ_BATCH];
+  int i;
+
+  while (!*readerP->stopP) {
+    for (i = 0; i < READ_BATCH; i++) {
+      batch[i] = readerP->stocks_list[rand_r(&readerP->seed) % readerP->num_stocks];
+    }
+    if (benchmark_view_stock2(READ_BATCH, batch, readerP->benchmarkH) == SUCCESS) {
+      readerP->reads ++;
+    }
+  }
+
+  return NULL;
+}
+
+static int
+run(const char *label, int use_snapshot, int num_readers, int num_updates)
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  reader_t      readers[MAX_THREADS];
+  struct timespec start, end;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  volatile int  stop = 0;
+  double        total_usec = 0;
+  double        max_usec = 0;
+  double        usec;
+  long          reads = 0;
+  unsigned long nsnapshots, maxnsnapshots, cached_pages, frozen, freed;
+  unsigned int  seed = 1;
+  int           symbol;
+  int           i;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_snapshot_set(configH, use_snapshot) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  for (i = 0; i < num_readers; i++) {
+    memset(&readers[i], 0, sizeof(reader_t));
+    readers[i].benchmarkH = benchmarkH;
+    readers[i].stocks_list = stocks_list;
+    readers[i].num_stocks = num_stocks;
+    readers[i].seed = i + 100;
+    readers[i].stopP = &stop;
+    if (pthread_create(&readers[i].thread, NULL, reader_main, &readers[i]) != 0) {
+      fprintf(stderr, "ERROR: Failed to start reader\n");
+      num_readers = i;
+      break;
+    }
+  }
+
+  for (i = 0; i < num_updates; i++) {
+    symbol = rand_r(&seed) % num_stocks;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (benchmark_refresh_quotes(benchmarkH, &symbol, (rand_r(&seed) % 1000) + 1) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to refresh stock %d\n", symbol);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    usec = elapsed_usec(&start, &end);
+    total_usec += usec;
+    if (usec > max_usec) {
+      max_usec = usec;
+    }
+  }
+
+  if (benchmark_mvcc_stats_get(benchmarkH, &nsnapshots, &maxnsnapshots,
+                               &cached_pages, &frozen, &freed) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain MVCC statistics\n");
+    nsnapshots = maxnsnapshots = cached_pages = frozen = freed = 0;
+  }
+
+  stop = 1;
+  for (i = 0; i < num_readers; i++) {
+    pthread_join(readers[i].thread, NULL);
+    reads += readers[i].reads;
+  }
+
+  fprintf(stdout, "%8s %14.2f %14.2f %12ld %10lu %12lu %8lu\n",
+          label, total_usec / num_updates, max_usec, reads,
+          maxnsnapshots, cached_pages, frozen);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_readers = 4;
+  int num_updates = 20000;
+
+  if (argc > 1) {
+    num_readers = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    num_updates = atoi(argv[2]);
+  }
+
+  if (num_readers < 0 || num_readers > MAX_THREADS || num_updates <= 0) {
+    fprintf(stderr, "Usage: %s [reader threads (0-%d)] [updates]\n", argv[0], MAX_THREADS);
+    goto failXit;
+  }
+
+  fprintf(stdout, "readers: %d, updates: %d\n\n", num_readers, num_updates);
+  fprintf(stdout, "%8s %14s %14s %12s %10s %12s %8s\n", "snapshot",
+          "avg write (us)", "max write (us)", "reads", "snapshots", "cached pages", "frozen");
+
+  if (run("off", 0, num_readers, num_updates) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (run("on", 1, num_readers, num_updates) != SUCCESS) {
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  fprintf(stderr, "ERROR: Failure in benchmark\n");
+  return FAIL;
+}
@@ -0,0 +1,136 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gen_dataset.c
+ *
+ *    Description:  Load a synthetic dataset of the given scale instead of
+ *                  the datafiles, and report how fast each part loads.
+ *                  The same seed always gives the same dataset.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+static double
+elapsed_usec(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000.0
+         + (end->tv_nsec - start->tv_nsec) / 1000.0;
+}
+
+static void
+usage(const char *program)
+{
+  fprintf(stderr, "Usage: %s <accounts> <symbols> <holdings> [skew] [seed] [threads]\n", program);
+  fprintf(stderr, "  skew     Zipf skew of the holdings, in [0, 1). Default: 0.99\n");
+  fprintf(stderr, "  seed     Seed of the dataset. Default: 1\n");
+  fprintf(stderr, "  threads  Threads loading each table. Default: 1\n");
+}
+
+int main(int argc, char *argv[])
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  struct timespec start, loaded, end;
+  unsigned long num_accounts;
+  unsigned long num_symbols;
+  unsigned long num_portfolios;
+  unsigned long seed = 1;
+  double skew = 0.99;
+  double load_usec;
+  double holdings_usec;
+  int num_threads = 1;
+
+  if (argc < 4) {
+    usage(argv[0]);
+    goto failXit;
+  }
+
+  num_accounts = strtoul(argv[1], NULL, 10);
+  num_symbols = strtoul(argv[2], NULL, 10);
+  num_portfolios = strtoul(argv[3], NULL, 10);
+  if (argc > 4) {
+    skew = atof(argv[4]);
+  }
+  if (argc > 5) {
+    seed = strtoul(argv[5], NULL, 10);
+  }
+  if (argc > 6) {
+    num_threads = atoi(argv[6]);
+  }
+
+  if (num_accounts == 0 || num_symbols == 0 || num_threads <= 0) {
+    usage(argv[0]);
+    goto failXit;
+  }
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_generator_set(configH, num_accounts, num_symbols,
+                                        num_portfolios, skew, seed) != SUCCESS
+      || benchmark_config_parallel_load_set(configH, num_threads) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  benchmarkH = benchmark_initial_load2("MyBench",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  clock_gettime(CLOCK_MONOTONIC, &loaded);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_load_portfolio(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to load portfolios\n");
+    goto failXit;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  load_usec = elapsed_usec(&start, &loaded);
+  holdings_usec = elapsed_usec(&loaded, &end);
+
+  fprintf(stdout, "%12s %12s %12s %12s\n", "part", "rows", "load (ms)", "rows/s");
+  /* Accounts, plus a stock and a quote per symbol */
+  fprintf(stdout, "%12s %12lu %12.1f %12.0f\n", "initial", num_accounts + 2 * num_symbols,
+          load_usec / 1000.0, (num_accounts + 2 * num_symbols) * 1000000.0 / load_usec);
+  fprintf(stdout, "%12s %12lu %12.1f %12.0f\n", "holdings", num_portfolios,
+          holdings_usec / 1000.0, num_portfolios * 1000000.0 / holdings_usec);
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+
+  benchmark_config_free(configH);
+  return SUCCESS;
+
+failXit:
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+  }
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+  return FAIL;
+}
@@ -3,7 +3,7 @@
 use strict;
 use warnings;
 
-my @tests = ('test1', 'test2');
+my @tests = ('test1', 'test2', 'test3', 'test4', 'test5', 'test6', 'test7');
 my $test_number = 0;
 my $test_passed = 0;
 my $test_failed = 0;
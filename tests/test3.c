@@ -28,6 +28,8 @@ int test()
 {
   int i;
   BENCHMARK_H   benchmarkH = NULL;
+  BENCHMARK_THREAD_CTX_H ctxH = NULL;
+  unsigned long allocs_before, allocs_after;
 
   /* Perform an initial load */
   fprintf(stdout, "Performing initial load\n");
@@ -58,6 +60,68 @@ int test()
     }
   }
 
+  /* Reads return their records in buffers of the thread and keep
+   * their transaction context there too, so repeating them must not
+   * allocate anything */
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Checking that reads don't allocate memory\n");
+  if (benchmark_alloc_count_get(benchmarkH, &allocs_before) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain allocation count\n");
+    goto failXit;
+  }
+
+  for (i = 0; i < 100; i++) {
+    if (benchmark_view_stock(benchmarkH, &i) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to retrieve info for symbol: %d\n", i);
+      goto failXit;
+    }
+  }
+
+  if (benchmark_alloc_count_get(benchmarkH, &allocs_after) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain allocation count\n");
+    goto failXit;
+  }
+
+  if (allocs_after != allocs_before) {
+    fprintf(stderr, "ERROR: Reads allocated memory %lu times\n", allocs_after - allocs_before);
+    goto failXit;
+  }
+
+  /* A context may read uncommitted quotes, while the handle reads
+   * committed ones */
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Reading with uncommitted isolation\n");
+  if (benchmark_thread_ctx_alloc(benchmarkH, 1, &ctxH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to allocate thread context\n");
+    goto failXit;
+  }
+
+  if (benchmark_thread_ctx_isolation_set(ctxH, BENCHMARK_ISOLATION_SERIALIZABLE + 1) == SUCCESS) {
+    fprintf(stderr, "ERROR: Accepted an invalid isolation level\n");
+    goto failXit;
+  }
+
+  if (benchmark_thread_ctx_isolation_set(ctxH, BENCHMARK_ISOLATION_UNCOMMITTED) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set isolation level\n");
+    goto failXit;
+  }
+
+  for (i = 0; i < 100; i++) {
+    if (benchmark_view_stock_ctx(ctxH, &i) != SUCCESS
+        || benchmark_view_stock(benchmarkH, &i) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to retrieve info for symbol: %d\n", i);
+      goto failXit;
+    }
+  }
+
+  if (benchmark_view_portfolio_ctx(ctxH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to retrieve portfolios\n");
+    goto failXit;
+  }
+
+  benchmark_thread_ctx_free(ctxH);
+  ctxH = NULL;
+
   fprintf(stdout, "\n");
   fprintf(stdout, "Freeing benchmark handle\n");
   if (benchmark_handle_free(benchmarkH) != SUCCESS) {
@@ -74,6 +138,11 @@ failXit:
   fprintf(stdout, "\n");
   fprintf(stdout, "++ Test FAILED\n");
 
+  if (ctxH) {
+    benchmark_thread_ctx_free(ctxH);
+    ctxH = NULL;
+  }
+
   if (benchmarkH) {
     benchmark_handle_free(benchmarkH);
     benchmarkH = NULL;
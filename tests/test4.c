@@ -0,0 +1,172 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test4.c
+ *
+ *    Description:  Show that a packet with partial commits keeps its good
+ *                  entries when one of them fails
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define SUCCESS 0
+#define FAIL    1
+
+#define NUM_ENTRIES   3
+
+/* The middle entry of each packet fails */
+static int
+check_statuses(BENCHMARK_DATA_PACKET_H packetH, const char *what)
+{
+  int expected[NUM_ENTRIES] = {BENCHMARK_ITEM_APPLIED, BENCHMARK_ITEM_FAILED, BENCHMARK_ITEM_APPLIED};
+  int status;
+  int i;
+
+  for (i = 0; i < NUM_ENTRIES; i++) {
+    if (benchmark_data_packet_status_get(packetH, i, &status) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to obtain status of %s entry %d\n", what, i);
+      return FAIL;
+    }
+
+    if (status != expected[i]) {
+      fprintf(stderr, "ERROR: %s entry %d has status %d, expected %d\n", what, i, status, expected[i]);
+      return FAIL;
+    }
+  }
+
+  return SUCCESS;
+}
+
+int test()
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  BENCHMARK_DATA_PACKET_H packetH = NULL;
+  int round;
+
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_packet_partial_set(configH, 1) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  /* Perform an initial load */
+  fprintf(stdout, "Performing initial load\n");
+  benchmarkH = benchmark_initial_load2("MyTest",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  /* A failed entry must leave its child transaction clean, so
+   * that the packet commits, and later packets still run */
+  for (round = 0; round < 2; round++) {
+    fprintf(stdout, "\n");
+    fprintf(stdout, "Purchasing with a price that is too low (round %d)\n", round);
+    if (benchmark_data_packet_alloc(NUM_ENTRIES, &packetH) != SUCCESS
+        || benchmark_data_packet_append("1", 0, NULL, 1000000, 10, packetH) != SUCCESS
+        || benchmark_data_packet_append("1", 1, NULL, -1, 10, packetH) != SUCCESS
+        || benchmark_data_packet_append("2", 2, NULL, 1000000, 10, packetH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to build purchase packet\n");
+      goto failXit;
+    }
+
+    if (benchmark_purchase2(packetH, benchmarkH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Purchase packet failed as a whole\n");
+      goto failXit;
+    }
+
+    if (check_statuses(packetH, "purchase") != SUCCESS) {
+      goto failXit;
+    }
+
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+
+    fprintf(stdout, "\n");
+    fprintf(stdout, "Selling more than is held (round %d)\n", round);
+    if (benchmark_data_packet_alloc(NUM_ENTRIES, &packetH) != SUCCESS
+        || benchmark_data_packet_append("1", 0, NULL, 0, 1, packetH) != SUCCESS
+        || benchmark_data_packet_append("1", 0, NULL, 0, 1000000, packetH) != SUCCESS
+        || benchmark_data_packet_append("2", 2, NULL, 0, 1, packetH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to build sell packet\n");
+      goto failXit;
+    }
+
+    if (benchmark_sell2(packetH, benchmarkH) != SUCCESS) {
+      fprintf(stderr, "ERROR: Sell packet failed as a whole\n");
+      goto failXit;
+    }
+
+    if (check_statuses(packetH, "sell") != SUCCESS) {
+      goto failXit;
+    }
+
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Freeing benchmark handle\n");
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test PASSED\n");
+  return SUCCESS;
+
+failXit:
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test FAILED\n");
+
+  if (packetH) {
+    benchmark_data_packet_free(packetH);
+    packetH = NULL;
+  }
+
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+    benchmarkH = NULL;
+  }
+
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+
+  return FAIL;
+}
+
+int main()
+{
+  if (test() != SUCCESS) {
+    fprintf(stderr, "ERROR: Failure in test");
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
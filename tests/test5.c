@@ -0,0 +1,244 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test5.c
+ *
+ *    Description:  Show that the datafile tokenizer reads the edge cases of
+ *                  the datafiles: signed percentages, unknown values,
+ *                  quoted '#', CRLF line ends, overlong fields, and lines
+ *                  that cross the chunks of a parallel load
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_FIXTURES_DIR   "/tmp/chronos/fixtures"
+#define SUCCESS 0
+#define FAIL    1
+
+/* Enough filler stocks for the Stocks datafile to be split in
+ * several chunks of 1 MB by a parallel load */
+#define NUM_FILLER_STOCKS   (150000)
+
+/* Five of the quotes are good: the one with a CRLF line end ends in
+ * the volume, and the one of "D#D" only has its fields in place if
+ * the quotes around the symbol are honored */
+static const char *quotes_fixture =
+  "AAA#7.15#8/8/2017#7.15#7.30#-2.05%#None#9.00#1931#42.59M\n"
+  "BBB#9.30#8/8/2017#9.25#9.43#+1.46%#n/a#10.50#57930#607.62M\n"
+  "\n"
+  "CCC#17.40#8/8/2017#17.15#17.40#+0.00%#None#None#7624\r\n"
+  "\"D#D\"#1.00#8/8/2017#1.00#1.00#0%#1.00#1.00#100#1.00M\n"
+  "\r\n"
+  "EEE#abc#8/8/2017#1.00#1.00#0%#1.00#1.00#100#1.00M\n"
+  "FFF#1.00#13/40/2017#1.00#1.00#0%#1.00#1.00#100#1.00M\n"
+  "LONGSYMBO#  2.00  #12/31/2017#2.00#2.00#+2%#n/a#n/a#n/a#None";
+
+#define QUOTES_ROWS       5
+#define QUOTES_MALFORMED  2
+
+/* Keys are trimmed, and LONGSYMBOL123 is cut to fit */
+static const char *stocks_fixture =
+  "  AAA  #Padded Inc.\n"
+  "BBB#Plain Inc.\n"
+  "CCC#Crlf Inc.\r\n"
+  "\"D#D\"#\"Quoted # Inc.\"\n"
+  "LONGSYMBOL123#Overlong Inc.\n";
+
+#define STOCKS_FIXTURE_ROWS  5
+
+static const char *expected_stocks[] = {"AAA", "BBB", "CCC", "D#D", "LONGSYMBO"};
+
+static const char *accounts_fixture =
+  "1#DOE#JOHN#1 HIGH ST#AUSTIN#TX#USA#512-555-0100\r\n"
+  "2#ROE#JANE#2 HIGH ST#AUSTIN#TX#USA#512-555-0101\r\n";
+
+static const char *currencies_fixture =
+  "United States#Dollar#USD\n"
+  "Mexico#Peso#MXN\n";
+
+static int
+write_fixture(const char *name, const char *contents, int num_filler)
+{
+  char path[256];
+  FILE *fp;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/%s", CHRONOS_SERVER_FIXTURES_DIR, name);
+  fp = fopen(path, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "ERROR: Failed to create %s\n", path);
+    return FAIL;
+  }
+
+  fputs(contents, fp);
+
+  /* Lines of different lengths, so that chunks start mid-line */
+  for (i = 0; i < num_filler; i++) {
+    fprintf(fp, "Z%d#Filler %.*s Corp\n", i, i % 7, "ABCDEFG");
+  }
+
+  if (fclose(fp) != 0) {
+    fprintf(stderr, "ERROR: Failed to write %s\n", path);
+    return FAIL;
+  }
+
+  return SUCCESS;
+}
+
+static int
+check_stocks(BENCHMARK_H benchmarkH)
+{
+  char **stocks_list = NULL;
+  int num_stocks = 0;
+  int found;
+  int i, j;
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    return FAIL;
+  }
+
+  /* A line lost or read twice at a chunk boundary changes the count */
+  if (num_stocks != STOCKS_FIXTURE_ROWS + NUM_FILLER_STOCKS) {
+    fprintf(stderr, "ERROR: Loaded %d stocks, expected %d\n",
+            num_stocks, STOCKS_FIXTURE_ROWS + NUM_FILLER_STOCKS);
+    return FAIL;
+  }
+
+  for (i = 0; i < STOCKS_FIXTURE_ROWS; i++) {
+    found = 0;
+    for (j = 0; j < num_stocks && !found; j++) {
+      found = (strcmp(stocks_list[j], expected_stocks[i]) == 0);
+    }
+
+    if (!found) {
+      fprintf(stderr, "ERROR: Stock '%s' was not loaded\n", expected_stocks[i]);
+      return FAIL;
+    }
+  }
+
+  return SUCCESS;
+}
+
+int test()
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  unsigned long rows = 0;
+  unsigned long malformed = 0;
+
+  if (mkdir(CHRONOS_SERVER_FIXTURES_DIR, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "ERROR: Failed to create %s\n", CHRONOS_SERVER_FIXTURES_DIR);
+    goto failXit;
+  }
+
+  if (write_fixture("quotes.txt", quotes_fixture, 0) != SUCCESS
+      || write_fixture("companylist.txt", stocks_fixture, NUM_FILLER_STOCKS) != SUCCESS
+      || write_fixture("accounts.txt", accounts_fixture, 0) != SUCCESS
+      || write_fixture("currencies.txt", currencies_fixture, 0) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "Parsing the quotes fixture\n");
+  if (benchmark_datafile_parse(CHRONOS_SERVER_FIXTURES_DIR "/quotes.txt",
+                               BENCHMARK_TABLE_QUOTES, &rows, &malformed) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to parse the quotes fixture\n");
+    goto failXit;
+  }
+
+  if (rows != QUOTES_ROWS || malformed != QUOTES_MALFORMED) {
+    fprintf(stderr, "ERROR: Parsed %lu quotes and %lu malformed lines, expected %d and %d\n",
+            rows, malformed, QUOTES_ROWS, QUOTES_MALFORMED);
+    goto failXit;
+  }
+
+  /* Stocks takes over 3 MB, so it is loaded in several chunks */
+  if (benchmark_config_alloc(&configH) != SUCCESS
+      || benchmark_config_parallel_load_set(configH, 4) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Loading the fixtures in parallel\n");
+  benchmarkH = benchmark_initial_load2("MyTest",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_FIXTURES_DIR,
+                                       configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Checking the loaded stocks\n");
+  if (check_stocks(benchmarkH) != SUCCESS) {
+    goto failXit;
+  }
+
+  /* Every good quote went to a listed symbol */
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Retrieving the loaded quotes\n");
+  if (benchmark_view_stock2(STOCKS_FIXTURE_ROWS, expected_stocks, benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to retrieve the loaded quotes\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Freeing benchmark handle\n");
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  benchmark_config_free(configH);
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test PASSED\n");
+  return SUCCESS;
+
+failXit:
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test FAILED\n");
+
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+    benchmarkH = NULL;
+  }
+
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+
+  return FAIL;
+}
+
+int main()
+{
+  if (test() != SUCCESS) {
+    fprintf(stderr, "ERROR: Failure in test");
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
@@ -0,0 +1,371 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test6.c
+ *
+ *    Description:  Show that restoring an image gives back the tables that
+ *                  were saved, and that damaged images and images of other
+ *                  record layouts are refused
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define CHRONOS_SERVER_IMAGE          "/tmp/chronos/tables.img"
+#define CHRONOS_SERVER_BAD_IMAGE      "/tmp/chronos/bad.img"
+#define SUCCESS 0
+#define FAIL    1
+
+#define NUM_TABLES    5
+#define NUM_SYMBOLS   10
+
+static const int tables[NUM_TABLES] = {
+  BENCHMARK_TABLE_STOCKS,
+  BENCHMARK_TABLE_QUOTES,
+  BENCHMARK_TABLE_PERSONAL,
+  BENCHMARK_TABLE_CURRENCIES,
+  BENCHMARK_TABLE_PORTFOLIOS
+};
+
+static const char *accounts[] = {"1", "2", "3"};
+
+/* What is compared before the save and after the restore */
+typedef struct snapshot_t {
+  unsigned long rows[NUM_TABLES];
+  int           holders[NUM_SYMBOLS];
+  char         *symbols[NUM_SYMBOLS];
+} snapshot_t;
+
+/* Start of an image, as written by benchmark_image_save() */
+typedef struct image_header_t {
+  char      magic[8];
+  uint32_t  version;
+  uint32_t  num_sections;
+  uint32_t  layout[6];
+  uint32_t  crc;
+} image_header_t;
+
+/* The first section header follows the image header */
+#define SECTION_HEADER_SIZE   (24)
+
+/* CRC32 of len bytes, as the image computes it */
+static uint32_t
+image_crc32(const void *bufP, size_t len)
+{
+  const unsigned char *p = bufP;
+  uint32_t crc = 0xFFFFFFFF;
+  int i;
+
+  while (len-- > 0) {
+    crc ^= *p++;
+    for (i = 0; i < 8; i++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
+
+static int
+snapshot_take(BENCHMARK_H benchmarkH, snapshot_t *snapP)
+{
+  char **stocks_list = NULL;
+  int num_stocks = 0;
+  int pending;
+  int i;
+
+  for (i = 0; i < NUM_TABLES; i++) {
+    if (benchmark_table_rows_get(benchmarkH, tables[i], &snapP->rows[i]) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to count the rows of table 0x%x\n", tables[i]);
+      return FAIL;
+    }
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS
+      || num_stocks < NUM_SYMBOLS) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    return FAIL;
+  }
+
+  /* The list belongs to the handle */
+  for (i = 0; i < NUM_SYMBOLS; i++) {
+    snapP->symbols[i] = strdup(stocks_list[i]);
+    if (snapP->symbols[i] == NULL) {
+      fprintf(stderr, "ERROR: Failed to allocate memory\n");
+      return FAIL;
+    }
+  }
+
+  for (i = 0; i < NUM_SYMBOLS; i++) {
+    if (benchmark_symbol_holders_get(benchmarkH, i, &snapP->holders[i], &pending) != SUCCESS) {
+      fprintf(stderr, "ERROR: Failed to obtain holders of symbol %d\n", i);
+      return FAIL;
+    }
+  }
+
+  if (benchmark_view_stock2(NUM_SYMBOLS, (const char **) snapP->symbols, benchmarkH) != SUCCESS
+      || benchmark_view_portfolio2(3, accounts, benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to view stocks and portfolios\n");
+    return FAIL;
+  }
+
+  return SUCCESS;
+}
+
+static void
+snapshot_free(snapshot_t *snapP)
+{
+  int i;
+
+  for (i = 0; i < NUM_SYMBOLS; i++) {
+    free(snapP->symbols[i]);
+    snapP->symbols[i] = NULL;
+  }
+}
+
+static int
+snapshot_compare(const snapshot_t *savedP, const snapshot_t *restoredP)
+{
+  int i;
+
+  for (i = 0; i < NUM_TABLES; i++) {
+    if (restoredP->rows[i] != savedP->rows[i]) {
+      fprintf(stderr, "ERROR: Table 0x%x has %lu rows, %lu were saved\n",
+              tables[i], restoredP->rows[i], savedP->rows[i]);
+      return FAIL;
+    }
+  }
+
+  /* Symbol ids must be the same, or holdings point elsewhere */
+  for (i = 0; i < NUM_SYMBOLS; i++) {
+    if (strcmp(restoredP->symbols[i], savedP->symbols[i]) != 0
+        || restoredP->holders[i] != savedP->holders[i]) {
+      fprintf(stderr, "ERROR: Symbol %d is %s with %d holders, %s with %d was saved\n",
+              i, restoredP->symbols[i], restoredP->holders[i],
+              savedP->symbols[i], savedP->holders[i]);
+      return FAIL;
+    }
+  }
+
+  return SUCCESS;
+}
+
+/* Writes a copy of the image, with damage done by damage_fn */
+static int
+image_copy(void (*damage_fn)(char *, size_t *))
+{
+  FILE *fp = NULL;
+  char *imageP = NULL;
+  size_t size;
+  long len;
+
+  fp = fopen(CHRONOS_SERVER_IMAGE, "rb");
+  if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) <= 0
+      || fseek(fp, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "ERROR: Failed to read %s\n", CHRONOS_SERVER_IMAGE);
+    goto failXit;
+  }
+  size = len;
+
+  imageP = malloc(size);
+  if (imageP == NULL || fread(imageP, 1, size, fp) != size) {
+    fprintf(stderr, "ERROR: Failed to read %s\n", CHRONOS_SERVER_IMAGE);
+    goto failXit;
+  }
+  fclose(fp);
+  fp = NULL;
+
+  damage_fn(imageP, &size);
+
+  fp = fopen(CHRONOS_SERVER_BAD_IMAGE, "wb");
+  if (fp == NULL || fwrite(imageP, 1, size, fp) != size || fclose(fp) != 0) {
+    fprintf(stderr, "ERROR: Failed to write %s\n", CHRONOS_SERVER_BAD_IMAGE);
+    fp = NULL;
+    goto failXit;
+  }
+
+  free(imageP);
+  return SUCCESS;
+
+failXit:
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  free(imageP);
+  return FAIL;
+}
+
+/* A byte of the first Stocks record */
+static void
+damage_section(char *imageP, size_t *sizeP)
+{
+  imageP[sizeof(image_header_t) + SECTION_HEADER_SIZE + 12] ^= 0x01;
+}
+
+/* A STOCK record of another size, with a header checksum that
+ * matches, as a build with another layout would write it */
+static void
+damage_layout(char *imageP, size_t *sizeP)
+{
+  image_header_t header;
+
+  memcpy(&header, imageP, sizeof(image_header_t));
+  header.layout[0] += 4;
+  header.crc = 0;
+  header.crc = image_crc32(&header, sizeof(image_header_t));
+  memcpy(imageP, &header, sizeof(image_header_t));
+}
+
+/* The last bytes of the image are lost */
+static void
+damage_truncate(char *imageP, size_t *sizeP)
+{
+  *sizeP -= 16;
+}
+
+static int
+check_refused(BENCHMARK_CONFIG_H configH, void (*damage_fn)(char *, size_t *), const char *what)
+{
+  BENCHMARK_H benchmarkH;
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Restoring an image with %s\n", what);
+  if (image_copy(damage_fn) != SUCCESS) {
+    return FAIL;
+  }
+
+  benchmarkH = benchmark_image_load("MyTest", CHRONOS_SERVER_HOME_DIR,
+                                    CHRONOS_SERVER_BAD_IMAGE, configH);
+  if (benchmarkH != NULL) {
+    fprintf(stderr, "ERROR: An image with %s was restored\n", what);
+    benchmark_handle_free(benchmarkH);
+    return FAIL;
+  }
+
+  return SUCCESS;
+}
+
+int test()
+{
+  BENCHMARK_CONFIG_H configH = NULL;
+  BENCHMARK_H   benchmarkH = NULL;
+  snapshot_t    saved;
+  snapshot_t    restored;
+
+  memset(&saved, 0, sizeof(snapshot_t));
+  memset(&restored, 0, sizeof(snapshot_t));
+
+  if (benchmark_config_alloc(&configH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to set up configuration\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "Performing initial load\n");
+  benchmarkH = benchmark_initial_load2("MyTest",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       configH);
+  if (benchmarkH == NULL || benchmark_load_portfolio(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (snapshot_take(benchmarkH, &saved) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Saving image\n");
+  if (benchmark_image_save(benchmarkH, CHRONOS_SERVER_IMAGE) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to save image\n");
+    goto failXit;
+  }
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Restoring image\n");
+  benchmarkH = benchmark_image_load("MyTest", CHRONOS_SERVER_HOME_DIR,
+                                    CHRONOS_SERVER_IMAGE, configH);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to restore image\n");
+    goto failXit;
+  }
+
+  if (snapshot_take(benchmarkH, &restored) != SUCCESS
+      || snapshot_compare(&saved, &restored) != SUCCESS) {
+    goto failXit;
+  }
+
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  if (check_refused(configH, damage_section, "a damaged section") != SUCCESS
+      || check_refused(configH, damage_layout, "other record layouts") != SUCCESS
+      || check_refused(configH, damage_truncate, "its end cut off") != SUCCESS) {
+    goto failXit;
+  }
+
+  snapshot_free(&saved);
+  snapshot_free(&restored);
+  benchmark_config_free(configH);
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test PASSED\n");
+  return SUCCESS;
+
+failXit:
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test FAILED\n");
+
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+    benchmarkH = NULL;
+  }
+
+  snapshot_free(&saved);
+  snapshot_free(&restored);
+
+  if (configH) {
+    benchmark_config_free(configH);
+  }
+
+  return FAIL;
+}
+
+int main()
+{
+  if (test() != SUCCESS) {
+    fprintf(stderr, "ERROR: Failure in test");
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}
@@ -0,0 +1,160 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test7.c
+ *
+ *    Description:  Show that a text stream of quote ticks is parsed with
+ *                  the datafile tokenizer: unknown prices are rejected,
+ *                  unknown bids, asks and volumes are left out, and lines
+ *                  that cross the read buffer are not lost
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  RICARDO ZAVALETA (),
+ *   Organization:
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include "benchmark.h"
+
+#define CHRONOS_SERVER_HOME_DIR       "/tmp/chronos/databases"
+#define CHRONOS_SERVER_DATAFILES_DIR  "/tmp/chronos/datafiles"
+#define CHRONOS_SERVER_TICKS_TEXT     "/tmp/chronos/ticks.txt"
+#define SUCCESS 0
+#define FAIL    1
+
+/* Enough ticks for the stream to take more than one read of 1 MB */
+#define NUM_FILLER_TICKS  (60000)
+
+#define TICKS_APPLIED     (3 + NUM_FILLER_TICKS)
+#define TICKS_REJECTED    (6)
+
+static int
+write_ticks(const char *symbol)
+{
+  FILE *fp;
+  int i;
+
+  fp = fopen(CHRONOS_SERVER_TICKS_TEXT, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "ERROR: Failed to create %s\n", CHRONOS_SERVER_TICKS_TEXT);
+    return FAIL;
+  }
+
+  /* Applied */
+  fprintf(fp, "%s#10.50#10.40#10.60#100#1502197200\n", symbol);
+  fprintf(fp, "%s#12.00#None#n/a#None#None\n", symbol);
+  fprintf(fp, "%s#11.00\r\n", symbol);
+
+  /* Rejected: unknown or bad prices, and an unlisted symbol */
+  fprintf(fp, "%s#None#10.40#10.60#100#1502197200\n", symbol);
+  fprintf(fp, "%s#n/a\n", symbol);
+  fprintf(fp, "%s##10.40\n", symbol);
+  fprintf(fp, "%s#-1.00\n", symbol);
+  fprintf(fp, "%s#abc\n", symbol);
+  fprintf(fp, "NOSUCHSYM#1.00\n");
+
+  for (i = 0; i < NUM_FILLER_TICKS; i++) {
+    fprintf(fp, "%s#%d.%02d#%d#%d#%d#%d\n", symbol, 10 + i % 7, i % 100,
+            10, 11, i % 1000, 1502197200 + i);
+  }
+
+  if (fclose(fp) != 0) {
+    fprintf(stderr, "ERROR: Failed to write %s\n", CHRONOS_SERVER_TICKS_TEXT);
+    return FAIL;
+  }
+
+  return SUCCESS;
+}
+
+int test()
+{
+  BENCHMARK_H   benchmarkH = NULL;
+  char        **stocks_list = NULL;
+  int           num_stocks = 0;
+  unsigned long applied = 0;
+  unsigned long rejected = 0;
+
+  fprintf(stdout, "Performing initial load\n");
+  benchmarkH = benchmark_initial_load2("MyTest",
+                                       CHRONOS_SERVER_HOME_DIR,
+                                       CHRONOS_SERVER_DATAFILES_DIR,
+                                       NULL);
+  if (benchmarkH == NULL) {
+    fprintf(stderr, "ERROR: Failed to perform initial load\n");
+    goto failXit;
+  }
+
+  if (benchmark_stock_list_get(benchmarkH, &stocks_list, &num_stocks) != SUCCESS
+      || num_stocks <= 0) {
+    fprintf(stderr, "ERROR: Failed to obtain list of stocks\n");
+    goto failXit;
+  }
+
+  if (write_ticks(stocks_list[0]) != SUCCESS) {
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Replaying ticks of %s\n", stocks_list[0]);
+  if (benchmark_ingest_run(benchmarkH, CHRONOS_SERVER_TICKS_TEXT, BENCHMARK_TICKS_TEXT,
+                           &applied, &rejected) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to replay ticks\n");
+    goto failXit;
+  }
+
+  if (applied != TICKS_APPLIED || rejected != TICKS_REJECTED) {
+    fprintf(stderr, "ERROR: Applied %lu ticks and rejected %lu, expected %d and %d\n",
+            applied, rejected, TICKS_APPLIED, TICKS_REJECTED);
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Retrieving the quote of %s\n", stocks_list[0]);
+  if (benchmark_view_stock2(1, (const char **) stocks_list, benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to retrieve the quote\n");
+    goto failXit;
+  }
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "Freeing benchmark handle\n");
+  if (benchmark_handle_free(benchmarkH) != SUCCESS) {
+    fprintf(stderr, "ERROR: Failed to free benchmark handle\n");
+    benchmarkH = NULL;
+    goto failXit;
+  }
+  benchmarkH = NULL;
+
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test PASSED\n");
+  return SUCCESS;
+
+failXit:
+  fprintf(stdout, "\n");
+  fprintf(stdout, "++ Test FAILED\n");
+
+  if (benchmarkH) {
+    benchmark_handle_free(benchmarkH);
+    benchmarkH = NULL;
+  }
+
+  return FAIL;
+}
+
+int main()
+{
+  if (test() != SUCCESS) {
+    fprintf(stderr, "ERROR: Failure in test");
+    goto failXit;
+  }
+
+  return SUCCESS;
+
+failXit:
+  return FAIL;
+}